@@ -18,6 +18,8 @@
 #define BENCHMARK_H
 
 extern char *benchmark_file;
+// second save for the two thread check
+extern char *benchmark_file2;
 
 void benchmark_run();
 double benchmark_get_time();
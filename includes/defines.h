@@ -58,6 +58,10 @@
 #define LOCAL_SAVE_DIR "Saves"
 
 #define THUMB_CACHE_SIZE 256
+#define THUMB_DECODED_CACHE_SIZE 256
+#define THUMB_DISK_CACHE_SIZE 2048
+// seconds before a thumbnail on disk is decoded again, the listing doesn't say when a save was last updated
+#define THUMB_DISK_CACHE_AGE (60*60*24)
 
 #ifndef M_PI
 #define M_PI 3.14159265f
@@ -163,10 +167,6 @@ typedef unsigned char uint8;
 extern char * saveDataOpen;
 extern int saveDataOpenSize;
 
-#ifdef INTERNAL
-	extern int vs;
-#endif
-
 extern bool firstRun;
 extern bool doubleScreenDialog;
 extern int screenWidth;
@@ -175,8 +175,6 @@ extern float FPSB2;
 extern int main_loop;
 extern int elapsedTime;
 
-extern int NUM_PARTS;
-
 extern bool legacy_enable;
 extern int kiosk_enable;
 extern bool aheat_enable;
@@ -281,6 +279,7 @@ void tab_save(int num, char reloadButton);
 void *stamp_load(int i, int *size, int reorder);
 int tab_load(int tabNum, bool del = false);
 void stamp_init();
+bool stamp_gen_thumb(int i);
 void del_stamp(int d);
 int set_scale(int scale, int kiosk);
 void dump_frame(pixel *src, int w, int h, int pitch);
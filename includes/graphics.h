@@ -80,6 +80,9 @@ void sdl_blit_2(int x, int y, int w, int h, pixel *src, int pitch);
 
 void sdl_blit(int x, int y, int w, int h, pixel *src, int pitch);
 
+// makes the next sdl_blit send the whole frame, for when the window contents may have been lost
+void sdl_invalidate();
+
 void drawblob(pixel *vid, int x, int y, unsigned char cr, unsigned char cg, unsigned char cb);
 
 void draw_tool_button(pixel *vid_buf, int x, int y, pixel color, std::string name);
@@ -47,6 +47,9 @@ const quick_option quickmenu[] =
 
 extern char tabNames[10][255];
 extern pixel* tabThumbnails[10];
+class TabState;
+// inactive tabs, NULL for the current tab or tabs that only exist on disk
+extern TabState* tabStates[10];
 
 struct ui_edit
 {
@@ -289,6 +292,8 @@ int info_parse(const char *info_data, save_info *info);
 
 int search_results(char *str, int votes);
 
+std::string search_thumb_id(int pos);
+
 int execute_tagop(pixel *vid_buf, const char *op, char *tag);
 
 int execute_save(pixel *vid_buf);
@@ -43,6 +43,7 @@ extern Simulation * luaSim;
 
 extern pixel *lua_vid_buf;
 extern int *lua_el_func, *lua_el_mode, *lua_gr_func;
+extern int *lua_el_batch_func, *lua_el_batch_mode;
 extern char* log_history[20];
 extern int log_history_times[20];
 
@@ -58,6 +59,8 @@ void luacon_log(char *log);
 int luacon_keyevent(int key, unsigned short character, int modifier, int event);
 int luacon_eval(const char *command, char **result);
 int luacon_part_update(unsigned int t, int i, int x, int y, int surround_space, int nt);
+void luacon_set_batch_update(int t, int function, int mode);
+void luacon_batch_update(Simulation *sim, bool before);
 int luacon_graphics_update(int t, int i, int *pixel_mode, int *cola, int *colr, int *colg, int *colb, int *firea, int *firer, int *fireg, int *fireb);
 const char *luacon_geterror();
 void luacon_close();
@@ -139,6 +142,7 @@ int luatpt_setfpscap(lua_State* l);
 int luatpt_getscript(lua_State* l);
 int luatpt_setwindowsize(lua_State* l);
 int luatpt_screenshot(lua_State* l);
+int luatpt_record(lua_State* l);
 int luatpt_getclip(lua_State* l);
 int luatpt_setclip(lua_State* l);
 int luatpt_bubble(lua_State* l);
@@ -13,6 +13,9 @@ int simulation_signIndex(lua_State *l);
 int simulation_signNewIndex(lua_State *l);
 int simulation_newsign(lua_State *l);
 void initSimulationAPI(lua_State * l);
+#ifdef LUAJIT
+void initFFIViews(lua_State * l);
+#endif
 int simulation_partNeighbours(lua_State * l);
 int simulation_partChangeType(lua_State * l);
 int simulation_partCreate(lua_State * l);
@@ -48,6 +51,11 @@ int simulation_resetPressure(lua_State * l);
 int simulation_saveStamp(lua_State * l);
 int simulation_loadStamp(lua_State * l);
 int simulation_deleteStamp(lua_State * l);
+int simulation_serialize(lua_State * l);
+int simulation_deserialize(lua_State * l);
+int simulation_diff(lua_State * l);
+int simulation_applyDiff(lua_State * l);
+void simulation_diff_free();
 int simulation_loadSave(lua_State * l);
 int simulation_reloadSave(lua_State * l);
 int simulation_getSaveID(lua_State * l);
@@ -60,6 +68,12 @@ int simulation_airMode(lua_State * l);
 int simulation_waterEqualization(lua_State * l);
 int simulation_ambientAirTemp(lua_State * l);
 int simulation_elementCount(lua_State* l);
+int simulation_stats(lua_State * l);
+int simulation_temperatureHistogram(lua_State * l);
+int simulation_updateByType(lua_State * l);
+int simulation_compactParticles(lua_State * l);
+int simulation_compactInterval(lua_State * l);
+int simulation_elementUpdateTime(lua_State * l);
 int simulation_canMove(lua_State * l);
 int simulation_parts(lua_State * l);
 int simulation_brush(lua_State * l);
@@ -23,9 +23,24 @@
 //Signum function
 int isign(float i);
 
-unsigned clamp_flt(float f, float min, float max);
-
-float restrict_flt(float f, float min, float max);
+// inline so the air display loops in graphics.cpp can be vectorized
+inline unsigned clamp_flt(float f, float min, float max)
+{
+	if (f<min)
+		return 0;
+	if (f>max)
+		return 255;
+	return (int)(255.0f*(f-min)/(max-min));
+}
+
+inline float restrict_flt(float f, float min, float max)
+{
+	if (f<min)
+		return min;
+	if (f>max)
+		return max;
+	return f;
+}
 
 char *mystrdup(const char *s);
 
@@ -19,6 +19,7 @@
 
 #include "defines.h"
 #include "misc.h"
+#include "common/tpt-tls.h"
 
 #define BRUSH_REPLACEMODE 0x1
 #define BRUSH_SPECIFIC_DELETE 0x2
@@ -95,15 +96,17 @@ extern const particle emptyparticle;
 
 extern int airMode;
 
-extern particle *parts;
+// Views into the simulation that is current on the calling thread, see Simulation::MakeCurrent
+// Older code and most element functions still use these, new code should use sim->parts, sim->pmap, ...
+extern TPT_THREAD_LOCAL particle *parts;
 
-extern unsigned char bmap[YRES/CELL][XRES/CELL];
-extern unsigned char emap[YRES/CELL][XRES/CELL];
+extern TPT_THREAD_LOCAL unsigned char (*bmap)[XRES/CELL];
+extern TPT_THREAD_LOCAL unsigned char (*emap)[XRES/CELL];
 
-extern unsigned pmap[YRES][XRES];
-extern int pmap_count[YRES][XRES];
+extern TPT_THREAD_LOCAL unsigned (*pmap)[XRES];
+extern TPT_THREAD_LOCAL int (*pmap_count)[XRES];
 
-extern unsigned photons[YRES][XRES];
+extern TPT_THREAD_LOCAL unsigned (*photons)[XRES];
 
 int get_wavelength_bin(int *wm);
 
@@ -31,7 +31,8 @@ void *transform_save(void *odata, int *size, matrix2d transform, vector2d transl
 void *build_thumb(int *size, int bzip2);
 
 //calls the correct function to prerender either an OPS or PSV save
-pixel *prerender_save(void *save, int size, int *width, int *height);
+//if elementCounts isn't NULL, the number of particles of each type is added to it (PT_NUM entries, OPS saves only)
+pixel *prerender_save(void *save, int size, int *width, int *height, int *elementCounts = NULL);
 
 //calls the correct function to parse either an OPS or PSV save
 int parse_save(void *save, int size, int replace, int x0, int y0, unsigned char bmap[YRES/CELL][XRES/CELL], float vx[YRES/CELL][XRES/CELL], float vy[YRES/CELL][XRES/CELL], float pv[YRES/CELL][XRES/CELL], float fvx[YRES/CELL][XRES/CELL], float fvy[YRES/CELL][XRES/CELL], std::vector<Sign*>& signs, void* partsptr, unsigned pmap[YRES][XRES], Json::Value *j, bool includePressure = true);
@@ -48,8 +49,10 @@ int change_wall(int wt);
 int change_wallpp(int wt);
 
 //Current save prerenderer, builder, and parser
-pixel *prerender_save_OPS(void *save, int size, int *width, int *height);
-void *build_save(int *size, int orig_x0, int orig_y0, int orig_w, int orig_h, unsigned char bmap[YRES/CELL][XRES/CELL], float vx[YRES/CELL][XRES/CELL], float vy[YRES/CELL][XRES/CELL], float pv[YRES/CELL][XRES/CELL], float fvx[YRES/CELL][XRES/CELL], float fvy[YRES/CELL][XRES/CELL], std::vector<Sign*>& signs, void* partsptr, Json::Value *j, bool tab = false, bool includePressure = true);
+pixel *prerender_save_OPS(void *save, int size, int *width, int *height, int *elementCounts = NULL);
+void *build_save(int *size, int orig_x0, int orig_y0, int orig_w, int orig_h, unsigned char bmap[YRES/CELL][XRES/CELL], float vx[YRES/CELL][XRES/CELL], float vy[YRES/CELL][XRES/CELL], float pv[YRES/CELL][XRES/CELL], float fvx[YRES/CELL][XRES/CELL], float fvy[YRES/CELL][XRES/CELL], std::vector<Sign*>& signs, void* partsptr, Json::Value *j, bool tab = false, bool includePressure = true, bool compress = true);
+//bzip2 compresses a save made by build_save with compress = false. Doesn't use any globals, so it can be called from other threads
+void *compress_save(void *save, int size, int *compressedSize);
 int parse_save_OPS(void *save, int size, int replace, int x0, int y0, unsigned char bmap[YRES/CELL][XRES/CELL], float vx[YRES/CELL][XRES/CELL], float vy[YRES/CELL][XRES/CELL], float pv[YRES/CELL][XRES/CELL], float fvx[YRES/CELL][XRES/CELL], float fvy[YRES/CELL][XRES/CELL], std::vector<Sign*>& signs, void* partsptr, unsigned pmap[YRES][XRES], Json::Value *j, bool includePressure);
 
 //Old save prerenderer and parser
@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <math.h>
+#include <algorithm>
+#include <vector>
 #include "SDLCompat.h"
 
 #include "powder.h"
@@ -9,12 +11,17 @@
 #include "benchmark.h"
 #include "save.h"
 #include "common/Point.h"
+#include "common/tpt-thread.h"
 #include "game/Sign.h"
 #include "graphics/Pixel.h"
 #include "json/json.h"
+#ifdef LUACONSOLE
+#include "luaconsole.h"
+#endif
 #include "simulation/Simulation.h"
 
 char *benchmark_file = NULL;
+char *benchmark_file2 = NULL;
 double benchmark_loops_multiply = 1.0; // Increase for more accurate results (particularly on fast computers)
 int benchmark_repeat_count = 5; // this too, but try benchmark_loops_multiply first
 
@@ -57,6 +64,306 @@ double benchmark_get_time()
 		printf("mean time per iteration %g ms\n", bench_mean/bench_iterations * 1000.0);\
 }
 
+struct benchmark_sim_thread_data
+{
+	Simulation *sim;
+	int frames;
+	std::vector<unsigned int> hashes; // one per frame, see benchmark_sim_hash
+};
+
+// FNV-1a hash of the particles and the pressure map, to compare two runs frame by frame
+unsigned int benchmark_sim_hash(Simulation *sim)
+{
+	unsigned int hash = 2166136261U;
+	const unsigned char *data = (const unsigned char*)sim->parts;
+	size_t size = sizeof(particle)*(sim->parts_lastActiveIndex+1);
+	for (size_t i = 0; i < size; i++)
+		hash = (hash^data[i]) * 16777619U;
+	data = (const unsigned char*)sim->air->pv;
+	for (size_t i = 0; i < sizeof(sim->air->pv); i++)
+		hash = (hash^data[i]) * 16777619U;
+	return hash;
+}
+
+TH_ENTRY_POINT void* benchmark_sim_thread(void *arg)
+{
+	benchmark_sim_thread_data *data = (benchmark_sim_thread_data*)arg;
+	data->sim->MakeCurrent();
+	for (int i = 0; i < data->frames; i++)
+	{
+		data->sim->air->UpdateAir();
+		data->sim->air->UpdateAirHeat();
+		data->sim->Tick();
+		data->hashes.push_back(benchmark_sim_hash(data->sim));
+	}
+	return NULL;
+}
+
+// loads a save into a new simulation with its own random number generator
+Simulation *benchmark_load_sim(char *file_data, int size, unsigned int seed)
+{
+	Simulation *mainSim = globalSim;
+	Simulation *sim = new Simulation();
+	Json::Value temp;
+	sim->MakeCurrent();
+	parse_save(file_data, size, 1, 0, 0, sim->bmap, sim->air->vx, sim->air->vy, sim->air->pv, sim->air->fvx, sim->air->fvy, signs, sim->parts, sim->pmap, &temp);
+	sim->SeedRandom(seed);
+	mainSim->MakeCurrent();
+	return sim;
+}
+
+// Ticks two saves at the same time on two threads, and checks every frame of each against a run of the same save
+// on its own. The main thread's simulation holds an untouched copy of the first save, which must not change either.
+// Each simulation has its own random number generator, so the runs only differ if the simulations share some state
+void benchmark_parallel_sims(char *file_data, int size, char *file_data2, int size2, int frames)
+{
+	Simulation *mainSim = globalSim;
+	benchmark_sim_thread_data data[2];
+	pthread_t threads[2];
+	std::vector<unsigned int> expected[2];
+
+	particle *mainParts = (particle*)malloc(sizeof(particle)*NPART);
+	memcpy(mainParts, mainSim->parts, sizeof(particle)*NPART);
+
+	// one at a time first
+	for (int t = 0; t < 2; t++)
+	{
+		data[t].sim = t ? benchmark_load_sim(file_data2, size2, 2) : benchmark_load_sim(file_data, size, 1);
+		data[t].frames = frames;
+		pthread_create(&threads[t], NULL, &benchmark_sim_thread, &data[t]);
+		pthread_join(threads[t], NULL);
+		expected[t].swap(data[t].hashes);
+		delete data[t].sim;
+	}
+
+	for (int t = 0; t < 2; t++)
+		data[t].sim = t ? benchmark_load_sim(file_data2, size2, 2) : benchmark_load_sim(file_data, size, 1);
+	double start = benchmark_get_time();
+	for (int t = 0; t < 2; t++)
+		pthread_create(&threads[t], NULL, &benchmark_sim_thread, &data[t]);
+	for (int t = 0; t < 2; t++)
+		pthread_join(threads[t], NULL);
+	double end = benchmark_get_time();
+
+	printf("%d frames in %g ms", frames, (end-start) * 1000.0);
+	bool ok = true;
+	for (int t = 0; t < 2; t++)
+		for (int i = 0; i < frames; i++)
+			if (data[t].hashes[i] != expected[t][i])
+			{
+				printf(", FAILED, save %d differs from running it alone in frame %d", t+1, i+1);
+				ok = false;
+				break;
+			}
+	if (memcmp(mainParts, mainSim->parts, sizeof(particle)*NPART))
+	{
+		printf(", FAILED, the main simulation changed");
+		ok = false;
+	}
+	printf(ok ? ", simulations are independent\n" : "\n");
+
+	free(mainParts);
+	delete data[0].sim;
+	delete data[1].sim;
+}
+
+// Builds a scene with long pipe runs fed by clone and a few hundred portal pairs spread over most of the channels
+void benchmark_portal_scene(Simulation *sim)
+{
+	const int pipeStart = 40, pipeEnd = XRES-40;
+	clear_sim();
+	sys_pause = false;
+	framerender = 0;
+
+	// horizontal pipes, wait for the BRCK borders to form then open both ends
+	for (int y = 16; y < 136; y += 20)
+		for (int x = pipeStart; x <= pipeEnd; x++)
+			sim->part_create(-1, x, y, PT_PIPE);
+	for (int i = 0; i < 20; i++)
+		sim->Tick();
+	for (int y = 16; y < 136; y += 20)
+	{
+		sim->part_delete(pipeStart-1, y);
+		sim->part_delete(pipeStart-2, y);
+		sim->part_delete(pipeEnd+1, y);
+		sim->part_delete(pipeEnd+2, y);
+	}
+	// the pipe pattern only moves one pixel per frame
+	for (int i = 0; i < pipeEnd-pipeStart+100; i++)
+		sim->Tick();
+	for (int y = 16; y < 136; y += 20)
+	{
+		int np = sim->part_create(-1, pipeStart-2, y, PT_CLNE);
+		if (np >= 0)
+			sim->parts[np].ctype = PT_WATR;
+		sim->part_create(-1, pipeEnd+2, y, PT_VOID);
+	}
+
+	// portal pairs fed with photons, each pair on a different channel where possible
+	int pair = 0;
+	for (int y = 150; y < YRES-30; y += 22)
+		for (int x = 16; x+12 < XRES; x += 30, pair++)
+		{
+			float temp = 73.15f + 100.0f*(pair%(CHANNELS-1)) + 50.0f;
+			int np = sim->part_create(-1, x-2, y, PT_CLNE);
+			if (np >= 0)
+				sim->parts[np].ctype = PT_PHOT;
+			np = sim->part_create(-1, x, y, PT_PRTI);
+			if (np >= 0)
+				sim->parts[np].temp = temp;
+			np = sim->part_create(-1, x+8, y, PT_PRTO);
+			if (np >= 0)
+				sim->parts[np].temp = temp;
+		}
+	for (int i = 0; i < 50; i++)
+		sim->Tick();
+}
+
+// Fills a block with METL, placing the particles in a random order so neighbours have unrelated indices
+void benchmark_scattered_scene(Simulation *sim)
+{
+	std::vector<int> positions;
+	clear_sim();
+	sys_pause = false;
+	framerender = 0;
+	for (int y = 40; y < YRES-40; y++)
+		for (int x = 40; x < XRES-40; x++)
+			positions.push_back(x+y*XRES);
+	for (int i = positions.size()-1; i > 0; i--)
+		std::swap(positions[i], positions[rand()%(i+1)]);
+	for (size_t i = 0; i < positions.size(); i++)
+		sim->part_create(-1, positions[i]%XRES, positions[i]/XRES, PT_METL);
+	sim->RecalcFreeParticles(false);
+}
+
+// A grid of INST wires, so there are plenty of wire crossings and T junctions, sparked by batteries through PSCN
+void benchmark_inst_scene(Simulation *sim)
+{
+	sys_pause = false;
+	framerender = 0;
+	for (int y = 40; y < YRES-40; y += 12)
+		for (int x = 40; x < XRES-40; x++)
+			sim->part_create(-1, x, y, PT_INST);
+	for (int x = 46; x < XRES-40; x += 16)
+		for (int y = 40; y < YRES-40; y++)
+			sim->part_create(-1, x, y, PT_INST);
+	for (int x = 46; x < XRES-40; x += 64)
+	{
+		sim->part_create(-1, x, 38, PT_PSCN);
+		sim->part_create(-1, x, 37, PT_BTRY);
+	}
+}
+
+// Cuts and repairs one of the INST wires, so nets are dropped and found again
+void benchmark_inst_scene_edit(Simulation *sim, bool repair)
+{
+	for (int x = 100; x < 104; x++)
+	{
+		if (repair)
+			sim->part_create(-1, x, 52, PT_INST);
+		else
+			sim->part_delete(x, 52);
+	}
+}
+
+// Ticks the INST scene with and without sim->instNetlist, the particles must end up exactly the same
+void benchmark_check_inst_netlist(int frames)
+{
+	Simulation *mainSim = globalSim;
+	particle *results[2];
+	for (int n = 0; n < 2; n++)
+	{
+		Simulation *sim = new Simulation();
+		sim->MakeCurrent();
+		sim->instNetlist.enabled = (n == 0);
+		srand(1);
+		benchmark_inst_scene(sim);
+		for (int i = 0; i < frames; i++)
+		{
+			if (i == frames/3 || i == frames*2/3)
+				benchmark_inst_scene_edit(sim, i != frames/3);
+			sim->Tick();
+		}
+		results[n] = (particle*)malloc(sizeof(particle)*NPART);
+		memcpy(results[n], sim->parts, sizeof(particle)*NPART);
+		delete sim;
+	}
+	mainSim->MakeCurrent();
+
+	bool ok = !memcmp(results[0], results[1], sizeof(particle)*NPART);
+	printf("INST netlist, %d frames: %s\n", frames, ok ? "same as flooding" : "FAILED, replayed nets differ from flooding");
+	free(results[0]);
+	free(results[1]);
+}
+
+// Ticks a save with and without sim->instNetlist, and compares them after every frame. Meant for real electronics
+// saves, which use INST in ways the scene above doesn't
+void benchmark_check_inst_netlist_save(const char *name, char *file_data, int size, int frames)
+{
+	benchmark_sim_thread_data data[2];
+	pthread_t thread;
+	for (int n = 0; n < 2; n++)
+	{
+		data[n].sim = benchmark_load_sim(file_data, size, 1);
+		data[n].sim->instNetlist.enabled = (n == 0);
+		data[n].frames = frames;
+		pthread_create(&thread, NULL, &benchmark_sim_thread, &data[n]);
+		pthread_join(thread, NULL);
+	}
+
+	int differs = 0;
+	for (int i = 0; i < frames && !differs; i++)
+		if (data[0].hashes[i] != data[1].hashes[i])
+			differs = i+1;
+	if (differs)
+		printf("INST netlist, %s: FAILED, differs from flooding in frame %d\n", name, differs);
+	else
+		printf("INST netlist, %s, %d frames: same as flooding\n", name, frames);
+	delete data[0].sim;
+	delete data[1].sim;
+}
+
+#ifdef LUACONSOLE
+void benchmark_lua(const char *code)
+{
+	char *result = NULL;
+	if (luacon_eval(code, &result))
+		printf("Lua error: %s\n", luacon_geterror());
+	free(result);
+}
+
+// Ticks a block of DMND with a Lua function that reads every particle's temperature, once called for each particle
+// from Update and once called for the whole element from UpdateBatch
+void benchmark_lua_updates(Simulation *sim)
+{
+	clear_sim();
+	sys_pause = false;
+	framerender = 0;
+	for (int y = 50; y < YRES-50; y++)
+		for (int x = 50; x < XRES-50; x++)
+			sim->part_create(-1, x, y, PT_DMND);
+
+	benchmark_lua("benchmarkTemp = 0");
+	printf("Lua element update - per particle: ");
+	benchmark_lua("elements.property(elements.DEFAULT_PT_DMND, \"Update\", function(i) benchmarkTemp = benchmarkTemp + sim.partProperty(i, \"temp\") end)");
+	BENCHMARK_START(benchmark_repeat_count, 50)
+	{
+		sim->Tick();
+	}
+	BENCHMARK_END()
+	benchmark_lua("elements.property(elements.DEFAULT_PT_DMND, \"Update\", false)");
+
+	printf("Lua element update - batched: ");
+	benchmark_lua("elements.property(elements.DEFAULT_PT_DMND, \"UpdateBatch\", function(ids, count) for n = 1, count do benchmarkTemp = benchmarkTemp + sim.partProperty(ids[n], \"temp\") end end)");
+	BENCHMARK_START(benchmark_repeat_count, 50)
+	{
+		sim->Tick();
+	}
+	BENCHMARK_END()
+	benchmark_lua("elements.property(elements.DEFAULT_PT_DMND, \"UpdateBatch\", false) benchmarkTemp = nil");
+	clear_sim();
+}
+#endif
 
 void benchmark_run()
 {
@@ -167,6 +474,26 @@ void benchmark_run()
 				}
 				BENCHMARK_END()
 
+				printf("Two simulations on two threads: ");
+				int size2;
+				char *file_data2 = benchmark_file2 ? (char*)file_load(benchmark_file2, &size2) : NULL;
+				if (file_data2)
+				{
+					temp.clear();
+					parse_save(file_data, size, 1, 0, 0, bmap, sim->air->fvx, sim->air->fvy, sim->air->vx, sim->air->vy, sim->air->pv, signs, parts, pmap, &temp);
+					sys_pause = false;
+					framerender = 0;
+					benchmark_parallel_sims(file_data, size, file_data2, size2, 200);
+				}
+				else
+					printf("skipped, needs a second save (benchmark2 <file>)\n");
+
+				benchmark_check_inst_netlist_save(benchmark_file, file_data, size, 300);
+				if (file_data2)
+				{
+					benchmark_check_inst_netlist_save(benchmark_file2, file_data2, size2, 300);
+					free(file_data2);
+				}
 
 			}
 			free(file_data);
@@ -202,6 +529,59 @@ void benchmark_run()
 		}
 		BENCHMARK_END()
 
+		printf("Update particles - portals and pipes: ");
+		benchmark_portal_scene(sim);
+		BENCHMARK_START(benchmark_repeat_count, 200)
+		{
+			sim->Tick();
+		}
+		BENCHMARK_END()
+		clear_sim();
+
+		printf("Update particles - scattered indices: ");
+		benchmark_scattered_scene(sim);
+		BENCHMARK_START(benchmark_repeat_count, 100)
+		{
+			sim->Tick();
+		}
+		BENCHMARK_END()
+
+		printf("Update particles - after CompactParticles: ");
+		benchmark_scattered_scene(sim);
+		sim->CompactParticles();
+		BENCHMARK_START(benchmark_repeat_count, 100)
+		{
+			sim->Tick();
+		}
+		BENCHMARK_END()
+		clear_sim();
+
+		printf("Update particles - INST circuit: ");
+		benchmark_inst_scene(sim);
+		BENCHMARK_START(benchmark_repeat_count, 200)
+		{
+			sim->Tick();
+		}
+		BENCHMARK_END()
+		clear_sim();
+
+		printf("Update particles - INST circuit, no netlist: ");
+		sim->instNetlist.enabled = false;
+		benchmark_inst_scene(sim);
+		BENCHMARK_START(benchmark_repeat_count, 200)
+		{
+			sim->Tick();
+		}
+		BENCHMARK_END()
+		sim->instNetlist.enabled = true;
+		clear_sim();
+
+		benchmark_check_inst_netlist(300);
+
+#ifdef LUACONSOLE
+		benchmark_lua_updates(sim);
+#endif
+
 		printf("Air - no walls, no changes: ");
 		BENCHMARK_START(benchmark_repeat_count, 3000)
 		{
@@ -0,0 +1,471 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include "JobSystem.h"
+#include "common/Platform.h"
+#include "common/tpt-tls.h"
+
+// smallest block a scratch arena allocates
+#define SCRATCH_BLOCK_SIZE (1024*1024)
+
+// which queue the current thread pushes to, 0 for threads that aren't workers
+TPT_THREAD_LOCAL int currentQueue = 0;
+TPT_THREAD_LOCAL ScratchArena *currentArena = NULL;
+
+TaskGroup::TaskGroup():
+	pending(0)
+{
+	pthread_mutex_init(&lock, NULL);
+}
+
+TaskGroup::~TaskGroup()
+{
+	pthread_mutex_destroy(&lock);
+}
+
+void TaskGroup::Add()
+{
+	pthread_mutex_lock(&lock);
+	pending++;
+	pthread_mutex_unlock(&lock);
+}
+
+void TaskGroup::Finish()
+{
+	pthread_mutex_lock(&lock);
+	pending--;
+	pthread_mutex_unlock(&lock);
+}
+
+bool TaskGroup::Done()
+{
+	pthread_mutex_lock(&lock);
+	bool done = !pending;
+	pthread_mutex_unlock(&lock);
+	return done;
+}
+
+void TaskGroup::Wait()
+{
+	JobSystem::Ref().Wait(this);
+}
+
+ScratchArena::ScratchArena():
+	current(0),
+	used(0)
+{
+
+}
+
+ScratchArena::~ScratchArena()
+{
+	for (size_t i = 0; i < blocks.size(); i++)
+		free(blocks[i].data);
+}
+
+void *ScratchArena::Alloc(size_t size)
+{
+	size = (size+15) & ~(size_t)15;
+	if (current < blocks.size() && used+size <= blocks[current].size)
+	{
+		void *ret = blocks[current].data+used;
+		used += size;
+		return ret;
+	}
+
+	// move on to the next block, or put a big enough one after this one
+	size_t next = blocks.size() ? current+1 : 0;
+	if (next >= blocks.size() || blocks[next].size < size)
+	{
+		Block block;
+		block.size = size > SCRATCH_BLOCK_SIZE ? size : SCRATCH_BLOCK_SIZE;
+		block.data = (char*)malloc(block.size);
+		if (!block.data)
+			return NULL;
+		blocks.insert(blocks.begin()+next, block);
+	}
+	current = next;
+	used = size;
+	return blocks[current].data;
+}
+
+ScratchArena::Mark ScratchArena::GetMark()
+{
+	Mark mark;
+	mark.block = current;
+	mark.used = used;
+	return mark;
+}
+
+void ScratchArena::Release(Mark mark)
+{
+	current = mark.block;
+	used = mark.used;
+}
+
+class RangeJob : public Job
+{
+	void (*func)(int start, int end, void *data);
+	int start, end;
+	void *data;
+
+public:
+	RangeJob(void (*func)(int start, int end, void *data), int start, int end, void *data):
+		func(func),
+		start(start),
+		end(end),
+		data(data)
+	{
+
+	}
+
+	virtual void Run()
+	{
+		func(start, end, data);
+	}
+};
+
+JobSystem::JobSystem():
+	threadCount(1),
+	started(false),
+	shutdown(false),
+	pendingJobs(0),
+	backgroundStarted(false)
+{
+	pthread_mutex_init(&sleepLock, NULL);
+	pthread_cond_init(&sleepCond, NULL);
+	pthread_mutex_init(&backgroundLock, NULL);
+	pthread_cond_init(&backgroundCond, NULL);
+	pthread_mutex_init(&arenaLock, NULL);
+}
+
+JobSystem::~JobSystem()
+{
+
+}
+
+//helper functions for the worker threads
+TH_ENTRY_POINT void* JobSystemHelper(void* queue)
+{
+	JobSystem::Ref().Worker((int)(size_t)queue);
+	return NULL;
+}
+
+TH_ENTRY_POINT void* JobSystemBackgroundHelper(void* obj)
+{
+	JobSystem *temp = (JobSystem*)obj;
+	temp->BackgroundWorker();
+	return NULL;
+}
+
+void JobSystem::Init(int threads)
+{
+	if (started)
+		return;
+	if (threads <= 0)
+		threads = Platform::GetCPUCount();
+	if (threads < 1)
+		threads = 1;
+	threadCount = threads;
+	shutdown = false;
+	started = true;
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		Queue *queue = new Queue();
+		pthread_mutex_init(&queue->lock, NULL);
+		queues.push_back(queue);
+	}
+	// the thread that waits on a group helps run it, so it counts as one of the threads
+	workers.resize(threadCount-1);
+	for (int i = 1; i < threadCount; i++)
+		pthread_create(&workers[i-1], NULL, &JobSystemHelper, (void*)(size_t)i);
+}
+
+void JobSystem::Shutdown()
+{
+	if (!started)
+		return;
+	// queued jobs are still run. Background jobs go first, they might queue more jobs for the workers
+	pthread_mutex_lock(&backgroundLock);
+	pthread_mutex_lock(&sleepLock);
+	shutdown = true;
+	pthread_mutex_unlock(&sleepLock);
+	pthread_cond_signal(&backgroundCond);
+	pthread_mutex_unlock(&backgroundLock);
+	if (backgroundStarted)
+	{
+		pthread_join(backgroundThread, NULL);
+		backgroundStarted = false;
+	}
+
+	pthread_mutex_lock(&sleepLock);
+	pthread_cond_broadcast(&sleepCond);
+	pthread_mutex_unlock(&sleepLock);
+	for (size_t i = 0; i < workers.size(); i++)
+		pthread_join(workers[i], NULL);
+	workers.clear();
+	while (RunOne(NULL))
+		;
+
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		pthread_mutex_destroy(&queues[i]->lock);
+		delete queues[i];
+	}
+	queues.clear();
+	pthread_mutex_lock(&arenaLock);
+	for (size_t i = 0; i < arenas.size(); i++)
+		delete arenas[i];
+	arenas.clear();
+	pthread_mutex_unlock(&arenaLock);
+	currentArena = NULL;
+	started = false;
+}
+
+void JobSystem::Push(Entry entry, bool wake)
+{
+	Queue *queue = queues[currentQueue];
+	pthread_mutex_lock(&queue->lock);
+	queue->entries.push_back(entry);
+	pthread_mutex_unlock(&queue->lock);
+
+	pthread_mutex_lock(&sleepLock);
+	pendingJobs++;
+	// threads waiting on a group sleep here too, so wake all of them
+	if (wake)
+		pthread_cond_broadcast(&sleepCond);
+	pthread_mutex_unlock(&sleepLock);
+}
+
+bool JobSystem::Pop(int queue, TaskGroup *group, Entry &entry)
+{
+	Queue *q = queues[queue];
+	pthread_mutex_lock(&q->lock);
+	if (q->entries.empty() || (group && q->entries.back().group != group))
+	{
+		pthread_mutex_unlock(&q->lock);
+		return false;
+	}
+	entry = q->entries.back();
+	q->entries.pop_back();
+	pthread_mutex_unlock(&q->lock);
+
+	pthread_mutex_lock(&sleepLock);
+	pendingJobs--;
+	pthread_mutex_unlock(&sleepLock);
+	return true;
+}
+
+bool JobSystem::Steal(int queue, Entry &entry)
+{
+	int count = queues.size();
+	for (int i = 1; i < count; i++)
+	{
+		Queue *q = queues[(queue+i) % count];
+		pthread_mutex_lock(&q->lock);
+		if (q->entries.empty())
+		{
+			pthread_mutex_unlock(&q->lock);
+			continue;
+		}
+		entry = q->entries.front();
+		q->entries.pop_front();
+		pthread_mutex_unlock(&q->lock);
+
+		pthread_mutex_lock(&sleepLock);
+		pendingJobs--;
+		pthread_mutex_unlock(&sleepLock);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::RunEntry(Entry entry)
+{
+	ScratchArena &arena = Scratch();
+	ScratchArena::Mark mark = arena.GetMark();
+	entry.job->Run();
+	delete entry.job;
+	arena.Release(mark);
+
+	if (entry.group)
+	{
+		entry.group->Finish();
+		// wake up anything waiting on the group
+		pthread_mutex_lock(&sleepLock);
+		pthread_cond_broadcast(&sleepCond);
+		pthread_mutex_unlock(&sleepLock);
+	}
+}
+
+void JobSystem::Worker(int queue)
+{
+	currentQueue = queue;
+	while (true)
+	{
+		Entry entry;
+		if (Pop(queue, NULL, entry) || Steal(queue, entry))
+		{
+			RunEntry(entry);
+			continue;
+		}
+
+		pthread_mutex_lock(&sleepLock);
+		while (!pendingJobs && !shutdown)
+			pthread_cond_wait(&sleepCond, &sleepLock);
+		bool stop = shutdown && !pendingJobs;
+		pthread_mutex_unlock(&sleepLock);
+		if (stop)
+			break;
+	}
+}
+
+void JobSystem::BackgroundWorker()
+{
+	pthread_mutex_lock(&backgroundLock);
+	while (true)
+	{
+		if (backgroundJobs.empty())
+		{
+			if (shutdown)
+				break;
+			pthread_cond_wait(&backgroundCond, &backgroundLock);
+			continue;
+		}
+		Entry entry = backgroundJobs.front();
+		backgroundJobs.pop_front();
+		pthread_mutex_unlock(&backgroundLock);
+
+		RunEntry(entry);
+
+		pthread_mutex_lock(&backgroundLock);
+	}
+	pthread_mutex_unlock(&backgroundLock);
+}
+
+void JobSystem::Submit(Job *job, TaskGroup *group)
+{
+	if (!started)
+		Init(0);
+	Entry entry;
+	entry.job = job;
+	entry.group = group;
+	if (group)
+		group->Add();
+	if (threadCount == 1)
+		RunEntry(entry);
+	else
+		Push(entry, true);
+}
+
+void JobSystem::RunInBackground(Job *job, TaskGroup *group)
+{
+	if (!started)
+		Init(0);
+	Entry entry;
+	entry.job = job;
+	entry.group = group;
+	if (group)
+		group->Add();
+
+	pthread_mutex_lock(&backgroundLock);
+	if (!backgroundStarted)
+	{
+		backgroundStarted = true;
+		pthread_create(&backgroundThread, NULL, &JobSystemBackgroundHelper, this);
+	}
+	backgroundJobs.push_back(entry);
+	pthread_cond_signal(&backgroundCond);
+	pthread_mutex_unlock(&backgroundLock);
+}
+
+bool JobSystem::RunOne(TaskGroup *group)
+{
+	if (!started)
+		return false;
+	Entry entry;
+	// other groups' jobs on our own queue go last. Steal never looks at our own queue, and queue 0 is shared by every
+	// thread that isn't a worker, so without this Wait would spin while those jobs were still queued
+	if (Pop(currentQueue, group, entry) || Steal(currentQueue, entry) || (group && Pop(currentQueue, NULL, entry)))
+	{
+		RunEntry(entry);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::Wait(TaskGroup *group)
+{
+	while (!group->Done())
+	{
+		if (RunOne(group))
+			continue;
+		// sleep until a job is queued or one of the group's jobs finishes
+		pthread_mutex_lock(&sleepLock);
+		if (!pendingJobs && !group->Done())
+			pthread_cond_wait(&sleepCond, &sleepLock);
+		pthread_mutex_unlock(&sleepLock);
+	}
+}
+
+void JobSystem::ParallelFor(int begin, int end, int grain, void (*func)(int start, int end, void *data), void *data)
+{
+	if (end <= begin)
+		return;
+	if (!started)
+		Init(0);
+	if (grain < 1)
+		grain = 1;
+	// a few chunks per thread, so threads that finish early can steal the rest
+	int chunks = (end-begin+grain-1)/grain;
+	if (chunks > threadCount*4)
+		chunks = threadCount*4;
+	if (chunks <= 1 || threadCount == 1)
+	{
+		func(begin, end, data);
+		return;
+	}
+
+	TaskGroup group;
+	int chunkSize = (end-begin+chunks-1)/chunks;
+	for (int start = begin+chunkSize; start < end; start += chunkSize)
+	{
+		Entry entry;
+		entry.job = new RangeJob(func, start, start+chunkSize < end ? start+chunkSize : end, data);
+		entry.group = &group;
+		group.Add();
+		Push(entry, false);
+	}
+	pthread_mutex_lock(&sleepLock);
+	pthread_cond_broadcast(&sleepCond);
+	pthread_mutex_unlock(&sleepLock);
+
+	func(begin, begin+chunkSize, data);
+	group.Wait();
+}
+
+ScratchArena &JobSystem::Scratch()
+{
+	if (!currentArena)
+	{
+		currentArena = new ScratchArena();
+		pthread_mutex_lock(&arenaLock);
+		arenas.push_back(currentArena);
+		pthread_mutex_unlock(&arenaLock);
+	}
+	return *currentArena;
+}
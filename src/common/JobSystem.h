@@ -0,0 +1,155 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include "common/tpt-thread.h"
+#include "common/Singleton.h"
+
+// Something to run on the job system. Jobs are allocated with new, and deleted by the job system after Run returns
+class Job
+{
+public:
+	virtual ~Job() {}
+	virtual void Run() = 0;
+};
+
+// Counts the unfinished jobs that were submitted with it, so they can be waited on together
+class TaskGroup
+{
+	pthread_mutex_t lock;
+	int pending;
+
+	friend class JobSystem;
+	void Add();
+	void Finish();
+
+public:
+	TaskGroup();
+	~TaskGroup();
+
+	// true if every job in the group has finished. Never blocks
+	bool Done();
+	// runs jobs until every job in the group has finished, this group's own jobs first
+	void Wait();
+};
+
+// Bump allocator for temporary memory. Each thread has its own, see JobSystem::Scratch
+class ScratchArena
+{
+	struct Block
+	{
+		char *data;
+		size_t size;
+	};
+	std::vector<Block> blocks;
+	size_t current, used;
+
+public:
+	struct Mark
+	{
+		size_t block, used;
+	};
+
+	ScratchArena();
+	~ScratchArena();
+
+	// 16 byte aligned, valid until the arena is released to an earlier mark
+	void *Alloc(size_t size);
+	Mark GetMark();
+	// frees everything allocated after mark was taken, the memory is kept for reuse
+	void Release(Mark mark);
+};
+
+// Shared pool of worker threads, sized from the CPU count. Each thread has its own queue of jobs, new jobs go to the
+// end of the submitting thread's queue and are taken from there first, idle threads steal from the front of the
+// other queues. Threads that aren't workers (the main thread) all share one queue.
+// Jobs must not block for long, use RunInBackground for jobs that mostly wait on something else
+class JobSystem : public Singleton<JobSystem>
+{
+	struct Entry
+	{
+		Job *job;
+		TaskGroup *group;
+	};
+	struct Queue
+	{
+		pthread_mutex_t lock;
+		std::deque<Entry> entries;
+	};
+
+	int threadCount;
+	bool started, shutdown;
+	std::vector<pthread_t> workers;
+	// queues[0] is shared by every thread that isn't a worker
+	std::vector<Queue*> queues;
+
+	// sleeping workers wait here until pendingJobs isn't 0
+	pthread_mutex_t sleepLock;
+	pthread_cond_t sleepCond;
+	int pendingJobs;
+
+	// jobs that wait on I/O get their own thread, so they never hold up a worker
+	pthread_t backgroundThread;
+	pthread_mutex_t backgroundLock;
+	pthread_cond_t backgroundCond;
+	std::deque<Entry> backgroundJobs;
+	bool backgroundStarted;
+
+	std::vector<ScratchArena*> arenas;
+	pthread_mutex_t arenaLock;
+
+	void Push(Entry entry, bool wake);
+	bool Pop(int queue, TaskGroup *group, Entry &entry);
+	bool Steal(int queue, Entry &entry);
+	void RunEntry(Entry entry);
+
+public:
+	JobSystem();
+	~JobSystem();
+
+	// starts the workers. threads is the total number of threads running jobs including the calling thread, 0 uses
+	// the number of CPUs. Called automatically with 0 on first use
+	void Init(int threads);
+	void Shutdown();
+	void Worker(int queue);
+	void BackgroundWorker();
+
+	int GetThreadCount() { return threadCount; }
+
+	// group can be NULL. With only one thread, the job is run right away on the calling thread
+	void Submit(Job *job, TaskGroup *group);
+	// runs the job on the background thread, in submission order. group can be NULL. Jobs that don't return until
+	// shutdown would hold up every job after them, those need their own thread
+	void RunInBackground(Job *job, TaskGroup *group);
+	// runs one queued job on the calling thread, preferring group's jobs from its own queue. Returns false if there
+	// was nothing to run
+	bool RunOne(TaskGroup *group);
+	// see TaskGroup::Wait
+	void Wait(TaskGroup *group);
+
+	// calls func(start, end, data) for chunks of [begin, end) of at least grain items on all threads, and returns
+	// once all of them are done
+	void ParallelFor(int begin, int end, int grain, void (*func)(int start, int end, void *data), void *data);
+
+	// the calling thread's scratch arena. Anything a job allocates from it is freed when the job returns
+	ScratchArena &Scratch();
+};
+
+#endif
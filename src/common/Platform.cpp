@@ -10,7 +10,11 @@
 #include <windows.h>
 #include <direct.h>
 #else
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 #endif
 
 #ifdef MACOSX
@@ -29,6 +33,7 @@
 
 #include "Platform.h"
 #include "defines.h"
+#include "game/SaveWriter.h"
 
 namespace Platform
 {
@@ -91,6 +96,8 @@ void DoRestart(bool saveTab)
 		sys_pause = true;
 		tab_save(tab_num, 0);
 	}
+	//tabs are written in the background, make sure they are all on disk before restarting
+	SaveWriter::Ref().Flush();
 #ifdef ANDROID
 	SDL_ANDROID_RestartMyself("");
 	exit(-1);
@@ -141,6 +148,86 @@ void Millisleep(long int t)
 #endif
 }
 
+double GetTime()
+{
+#ifdef WIN
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart/frequency.QuadPart;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec/1000000.0;
+#endif
+}
+
+int GetCPUCount()
+{
+#ifdef WIN
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo(&sysinfo);
+	return sysinfo.dwNumberOfProcessors;
+#else
+	int count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? count : 1;
+#endif
+}
+
+const char *MapFile(const char *path, size_t *size)
+{
+	*size = 0;
+#ifdef WIN
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+	DWORD fileSize = GetFileSize(file, NULL);
+	if (fileSize == INVALID_FILE_SIZE || !fileSize)
+	{
+		CloseHandle(file);
+		return NULL;
+	}
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping)
+		return NULL;
+	// the view keeps the mapping open
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!data)
+		return NULL;
+	*size = fileSize;
+	return (const char*)data;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	struct stat info;
+	if (fstat(fd, &info) || info.st_size <= 0)
+	{
+		close(fd);
+		return NULL;
+	}
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+	*size = info.st_size;
+	return (const char*)data;
+#endif
+}
+
+void UnmapFile(const char *data, size_t size)
+{
+	if (!data)
+		return;
+#ifdef WIN
+	UnmapViewOfFile(data);
+#else
+	munmap((void*)data, size);
+#endif
+}
+
 void LoadFileInResource(int name, int type, unsigned int& size, const char*& data)
 {
 #ifdef _MSC_VER
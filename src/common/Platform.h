@@ -1,6 +1,7 @@
 #ifndef PLATFORM_H
 #define PLATFORM_H
 
+#include <cstddef>
 #include <string>
 
 namespace Platform
@@ -9,6 +10,13 @@ namespace Platform
 	void DoRestart(bool saveTab);
 	void OpenLink(std::string uri);
 	void Millisleep(long int t);
+	// high resolution time in seconds, only useful for measuring intervals
+	double GetTime();
+	int GetCPUCount();
+	// maps a whole file into memory, read only. Returns NULL if it couldn't be mapped or is empty. The file can't be
+	// changed or deleted on Windows while it is mapped
+	const char *MapFile(const char *path, size_t *size);
+	void UnmapFile(const char *data, size_t size);
 	void LoadFileInResource(int name, int type, unsigned int& size, const char*& data);
 	bool RegisterExtension();
 	bool ShowOnScreenKeyboard(const char *str, bool autoCorrect = true);
@@ -16,6 +16,7 @@
 #include <numeric>
 #include <cstdlib>
 #include "Probability.h"
+#include "tpt-rand.h"
 
 namespace Probability
 {
@@ -27,7 +28,7 @@ float binomial_gte1(int n, float p)
 
 float randFloat()
 {
-	return static_cast<float>(rand())/RAND_MAX;
+	return static_cast<float>(tpt_rand())/RAND_MAX;
 }
 
 SmallKBinomialGenerator::SmallKBinomialGenerator(unsigned int n, float p, unsigned int maxK_)
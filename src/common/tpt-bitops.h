@@ -0,0 +1,52 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TPT_BITOPS_H
+#define TPT_BITOPS_H
+
+#include "common/tpt-stdint.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// index of the lowest set bit, a must not be 0
+inline int tpt_ctz64(uint64_t a)
+{
+#ifdef _MSC_VER
+	unsigned long i;
+	if (_BitScanForward(&i, (unsigned long)a))
+		return i;
+	_BitScanForward(&i, (unsigned long)(a>>32));
+	return i+32;
+#else
+	return __builtin_ctzll(a);
+#endif
+}
+
+// index of the highest set bit, a must not be 0
+inline int tpt_msb64(uint64_t a)
+{
+#ifdef _MSC_VER
+	unsigned long i;
+	if (_BitScanReverse(&i, (unsigned long)(a>>32)))
+		return i+32;
+	_BitScanReverse(&i, (unsigned long)a);
+	return i;
+#else
+	return 63-__builtin_clzll(a);
+#endif
+}
+
+#endif
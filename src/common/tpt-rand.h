@@ -0,0 +1,40 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TPT_RAND_H
+#define TPT_RAND_H
+
+#include <cstdlib>
+#include "tpt-tls.h"
+
+// rand() for simulation code. A simulation with its own generator (Simulation::SeedRandom) points this at its state in
+// MakeCurrent, so simulations ticked on different threads each get their own repeatable sequence. Otherwise it is NULL
+// and rand() is used, so the main simulation plays out the same way it always has
+extern TPT_THREAD_LOCAL unsigned int *currentRandState;
+
+inline int tpt_rand()
+{
+	if (!currentRandState)
+		return rand();
+	// xorshift32, the state is never 0
+	unsigned int x = *currentRandState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*currentRandState = x;
+	return (int)(x & RAND_MAX);
+}
+
+#endif
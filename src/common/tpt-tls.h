@@ -0,0 +1,26 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TPT_TLS_H
+#define TPT_TLS_H
+
+// thread local storage for plain variables (pointers, ints, POD arrays). No constructors allowed
+#ifdef _MSC_VER
+#define TPT_THREAD_LOCAL __declspec(thread)
+#else
+#define TPT_THREAD_LOCAL __thread
+#endif
+
+#endif
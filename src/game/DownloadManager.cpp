@@ -38,7 +38,11 @@ void DownloadManager::Shutdown()
 	managerShutdown = true;
 	pthread_mutex_unlock(&downloadAddLock);
 	pthread_mutex_unlock(&downloadLock);
-	pthread_join(downloadThread, NULL);
+	if (threadStarted)
+	{
+		pthread_join(downloadThread, NULL);
+		threadStarted = false;
+	}
 }
 
 //helper function for download
@@ -51,8 +55,8 @@ TH_ENTRY_POINT void* DownloadManagerHelper(void* obj)
 
 void DownloadManager::Start()
 {
-	managerRunning = true;
 	lastUsed = time(NULL);
+	threadStarted = true;
 	pthread_create(&downloadThread, NULL, &DownloadManagerHelper, this);
 }
 
@@ -114,16 +118,18 @@ void DownloadManager::Update()
 
 void DownloadManager::EnsureRunning()
 {
+	// only one caller sees managerRunning go from false to true, so only that one restarts the thread. The join
+	// happens after unlocking, the old thread might still need downloadLock on its way out
 	pthread_mutex_lock(&downloadLock);
-	if (!managerRunning)
-	{
-		if (threadStarted)
-			pthread_join(downloadThread, NULL);
-		else
-			threadStarted = true;
-		Start();
-	}
+	bool start = !managerRunning && !managerShutdown;
+	managerRunning = true;
 	pthread_mutex_unlock(&downloadLock);
+	if (!start)
+		return;
+	// the last thread has stopped updating, and is only returning
+	if (threadStarted)
+		pthread_join(downloadThread, NULL);
+	Start();
 }
 
 void DownloadManager::AddDownload(Download *download)
@@ -9,6 +9,8 @@ class Download;
 class DownloadManager : public Singleton<DownloadManager>
 {
 private:
+	// Update runs on its own thread until there's nothing left to download. It polls for minutes at a time, so it
+	// can't go on the job system's background thread without holding up everything else there
 	pthread_t downloadThread;
 	pthread_mutex_t downloadLock;
 	pthread_mutex_t downloadAddLock;
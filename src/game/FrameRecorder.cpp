@@ -0,0 +1,393 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#ifdef WIN
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "FrameRecorder.h"
+#include "defines.h"
+
+#define RECORDINGS_DIR "recordings"
+
+FrameRecorder::FrameRecorder():
+	threadStarted(false),
+	shuttingDown(false),
+	current(NULL)
+{
+	pthread_mutex_init(&ringLock, NULL);
+	pthread_cond_init(&ringCond, NULL);
+}
+
+FrameRecorder::~FrameRecorder()
+{
+
+}
+
+//helper function for the worker thread
+TH_ENTRY_POINT void* FrameRecorderHelper(void* obj)
+{
+	FrameRecorder *temp = (FrameRecorder*)obj;
+	temp->Worker();
+	return NULL;
+}
+
+static void PutInt(std::vector<unsigned char> &data, unsigned int value)
+{
+	data.push_back(value);
+	data.push_back(value>>8);
+	data.push_back(value>>16);
+	data.push_back(value>>24);
+}
+
+static bool MakeDirectory(const std::string &path)
+{
+#ifdef WIN
+	return !_mkdir(path.c_str());
+#else
+	return !mkdir(path.c_str(), 0755);
+#endif
+}
+
+static void FreeFrames(pixel **frames)
+{
+	for (int i = 0; i < RECORDER_RING_FRAMES; i++)
+	{
+		free(frames[i]);
+		frames[i] = NULL;
+	}
+}
+
+// <date>-<time>-<n>, where n counts the recordings started in the same second, like stamp_gen_name
+static std::string RecordingName()
+{
+	static time_t lastTime = 0;
+	static int lastNumber = 0;
+	time_t now = time(NULL);
+	if (now != lastTime)
+	{
+		lastTime = now;
+		lastNumber = 0;
+	}
+	else
+		lastNumber++;
+
+	char timeString[32], name[48];
+	strftime(timeString, sizeof(timeString), "%Y%m%d-%H%M%S", localtime(&now));
+	sprintf(name, "%s-%02d", timeString, lastNumber);
+	return name;
+}
+
+std::string FrameRecorder::Start(Format format, int every, int x, int y, int w, int h)
+{
+	// the last recording is finished by the worker after this one is started
+	Stop();
+
+	// clip the region to the screen
+	if (x < 0)
+	{
+		w += x;
+		x = 0;
+	}
+	if (y < 0)
+	{
+		h += y;
+		y = 0;
+	}
+	if (x+w > XRES+BARSIZE)
+		w = XRES+BARSIZE-x;
+	if (y+h > YRES+MENUSIZE)
+		h = YRES+MENUSIZE-y;
+	if (w <= 0 || h <= 0 || w > 65535 || h > 65535 || every < 1)
+	{
+		error = "Invalid recording region";
+		return "";
+	}
+
+	// allocate the frames before anything is created on disk
+	pixel *frames[RECORDER_RING_FRAMES] = {};
+	for (int i = 0; i < RECORDER_RING_FRAMES; i++)
+	{
+		frames[i] = (pixel*)malloc(w*h*PIXELSIZE);
+		if (!frames[i])
+		{
+			FreeFrames(frames);
+			error = "Not enough memory to record";
+			return "";
+		}
+	}
+
+	if (!MakeDirectory(RECORDINGS_DIR) && errno != EEXIST)
+	{
+		error = "Could not create the " RECORDINGS_DIR " directory: " + std::string(strerror(errno));
+		FreeFrames(frames);
+		return "";
+	}
+	// skip names that are already taken, by a recording from an earlier session
+	std::string newName, path;
+	for (int tries = 0; ; tries++)
+	{
+		if (tries == 100)
+		{
+			error = "Could not find an unused recording name";
+			FreeFrames(frames);
+			return "";
+		}
+		newName = RecordingName();
+		path = RECORDINGS_DIR PATH_SEP + newName;
+		if (format == FORMAT_PNG)
+		{
+			if (MakeDirectory(path))
+				break;
+			if (errno != EEXIST)
+			{
+				error = "Could not create " + path + ": " + std::string(strerror(errno));
+				FreeFrames(frames);
+				return "";
+			}
+		}
+		else
+		{
+			FILE *existing = fopen((path + ".tptr").c_str(), "rb");
+			if (!existing)
+				break;
+			fclose(existing);
+		}
+	}
+
+	FILE *deltaFile = NULL;
+	if (format == FORMAT_DELTA)
+	{
+		deltaFile = fopen((path + ".tptr").c_str(), "wb");
+		if (!deltaFile)
+		{
+			error = "Could not create " + path + ".tptr";
+			FreeFrames(frames);
+			return "";
+		}
+		unsigned char header[9] = {'T', 'P', 'T', 'R', 1, (unsigned char)w, (unsigned char)(w>>8), (unsigned char)h, (unsigned char)(h>>8)};
+		fwrite(header, sizeof(header), 1, deltaFile);
+	}
+
+	Recording *rec = new Recording();
+	rec->format = format;
+	rec->name = newName;
+	rec->every = every;
+	rec->x = x;
+	rec->y = y;
+	rec->w = w;
+	rec->h = h;
+	for (int i = 0; i < RECORDER_RING_FRAMES; i++)
+		rec->frames[i] = frames[i];
+	rec->captureCount = 0;
+	rec->first = rec->queued = 0;
+	rec->stopping = rec->finished = false;
+	rec->recordedFrames = rec->droppedFrames = 0;
+	rec->deltaFile = deltaFile;
+	if (format == FORMAT_DELTA)
+		rec->previousFrame.assign(w*h, PIXRGB(0, 0, 0));
+
+	pthread_mutex_lock(&ringLock);
+	// current is replaced below, so the only one the main thread still looks at is the new one
+	for (std::deque<Recording*>::iterator it = recordings.begin(); it != recordings.end(); )
+	{
+		if ((*it)->finished)
+		{
+			delete *it;
+			it = recordings.erase(it);
+		}
+		else
+			++it;
+	}
+	recordings.push_back(rec);
+	pthread_cond_signal(&ringCond);
+	pthread_mutex_unlock(&ringLock);
+	current = rec;
+
+	if (!threadStarted)
+	{
+		threadStarted = true;
+		pthread_create(&workerThread, NULL, &FrameRecorderHelper, this);
+	}
+	return newName;
+}
+
+void FrameRecorder::Stop()
+{
+	if (!current || current->stopping)
+		return;
+	pthread_mutex_lock(&ringLock);
+	current->stopping = true;
+	pthread_cond_signal(&ringCond);
+	pthread_mutex_unlock(&ringLock);
+}
+
+void FrameRecorder::Shutdown()
+{
+	Stop();
+	if (threadStarted)
+	{
+		pthread_mutex_lock(&ringLock);
+		shuttingDown = true;
+		pthread_cond_signal(&ringCond);
+		pthread_mutex_unlock(&ringLock);
+		pthread_join(workerThread, NULL);
+		threadStarted = false;
+	}
+	for (size_t i = 0; i < recordings.size(); i++)
+		delete recordings[i];
+	recordings.clear();
+	current = NULL;
+}
+
+void FrameRecorder::Capture(pixel *vid, int pitch)
+{
+	Recording *rec = current;
+	if (!rec || rec->stopping)
+		return;
+	int frameNumber = rec->captureCount++;
+	if (frameNumber % rec->every)
+		return;
+
+	pthread_mutex_lock(&ringLock);
+	if (rec->queued == RECORDER_RING_FRAMES)
+	{
+		// the worker is behind, never wait for it
+		rec->droppedFrames++;
+		pthread_mutex_unlock(&ringLock);
+		return;
+	}
+	int slot = (rec->first+rec->queued) % RECORDER_RING_FRAMES;
+	pthread_mutex_unlock(&ringLock);
+
+	// the slot isn't the worker's until queued is increased
+	for (int j = 0; j < rec->h; j++)
+		memcpy(rec->frames[slot]+j*rec->w, vid+(rec->y+j)*pitch+rec->x, rec->w*PIXELSIZE);
+
+	pthread_mutex_lock(&ringLock);
+	rec->frameNumbers[slot] = frameNumber;
+	rec->queued++;
+	pthread_cond_signal(&ringCond);
+	pthread_mutex_unlock(&ringLock);
+}
+
+// called by the worker without ringLock once a recording is stopped and all its frames are written
+void FrameRecorder::Finish(Recording *rec)
+{
+	if (rec->deltaFile)
+	{
+		fclose(rec->deltaFile);
+		rec->deltaFile = NULL;
+	}
+	FreeFrames(rec->frames);
+	rec->previousFrame.clear();
+}
+
+void FrameRecorder::Worker()
+{
+	pthread_mutex_lock(&ringLock);
+	while (true)
+	{
+		Recording *rec = NULL;
+		for (size_t i = 0; i < recordings.size() && !rec; i++)
+			if (!recordings[i]->finished)
+				rec = recordings[i];
+		if (!rec || (!rec->queued && !rec->stopping))
+		{
+			if (!rec && shuttingDown)
+				break;
+			pthread_cond_wait(&ringCond, &ringLock);
+			continue;
+		}
+		if (!rec->queued)
+		{
+			pthread_mutex_unlock(&ringLock);
+			Finish(rec);
+			pthread_mutex_lock(&ringLock);
+			rec->finished = true;
+			continue;
+		}
+		int slot = rec->first;
+		pthread_mutex_unlock(&ringLock);
+
+		WriteFrame(rec, rec->frames[slot], rec->frameNumbers[slot]);
+
+		pthread_mutex_lock(&ringLock);
+		rec->first = (rec->first+1) % RECORDER_RING_FRAMES;
+		rec->queued--;
+		rec->recordedFrames++;
+	}
+	pthread_mutex_unlock(&ringLock);
+}
+
+void FrameRecorder::WriteFrame(Recording *rec, pixel *frame, int frameNumber)
+{
+	int w = rec->w, h = rec->h;
+	if (rec->format == FORMAT_PNG)
+	{
+		int size;
+		void *png = png_pack(frame, w, h, &size);
+		if (!png)
+			return;
+		char filename[32];
+		sprintf(filename, "frame%05d.png", frameNumber);
+		FILE *f = fopen((RECORDINGS_DIR PATH_SEP + rec->name + PATH_SEP + filename).c_str(), "wb");
+		if (f)
+		{
+			fwrite(png, size, 1, f);
+			fclose(f);
+		}
+		free(png);
+		return;
+	}
+
+	// delta format, runs of unchanged and changed pixels
+	const pixel mask = PIXRGB(255, 255, 255);
+	int count = w*h;
+	deltaData.clear();
+	PutInt(deltaData, frameNumber);
+	PutInt(deltaData, 0); // size, filled in below
+	for (int i = 0; i < count; )
+	{
+		int start = i;
+		while (i < count && !((frame[i]^rec->previousFrame[i])&mask))
+			i++;
+		PutInt(deltaData, i-start);
+		start = i;
+		while (i < count && ((frame[i]^rec->previousFrame[i])&mask))
+			i++;
+		PutInt(deltaData, i-start);
+		for (int j = start; j < i; j++)
+		{
+			deltaData.push_back(PIXR(frame[j]));
+			deltaData.push_back(PIXG(frame[j]));
+			deltaData.push_back(PIXB(frame[j]));
+			rec->previousFrame[j] = frame[j];
+		}
+	}
+	unsigned int size = deltaData.size()-8;
+	deltaData[4] = size;
+	deltaData[5] = size>>8;
+	deltaData[6] = size>>16;
+	deltaData[7] = size>>24;
+	fwrite(&deltaData[0], deltaData.size(), 1, rec->deltaFile);
+}
+
+int FrameRecorder::GetRecordedFrames()
+{
+	pthread_mutex_lock(&ringLock);
+	int ret = current ? current->recordedFrames : 0;
+	pthread_mutex_unlock(&ringLock);
+	return ret;
+}
+
+int FrameRecorder::GetDroppedFrames()
+{
+	pthread_mutex_lock(&ringLock);
+	int ret = current ? current->droppedFrames : 0;
+	pthread_mutex_unlock(&ringLock);
+	return ret;
+}
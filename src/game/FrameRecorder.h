@@ -0,0 +1,96 @@
+#ifndef FRAMERECORDER_H
+#define FRAMERECORDER_H
+
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+#include "common/tpt-thread.h"
+#include "common/Singleton.h"
+#include "graphics/Pixel.h"
+
+// number of preallocated frames waiting to be written. When all of them are full, new frames are dropped
+#define RECORDER_RING_FRAMES 32
+
+// Records the screen into recordings/ without slowing down the game. Capture copies a region of the screen into a
+// ring of preallocated frames, and a worker thread encodes and writes them, so the main loop never waits on disk.
+// Starting a new recording doesn't wait for the last one either, the worker writes them one after another.
+// All public functions must be called from the main thread
+class FrameRecorder : public Singleton<FrameRecorder>
+{
+public:
+	enum Format
+	{
+		// recordings/<name>/frame00000.png, ...
+		FORMAT_PNG,
+		// recordings/<name>.tptr: "TPTR", version byte, u16 width and height. Then for each frame u32 frame number,
+		// u32 data size, and runs of (u32 unchanged pixels, u32 changed pixels, RGB of the changed pixels) that
+		// cover the whole frame. The first frame is compared against a black frame. All numbers are little endian
+		FORMAT_DELTA
+	};
+
+private:
+	struct Recording
+	{
+		// only changed before the recording is added to recordings
+		Format format;
+		std::string name;
+		int every, x, y, w, h;
+		pixel *frames[RECORDER_RING_FRAMES]; // freed by the worker when it is finished
+		int frameNumbers[RECORDER_RING_FRAMES];
+		int captureCount; // frames seen by Capture, every'th one is recorded
+
+		// only accessed with ringLock held. Slots [first, first+queued) belong to the worker
+		int first, queued;
+		bool stopping; // also read by the main thread without the lock, it is the only one that changes it
+		bool finished; // all frames are written and the file is closed
+		int recordedFrames, droppedFrames;
+
+		// only used by the worker
+		FILE *deltaFile;
+		std::vector<pixel> previousFrame;
+	};
+
+	pthread_t workerThread;
+	pthread_mutex_t ringLock;
+	pthread_cond_t ringCond;
+	bool threadStarted;
+
+	// only accessed with ringLock held. Oldest first, the worker writes the first one that isn't finished.
+	// Finished ones are deleted by the main thread
+	std::deque<Recording*> recordings;
+	bool shuttingDown;
+	// the newest recording, which Capture adds to until it is stopped. Only changed by the main thread
+	Recording *current;
+	std::string error;
+
+	// only used by the worker
+	std::vector<unsigned char> deltaData;
+
+	void WriteFrame(Recording *rec, pixel *frame, int frameNumber);
+	void Finish(Recording *rec);
+
+public:
+	FrameRecorder();
+	~FrameRecorder();
+
+	void Worker();
+	void Shutdown();
+
+	// starts a new recording of the (x, y, w, h) region of the screen, keeping every n'th frame. A recording that is
+	// still going is stopped. Returns the recording name, or an empty string if it couldn't be started (see GetError)
+	std::string Start(Format format, int every, int x, int y, int w, int h);
+	// stops capturing, frames that were already captured are still written in the background
+	void Stop();
+	bool IsRecording() { return current && !current->stopping; }
+	// call once per frame with the finished screen, copies the region if this frame is recorded
+	void Capture(pixel *vid, int pitch);
+
+	// of the newest recording
+	int GetRecordedFrames();
+	int GetDroppedFrames();
+	// why the last Start failed
+	std::string GetError() { return error; }
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cstdlib>
+#include "SaveWriter.h"
+#include "defines.h"
+#include "misc.h"
+#include "save.h"
+
+SaveWriter::SaveWriter():
+	writerRunning(false)
+{
+	pthread_mutex_init(&jobLock, NULL);
+	pthread_cond_init(&doneCond, NULL);
+}
+
+SaveWriter::~SaveWriter()
+{
+
+}
+
+class SaveWriterJob : public Job
+{
+	SaveWriter *writer;
+
+public:
+	SaveWriterJob(SaveWriter *writer):
+		writer(writer)
+	{
+
+	}
+
+	virtual void Run()
+	{
+		writer->Worker();
+	}
+};
+
+void SaveWriter::Worker()
+{
+	pthread_mutex_lock(&jobLock);
+	while (!jobQueue.empty())
+	{
+		WriteJob job = jobQueue.front();
+		jobQueue.pop_front();
+		writingFile = job.filename;
+		pthread_mutex_unlock(&jobLock);
+
+		WriteFile(job);
+
+		pthread_mutex_lock(&jobLock);
+		writingFile.clear();
+		pthread_cond_broadcast(&doneCond);
+	}
+	writerRunning = false;
+	pthread_mutex_unlock(&jobLock);
+}
+
+void SaveWriter::WriteFile(WriteJob job)
+{
+	int compressedSize;
+	void *compressedData = compress_save(job.data, job.size, &compressedSize);
+	free(job.data);
+	if (!compressedData)
+		return;
+
+	FILE *f = fopen(job.filename.c_str(), "wb");
+	if (f)
+	{
+		fwrite(compressedData, compressedSize, 1, f);
+		fclose(f);
+	}
+	free(compressedData);
+}
+
+void SaveWriter::Write(std::string filename, void *data, int size)
+{
+	pthread_mutex_lock(&jobLock);
+	bool replaced = false;
+	for (std::deque<WriteJob>::iterator iter = jobQueue.begin(), end = jobQueue.end(); iter != end; ++iter)
+		if (iter->filename == filename)
+		{
+			free(iter->data);
+			iter->data = data;
+			iter->size = size;
+			replaced = true;
+			break;
+		}
+	if (!replaced)
+	{
+		WriteJob job;
+		job.filename = filename;
+		job.data = data;
+		job.size = size;
+		jobQueue.push_back(job);
+	}
+	bool startWriter = !writerRunning;
+	writerRunning = true;
+	pthread_mutex_unlock(&jobLock);
+
+	// the job might run right away on this thread, so jobLock can't be held here
+	if (startWriter)
+		JobSystem::Ref().Submit(new SaveWriterJob(this), &writerJob);
+}
+
+void SaveWriter::Cancel(std::string filename)
+{
+	pthread_mutex_lock(&jobLock);
+	for (std::deque<WriteJob>::iterator iter = jobQueue.begin(); iter != jobQueue.end(); )
+	{
+		if (iter->filename == filename)
+		{
+			free(iter->data);
+			iter = jobQueue.erase(iter);
+		}
+		else
+			++iter;
+	}
+	while (writingFile == filename)
+		pthread_cond_wait(&doneCond, &jobLock);
+	pthread_mutex_unlock(&jobLock);
+}
+
+void SaveWriter::Flush()
+{
+	writerJob.Wait();
+}
+
+void SaveWriter::Shutdown()
+{
+	// saves that haven't been started yet are dropped, Flush first to keep them
+	pthread_mutex_lock(&jobLock);
+	for (std::deque<WriteJob>::iterator iter = jobQueue.begin(), end = jobQueue.end(); iter != end; ++iter)
+		free(iter->data);
+	jobQueue.clear();
+	pthread_mutex_unlock(&jobLock);
+	writerJob.Wait();
+}
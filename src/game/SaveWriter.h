@@ -0,0 +1,49 @@
+#ifndef SAVEWRITER_H
+#define SAVEWRITER_H
+
+#include <deque>
+#include <string>
+#include "common/tpt-thread.h"
+#include "common/JobSystem.h"
+#include "common/Singleton.h"
+
+// Compresses saves and writes them to disk on the job system, so saving tabs doesn't block the game.
+// Saves must be made with build_save(..., compress = false). All public functions must be called from the main thread
+class SaveWriter : public Singleton<SaveWriter>
+{
+	struct WriteJob
+	{
+		std::string filename;
+		void *data;
+		int size;
+	};
+
+	// one job at a time writes everything in jobQueue, so saves are written in order
+	TaskGroup writerJob;
+	pthread_mutex_t jobLock;
+	pthread_cond_t doneCond;
+
+	// only accessed with jobLock held
+	std::deque<WriteJob> jobQueue;
+	std::string writingFile;
+	bool writerRunning;
+
+	static void WriteFile(WriteJob job);
+
+public:
+	SaveWriter();
+	~SaveWriter();
+
+	void Worker();
+	// saves that haven't been started yet are dropped
+	void Shutdown();
+
+	// takes ownership of data. Replaces any queued save for the same file that hasn't been started yet
+	void Write(std::string filename, void *data, int size);
+	// removes a queued save for filename, or waits for it if it is being written right now
+	void Cancel(std::string filename);
+	// waits until everything has been written
+	void Flush();
+};
+
+#endif
@@ -0,0 +1,663 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef WIN
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "StampPack.h"
+#include "defines.h"
+#include "misc.h"
+#include "save.h"
+#include "common/Platform.h"
+#include "simulation/Simulation.h"
+
+// File format, all numbers are little endian:
+// header: "TPSP", u32 version, u32 index offset, u32 number of stamps
+// then blocks of save data and thumbnails, referenced from the index. Thumbnails are 8 bit RGB, row by row
+// index: for each stamp, 64 bytes:
+//   name (12 bytes, 0 padded), u32 data offset, u32 data size, u32 thumbnail offset (0 if there is none),
+//   u16 thumbnail width, u16 thumbnail height, u16 save width, u16 save height, u32 particle count,
+//   u16 top element types[4], u32 top element counts[4], u32 reserved
+// Changes write the new blocks and a new index at the end of the file, and then point the header at the new index.
+// Anything that isn't referenced from the current index is unused, and the file is rewritten once that is over half
+#define STAMPPACK_PATH "stamps" PATH_SEP "stamps.pack"
+#define STAMPPACK_TEMP_PATH "stamps" PATH_SEP "stamps.pack.tmp"
+#define STAMPPACK_BACKUP_PATH "stamps" PATH_SEP "stamps.pack.bak"
+#define STAMPPACK_MAGIC "TPSP"
+#define STAMPPACK_VERSION 1
+#define STAMPPACK_HEADER_SIZE 16
+#define STAMPPACK_ENTRY_SIZE 64
+#define STAMPPACK_NAME_SIZE 12
+// small packs are never rewritten
+#define STAMPPACK_COMPACT_SIZE (1<<20)
+
+StampPack::StampPack():
+	opened(false),
+	orderChanged(false),
+	fileData(NULL),
+	fileSize(0)
+{
+	pthread_mutex_init(&resultLock, NULL);
+}
+
+StampPack::~StampPack()
+{
+
+}
+
+static void PutShort(std::vector<unsigned char> &data, unsigned int value)
+{
+	data.push_back(value);
+	data.push_back(value>>8);
+}
+
+static void PutInt(std::vector<unsigned char> &data, unsigned int value)
+{
+	data.push_back(value);
+	data.push_back(value>>8);
+	data.push_back(value>>16);
+	data.push_back(value>>24);
+}
+
+static unsigned int GetShort(const unsigned char *data)
+{
+	return data[0] | (data[1]<<8);
+}
+
+static unsigned int GetInt(const unsigned char *data)
+{
+	return data[0] | (data[1]<<8) | (data[2]<<16) | ((unsigned int)data[3]<<24);
+}
+
+// header of an empty pack
+static bool WriteHeader(FILE *f)
+{
+	std::vector<unsigned char> header;
+	header.insert(header.end(), STAMPPACK_MAGIC, STAMPPACK_MAGIC+4);
+	PutInt(header, STAMPPACK_VERSION);
+	PutInt(header, STAMPPACK_HEADER_SIZE);
+	PutInt(header, 0);
+	return fwrite(&header[0], header.size(), 1, f) == 1;
+}
+
+static bool FileExists(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f)
+		return false;
+	fclose(f);
+	return true;
+}
+
+class StampThumbnailJob : public Job
+{
+	StampPack::ThumbnailResult *result;
+	void *data;
+	int size;
+	Simulation *sim;
+
+public:
+	StampThumbnailJob(StampPack::ThumbnailResult *result, void *data, int size, Simulation *sim):
+		result(result),
+		data(data),
+		size(size),
+		sim(sim)
+	{
+
+	}
+
+	virtual void Run()
+	{
+		int *counts = (int*)JobSystem::Ref().Scratch().Alloc(PT_NUM*sizeof(int));
+		memset(counts, 0, PT_NUM*sizeof(int));
+		memset(&result->info, 0, sizeof(result->info));
+
+		// prerender_save reads element colors through globalSim
+		Simulation *oldSim = globalSim;
+		globalSim = sim;
+		int imgw, imgh;
+		pixel *img = prerender_save(data, size, &imgw, &imgh, counts);
+		globalSim = oldSim;
+		free(data);
+
+		if (img)
+		{
+			result->info.width = imgw;
+			result->info.height = imgh;
+			if (imgw > XRES/GRID_S || imgh > YRES/GRID_S)
+			{
+				int factor_x = (imgw+XRES/GRID_S-1)/(XRES/GRID_S);
+				int factor_y = (imgh+YRES/GRID_S-1)/(YRES/GRID_S);
+				if (factor_y > factor_x)
+					factor_x = factor_y;
+				pixel *tmp = rescale_img(img, imgw, imgh, &imgw, &imgh, factor_x);
+				free(img);
+				img = tmp;
+			}
+
+			for (int t = 1; t < PT_NUM; t++)
+				result->info.particleCount += counts[t];
+			for (int i = 0; i < STAMP_TOP_ELEMENTS; i++)
+			{
+				int best = 0;
+				for (int t = 1; t < PT_NUM; t++)
+					if (counts[t] > counts[best])
+						best = t;
+				if (!counts[best])
+					break;
+				result->info.topTypes[i] = best;
+				result->info.topCounts[i] = counts[best];
+				counts[best] = 0;
+			}
+		}
+		result->thumb = img;
+		result->width = imgw;
+		result->height = imgh;
+		StampPack::Ref().ThumbnailFinished(result);
+	}
+};
+
+void StampPack::Map()
+{
+	if (!fileData)
+		fileData = Platform::MapFile(STAMPPACK_PATH, &fileSize);
+}
+
+void StampPack::Unmap()
+{
+	Platform::UnmapFile(fileData, fileSize);
+	fileData = NULL;
+	fileSize = 0;
+}
+
+// reads the index of the pack on disk, returns false if it isn't a valid pack
+bool StampPack::Load()
+{
+	entries.clear();
+	orderChanged = false;
+	Unmap();
+	Map();
+	const unsigned char *data = (const unsigned char*)fileData;
+	if (!data || fileSize < STAMPPACK_HEADER_SIZE || memcmp(data, STAMPPACK_MAGIC, 4) || GetInt(data+4) != STAMPPACK_VERSION)
+		return false;
+	size_t indexOffset = GetInt(data+8), count = GetInt(data+12);
+	if (indexOffset < STAMPPACK_HEADER_SIZE || indexOffset > fileSize || count > (fileSize-indexOffset)/STAMPPACK_ENTRY_SIZE)
+		return false;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const unsigned char *item = data+indexOffset+i*STAMPPACK_ENTRY_SIZE;
+		Entry entry;
+		entry.name = std::string((const char*)item, strnlen((const char*)item, STAMPPACK_NAME_SIZE));
+		entry.dataOffset = GetInt(item+12);
+		entry.dataSize = GetInt(item+16);
+		entry.thumbOffset = GetInt(item+20);
+		entry.thumbWidth = GetShort(item+24);
+		entry.thumbHeight = GetShort(item+26);
+		entry.info.width = GetShort(item+28);
+		entry.info.height = GetShort(item+30);
+		entry.info.particleCount = GetInt(item+32);
+		for (int j = 0; j < STAMP_TOP_ELEMENTS; j++)
+		{
+			entry.info.topTypes[j] = GetShort(item+36+j*2);
+			entry.info.topCounts[j] = GetInt(item+44+j*4);
+			if (entry.info.topTypes[j] >= PT_NUM)
+				entry.info.topTypes[j] = entry.info.topCounts[j] = 0;
+		}
+
+		if (!entry.name.length() || entry.dataOffset < STAMPPACK_HEADER_SIZE || entry.dataOffset > fileSize || entry.dataSize > fileSize-entry.dataOffset)
+			continue;
+		if (entry.thumbOffset && (entry.thumbWidth <= 0 || entry.thumbWidth > XRES || entry.thumbHeight <= 0 || entry.thumbHeight > YRES
+		        || entry.thumbOffset > fileSize || (size_t)(entry.thumbWidth*entry.thumbHeight*3) > fileSize-entry.thumbOffset))
+			entry.thumbOffset = 0;
+		entries.push_back(entry);
+	}
+	return true;
+}
+
+// creates a new pack from stamps.def and the .stm files it lists
+bool StampPack::Migrate()
+{
+	FILE *f = fopen(STAMPPACK_PATH, "wb");
+	if (!f)
+		return false;
+	bool ok = WriteHeader(f);
+	if (fclose(f) || !ok)
+		return false;
+
+	entries.clear();
+	f = BeginWrite();
+	if (!f)
+		return false;
+	int defSize;
+	char *def = (char*)file_load("stamps" PATH_SEP "stamps.def", &defSize);
+	for (int i = 0; def && i+10 <= defSize && def[i]; i += 10)
+	{
+		char fn[64];
+		int size;
+		std::string name(def+i, strnlen(def+i, 10));
+		sprintf(fn, "stamps" PATH_SEP "%s.stm", name.c_str());
+		void *data = file_load(fn, &size);
+		if (!data)
+			continue;
+		Entry entry;
+		memset(&entry.info, 0, sizeof(entry.info));
+		entry.name = name;
+		entry.dataOffset = WriteBlock(f, data, size, ok);
+		entry.dataSize = size;
+		entry.thumbOffset = 0;
+		entry.thumbWidth = entry.thumbHeight = 0;
+		entries.push_back(entry);
+		free(data);
+	}
+	free(def);
+	return EndWrite(f, ok);
+}
+
+// unmaps the pack and opens it for appending. Returns NULL if it couldn't be opened
+FILE *StampPack::BeginWrite()
+{
+	Unmap();
+	FILE *f = fopen(STAMPPACK_PATH, "r+b");
+	if (!f || fseek(f, 0, SEEK_END))
+	{
+		if (f)
+			fclose(f);
+		Map();
+		return NULL;
+	}
+	return f;
+}
+
+// appends a block, returns its offset. ok is set to false if it couldn't be written
+unsigned int StampPack::WriteBlock(FILE *f, const void *data, unsigned int size, bool &ok)
+{
+	long offset = ftell(f);
+	if (!ok || offset < STAMPPACK_HEADER_SIZE || (unsigned long)offset > 0xFFFFFFFFUL-size)
+		ok = false;
+	else if (size && fwrite(data, size, 1, f) != 1)
+		ok = false;
+	return (unsigned int)offset;
+}
+
+// writes the index for entries at the end of the file, and then switches the header over to it
+bool StampPack::WriteIndex(FILE *f, bool ok)
+{
+	std::vector<unsigned char> index;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		Entry &entry = entries[i];
+		char name[STAMPPACK_NAME_SIZE] = {0};
+		strncpy(name, entry.name.c_str(), STAMPPACK_NAME_SIZE-1);
+		index.insert(index.end(), name, name+STAMPPACK_NAME_SIZE);
+		PutInt(index, entry.dataOffset);
+		PutInt(index, entry.dataSize);
+		PutInt(index, entry.thumbOffset);
+		PutShort(index, entry.thumbWidth);
+		PutShort(index, entry.thumbHeight);
+		PutShort(index, entry.info.width);
+		PutShort(index, entry.info.height);
+		PutInt(index, entry.info.particleCount);
+		for (int j = 0; j < STAMP_TOP_ELEMENTS; j++)
+			PutShort(index, entry.info.topTypes[j]);
+		for (int j = 0; j < STAMP_TOP_ELEMENTS; j++)
+			PutInt(index, entry.info.topCounts[j]);
+		PutInt(index, 0);
+	}
+	unsigned int indexOffset = WriteBlock(f, index.size() ? &index[0] : NULL, index.size(), ok);
+	orderChanged = false;
+
+	// the header is only changed once everything it points to is written
+	if (!ok || fflush(f) || fseek(f, 8, SEEK_SET))
+		return false;
+	std::vector<unsigned char> header;
+	PutInt(header, indexOffset);
+	PutInt(header, entries.size());
+	return fwrite(&header[0], header.size(), 1, f) == 1;
+}
+
+// finishes a change started with BeginWrite. If anything went wrong, entries is read from disk again, so it always
+// matches the file
+bool StampPack::EndWrite(FILE *f, bool ok)
+{
+	ok = WriteIndex(f, ok);
+	if (fclose(f))
+		ok = false;
+	if (!ok)
+	{
+		Load();
+		return false;
+	}
+	Map();
+	if (fileSize > STAMPPACK_COMPACT_SIZE && UsedBytes() < fileSize/2)
+		Compact();
+	return true;
+}
+
+unsigned int StampPack::UsedBytes()
+{
+	unsigned int used = STAMPPACK_HEADER_SIZE + entries.size()*STAMPPACK_ENTRY_SIZE;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		used += entries[i].dataSize;
+		if (entries[i].thumbOffset)
+			used += entries[i].thumbWidth*entries[i].thumbHeight*3;
+	}
+	return used;
+}
+
+// writes a new pack with only the blocks that are still in use, and replaces the old one with it
+void StampPack::Compact()
+{
+	if (!fileData)
+		return;
+	FILE *f = fopen(STAMPPACK_TEMP_PATH, "wb");
+	if (!f)
+		return;
+	bool ok = WriteHeader(f);
+	std::vector<Entry> oldEntries = entries;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		Entry &entry = entries[i];
+		entry.dataOffset = WriteBlock(f, fileData+entry.dataOffset, entry.dataSize, ok);
+		if (entry.thumbOffset)
+			entry.thumbOffset = WriteBlock(f, fileData+entry.thumbOffset, entry.thumbWidth*entry.thumbHeight*3, ok);
+	}
+	ok = WriteIndex(f, ok);
+	if (fclose(f))
+		ok = false;
+	if (!ok)
+	{
+		entries = oldEntries;
+		remove(STAMPPACK_TEMP_PATH);
+		return;
+	}
+
+	Unmap();
+#ifdef WIN
+	// rename doesn't replace files on Windows. If this stops in between, Open uses the new pack
+	remove(STAMPPACK_PATH);
+#endif
+	if (rename(STAMPPACK_TEMP_PATH, STAMPPACK_PATH))
+		remove(STAMPPACK_TEMP_PATH);
+	Load();
+}
+
+// writes stamps.def in the pack's order, so Migrate can bring back every stamp if the pack is lost
+void StampPack::WriteDef()
+{
+	FILE *f = fopen("stamps" PATH_SEP "stamps.def", "wb");
+	if (!f)
+		return;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		char name[10] = {0};
+		if (entries[i].name.length() > 10)
+			continue;
+		memcpy(name, entries[i].name.c_str(), entries[i].name.length());
+		fwrite(name, 10, 1, f);
+	}
+	fclose(f);
+}
+
+void StampPack::Open()
+{
+	if (opened)
+		return;
+	opened = true;
+
+#ifdef WIN
+	_mkdir("stamps");
+#else
+	mkdir("stamps", 0755);
+#endif
+	// the last compaction stopped after the old pack was removed
+	if (!FileExists(STAMPPACK_PATH) && FileExists(STAMPPACK_TEMP_PATH))
+		rename(STAMPPACK_TEMP_PATH, STAMPPACK_PATH);
+	remove(STAMPPACK_TEMP_PATH);
+
+	if (Load())
+		return;
+	// keep a damaged pack around instead of overwriting it
+	if (FileExists(STAMPPACK_PATH))
+	{
+		Unmap();
+		remove(STAMPPACK_BACKUP_PATH);
+		rename(STAMPPACK_PATH, STAMPPACK_BACKUP_PATH);
+	}
+	Migrate();
+}
+
+void StampPack::Shutdown()
+{
+	thumbnailJobs.Wait();
+	CollectThumbnails();
+	if (orderChanged)
+	{
+		FILE *f = BeginWrite();
+		if (f)
+			EndWrite(f, true);
+		WriteDef();
+	}
+	Unmap();
+	entries.clear();
+	opened = false;
+}
+
+// called from the job system
+void StampPack::ThumbnailFinished(ThumbnailResult *result)
+{
+	pthread_mutex_lock(&resultLock);
+	finishedThumbnails.push_back(result);
+	pthread_mutex_unlock(&resultLock);
+}
+
+// writes finished thumbnails into the pack, all in one change
+void StampPack::CollectThumbnails()
+{
+	std::vector<ThumbnailResult*> finished;
+	pthread_mutex_lock(&resultLock);
+	finished.swap(finishedThumbnails);
+	pthread_mutex_unlock(&resultLock);
+	if (finished.empty())
+		return;
+
+	FILE *f = BeginWrite();
+	bool ok = f != NULL;
+	for (size_t i = 0; i < finished.size(); i++)
+	{
+		ThumbnailResult *result = finished[i];
+		renderingThumbnails.erase(result->name);
+		Entry *entry = GetEntry(result->name);
+		if (!result->thumb)
+			failedThumbnails.insert(result->name);
+		else if (entry && ok)
+		{
+			std::vector<unsigned char> rgb;
+			rgb.reserve(result->width*result->height*3);
+			for (int j = 0; j < result->width*result->height; j++)
+			{
+				rgb.push_back(PIXR(result->thumb[j]));
+				rgb.push_back(PIXG(result->thumb[j]));
+				rgb.push_back(PIXB(result->thumb[j]));
+			}
+			entry->thumbOffset = WriteBlock(f, &rgb[0], rgb.size(), ok);
+			entry->thumbWidth = result->width;
+			entry->thumbHeight = result->height;
+			entry->info = result->info;
+		}
+		free(result->thumb);
+	}
+
+	if (!f || !EndWrite(f, ok))
+	{
+		// don't keep rendering thumbnails that can't be stored
+		for (size_t i = 0; i < finished.size(); i++)
+			failedThumbnails.insert(finished[i]->name);
+	}
+	for (size_t i = 0; i < finished.size(); i++)
+		delete finished[i];
+}
+
+StampPack::Entry *StampPack::GetEntry(std::string name)
+{
+	for (size_t i = 0; i < entries.size(); i++)
+		if (entries[i].name == name)
+			return &entries[i];
+	return NULL;
+}
+
+int StampPack::GetCount()
+{
+	Open();
+	return entries.size();
+}
+
+std::string StampPack::GetName(int i)
+{
+	Open();
+	if (i < 0 || i >= (int)entries.size())
+		return "";
+	return entries[i].name;
+}
+
+bool StampPack::Contains(std::string name)
+{
+	Open();
+	return GetEntry(name) != NULL;
+}
+
+void *StampPack::GetData(std::string name, int *size)
+{
+	Open();
+	Entry *entry = GetEntry(name);
+	if (!entry || !fileData)
+		return NULL;
+	void *data = malloc(entry->dataSize ? entry->dataSize : 1);
+	memcpy(data, fileData+entry->dataOffset, entry->dataSize);
+	*size = entry->dataSize;
+	return data;
+}
+
+pixel *StampPack::GetThumbnail(std::string name, int *width, int *height, bool *loading)
+{
+	Open();
+	CollectThumbnails();
+	*loading = false;
+	Entry *entry = GetEntry(name);
+	if (!entry || !fileData)
+		return NULL;
+
+	if (entry->thumbOffset)
+	{
+		int count = entry->thumbWidth*entry->thumbHeight;
+		const unsigned char *rgb = (const unsigned char*)fileData+entry->thumbOffset;
+		pixel *thumb = (pixel*)malloc(count*PIXELSIZE);
+		for (int i = 0; i < count; i++)
+			thumb[i] = PIXRGB(rgb[i*3], rgb[i*3+1], rgb[i*3+2]);
+		*width = entry->thumbWidth;
+		*height = entry->thumbHeight;
+		return thumb;
+	}
+
+	if (failedThumbnails.find(name) != failedThumbnails.end())
+		return NULL;
+	*loading = true;
+	if (renderingThumbnails.find(name) != renderingThumbnails.end())
+		return NULL;
+	renderingThumbnails.insert(name);
+
+	ThumbnailResult *result = new ThumbnailResult();
+	result->name = name;
+	result->thumb = NULL;
+	result->width = result->height = 0;
+	void *data = malloc(entry->dataSize ? entry->dataSize : 1);
+	memcpy(data, fileData+entry->dataOffset, entry->dataSize);
+	JobSystem::Ref().Submit(new StampThumbnailJob(result, data, entry->dataSize, globalSim), &thumbnailJobs);
+	return NULL;
+}
+
+bool StampPack::GetInfo(std::string name, Info *info)
+{
+	Open();
+	CollectThumbnails();
+	Entry *entry = GetEntry(name);
+	if (!entry || !entry->thumbOffset)
+		return false;
+	*info = entry->info;
+	return true;
+}
+
+bool StampPack::Add(std::string name, void *data, int size)
+{
+	Open();
+	if (!name.length() || size < 0)
+		return false;
+	FILE *f = BeginWrite();
+	if (!f)
+		return false;
+	bool ok = true;
+	Entry entry;
+	memset(&entry.info, 0, sizeof(entry.info));
+	entry.name = name.substr(0, STAMPPACK_NAME_SIZE-1);
+	entry.dataOffset = WriteBlock(f, data, size, ok);
+	entry.dataSize = size;
+	entry.thumbOffset = 0;
+	entry.thumbWidth = entry.thumbHeight = 0;
+	entries.insert(entries.begin(), entry);
+	failedThumbnails.erase(entry.name);
+	if (!EndWrite(f, ok))
+		return false;
+	WriteDef();
+	return true;
+}
+
+bool StampPack::Import(std::string name)
+{
+	if (Contains(name))
+		return false;
+	char fn[64];
+	int size;
+	snprintf(fn, 64, "stamps" PATH_SEP "%s.stm", name.c_str());
+	void *data = file_load(fn, &size);
+	if (!data)
+		return false;
+	bool ret = Add(name, data, size);
+	free(data);
+	return ret;
+}
+
+void StampPack::Remove(std::string name)
+{
+	Open();
+	if (!GetEntry(name))
+		return;
+	FILE *f = BeginWrite();
+	if (!f)
+		return;
+	for (size_t i = 0; i < entries.size(); i++)
+		if (entries[i].name == name)
+		{
+			entries.erase(entries.begin()+i);
+			break;
+		}
+	if (EndWrite(f, true))
+		WriteDef();
+}
+
+void StampPack::MoveToFront(std::string name)
+{
+	Open();
+	size_t i = 0;
+	while (i < entries.size() && entries[i].name != name)
+		i++;
+	if (!i || i == entries.size())
+		return;
+	// this happens every time a stamp is loaded, so it isn't worth a new index each time
+	Entry entry = entries[i];
+	entries.erase(entries.begin()+i);
+	entries.insert(entries.begin(), entry);
+	orderChanged = true;
+}
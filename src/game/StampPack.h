@@ -0,0 +1,106 @@
+#ifndef STAMPPACK_H
+#define STAMPPACK_H
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+#include "common/tpt-thread.h"
+#include "common/JobSystem.h"
+#include "common/Singleton.h"
+#include "graphics/Pixel.h"
+
+// number of elements kept for each stamp, most common first
+#define STAMP_TOP_ELEMENTS 4
+
+// All stamps in one file, stamps/stamps.pack, which is memory mapped and read in place. Each stamp has its save data,
+// a thumbnail and some information about it in there, so the stamp browser only reads the stamps it is showing.
+// Thumbnails are rendered on the job system the first time they are needed and then kept in the pack.
+// Changes are appended to the end of the file, see StampPack.cpp. stamps.def and the .stm files in stamps/ are
+// imported the first time. They are still kept up to date, Open rebuilds the pack from them if it is ever damaged.
+// All public functions must be called from the main thread
+class StampPack : public Singleton<StampPack>
+{
+public:
+	struct Info
+	{
+		int width, height;
+		int particleCount;
+		int topTypes[STAMP_TOP_ELEMENTS]; // 0 if there are fewer different elements
+		int topCounts[STAMP_TOP_ELEMENTS];
+	};
+
+	struct ThumbnailResult
+	{
+		std::string name;
+		pixel *thumb; // NULL if the stamp couldn't be rendered
+		int width, height;
+		Info info;
+	};
+
+private:
+	struct Entry
+	{
+		std::string name;
+		unsigned int dataOffset, dataSize;
+		unsigned int thumbOffset; // 0 until the thumbnail is rendered
+		int thumbWidth, thumbHeight;
+		Info info;
+	};
+
+	bool opened;
+	// MoveToFront only changes entries, the new order is written with the next change or on Shutdown
+	bool orderChanged;
+	const char *fileData;
+	size_t fileSize;
+	// in display order, most recently used first
+	std::vector<Entry> entries;
+
+	TaskGroup thumbnailJobs;
+	pthread_mutex_t resultLock;
+	std::vector<ThumbnailResult*> finishedThumbnails; // only accessed with resultLock held
+	std::set<std::string> renderingThumbnails, failedThumbnails;
+
+	void Map();
+	void Unmap();
+	bool Load();
+	bool Migrate();
+	FILE *BeginWrite();
+	unsigned int WriteBlock(FILE *f, const void *data, unsigned int size, bool &ok);
+	bool WriteIndex(FILE *f, bool ok);
+	bool EndWrite(FILE *f, bool ok);
+	void Compact();
+	void WriteDef();
+	void CollectThumbnails();
+	unsigned int UsedBytes();
+	Entry *GetEntry(std::string name);
+
+public:
+	StampPack();
+	~StampPack();
+
+	// opens the pack, importing stamps.def if there is no pack yet. Called automatically on first use
+	void Open();
+	void Shutdown();
+	void ThumbnailFinished(ThumbnailResult *result);
+
+	int GetCount();
+	std::string GetName(int i);
+	bool Contains(std::string name);
+	// copy of the stamp's save, NULL if it doesn't exist
+	void *GetData(std::string name, int *size);
+	// copy of the thumbnail, or NULL if it isn't rendered yet. Starts rendering it in the background, loading is set
+	// while that is still going on
+	pixel *GetThumbnail(std::string name, int *width, int *height, bool *loading);
+	// false if the thumbnail hasn't been rendered yet, that is where this comes from
+	bool GetInfo(std::string name, Info *info);
+
+	// adds a stamp in front of all others
+	bool Add(std::string name, void *data, int size);
+	// adds stamps/<name>.stm in front of all others, if it isn't in the pack already
+	bool Import(std::string name);
+	void Remove(std::string name);
+	void MoveToFront(std::string name);
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include <cstdlib>
+#include <cstring>
+#include "TabState.h"
+#include "defines.h"
+#include "gravity.h"
+#include "interface.h"
+#include "luaconsole.h"
+#include "misc.h"
+#include "powder.h"
+#include "game/Menus.h"
+#include "graphics/Renderer.h"
+#include "simulation/Simulation.h"
+#include "simulation/Snapshot.h"
+#include "simulation/Tool.h"
+
+TabState::TabState():
+	snapshot(NULL),
+	reloadData(NULL),
+	reloadSize(0)
+{
+
+}
+
+TabState::~TabState()
+{
+	delete snapshot;
+	free(reloadData);
+}
+
+TabState *TabState::Capture(Simulation *sim)
+{
+	TabState *tab = new TabState();
+	tab->snapshot = Snapshot::CreateSnapshot(sim);
+
+	tab->legacyEnable = legacy_enable;
+	tab->gravityEnable = ngrav_enable;
+	tab->aheatEnable = aheat_enable;
+	tab->waterEEnabled = water_equal_test;
+	tab->paused = sys_pause;
+	tab->decorationsEnable = decorations_enable;
+	tab->hudEnable = hud_enable;
+	tab->msRotation = sim->msRotation;
+	tab->instantActivation = sim->instantActivation;
+	tab->gravMode = gravityMode;
+	tab->airSimMode = airMode;
+	tab->edgeMode = sim->saveEdgeMode;
+	tab->activeMenu = active_menu;
+	tab->leftTool = activeTools[0]->GetIdentifier();
+	tab->rightTool = activeTools[1]->GetIdentifier();
+	tab->renderModes = Renderer::Ref().GetRenderModes();
+	tab->displayModes = Renderer::Ref().GetDisplayModes();
+	tab->colorMode = Renderer::Ref().GetColorMode();
+#if defined(LUACONSOLE) && !defined(NOMOD)
+	if (LuaCode && LuaCodeLen)
+		tab->luaCode = std::string(LuaCode, LuaCodeLen);
+#endif
+
+	tab->saveOpened = svf_open;
+	tab->fileOpened = svf_fileopen;
+	tab->published = svf_publish;
+	tab->own = svf_own;
+	tab->myVote = svf_myvote;
+	tab->saveName = svf_name;
+	tab->fileName = svf_filename;
+	tab->saveID = svf_id;
+	tab->description = svf_description;
+	tab->author = svf_author;
+	tab->tags = svf_tags;
+	if (svf_last)
+	{
+		tab->reloadData = malloc(svf_lsize);
+		memcpy(tab->reloadData, svf_last, svf_lsize);
+		tab->reloadSize = svf_lsize;
+	}
+	return tab;
+}
+
+void TabState::Restore(Simulation *sim)
+{
+	// same settings parse_save restores when loading a tab
+	legacy_enable = legacyEnable;
+	aheat_enable = aheatEnable;
+	water_equal_test = waterEEnabled;
+	sys_pause = paused;
+	decorations_enable = decorationsEnable;
+#ifndef TOUCHUI
+	hud_enable = hudEnable;
+#endif
+	sim->msRotation = msRotation;
+	sim->instantActivation = instantActivation;
+	gravityMode = gravMode;
+	airMode = airSimMode;
+	if (activeMenu >= 0 && activeMenu < SC_TOTAL && menuSections[activeMenu]->enabled)
+		active_menu = activeMenu;
+	Tool *tool = GetToolFromIdentifier(leftTool);
+	if (tool)
+		activeTools[0] = tool;
+	tool = GetToolFromIdentifier(rightTool);
+	if (tool)
+		activeTools[1] = tool;
+	Renderer::Ref().SetRenderModes(renderModes);
+	Renderer::Ref().SetDisplayModes(displayModes);
+	Renderer::Ref().SetColorMode(colorMode);
+#if defined(LUACONSOLE) && !defined(NOMOD)
+	// loading a save without code clears it too, the last tab's code shouldn't carry over
+	free(LuaCode);
+	LuaCode = NULL;
+	LuaCodeLen = 0;
+	if (luaCode.length())
+	{
+		LuaCode = mystrdup(luaCode.c_str());
+		LuaCodeLen = luaCode.length();
+		ranLuaCode = false;
+	}
+#endif
+#ifndef RENDERER
+	if (ngrav_enable != gravityEnable)
+	{
+		if (gravityEnable)
+			start_grav_async();
+		else
+			stop_grav_async();
+	}
+#endif
+	// the frame walls themselves are part of the snapshot
+	sim->saveEdgeMode = edgeMode;
+
+	// gravity has to be started first, the snapshot only restores the gravity maps if it is on
+	Snapshot::Restore(sim, *snapshot);
+
+	svf_open = saveOpened;
+	svf_fileopen = fileOpened;
+	svf_publish = published;
+	svf_own = own;
+	svf_myvote = myVote;
+	strncpy(svf_name, saveName.c_str(), 63);
+	strncpy(svf_filename, fileName.c_str(), 254);
+	strncpy(svf_id, saveID.c_str(), 15);
+	strncpy(svf_description, description.c_str(), 254);
+	strncpy(svf_author, author.c_str(), 63);
+	strncpy(svf_tags, tags.c_str(), 255);
+	free(svf_last);
+	svf_last = reloadData;
+	svf_lsize = reloadSize;
+	reloadData = NULL;
+	reloadSize = 0;
+}
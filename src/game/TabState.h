@@ -0,0 +1,41 @@
+#ifndef TABSTATE_H
+#define TABSTATE_H
+
+#include <set>
+#include <string>
+
+class Simulation;
+class Snapshot;
+// Everything parse_save would restore when loading a tab, kept in memory so switching tabs
+// doesn't need to build, compress and parse a save. This is a copy, not a live Simulation, so inactive tabs don't
+// tick. Keeping a Simulation per tab needs the settings below, signs and the newtonian gravity maps to move into
+// Simulation first, a background tab would tick with the open tab's settings otherwise
+class TabState
+{
+	Snapshot *snapshot;
+
+	bool legacyEnable, gravityEnable, aheatEnable, waterEEnabled, paused, decorationsEnable, hudEnable;
+	bool msRotation, instantActivation;
+	int gravMode, airSimMode, edgeMode, activeMenu;
+	std::string leftTool, rightTool;
+	std::set<unsigned int> renderModes, displayModes;
+	unsigned int colorMode;
+	std::string luaCode;
+
+	int saveOpened, fileOpened, published, own, myVote;
+	std::string saveName, fileName, saveID, description, author, tags;
+	// reload button data, owned by this tab while it isn't active
+	void *reloadData;
+	int reloadSize;
+
+	TabState();
+
+public:
+	~TabState();
+
+	// copy the current simulation and settings, including the reload button data
+	static TabState *Capture(Simulation *sim);
+	void Restore(Simulation *sim);
+};
+
+#endif
@@ -0,0 +1,449 @@
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <time.h>
+#ifdef WIN
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "ThumbnailCache.h"
+#include "defines.h"
+#include "misc.h"
+
+#define THUMBCACHE_DIR "thumbcache"
+// v2 added the time the file was written
+#define THUMBCACHE_MAGIC "TPC2"
+
+ThumbnailCache::ThumbnailCache():
+	threadStarted(false),
+	threadShutdown(false),
+	diskIndexLoaded(false)
+{
+	pthread_mutex_init(&jobLock, NULL);
+	pthread_cond_init(&jobCond, NULL);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+
+}
+
+// keys are also used as file names, so only allow safe characters
+std::string ThumbnailCache::KeyPrefix(std::string id)
+{
+	for (size_t i = 0; i < id.length(); i++)
+		if (!isalnum((unsigned char)id[i]) && id[i] != '_')
+			id[i] = '_';
+	return id + "-";
+}
+
+std::string ThumbnailCache::Key(std::string id, int w, int h)
+{
+	std::stringstream key;
+	key << KeyPrefix(id) << w << "x" << h;
+	return key.str();
+}
+
+std::string ThumbnailCache::DiskPath(std::string key)
+{
+	return THUMBCACHE_DIR PATH_SEP + key + ".ptc";
+}
+
+//helper function for the worker thread
+TH_ENTRY_POINT void* ThumbnailCacheHelper(void* obj)
+{
+	ThumbnailCache *temp = (ThumbnailCache*)obj;
+	temp->Worker();
+	return NULL;
+}
+
+void ThumbnailCache::EnsureRunning()
+{
+	if (threadStarted)
+		return;
+	threadStarted = true;
+	pthread_create(&workerThread, NULL, &ThumbnailCacheHelper, this);
+}
+
+void ThumbnailCache::Worker()
+{
+	pthread_mutex_lock(&jobLock);
+	while (!threadShutdown)
+	{
+		if (jobQueue.empty())
+		{
+			pthread_cond_wait(&jobCond, &jobLock);
+			continue;
+		}
+		// newest requests first, those are the ones currently on screen
+		ThumbJob *job = jobQueue.back();
+		jobQueue.pop_back();
+		pthread_mutex_unlock(&jobLock);
+
+		if (!job->canceled)
+			Process(job);
+
+		pthread_mutex_lock(&jobLock);
+		finishedJobs.push_back(job);
+	}
+	pthread_mutex_unlock(&jobLock);
+}
+
+void ThumbnailCache::Process(ThumbJob *job)
+{
+	if (job->type == JOB_DISK)
+	{
+		ReadDisk(job);
+		return;
+	}
+
+	if (job->type == JOB_PTI)
+	{
+		int imgw, imgh;
+		pixel *img = ptif_unpack(job->data, job->size, &imgw, &imgh);
+		if (img)
+		{
+			job->result = resample_img(img, imgw, imgh, job->width, job->height);
+			job->resultWidth = job->width;
+			job->resultHeight = job->height;
+			free(img);
+		}
+	}
+
+	if (job->result)
+		job->written = WriteDisk(job);
+}
+
+bool ThumbnailCache::ReadDisk(ThumbJob *job)
+{
+	FILE *f = fopen(DiskPath(job->key).c_str(), "rb");
+	if (!f)
+		return false;
+	char magic[4];
+	int size[2];
+	unsigned int written;
+	if (fread(magic, 4, 1, f) != 1 || memcmp(magic, THUMBCACHE_MAGIC, 4) || fread(size, sizeof(int), 2, f) != 2
+	        || fread(&written, sizeof(written), 1, f) != 1
+	        || size[0] <= 0 || size[1] <= 0 || size[0] > XRES || size[1] > YRES)
+	{
+		fclose(f);
+		return false;
+	}
+	// the save might have been updated since then, treat it like a missing file so it is decoded again
+	unsigned int now = (unsigned int)time(NULL);
+	if (written > now || now-written > THUMB_DISK_CACHE_AGE)
+	{
+		fclose(f);
+		return false;
+	}
+	pixel *data = (pixel*)malloc(size[0]*size[1]*PIXELSIZE);
+	if (fread(data, PIXELSIZE, size[0]*size[1], f) != (size_t)(size[0]*size[1]))
+	{
+		free(data);
+		fclose(f);
+		return false;
+	}
+	fclose(f);
+	job->result = data;
+	job->resultWidth = size[0];
+	job->resultHeight = size[1];
+	return true;
+}
+
+bool ThumbnailCache::WriteDisk(ThumbJob *job)
+{
+	FILE *f = fopen(DiskPath(job->key).c_str(), "wb");
+	if (!f)
+		return false;
+	int size[2] = {job->resultWidth, job->resultHeight};
+	unsigned int written = (unsigned int)time(NULL);
+	bool success = fwrite(THUMBCACHE_MAGIC, 4, 1, f) == 1 && fwrite(size, sizeof(int), 2, f) == 2
+	        && fwrite(&written, sizeof(written), 1, f) == 1
+	        && fwrite(job->result, PIXELSIZE, size[0]*size[1], f) == (size_t)(size[0]*size[1]);
+	fclose(f);
+	if (!success)
+		remove(DiskPath(job->key).c_str());
+	return success;
+}
+
+void ThumbnailCache::QueueJob(ThumbJob *job)
+{
+	job->result = NULL;
+	job->resultWidth = job->resultHeight = 0;
+	job->written = false;
+	job->canceled = false;
+	pendingJobs[job->key] = job;
+
+	EnsureRunning();
+	pthread_mutex_lock(&jobLock);
+	jobQueue.push_back(job);
+	pthread_cond_signal(&jobCond);
+	pthread_mutex_unlock(&jobLock);
+}
+
+// move finished thumbnails from the worker thread into the cache
+void ThumbnailCache::Collect()
+{
+	std::vector<ThumbJob*> finished;
+	pthread_mutex_lock(&jobLock);
+	finished.swap(finishedJobs);
+	pthread_mutex_unlock(&jobLock);
+
+	for (std::vector<ThumbJob*>::iterator iter = finished.begin(), end = finished.end(); iter != end; ++iter)
+	{
+		ThumbJob *job = *iter;
+		std::map<std::string, ThumbJob*>::iterator pending = pendingJobs.find(job->key);
+		if (pending != pendingJobs.end() && pending->second == job)
+			pendingJobs.erase(pending);
+
+		if (job->canceled)
+		{
+			// don't remove the file if it has been requested again since then
+			if (job->written && diskIndex.find(job->key) == diskIndex.end() && pendingJobs.find(job->key) == pendingJobs.end())
+				remove(DiskPath(job->key).c_str());
+			free(job->result);
+		}
+		else if (job->type == JOB_DISK && !job->result)
+		{
+			// cache file is missing, corrupt or too old, the next request will decode it again
+			DiskRemove(job->key);
+		}
+		else
+		{
+			StoreThumbnail(job->key, job->result, job->resultWidth, job->resultHeight);
+			if (job->type == JOB_DISK || job->written)
+				DiskTouch(job->key);
+		}
+		free(job->data);
+		delete job;
+	}
+}
+
+void ThumbnailCache::StoreThumbnail(std::string key, pixel *data, int width, int height)
+{
+	std::map<std::string, std::list<Thumbnail>::iterator>::iterator found = memIndex.find(key);
+	if (found != memIndex.end())
+	{
+		free(found->second->data);
+		memCache.erase(found->second);
+	}
+
+	Thumbnail thumb;
+	thumb.key = key;
+	thumb.data = data;
+	thumb.width = width;
+	thumb.height = height;
+	memCache.push_front(thumb);
+	memIndex[key] = memCache.begin();
+
+	while (memCache.size() > THUMB_DECODED_CACHE_SIZE)
+	{
+		Thumbnail &last = memCache.back();
+		memIndex.erase(last.key);
+		free(last.data);
+		memCache.pop_back();
+	}
+}
+
+void ThumbnailCache::LoadDiskIndex()
+{
+	if (diskIndexLoaded)
+		return;
+	diskIndexLoaded = true;
+
+#ifdef WIN
+	_mkdir(THUMBCACHE_DIR);
+#else
+	mkdir(THUMBCACHE_DIR, 0755);
+#endif
+
+	int size;
+	char *data = (char*)file_load(THUMBCACHE_DIR PATH_SEP "index", &size);
+	if (!data)
+		return;
+	// one key per line, most recently used first
+	std::string index(data, size);
+	std::stringstream lines(index);
+	std::string key;
+	while (std::getline(lines, key) && diskCache.size() < THUMB_DISK_CACHE_SIZE)
+	{
+		if (!key.length() || diskIndex.find(key) != diskIndex.end())
+			continue;
+		diskCache.push_back(key);
+		diskIndex[key] = --diskCache.end();
+	}
+	free(data);
+}
+
+void ThumbnailCache::SaveDiskIndex()
+{
+	if (!diskIndexLoaded)
+		return;
+	FILE *f = fopen(THUMBCACHE_DIR PATH_SEP "index", "wb");
+	if (!f)
+		return;
+	for (std::list<std::string>::iterator iter = diskCache.begin(), end = diskCache.end(); iter != end; ++iter)
+		fprintf(f, "%s\n", iter->c_str());
+	fclose(f);
+}
+
+void ThumbnailCache::DiskTouch(std::string key)
+{
+	std::map<std::string, std::list<std::string>::iterator>::iterator found = diskIndex.find(key);
+	if (found != diskIndex.end())
+	{
+		diskCache.splice(diskCache.begin(), diskCache, found->second);
+		return;
+	}
+	diskCache.push_front(key);
+	diskIndex[key] = diskCache.begin();
+
+	while (diskCache.size() > THUMB_DISK_CACHE_SIZE)
+	{
+		std::string last = diskCache.back();
+		diskIndex.erase(last);
+		diskCache.pop_back();
+		remove(DiskPath(last).c_str());
+	}
+}
+
+void ThumbnailCache::DiskRemove(std::string key)
+{
+	std::map<std::string, std::list<std::string>::iterator>::iterator found = diskIndex.find(key);
+	if (found == diskIndex.end())
+		return;
+	diskCache.erase(found->second);
+	diskIndex.erase(found);
+	remove(DiskPath(key).c_str());
+}
+
+// returns true if there is nothing left to do for this key, loading it from disk if needed
+bool ThumbnailCache::RequestCached(std::string key)
+{
+	Collect();
+	LoadDiskIndex();
+	if (memIndex.find(key) != memIndex.end() || pendingJobs.find(key) != pendingJobs.end())
+		return true;
+	if (diskIndex.find(key) != diskIndex.end())
+	{
+		ThumbJob *job = new ThumbJob();
+		job->type = JOB_DISK;
+		job->key = key;
+		job->data = NULL;
+		job->size = 0;
+		job->width = job->height = 0;
+		QueueJob(job);
+		return true;
+	}
+	return false;
+}
+
+pixel *ThumbnailCache::Get(std::string id, int w, int h, int *width, int *height)
+{
+	std::string key = Key(id, w, h);
+	RequestCached(key);
+
+	std::map<std::string, std::list<Thumbnail>::iterator>::iterator found = memIndex.find(key);
+	if (found == memIndex.end())
+		return NULL;
+	memCache.splice(memCache.begin(), memCache, found->second);
+	Thumbnail &thumb = *found->second;
+	if (width)
+		*width = thumb.width;
+	if (height)
+		*height = thumb.height;
+	return thumb.data;
+}
+
+bool ThumbnailCache::IsLoading(std::string id, int w, int h)
+{
+	Collect();
+	return pendingJobs.find(Key(id, w, h)) != pendingJobs.end();
+}
+
+void ThumbnailCache::RequestPTI(std::string id, void *data, int size, int w, int h)
+{
+	std::string key = Key(id, w, h);
+	if (!data || RequestCached(key))
+		return;
+
+	ThumbJob *job = new ThumbJob();
+	job->type = JOB_PTI;
+	job->key = key;
+	job->data = (char*)malloc(size);
+	memcpy(job->data, data, size);
+	job->size = size;
+	job->width = w;
+	job->height = h;
+	QueueJob(job);
+}
+
+// remove all sizes of a thumbnail, from memory and from disk
+void ThumbnailCache::Invalidate(std::string id)
+{
+	Collect();
+	LoadDiskIndex();
+	std::string prefix = KeyPrefix(id);
+
+	for (std::list<Thumbnail>::iterator iter = memCache.begin(); iter != memCache.end();)
+	{
+		if (!iter->key.compare(0, prefix.length(), prefix))
+		{
+			memIndex.erase(iter->key);
+			free(iter->data);
+			iter = memCache.erase(iter);
+		}
+		else
+			++iter;
+	}
+	for (std::list<std::string>::iterator iter = diskCache.begin(); iter != diskCache.end();)
+	{
+		if (!iter->compare(0, prefix.length(), prefix))
+		{
+			diskIndex.erase(*iter);
+			remove(DiskPath(*iter).c_str());
+			iter = diskCache.erase(iter);
+		}
+		else
+			++iter;
+	}
+	for (std::map<std::string, ThumbJob*>::iterator iter = pendingJobs.begin(); iter != pendingJobs.end();)
+	{
+		if (!iter->first.compare(0, prefix.length(), prefix))
+		{
+			iter->second->canceled = true;
+			pendingJobs.erase(iter++);
+		}
+		else
+			++iter;
+	}
+}
+
+void ThumbnailCache::Shutdown()
+{
+	if (threadStarted)
+	{
+		pthread_mutex_lock(&jobLock);
+		threadShutdown = true;
+		pthread_cond_signal(&jobCond);
+		pthread_mutex_unlock(&jobLock);
+		pthread_join(workerThread, NULL);
+		threadStarted = false;
+	}
+
+	// anything still in the queue was never started
+	for (std::deque<ThumbJob*>::iterator iter = jobQueue.begin(), end = jobQueue.end(); iter != end; ++iter)
+		(*iter)->canceled = true;
+	finishedJobs.insert(finishedJobs.end(), jobQueue.begin(), jobQueue.end());
+	jobQueue.clear();
+	Collect();
+
+	for (std::list<Thumbnail>::iterator iter = memCache.begin(), end = memCache.end(); iter != end; ++iter)
+		free(iter->data);
+	memCache.clear();
+	memIndex.clear();
+	SaveDiskIndex();
+}
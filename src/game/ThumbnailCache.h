@@ -0,0 +1,94 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "common/tpt-thread.h"
+#include "common/Singleton.h"
+#include "graphics/Pixel.h"
+
+// LRU cache of decoded, already scaled thumbnails for the save browser.
+// Thumbnails are identified by an id (like "save_1234") and the size they were scaled to.
+// Decoding is done on a worker thread, and finished thumbnails are also written to the thumbcache/
+// directory so they are available immediately in the next session. Those expire after THUMB_DISK_CACHE_AGE, in case
+// the save was updated.
+// All public functions must be called from the main thread. Pointers returned by Get are owned
+// by the cache and are only valid until the next call into the cache.
+class ThumbnailCache : public Singleton<ThumbnailCache>
+{
+	struct Thumbnail
+	{
+		std::string key;
+		pixel *data; // NULL if decoding failed
+		int width, height;
+	};
+
+	enum JobType { JOB_DISK, JOB_PTI };
+	struct ThumbJob
+	{
+		JobType type;
+		std::string key;
+		char *data;
+		int size;
+		int width, height; // requested size
+		pixel *result;
+		int resultWidth, resultHeight;
+		bool written;
+		volatile bool canceled;
+	};
+
+	pthread_t workerThread;
+	pthread_mutex_t jobLock;
+	pthread_cond_t jobCond;
+	bool threadStarted;
+	bool threadShutdown;
+
+	// worker queue and results, only accessed with jobLock held
+	std::deque<ThumbJob*> jobQueue;
+	std::vector<ThumbJob*> finishedJobs;
+	// all jobs that haven't been collected yet by the main thread
+	std::map<std::string, ThumbJob*> pendingJobs;
+
+	std::list<Thumbnail> memCache;
+	std::map<std::string, std::list<Thumbnail>::iterator> memIndex;
+
+	bool diskIndexLoaded;
+	std::list<std::string> diskCache;
+	std::map<std::string, std::list<std::string>::iterator> diskIndex;
+
+	static std::string KeyPrefix(std::string id);
+	static std::string Key(std::string id, int w, int h);
+	static std::string DiskPath(std::string key);
+
+	void EnsureRunning();
+	void QueueJob(ThumbJob *job);
+	void Collect();
+	void StoreThumbnail(std::string key, pixel *data, int width, int height);
+	void LoadDiskIndex();
+	void SaveDiskIndex();
+	void DiskTouch(std::string key);
+	void DiskRemove(std::string key);
+	bool RequestCached(std::string key);
+
+	static void Process(ThumbJob *job);
+	static bool ReadDisk(ThumbJob *job);
+	static bool WriteDisk(ThumbJob *job);
+
+public:
+	ThumbnailCache();
+	~ThumbnailCache();
+
+	void Worker();
+	void Shutdown();
+
+	pixel *Get(std::string id, int w, int h, int *width = NULL, int *height = NULL);
+	bool IsLoading(std::string id, int w, int h);
+	// decode ptif data (copied) and resample it to exactly w x h
+	void RequestPTI(std::string id, void *data, int size, int w, int h);
+	void Invalidate(std::string id);
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include <sstream>
 #include <bzlib.h>
 #include <climits>
+#include <vector>
 
 #include "SDLCompat.h"
 #ifdef ANDROID
@@ -47,6 +48,7 @@
 #include "game/Brush.h"
 #include "game/Menus.h"
 #include "game/Sign.h"
+#include "graphics/Primitives.h"
 #include "graphics/Renderer.h"
 #include "interface/Engine.h"
 #include "simulation/Simulation.h"
@@ -164,9 +166,6 @@ void sdl_blit_1(int x, int y, int w, int h, pixel *src, int pitch)
 {
 	pixel *dst;
 	int j, depth3d = Engine::Ref().Get3dDepth();
-	if (SDL_MUSTLOCK(sdl_scrn))
-		if (SDL_LockSurface(sdl_scrn)<0)
-			return;
 	dst=(pixel *)sdl_scrn->pixels+y*sdl_scrn->pitch/PIXELSIZE+x;
 	if (depth3d)
 	{
@@ -257,9 +256,6 @@ void sdl_blit_1(int x, int y, int w, int h, pixel *src, int pitch)
 			}
 		}
 	}
-	if (SDL_MUSTLOCK(sdl_scrn))
-		SDL_UnlockSurface(sdl_scrn);
-	SDL_UpdateRect(sdl_scrn,0,0,0,0);
 }
 
 void sdl_blit_2(int x, int y, int w, int h, pixel *vid, int pitch)
@@ -268,10 +264,7 @@ void sdl_blit_2(int x, int y, int w, int h, pixel *vid, int pitch)
 	pixel px, lastpx, nextpx;
 	int j, depth3d = Engine::Ref().Get3dDepth();
 	int i,k;
-	if (SDL_MUSTLOCK(sdl_scrn))
-		if (SDL_LockSurface(sdl_scrn)<0)
-			return;
-	dst=(pixel *)sdl_scrn->pixels+y*sdl_scrn->pitch/PIXELSIZE+x;
+	dst=(pixel *)sdl_scrn->pixels+y*sdl_scale*sdl_scrn->pitch/PIXELSIZE+x*sdl_scale;
 	if (depth3d)
 	{
 		if (!vid3d)
@@ -349,12 +342,22 @@ void sdl_blit_2(int x, int y, int w, int h, pixel *vid, int pitch)
 			src+=pitch;
 		}
 	}
-	if (SDL_MUSTLOCK(sdl_scrn))
-		SDL_UnlockSurface(sdl_scrn);
-	SDL_UpdateRect(sdl_scrn,0,0,0,0);
 }
 
-void sdl_blit(int x, int y, int w, int h, pixel *src, int pitch)
+// Copy of the last frame sent to SDL, in screen coordinates. sdl_blit compares against it in tiles and only converts
+// and updates the tiles that changed, which matters most when SDL_UpdateRects is slow (software rendering, remote
+// sessions). It is invalid until the first full blit, and after anything that may have changed the window contents
+#define BLIT_TILE 16
+static pixel *lastBlit = NULL;
+static bool lastBlitValid = false;
+static std::vector<SDL_Rect> blitRects;
+
+void sdl_invalidate()
+{
+	lastBlitValid = false;
+}
+
+static void sdl_blit_rect(int x, int y, int w, int h, pixel *src, int pitch)
 {
 	if (sdl_scale == 2)
 		sdl_blit_2(x, y, w, h, src, pitch);
@@ -362,6 +365,90 @@ void sdl_blit(int x, int y, int w, int h, pixel *src, int pitch)
 		sdl_blit_1(x, y, w, h, src, pitch);
 }
 
+// compares one tile against lastBlit, and copies it there if it changed
+static bool update_tile(int x, int y, int w, int h, pixel *src, int pitch)
+{
+	bool changed = false;
+	for (int j = 0; j < h; j++)
+	{
+		pixel *last = lastBlit+(y+j)*(XRES+BARSIZE)+x;
+		if (changed || memcmp(last, src+j*pitch, w*PIXELSIZE))
+		{
+			memcpy(last, src+j*pitch, w*PIXELSIZE);
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+static void add_blit_rect(int x, int y, int w, int h)
+{
+	SDL_Rect rect;
+	rect.x = x*sdl_scale;
+	rect.y = y*sdl_scale;
+	rect.w = w*sdl_scale;
+	rect.h = h*sdl_scale;
+	blitRects.push_back(rect);
+}
+
+void sdl_blit(int x, int y, int w, int h, pixel *src, int pitch)
+{
+	if (!lastBlit)
+		lastBlit = (pixel*)calloc((XRES+BARSIZE)*(YRES+MENUSIZE), PIXELSIZE);
+	if (SDL_MUSTLOCK(sdl_scrn))
+		if (SDL_LockSurface(sdl_scrn)<0)
+			return;
+
+	// the 3d effect shifts pixels between tiles and draws the cursor, so it always sends the whole frame
+	int depth3d = Engine::Ref().Get3dDepth();
+	bool inScreen = x >= 0 && y >= 0 && x+w <= XRES+BARSIZE && y+h <= YRES+MENUSIZE;
+	if (!lastBlitValid || depth3d || !inScreen)
+	{
+		sdl_blit_rect(x, y, w, h, src, pitch);
+		if (SDL_MUSTLOCK(sdl_scrn))
+			SDL_UnlockSurface(sdl_scrn);
+		SDL_UpdateRect(sdl_scrn,0,0,0,0);
+
+		if (!depth3d && inScreen && !x && !y && w == XRES+BARSIZE && h == YRES+MENUSIZE)
+		{
+			for (int j = 0; j < h; j++)
+				memcpy(lastBlit+j*(XRES+BARSIZE), src+j*pitch, w*PIXELSIZE);
+			lastBlitValid = true;
+		}
+		else
+			lastBlitValid = false;
+		return;
+	}
+
+	// find the changed tiles, merging horizontal runs of them into one rectangle
+	blitRects.clear();
+	for (int ty = 0; ty < h; ty += BLIT_TILE)
+	{
+		int th = std::min(BLIT_TILE, h-ty);
+		int runStart = -1;
+		for (int tx = 0; ; tx += BLIT_TILE)
+		{
+			bool changed = tx < w && update_tile(x+tx, y+ty, std::min(BLIT_TILE, w-tx), th, src+ty*pitch+tx, pitch);
+			if (changed && runStart < 0)
+				runStart = tx;
+			else if (!changed && runStart >= 0)
+			{
+				int runEnd = std::min(tx, w);
+				sdl_blit_rect(x+runStart, y+ty, runEnd-runStart, th, src+ty*pitch+runStart, pitch);
+				add_blit_rect(x+runStart, y+ty, runEnd-runStart, th);
+				runStart = -1;
+			}
+			if (tx >= w)
+				break;
+		}
+	}
+
+	if (SDL_MUSTLOCK(sdl_scrn))
+		SDL_UnlockSurface(sdl_scrn);
+	if (blitRects.size())
+		SDL_UpdateRects(sdl_scrn, blitRects.size(), &blitRects[0]);
+}
+
 //an easy way to draw a blob
 void drawblob(pixel *vid, int x, int y, unsigned char cr, unsigned char cg, unsigned char cb)
 {
@@ -817,68 +904,18 @@ void drawpixel(pixel *vid, int x, int y, int r, int g, int b, int a)
 
 int drawchar(pixel *vid, int x, int y, int c, int r, int g, int b, int a)
 {
-	int bn = 0, ba = 0;
-	unsigned char *rp = font_data + font_ptrs[c];
-	signed char w = *(rp++);
-	unsigned char flags = *(rp++);
-	signed char t = (flags&0x4) ? -(flags&0x3) : flags&0x3;
-	signed char l = (flags&0x20) ? -((flags>>3)&0x3) : (flags>>3)&0x3;
-	flags >>= 6;
-	if (flags&0x2)
-	{
-		/*a = *(rp++);
-		r = *(rp++);
-		g = *(rp++);
-		b = *(rp++);*/
-		rp += 4;
-	}
-	for (int j = 0; j < FONT_H; j++)
-		for (int i = 0; i < w && i<FONT_W; i++)
-		{
-			if (!bn)
-			{
-				ba = *(rp++);
-				bn = 8;
-			}
-			drawpixel(vid, x+i+l, y+j+t, r, g, b, ((ba&3)*a)/3);
-			ba >>= 2;
-			bn -= 2;
-		}
-	return x + (flags&0x01 ? 0 : w);
+	const glyph *gl = get_glyph(c);
+	draw_glyph(vid, XRES+BARSIZE, YRES+MENUSIZE, x, y, gl, r, g, b, a);
+	return x + (gl->flags&0x01 ? 0 : gl->w);
 }
 
 int addchar(pixel *vid, int x, int y, int c, int r, int g, int b, int a)
 {
-	int bn = 0, ba = 0;
-	unsigned char *rp = font_data + font_ptrs[c];
-	signed char w = *(rp++);
-	unsigned char flags = *(rp++);
-	signed char t = (flags&0x4) ? -(flags&0x3) : flags&0x3;
-	signed char l = (flags&0x20) ? -((flags>>3)&0x3) : (flags>>3)&0x3;
-	flags >>= 6;
-	if (flags&0x2)
-	{
-		/*a = *(rp++);
-		r = *(rp++);
-		g = *(rp++);
-		b = *(rp++);*/
-		rp += 4;
-	}
+	const glyph *gl = get_glyph(c);
 	for (int j = 0; j < FONT_H; j++)
-		for (int i = 0; i < w && i < FONT_W; i++)
-		{
-			if (!bn)
-			{
-				ba = *(rp++);
-				bn = 8;
-			}
-			{
-			addpixel(vid, x+i+l, y+j+t, r, g, b, ((ba&3)*a)/3);
-			}
-			ba >>= 2;
-			bn -= 2;
-		}
-	return x + (flags&0x1 ? 0 : w);
+		for (int i = gl->rowStart[j]; i < gl->rowEnd[j]; i++)
+			addpixel(vid, x+i+gl->left, y+j+gl->top, r, g, b, (gl->level[j][i]*a)/3);
+	return x + (gl->flags&0x1 ? 0 : gl->w);
 }
 
 int drawtext(pixel *vid, int x, int y, const char *s, int r, int g, int b, int a)
@@ -1213,26 +1250,20 @@ highlightwrapend:
 //draws a rectange, (x,y) are the top left coords.
 void drawrect(pixel *vid, int x, int y, int w, int h, int r, int g, int b, int a)
 {
-	int i;
-	for (i=0; i<=w; i++)
+	// corners are part of the top and bottom lines
+	blend_rect(vid, XRES+BARSIZE, YRES+MENUSIZE, x, y, w+1, 1, r, g, b, a);
+	blend_rect(vid, XRES+BARSIZE, YRES+MENUSIZE, x, y+h, w+1, 1, r, g, b, a);
+	if (h > 1)
 	{
-		drawpixel(vid, x+i, y, r, g, b, a);
-		drawpixel(vid, x+i, y+h, r, g, b, a);
-	}
-	for (i=1; i<h; i++)
-	{
-		drawpixel(vid, x, y+i, r, g, b, a);
-		drawpixel(vid, x+w, y+i, r, g, b, a);
+		blend_rect(vid, XRES+BARSIZE, YRES+MENUSIZE, x, y+1, 1, h-1, r, g, b, a);
+		blend_rect(vid, XRES+BARSIZE, YRES+MENUSIZE, x+w, y+1, 1, h-1, r, g, b, a);
 	}
 }
 
-//draws a rectangle and fills it in as well.
+//draws a rectangle and fills it in as well. Note that the border (x,y) and (x+w,y+h) isn't included
 void fillrect(pixel *vid, int x, int y, int w, int h, int r, int g, int b, int a)
 {
-	int i,j;
-	for (j=1; j<h; j++)
-		for (i=1; i<w; i++)
-			drawpixel(vid, x+i, y+j, r, g, b, a);
+	blend_rect(vid, XRES+BARSIZE, YRES+MENUSIZE, x+1, y+1, w-1, h-1, r, g, b, a);
 }
 
 void drawcircle(pixel* vid, int x, int y, int rx, int ry, int r, int g, int b, int a)
@@ -1766,77 +1797,83 @@ void draw_icon(pixel *vid_buf, int x, int y, char ch, int flag)
 		drawtext(vid_buf, x+3, y+2, t, 255, 255, 255, 255);
 	}
 }
+
+// colors of one row of air cells for the current air display mode. The mode is checked once per row
+// so each loop only reads the arrays it needs
+static void air_row_colors(Simulation * sim, int y, pixel *colors)
+{
+	const float *pv = sim->air->pv[y], *vx = sim->air->vx[y], *vy = sim->air->vy[y];
+	if (display_mode & DISPLAY_AIRP)
+	{
+		for (int x = 0; x < XRES/CELL; x++)
+		{
+			if (pv[x] > 0.0f)
+				colors[x] = PIXRGB(clamp_flt(pv[x], 0.0f, 8.0f), 0, 0);//positive pressure is red!
+			else
+				colors[x] = PIXRGB(0, 0, clamp_flt(-pv[x], 0.0f, 8.0f));//negative pressure is blue!
+		}
+	}
+	else if (display_mode & DISPLAY_AIRV)
+	{
+		for (int x = 0; x < XRES/CELL; x++)
+			colors[x] = PIXRGB(clamp_flt(fabsf(vx[x]), 0.0f, 8.0f),//vx adds red
+			                   clamp_flt(pv[x], 0.0f, 8.0f),//pressure adds green
+			                   clamp_flt(fabsf(vy[x]), 0.0f, 8.0f));//vy adds blue
+	}
+	else if (display_mode & DISPLAY_AIRH)
+	{
+		if (!aheat_enable)
+		{
+			std::fill(colors, colors+XRES/CELL, 0);
+			return;
+		}
+		const float *hv = sim->air->hv[y];
+		for (int x = 0; x < XRES/CELL; x++)
+		{
+			float ttemp = hv[x]+(-MIN_TEMP);
+			int caddress = (int)restrict_flt((int)( restrict_flt(ttemp, 0.0f, (float)MAX_TEMP+(-MIN_TEMP)) / ((MAX_TEMP+(-MIN_TEMP))/1024) ) *3.0f, 0.0f, (1024.0f*3)-3);
+			colors[x] = PIXRGB((int)((unsigned char)color_data[caddress]*0.7f), (int)((unsigned char)color_data[caddress+1]*0.7f), (int)((unsigned char)color_data[caddress+2]*0.7f));
+		}
+	}
+	else if (display_mode & DISPLAY_AIRC)
+	{
+		for (int x = 0; x < XRES/CELL; x++)
+		{
+			// velocity adds grey
+			float avx = fabsf(vx[x]), avy = fabsf(vy[x]);
+			int r = clamp_flt(avx, 0.0f, 24.0f) + clamp_flt(avy, 0.0f, 20.0f);
+			int g = clamp_flt(avx, 0.0f, 20.0f) + clamp_flt(avy, 0.0f, 24.0f);
+			int b = clamp_flt(avx, 0.0f, 24.0f) + clamp_flt(avy, 0.0f, 20.0f);
+			if (pv[x] > 0.0f)
+				r += clamp_flt(pv[x], 0.0f, 16.0f);//pressure adds red!
+			else
+				b += clamp_flt(-pv[x], 0.0f, 16.0f);//pressure adds blue!
+			colors[x] = PIXRGB(std::min(r, 255), std::min(g, 255), std::min(b, 255));
+		}
+	}
+	else
+		std::fill(colors, colors+XRES/CELL, 0);
+}
+
 void draw_air(pixel *vid, Simulation * sim)
 {
-	pixel c;
+	pixel colors[XRES/CELL];
 	for (int y = 0; y < YRES/CELL; y++)
-		for (int x = 0; x < XRES/CELL; x++)
+	{
+		air_row_colors(sim, y, colors);
+		if (finding && !(finding & 0x8))
 		{
-			if (display_mode & DISPLAY_AIRP)
-			{
-				if (sim->air->pv[y][x] > 0.0f)
-					c  = PIXRGB(clamp_flt(sim->air->pv[y][x], 0.0f, 8.0f), 0, 0);//positive pressure is red!
-				else
-					c  = PIXRGB(0, 0, clamp_flt(-sim->air->pv[y][x], 0.0f, 8.0f));//negative pressure is blue!
-			}
-			else if (display_mode & DISPLAY_AIRV)
-			{
-				c  = PIXRGB(clamp_flt(fabsf(sim->air->vx[y][x]), 0.0f, 8.0f),//vx adds red
-				clamp_flt(sim->air->pv[y][x], 0.0f, 8.0f),//pressure adds green
-				clamp_flt(fabsf(sim->air->vy[y][x]), 0.0f, 8.0f));//vy adds blue
-			}
-			else if (display_mode & DISPLAY_AIRH)
-			{
-				if (!aheat_enable)
-					c = 0;
-				else
-				{
-					float ttemp = sim->air->hv[y][x]+(-MIN_TEMP);
-					int caddress = (int)restrict_flt((int)( restrict_flt(ttemp, 0.0f, (float)MAX_TEMP+(-MIN_TEMP)) / ((MAX_TEMP+(-MIN_TEMP))/1024) ) *3.0f, 0.0f, (1024.0f*3)-3);
-					c = PIXRGB((int)((unsigned char)color_data[caddress]*0.7f), (int)((unsigned char)color_data[caddress+1]*0.7f), (int)((unsigned char)color_data[caddress+2]*0.7f));
-				}
-			}
-			else if (display_mode & DISPLAY_AIRC)
-			{
-				int r;
-				int g;
-				int b;
-				// velocity adds grey
-				r = clamp_flt(fabsf(sim->air->vx[y][x]), 0.0f, 24.0f) + clamp_flt(fabsf(sim->air->vy[y][x]), 0.0f, 20.0f);
-				g = clamp_flt(fabsf(sim->air->vx[y][x]), 0.0f, 20.0f) + clamp_flt(fabsf(sim->air->vy[y][x]), 0.0f, 24.0f);
-				b = clamp_flt(fabsf(sim->air->vx[y][x]), 0.0f, 24.0f) + clamp_flt(fabsf(sim->air->vy[y][x]), 0.0f, 20.0f);
-				if (sim->air->pv[y][x] > 0.0f)
-				{
-					r += clamp_flt(sim->air->pv[y][x], 0.0f, 16.0f);//pressure adds red!
-					if (r>255)
-						r=255;
-					if (g>255)
-						g=255;
-					if (b>255)
-						b=255;
-					c  = PIXRGB(r, g, b);
-				}
-				else
-				{
-					b += clamp_flt(-sim->air->pv[y][x], 0.0f, 16.0f);//pressure adds blue!
-					if (r>255)
-						r=255;
-					if (g>255)
-						g=255;
-					if (b>255)
-						b=255;
-					c  = PIXRGB(r, g, b);
-				}
-			}
-			if (finding && !(finding & 0x8))
-			{
-				c = PIXRGB(PIXR(c)/10,PIXG(c)/10,PIXB(c)/10);
-			}
-			// Draws the colors
-			for (int j = 0; j < CELL; j++)
-				for (int i = 0; i < CELL; i++)
-					vid[(x*CELL+i) + (y*CELL+j)*(XRES+BARSIZE)] = c;
+			for (int x = 0; x < XRES/CELL; x++)
+				colors[x] = PIXRGB(PIXR(colors[x])/10,PIXG(colors[x])/10,PIXB(colors[x])/10);
 		}
+
+		// Draws the colors, the first row of pixels is built from the cell colors and then copied to the rest of the cell
+		pixel *row = vid+(y*CELL)*(XRES+BARSIZE);
+		for (int x = 0; x < XRES/CELL; x++)
+			std::fill(row+x*CELL, row+(x+1)*CELL, colors[x]);
+		for (int j = 1; j < CELL; j++)
+			std::copy(row, row+XRES, row+j*(XRES+BARSIZE));
+	}
 }
 
 void draw_grav_zones(pixel * vid)
@@ -2028,6 +2065,11 @@ void blend_line(pixel *vid, int x1, int y1, int x2, int y2, int r, int g, int b,
 		y1 = y2;
 		y2 = y;
 	}
+	if (!cp && y1 == y2 && a > 0 && a <= 255)
+	{
+		blend_rect(vid, XRES+BARSIZE, YRES+MENUSIZE, x1, y1, x2-x1+1, 1, r, g, b, a);
+		return;
+	}
 	dx = x2 - x1;
 	dy = abs(y2 - y1);
 	e = 0.0f;
@@ -2829,265 +2871,381 @@ void draw_find(Simulation * sim)
 	}
 }
 
-void draw_walls(pixel *vid, Simulation * sim)
+// Walls are rasterized once into this layer, and copied to the screen every frame through the mask.
+// A cell is only redrawn when its wall type, its power state (EWALL / EHOLE) or the find highlight changes
+static pixel wallLayer[YRES][XRES];
+static pixel wallMask[YRES][XRES]; // all bits set where the layer has a wall pixel
+static unsigned char wallLayerType[YRES/CELL][XRES/CELL];
+static unsigned char wallLayerPowered[YRES/CELL][XRES/CELL];
+static int wallLayerFinding = 0;
+static int wallLayerTools[3] = {-1, -1, -1};
+
+static inline void wall_pixel(int x, int y, pixel c)
 {
-	for (int y = 0; y < YRES/CELL; y++)
-		for (int x =0; x < XRES/CELL; x++)
-			if (bmap[y][x])
-			{
-				unsigned char wt = bmap[y][x];
-				if (wt >= WALLCOUNT)
-					continue;
-				unsigned char powered = emap[y][x];
-				pixel pc = PIXPACK(wallTypes[wt].colour);
-				pixel gc = PIXPACK(wallTypes[wt].eglow);
+	wallLayer[y][x] = c;
+	wallMask[y][x] = ~(pixel)0;
+}
 
-				if (finding)
-				{
-					if ((finding & 0x1) && wt == ((WallTool*)activeTools[0])->GetID())
-					{
-						pc = PIXRGB(255,0,0);
-						gc = PIXRGB(255,0,0);
-					}
-					else if ((finding & 0x2) && wt == ((WallTool*)activeTools[1])->GetID())
-					{
-						pc = PIXRGB(0,0,255);
-						gc = PIXRGB(0,0,255);
-					}
-					else if ((finding & 0x4) && wt == ((WallTool*)activeTools[2])->GetID())
-					{
-						pc = PIXRGB(0,255,0);
-						gc = PIXRGB(0,255,0);
-					}
-					else if (!(finding &0x8))
-					{
-						pc = PIXRGB(PIXR(pc)/10,PIXG(pc)/10,PIXB(pc)/10);
-						gc = PIXRGB(PIXR(gc)/10,PIXG(gc)/10,PIXB(gc)/10);
-					}
-				}
+static void clear_wall_cell(int x, int y)
+{
+	for (int j = 0; j < CELL; j++)
+	{
+		std::fill(&wallLayer[y*CELL+j][x*CELL], &wallLayer[y*CELL+j][x*CELL+CELL], 0);
+		std::fill(&wallMask[y*CELL+j][x*CELL], &wallMask[y*CELL+j][x*CELL+CELL], 0);
+	}
+}
+
+static void wall_colors(unsigned char wt, const int tools[3], pixel *pc, pixel *gc)
+{
+	*pc = PIXPACK(wallTypes[wt].colour);
+	*gc = PIXPACK(wallTypes[wt].eglow);
+	if (finding)
+	{
+		if ((finding & 0x1) && wt == tools[0])
+		{
+			*pc = PIXRGB(255,0,0);
+			*gc = PIXRGB(255,0,0);
+		}
+		else if ((finding & 0x2) && wt == tools[1])
+		{
+			*pc = PIXRGB(0,0,255);
+			*gc = PIXRGB(0,0,255);
+		}
+		else if ((finding & 0x4) && wt == tools[2])
+		{
+			*pc = PIXRGB(0,255,0);
+			*gc = PIXRGB(0,255,0);
+		}
+		else if (!(finding &0x8))
+		{
+			*pc = PIXRGB(PIXR(*pc)/10,PIXG(*pc)/10,PIXB(*pc)/10);
+			*gc = PIXRGB(PIXR(*gc)/10,PIXG(*gc)/10,PIXB(*gc)/10);
+		}
+	}
+}
 
-				switch (wallTypes[wt].drawstyle)
+// rasterize the wall pattern for cell (x, y) into the layer
+static void render_wall_cell(int x, int y, unsigned char wt, unsigned char powered, const int tools[3])
+{
+	pixel pc, gc;
+	wall_colors(wt, tools, &pc, &gc);
+	clear_wall_cell(x, y);
+
+	switch (wallTypes[wt].drawstyle)
+	{
+	case 0:
+		if (wt == WL_EWALL)
+		{
+			if (powered)
+			{
+				for (int j = 0; j < CELL; j++)
+					for (int i =0; i < CELL; i++)
+						if (i&j&1)
+							wall_pixel(x*CELL+i, y*CELL+j, pc);
+			}
+			else
+			{
+				for (int j = 0; j < CELL; j++)
+					for (int i = 0; i < CELL; i++)
+						if (!(i&j&1))
+							wall_pixel(x*CELL+i, y*CELL+j, pc);
+			}
+		}
+		else if (wt == WL_WALLELEC)
+		{
+			for (int j = 0; j < CELL; j++)
+				for (int i = 0; i < CELL; i++)
 				{
-				case 0:
-					if (wt == WL_EWALL)
-					{
-						if (powered)
-						{
-							for (int j = 0; j < CELL; j++)
-								for (int i =0; i < CELL; i++)
-									if (i&j&1)
-										vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = pc;
-						}
-						else
-						{
-							for (int j = 0; j < CELL; j++)
-								for (int i = 0; i < CELL; i++)
-									if (!(i&j&1))
-										vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = pc;
-						}
-					}
-					else if (wt == WL_WALLELEC)
-					{
-						for (int j = 0; j < CELL; j++)
-							for (int i = 0; i < CELL; i++)
-							{
-								if (!((y*CELL+j)%2) && !((x*CELL+i)%2))
-									vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = pc;
-								else
-									vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = PIXPACK(0x808080);
-							}
-					}
-					else if (wt == WL_EHOLE)
-					{
-						if (powered)
-						{
-							for (int j = 0; j < CELL; j++)
-								for (int i = 0; i < CELL; i++)
-									vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = PIXPACK(0x242424);
-							for (int j = 0; j < CELL; j += 2)
-								for (int i = 0; i < CELL; i += 2)
-									vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = PIXPACK(0x000000);
-						}
-						else
-						{
-							for (int j = 0; j < CELL; j += 2)
-								for (int i =0; i < CELL; i += 2)
-									vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = PIXPACK(0x242424);
-						}
-					}
-					else if (wt == WL_STREAM)
-					{
-						float xf = x*CELL + CELL*0.5f;
-						float yf = y*CELL + CELL*0.5f;
-						int oldX = (int)(xf+0.5f), oldY = (int)(yf+0.5f);
-						int newX, newY;
-						float xVel = sim->air->vx[y][x]*0.125f, yVel = sim->air->vy[y][x]*0.125f;
-						// there is no velocity here, draw a streamline and continue
-						if (!xVel && !yVel)
-						{
-							drawtext(vid, x*CELL, y*CELL-2, "\x8D", 255, 255, 255, 128);
-							drawpixel(vid, oldX, oldY, 255, 255, 255, 255);
-							continue;
-						}
-						bool changed = false;
-						for (int t = 0; t < 1024; t++)
-						{
-							newX = (int)(xf+0.5f);
-							newY = (int)(yf+0.5f);
-							if (newX != oldX || newY != oldY)
-							{
-								changed = true;
-								oldX = newX;
-								oldY = newY;
-							}
-							if (changed && (newX<0 || newX>=XRES || newY<0 || newY>=YRES))
-								break;
-							addpixel(vid, newX, newY, 255, 255, 255, 64);
-							// cache velocity and other checks so we aren't running them constantly
-							if (changed)
-							{
-								int wallX = newX/CELL;
-								int wallY = newY/CELL;
-								xVel = sim->air->vx[wallY][wallX]*0.125f;
-								yVel = sim->air->vy[wallY][wallX]*0.125f;
-								if (wallX != x && wallY != y && bmap[wallY][wallX] == WL_STREAM)
-									break;
-							}
-							xf += xVel;
-							yf += yVel;
-						}
-						drawtext(vid, x*CELL, y*CELL-2, "\x8D", 255, 255, 255, 128);
-					}
-					break;
-				case 1:
-					for (int j = 0; j < CELL; j += 2)
-						for (int i = (j>>1)&1; i < CELL; i += 2)
-							vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = pc;
-					break;
-				case 2:
-					for (int j = 0; j < CELL; j += 2)
-						for (int i = 0; i < CELL; i += 2)
-							vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = pc;
-					break;
-				case 3:
-					for (int j = 0; j < CELL; j++)
-						for (int i = 0; i < CELL; i++)
-							vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = pc;
-					break;
-				case 4:
-					for (int j = 0; j < CELL; j++)
-						for (int i = 0; i < CELL; i++)
-							if (i == j)
-								vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = pc;
-							else if (i == j+1 || (i == 0 && j == CELL-1))
-								vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = gc;
-							else
-								vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = PIXPACK(0x202020);
-					break;
+					if (!((y*CELL+j)%2) && !((x*CELL+i)%2))
+						wall_pixel(x*CELL+i, y*CELL+j, pc);
+					else
+						wall_pixel(x*CELL+i, y*CELL+j, PIXPACK(0x808080));
 				}
+		}
+		else if (wt == WL_EHOLE)
+		{
+			if (powered)
+			{
+				for (int j = 0; j < CELL; j++)
+					for (int i = 0; i < CELL; i++)
+						wall_pixel(x*CELL+i, y*CELL+j, PIXPACK(0x242424));
+				for (int j = 0; j < CELL; j += 2)
+					for (int i = 0; i < CELL; i += 2)
+						wall_pixel(x*CELL+i, y*CELL+j, PIXPACK(0x000000));
+			}
+			else
+			{
+				for (int j = 0; j < CELL; j += 2)
+					for (int i =0; i < CELL; i += 2)
+						wall_pixel(x*CELL+i, y*CELL+j, PIXPACK(0x242424));
+			}
+		}
+		break;
+	case 1:
+		for (int j = 0; j < CELL; j += 2)
+			for (int i = (j>>1)&1; i < CELL; i += 2)
+				wall_pixel(x*CELL+i, y*CELL+j, pc);
+		break;
+	case 2:
+		for (int j = 0; j < CELL; j += 2)
+			for (int i = 0; i < CELL; i += 2)
+				wall_pixel(x*CELL+i, y*CELL+j, pc);
+		break;
+	case 3:
+		for (int j = 0; j < CELL; j++)
+			for (int i = 0; i < CELL; i++)
+				wall_pixel(x*CELL+i, y*CELL+j, pc);
+		break;
+	case 4:
+		for (int j = 0; j < CELL; j++)
+			for (int i = 0; i < CELL; i++)
+				if (i == j)
+					wall_pixel(x*CELL+i, y*CELL+j, pc);
+				else if (i == j+1 || (i == 0 && j == CELL-1))
+					wall_pixel(x*CELL+i, y*CELL+j, gc);
+				else
+					wall_pixel(x*CELL+i, y*CELL+j, PIXPACK(0x202020));
+		break;
+	}
+}
 
-				// when in blob view, draw some blobs...
-				if (render_mode & PMODE_BLOB)
+// copies the wall layer in the pixel rectangle x1 <= x < x2, y1 <= y < y2 to the screen
+static void draw_wall_layer(pixel *vid, int x1, int x2, int y1, int y2)
+{
+	for (int y = y1; y < y2; y++)
+	{
+		pixel *dst = vid+y*(XRES+BARSIZE);
+		const pixel *src = wallLayer[y], *mask = wallMask[y];
+		// the layer is 0 outside of the mask, so this doesn't need any branches
+		for (int x = x1; x < x2; x++)
+			dst[x] = (dst[x] & ~mask[x]) | src[x];
+	}
+}
+
+static inline bool streamline_moving(Simulation * sim, int x, int y)
+{
+	return sim->air->vx[y][x]*0.125f != 0.0f || sim->air->vy[y][x]*0.125f != 0.0f;
+}
+
+// returns false if there is no air movement in the cell
+static bool draw_streamline(pixel *vid, Simulation * sim, int x, int y)
+{
+	float xf = x*CELL + CELL*0.5f;
+	float yf = y*CELL + CELL*0.5f;
+	int oldX = (int)(xf+0.5f), oldY = (int)(yf+0.5f);
+	int newX, newY;
+	float xVel = sim->air->vx[y][x]*0.125f, yVel = sim->air->vy[y][x]*0.125f;
+	// there is no velocity here, draw a streamline and continue
+	if (!xVel && !yVel)
+	{
+		drawtext(vid, x*CELL, y*CELL-2, "\x8D", 255, 255, 255, 128);
+		drawpixel(vid, oldX, oldY, 255, 255, 255, 255);
+		return false;
+	}
+	bool changed = false;
+	for (int t = 0; t < 1024; t++)
+	{
+		newX = (int)(xf+0.5f);
+		newY = (int)(yf+0.5f);
+		if (newX != oldX || newY != oldY)
+		{
+			changed = true;
+			oldX = newX;
+			oldY = newY;
+		}
+		if (changed && (newX<0 || newX>=XRES || newY<0 || newY>=YRES))
+			break;
+		addpixel(vid, newX, newY, 255, 255, 255, 64);
+		// cache velocity and other checks so we aren't running them constantly
+		if (changed)
+		{
+			int wallX = newX/CELL;
+			int wallY = newY/CELL;
+			xVel = sim->air->vx[wallY][wallX]*0.125f;
+			yVel = sim->air->vy[wallY][wallX]*0.125f;
+			if (wallX != x && wallY != y && bmap[wallY][wallX] == WL_STREAM)
+				break;
+		}
+		xf += xVel;
+		yf += yVel;
+	}
+	drawtext(vid, x*CELL, y*CELL-2, "\x8D", 255, 255, 255, 128);
+	return true;
+}
+
+// blob view draws blobs over the wall pattern, these blend into the neighbouring cells so they aren't cached
+static void draw_wall_blobs(pixel *vid, int x, int y, unsigned char wt, unsigned char powered, pixel pc, pixel gc)
+{
+	switch (wallTypes[wt].drawstyle)
+	{
+	case 0:
+		if (wt == WL_EWALL)
+		{
+			if (powered)
+			{
+				for (int j = 0; j < CELL; j++)
+					for (int i =0; i < CELL; i++)
+						if (i&j&1)
+							drawblob(vid, (x*CELL+i), (y*CELL+j), 0x80, 0x80, 0x80);
+			}
+			else
+			{
+				for (int j = 0; j < CELL; j++)
+					for (int i = 0; i < CELL; i++)
+						if (!(i&j&1))
+							drawblob(vid, (x*CELL+i), (y*CELL+j), 0x80, 0x80, 0x80);
+			}
+		}
+		else if (wt == WL_WALLELEC)
+		{
+			for (int j = 0; j < CELL; j++)
+				for (int i =0; i < CELL; i++)
 				{
-					switch (wallTypes[wt].drawstyle)
-					{
-					case 0:
-						if (wt == WL_EWALL)
-						{
-							if (powered)
-							{
-								for (int j = 0; j < CELL; j++)
-									for (int i =0; i < CELL; i++)
-										if (i&j&1)
-											drawblob(vid, (x*CELL+i), (y*CELL+j), 0x80, 0x80, 0x80);
-							}
-							else
-							{
-								for (int j = 0; j < CELL; j++)
-									for (int i = 0; i < CELL; i++)
-										if (!(i&j&1))
-											drawblob(vid, (x*CELL+i), (y*CELL+j), 0x80, 0x80, 0x80);
-							}
-						}
-						else if (wt == WL_WALLELEC)
-						{
-							for (int j = 0; j < CELL; j++)
-								for (int i =0; i < CELL; i++)
-								{
-									if (!((y*CELL+j)%2) && !((x*CELL+i)%2))
-										drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
-									else
-										drawblob(vid, (x*CELL+i), (y*CELL+j), 0x80, 0x80, 0x80);
-								}
-						}
-						else if (wt == WL_EHOLE)
-						{
-							if (powered)
-							{
-								for (int j = 0; j < CELL; j++)
-									for (int i = 0; i < CELL; i++)
-										drawblob(vid, (x*CELL+i), (y*CELL+j), 0x24, 0x24, 0x24);
-								for (int j = 0; j < CELL; j += 2)
-									for (int i = 0; i < CELL; i += 2)
-										// looks bad if drawing black blobs
-										vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = PIXPACK(0x000000);
-							}
-							else
-							{
-								for (int j = 0; j < CELL; j += 2)
-									for (int i = 0; i < CELL; i += 2)
-										drawblob(vid, (x*CELL+i), (y*CELL+j), 0x24, 0x24, 0x24);
-							}
-						}
-						break;
-					 case 1:
-						for (int j = 0; j < CELL; j += 2)
-							for (int i = (j>>1)&1; i < CELL; i += 2)
-								drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
-						break;
-					case 2:
-						for (int j = 0; j < CELL; j += 2)
-							for (int i = 0; i < CELL; i+=2)
-								drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
-						break;
-					case 3:
-						for (int j = 0; j < CELL; j++)
-							for (int i = 0; i < CELL; i++)
-								drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
-						break;
-					case 4:
-						for (int j = 0; j < CELL; j++)
-							for (int i = 0; i < CELL; i++)
-								if (i == j)
-									drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
-								else if (i == j+1 || (i == 0 && j == CELL-1))
-									drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(gc), PIXG(gc), PIXB(gc));
-								else
-									drawblob(vid, (x*CELL+i), (y*CELL+j), 0x20, 0x20, 0x20);
-						break;
-					}
+					if (!((y*CELL+j)%2) && !((x*CELL+i)%2))
+						drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
+					else
+						drawblob(vid, (x*CELL+i), (y*CELL+j), 0x80, 0x80, 0x80);
 				}
+		}
+		else if (wt == WL_EHOLE)
+		{
+			if (powered)
+			{
+				for (int j = 0; j < CELL; j++)
+					for (int i = 0; i < CELL; i++)
+						drawblob(vid, (x*CELL+i), (y*CELL+j), 0x24, 0x24, 0x24);
+				for (int j = 0; j < CELL; j += 2)
+					for (int i = 0; i < CELL; i += 2)
+						// looks bad if drawing black blobs
+						vid[(y*CELL+j)*(XRES+BARSIZE)+(x*CELL+i)] = PIXPACK(0x000000);
+			}
+			else
+			{
+				for (int j = 0; j < CELL; j += 2)
+					for (int i = 0; i < CELL; i += 2)
+						drawblob(vid, (x*CELL+i), (y*CELL+j), 0x24, 0x24, 0x24);
+			}
+		}
+		break;
+	case 1:
+		for (int j = 0; j < CELL; j += 2)
+			for (int i = (j>>1)&1; i < CELL; i += 2)
+				drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
+		break;
+	case 2:
+		for (int j = 0; j < CELL; j += 2)
+			for (int i = 0; i < CELL; i+=2)
+				drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
+		break;
+	case 3:
+		for (int j = 0; j < CELL; j++)
+			for (int i = 0; i < CELL; i++)
+				drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
+		break;
+	case 4:
+		for (int j = 0; j < CELL; j++)
+			for (int i = 0; i < CELL; i++)
+				if (i == j)
+					drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(pc), PIXG(pc), PIXB(pc));
+				else if (i == j+1 || (i == 0 && j == CELL-1))
+					drawblob(vid, (x*CELL+i), (y*CELL+j), PIXR(gc), PIXG(gc), PIXB(gc));
+				else
+					drawblob(vid, (x*CELL+i), (y*CELL+j), 0x20, 0x20, 0x20);
+		break;
+	}
+}
 
-				if (wallTypes[wt].eglow && powered)
+void draw_walls(pixel *vid, Simulation * sim)
+{
+	int tools[3];
+	for (int k = 0; k < 3; k++)
+		tools[k] = (finding & (1<<k)) ? ((WallTool*)activeTools[k])->GetID() : -1;
+	// the find highlight changes the colors of every wall
+	bool redrawAll = finding != wallLayerFinding || !std::equal(tools, tools+3, wallLayerTools);
+	wallLayerFinding = finding;
+	std::copy(tools, tools+3, wallLayerTools);
+
+	// blobs spill into the neighbouring cells, so in blob view every cell is drawn in order like before
+	bool blobs = (render_mode & PMODE_BLOB) != 0;
+	bool streams = false;
+	for (int y = 0; y < YRES/CELL; y++)
+	{
+		int first = XRES/CELL, last = -1;
+		for (int x = 0; x < XRES/CELL; x++)
+		{
+			unsigned char wt = bmap[y][x];
+			if (wt >= WALLCOUNT)
+				wt = 0;
+			unsigned char powered = emap[y][x];
+			// streamlines follow the air every frame, so they aren't cached
+			unsigned char layerType = wt == WL_STREAM ? 0 : wt;
+			// other walls look the same whether they are powered or not
+			unsigned char layerPowered = (wt == WL_EWALL || wt == WL_EHOLE) && powered;
+			if (redrawAll || wallLayerType[y][x] != layerType || wallLayerPowered[y][x] != layerPowered)
+			{
+				if (layerType)
+					render_wall_cell(x, y, layerType, layerPowered, tools);
+				else
+					clear_wall_cell(x, y);
+				wallLayerType[y][x] = layerType;
+				wallLayerPowered[y][x] = layerPowered;
+			}
+			if (!wt)
+				continue;
+
+			if (wt == WL_STREAM)
+			{
+				streams = true;
+				// outside of blob view the streamline is drawn after the wall layer. Streamlines without air movement don't glow
+				if (blobs ? !draw_streamline(vid, sim, x, y) : !streamline_moving(sim, x, y))
+					continue;
+			}
+			else
+			{
+				if (x < first)
+					first = x;
+				last = x;
+				if (blobs)
 				{
-					// glow if electrified
-					ARGBColour glow = wallTypes[wt].eglow;
-					int alpha = 255;
-					int cr = (alpha*COLR(glow) + (255-alpha)*fire_r[y/CELL][x/CELL]) >> 8;
-					int cg = (alpha*COLG(glow) + (255-alpha)*fire_g[y/CELL][x/CELL]) >> 8;
-					int cb = (alpha*COLB(glow) + (255-alpha)*fire_b[y/CELL][x/CELL]) >> 8;
-
-					if (cr > 255)
-						cr = 255;
-					if (cg > 255)
-						cg = 255;
-					if (cb > 255)
-						cb = 255;
-					fire_r[y][x] = cr;
-					fire_g[y][x] = cg;
-					fire_b[y][x] = cb;
+					pixel pc, gc;
+					wall_colors(wt, tools, &pc, &gc);
+					draw_wall_layer(vid, x*CELL, x*CELL+CELL, y*CELL, y*CELL+CELL);
+					draw_wall_blobs(vid, x, y, wt, powered, pc, gc);
 				}
 			}
+
+			if (wallTypes[wt].eglow && powered)
+			{
+				// glow if electrified
+				ARGBColour glow = wallTypes[wt].eglow;
+				int alpha = 255;
+				int cr = (alpha*COLR(glow) + (255-alpha)*fire_r[y/CELL][x/CELL]) >> 8;
+				int cg = (alpha*COLG(glow) + (255-alpha)*fire_g[y/CELL][x/CELL]) >> 8;
+				int cb = (alpha*COLB(glow) + (255-alpha)*fire_b[y/CELL][x/CELL]) >> 8;
+
+				if (cr > 255)
+					cr = 255;
+				if (cg > 255)
+					cg = 255;
+				if (cb > 255)
+					cb = 255;
+				fire_r[y][x] = cr;
+				fire_g[y][x] = cg;
+				fire_b[y][x] = cb;
+			}
+		}
+		if (!blobs && last >= first)
+			draw_wall_layer(vid, first*CELL, (last+1)*CELL, y*CELL, y*CELL+CELL);
+	}
+
+	// drawn on top of all other walls
+	if (streams && !blobs)
+	{
+		for (int y = 0; y < YRES/CELL; y++)
+			for (int x = 0; x < XRES/CELL; x++)
+				if (bmap[y][x] == WL_STREAM)
+					draw_streamline(vid, sim, x, y);
+	}
 }
 
 void render_signs(pixel *vid_buf, Simulation * sim)
@@ -3774,6 +3932,7 @@ int sdl_open()
 
 void SetSDLVideoMode(int width, int height)
 {
+	sdl_invalidate();
 #ifdef PIX16
 	if (kiosk_enable)
 		sdl_scrn = SDL_SetVideoMode(width, height, 16, SDL_FULLSCREEN|SDL_SWSURFACE);
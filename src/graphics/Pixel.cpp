@@ -96,6 +96,115 @@ void * ptif_pack(pixel *src, int w, int h, int *result_size)
 	return result;
 }
 
+static void png_put32(unsigned char *p, unsigned int v)
+{
+	p[0] = v>>24;
+	p[1] = v>>16;
+	p[2] = v>>8;
+	p[3] = v;
+}
+
+static unsigned int png_crc(unsigned char *data, int len)
+{
+	static unsigned int table[256];
+	static bool tableInited = false;
+	if (!tableInited)
+	{
+		for (unsigned int n = 0; n < 256; n++)
+		{
+			unsigned int c = n;
+			for (int k = 0; k < 8; k++)
+				c = (c&1) ? 0xEDB88320 ^ (c>>1) : c>>1;
+			table[n] = c;
+		}
+		tableInited = true;
+	}
+	unsigned int crc = 0xFFFFFFFF;
+	for (int i = 0; i < len; i++)
+		crc = table[(crc^data[i])&0xFF] ^ (crc>>8);
+	return crc ^ 0xFFFFFFFF;
+}
+
+// writes the length, type, data and crc of a chunk whose data is already at p+8
+static unsigned char * png_chunk(unsigned char *p, const char *type, int len)
+{
+	png_put32(p, len);
+	memcpy(p+4, type, 4);
+	png_put32(p+8+len, png_crc(p+4, len+4));
+	return p+12+len;
+}
+
+void * png_pack(pixel *src, int w, int h, int *result_size)
+{
+	// scanlines with a filter type byte (0, none) in front of each
+	int rawSize = h*(w*3+1);
+	unsigned char *raw = (unsigned char*)malloc(rawSize);
+	if (!raw)
+		return NULL;
+	unsigned char *r = raw;
+	for (int y = 0; y < h; y++)
+	{
+		*(r++) = 0;
+		for (int x = 0; x < w; x++)
+		{
+			pixel c = src[y*w+x];
+			*(r++) = PIXR(c);
+			*(r++) = PIXG(c);
+			*(r++) = PIXB(c);
+		}
+	}
+
+	// zlib stream made of stored deflate blocks, which are at most 65535 bytes each
+	int blocks = (rawSize+65534)/65535;
+	int zlibSize = 2+blocks*5+rawSize+4;
+	int size = 8+(12+13)+(12+zlibSize)+12;
+	unsigned char *result = (unsigned char*)malloc(size);
+	if (!result)
+	{
+		free(raw);
+		return NULL;
+	}
+
+	unsigned char *p = result;
+	memcpy(p, "\x89PNG\r\n\x1A\n", 8);
+	p += 8;
+
+	png_put32(p+8, w);
+	png_put32(p+12, h);
+	p[16] = 8; // bit depth
+	p[17] = 2; // truecolor
+	p[18] = p[19] = p[20] = 0; // compression, filter, no interlacing
+	p = png_chunk(p, "IHDR", 13);
+
+	unsigned char *z = p+8;
+	*(z++) = 0x78;
+	*(z++) = 0x01;
+	unsigned int a = 1, b = 0;
+	for (int pos = 0; pos < rawSize; pos += 65535)
+	{
+		int len = rawSize-pos < 65535 ? rawSize-pos : 65535;
+		*(z++) = pos+len == rawSize; // BFINAL on the last block, BTYPE 0
+		*(z++) = len;
+		*(z++) = len>>8;
+		*(z++) = ~len;
+		*(z++) = (~len)>>8;
+		memcpy(z, raw+pos, len);
+		z += len;
+		for (int i = pos; i < pos+len; i++)
+		{
+			a = (a+raw[i]) % 65521;
+			b = (b+a) % 65521;
+		}
+	}
+	png_put32(z, (b<<16)|a);
+	p = png_chunk(p, "IDAT", zlibSize);
+	png_chunk(p, "IEND", 0);
+	free(raw);
+
+	*result_size = size;
+	return result;
+}
+
 pixel * ptif_unpack(void *datain, int size, int *w, int *h)
 {
 	if (size<16)
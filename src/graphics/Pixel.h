@@ -60,6 +60,8 @@ typedef unsigned int pixel;
 char * generate_gradient(pixel * colours, float * points, int pointcount, int size);
 void * ptif_pack(pixel *src, int w, int h, int *result_size);
 pixel * ptif_unpack(void *datain, int size, int *w, int *h);
+// 24 bit PNG. zlib isn't linked, so the image data is stored uncompressed
+void * png_pack(pixel *src, int w, int h, int *result_size);
 pixel * resample_img_nn(pixel *src, int sw, int sh, int rw, int rh);
 pixel * resample_img(pixel *src, int sw, int sh, int rw, int rh);
 pixel * rescale_img(pixel *src, int sw, int sh, int *qw, int *qh, int f);
@@ -0,0 +1,151 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#ifdef X86_SSE2
+#include <emmintrin.h>
+#endif
+#define INCLUDE_FONTDATA
+#include "font.h"
+#include "Primitives.h"
+
+void blend_span(pixel *dst, int n, int r, int g, int b, int a)
+{
+	if (a <= 0 || n <= 0)
+		return;
+	if (a >= 255)
+	{
+		std::fill(dst, dst+n, (pixel)PIXRGB(r, g, b));
+		return;
+	}
+
+	int i = 0;
+#ifdef X86_SSE2
+	// Four pixels at a time, each channel is (a*c + (255-a)*d) >> 8, which always fits in 16 bits.
+	// Out of range colors would bleed into other channels in PIXRGB, so leave those to the scalar loop
+	if (r >= 0 && r <= 255 && g >= 0 && g <= 255 && b >= 0 && b <= 255)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i color = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32(PIXRGB(r, g, b)), zero), _mm_set1_epi16(a));
+		const __m128i inva = _mm_set1_epi16(255-a);
+		const __m128i mask = _mm_set1_epi32(PIXRGB(255, 255, 255));
+		for (; i+4 <= n; i += 4)
+		{
+			__m128i d = _mm_loadu_si128((__m128i*)(dst+i));
+			__m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inva), color), 8);
+			__m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inva), color), 8);
+			_mm_storeu_si128((__m128i*)(dst+i), _mm_and_si128(_mm_packus_epi16(lo, hi), mask));
+		}
+	}
+#endif
+	for (; i < n; i++)
+	{
+		pixel t = dst[i];
+		dst[i] = PIXRGB((a*r + (255-a)*PIXR(t)) >> 8, (a*g + (255-a)*PIXG(t)) >> 8, (a*b + (255-a)*PIXB(t)) >> 8);
+	}
+}
+
+void blend_rect(pixel *vid, int width, int height, int x, int y, int w, int h, int r, int g, int b, int a)
+{
+	int x2 = std::min(x+w, width), y2 = std::min(y+h, height);
+	x = std::max(x, 0);
+	y = std::max(y, 0);
+	if (x >= x2 || a <= 0)
+		return;
+	for (; y < y2; y++)
+		blend_span(vid+y*width+x, x2-x, r, g, b, a);
+}
+
+static glyph glyphs[256];
+static bool glyphsDecoded[256];
+
+const glyph *get_glyph(unsigned char c)
+{
+	glyph *gl = &glyphs[c];
+	if (glyphsDecoded[c])
+		return gl;
+
+	unsigned char *rp = font_data + font_ptrs[c];
+	gl->w = *(rp++);
+	unsigned char flags = *(rp++);
+	gl->top = (flags&0x4) ? -(flags&0x3) : flags&0x3;
+	gl->left = (flags&0x20) ? -((flags>>3)&0x3) : (flags>>3)&0x3;
+	gl->flags = flags >> 6;
+	gl->a = gl->r = gl->g = gl->b = 0;
+	if (gl->flags&0x2)
+	{
+		gl->a = *(rp++);
+		gl->r = *(rp++);
+		gl->g = *(rp++);
+		gl->b = *(rp++);
+	}
+
+	std::fill(&gl->level[0][0], &gl->level[0][0]+FONT_H*FONT_W, 0);
+	int bn = 0, ba = 0;
+	for (int j = 0; j < FONT_H; j++)
+	{
+		gl->rowStart[j] = FONT_W;
+		gl->rowEnd[j] = 0;
+		for (int i = 0; i < gl->w && i < FONT_W; i++)
+		{
+			if (!bn)
+			{
+				ba = *(rp++);
+				bn = 8;
+			}
+			gl->level[j][i] = ba&3;
+			if (ba&3)
+			{
+				gl->rowStart[j] = std::min<int>(gl->rowStart[j], i);
+				gl->rowEnd[j] = i+1;
+			}
+			ba >>= 2;
+			bn -= 2;
+		}
+	}
+	glyphsDecoded[c] = true;
+	return gl;
+}
+
+void draw_glyph(pixel *vid, int width, int height, int x, int y, const glyph *gl, int r, int g, int b, int a)
+{
+	if (a <= 0)
+		return;
+	int alphas[4];
+	for (int i = 0; i < 4; i++)
+		alphas[i] = (i*a)/3;
+
+	x += gl->left;
+	y += gl->top;
+	int jStart = std::max(0, -y), jEnd = std::min(FONT_H, height-y);
+	for (int j = jStart; j < jEnd; j++)
+	{
+		int iStart = std::max<int>(gl->rowStart[j], -x), iEnd = std::min<int>(gl->rowEnd[j], width-x);
+		pixel *row = vid+(y+j)*width+x;
+		for (int i = iStart; i < iEnd; i++)
+		{
+			int pa = alphas[gl->level[j][i]];
+			if (!pa)
+				continue;
+			if (pa == 255)
+				row[i] = PIXRGB(r, g, b);
+			else
+			{
+				pixel t = row[i];
+				row[i] = PIXRGB((pa*r + (255-pa)*PIXR(t)) >> 8, (pa*g + (255-pa)*PIXG(t)) >> 8, (pa*b + (255-pa)*PIXB(t)) >> 8);
+			}
+		}
+	}
+}
@@ -0,0 +1,51 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Span based drawing primitives shared by graphics.cpp and VideoBuffer.
+ * Callers clip once per rectangle / line / glyph and then hand whole rows
+ * to these functions, instead of bounds checking and blending every pixel
+ * separately. Results are identical to blending each pixel with drawpixel.
+ */
+
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include "Pixel.h"
+#include "font.h"
+
+// fills or blends n pixels starting at dst with the given color
+void blend_span(pixel *dst, int n, int r, int g, int b, int a);
+
+// blends a rectangle in a buffer of size width*height, (x,y) is the top left corner.
+// The rectangle is clipped to the buffer
+void blend_rect(pixel *vid, int width, int height, int x, int y, int w, int h, int r, int g, int b, int a);
+
+// Font glyph, decoded from font_data once. Each pixel is an alpha level from 0-3
+struct glyph
+{
+	signed char w, top, left;
+	unsigned char flags; // bit 0: zero width / combining char, bit 1: has its own color
+	unsigned char a, r, g, b;
+	// first and last column (exclusive) with any set pixels in each row
+	unsigned char rowStart[FONT_H], rowEnd[FONT_H];
+	unsigned char level[FONT_H][FONT_W];
+};
+
+const glyph *get_glyph(unsigned char c);
+
+// draws a glyph with its origin at (x,y), clipped to the buffer
+void draw_glyph(pixel *vid, int width, int height, int x, int y, const glyph *gl, int r, int g, int b, int a);
+
+#endif // PRIMITIVES_H
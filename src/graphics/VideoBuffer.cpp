@@ -2,6 +2,7 @@
 #include "VideoBuffer.h"
 #define INCLUDE_FONTDATA
 #include "font.h"
+#include "Primitives.h"
 #include "common/tpt-minmax.h"
 
 VideoBuffer::VideoBuffer(int width, int height):
@@ -153,73 +154,23 @@ void VideoBuffer::DrawRect(int x, int y, int w, int h, int r, int g, int b, int
 //draws a rectangle and fills it in as well.
 void VideoBuffer::FillRect(int x, int y, int w, int h, int r, int g, int b, int a)
 {
-	if (x < 0)
-	{
-		if (x+w >= 0)
-		{
-			w += x;
-			x = 0;
-		}
-		else
-			return;
-	}
-	if (y < 0)
-	{
-		if (y+h >= 0)
-		{
-			h += y;
-			y = 0;
-		}
-		else
-			return;
-	}
-	if (x+w >= width)
-		w = width-x;
-	if (y+h >= height)
-		h = height-y;
-
-	for (int j = 0; j < h; j++)
-		for (int i = 0; i < w; i++)
-			DrawPixel(x+i, y+j, r, g, b, a);
+	blend_rect(vid, width, height, x, y, w, h, r, g, b, a);
 }
 
 int VideoBuffer::DrawChar(int x, int y, unsigned char c, int r, int g, int b, int a, bool modifiedColor)
 {
-	int bn = 0, ba = 0;
-	unsigned char *rp = font_data + font_ptrs[c];
-	signed char w = *(rp++);
-	unsigned char flags = *(rp++);
-	signed char t = (flags&0x4) ? -(flags&0x3) : flags&0x3;
-	signed char l = (flags&0x20) ? -((flags>>3)&0x3) : (flags>>3)&0x3;
-	flags >>= 6;
-	if ((flags&0x2))
+	const glyph *gl = get_glyph(c);
+	if ((gl->flags&0x2) && !modifiedColor)
 	{
-		if (!modifiedColor)
-		{
-			a = *(rp++);
-			r = *(rp++);
-			g = *(rp++);
-			b = *(rp++);
-		}
-		else
-			rp += 4;
+		a = gl->a;
+		r = gl->r;
+		g = gl->g;
+		b = gl->b;
 	}
-	for (int j = 0; j < FONT_H; j++)
-		for (int i = 0; i < w && i < FONT_W; i++)
-		{
-			if (!bn)
-			{
-				ba = *(rp++);
-				bn = 8;
-			}
-			if (x+i+l >= 0 && y+j+t >= 0 && x+i+l < width && y+j+t < height)
-				DrawPixel(x+i+l, y+j+t, r, g, b, ((ba&3)*a)/3);
-			ba >>= 2;
-			bn -= 2;
-		}
-	if (flags&0x1)
-		return std::max(x+w, DrawChar(x, y, c+1, r, g, b, a, modifiedColor));
-	return x + w;
+	draw_glyph(vid, width, height, x, y, gl, r, g, b, a);
+	if (gl->flags&0x1)
+		return std::max(x+gl->w, DrawChar(x, y, c+1, r, g, b, a, modifiedColor));
+	return x + gl->w;
 }
 
 int VideoBuffer::DrawText(int x, int y, std::string s, int r, int g, int b, int a)
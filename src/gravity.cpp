@@ -19,7 +19,7 @@
 #include <cstring>
 #include <sys/types.h>
 #include <iostream>
-#include "common/tpt-thread.h"
+#include "common/JobSystem.h"
 #include "defines.h"
 #include "gravity.h"
 #include "powder.h"
@@ -57,11 +57,21 @@ bool ngrav_completedisable = false;
 #endif
 int th_gravchanged = 0;
 
-pthread_t gravthread;
-pthread_mutex_t gravmutex;
-pthread_cond_t gravcv;
-int grav_ready = 0;
-int gravthread_done = 0;
+// the job calculating the next gravity field from th_gravmap, the th_ maps belong to it until it is done
+TaskGroup gravityJob;
+
+class GravityJob : public Job
+{
+public:
+	virtual void Run()
+	{
+#ifdef GRAVFFT
+		if (!grav_fft_status)
+			grav_fft_init();
+#endif
+		update_grav();
+	}
+};
 
 void bilinear_interpolation(float *src, float *dst, int sw, int sh, int rw, int rh)
 {
@@ -114,12 +124,9 @@ void gravity_cleanup()
 
 void gravity_update_async()
 {
-	int result;
 	if(ngrav_enable)
 	{
-		pthread_mutex_lock(&gravmutex);
-		result = grav_ready;
-		if(result) //Did the gravity thread finish?
+		if (gravityJob.Done()) //Did the gravity job finish?
 		{
 			if (!sys_pause||framerender){ //Only update if not paused
 				//Switch the full size gravmaps, we don't really need the two above any more
@@ -159,11 +166,10 @@ void gravity_update_async()
 				gravmap = th_gravmap;
 				th_gravmap = tmpf;
 
-				grav_ready = 0; //Tell the other thread that we're ready for it to continue
-				pthread_cond_signal(&gravcv);
+				//Start calculating the next frame
+				JobSystem::Ref().Submit(new GravityJob(), &gravityJob);
 			}
 		}
-		pthread_mutex_unlock(&gravmutex);
 		//Apply the gravity mask
 		membwand(gravy, gravmask, (XRES/CELL)*(YRES/CELL)*sizeof(float), (XRES/CELL)*(YRES/CELL)*sizeof(unsigned));
 		membwand(gravx, gravmask, (XRES/CELL)*(YRES/CELL)*sizeof(float), (XRES/CELL)*(YRES/CELL)*sizeof(unsigned));
@@ -171,56 +177,17 @@ void gravity_update_async()
 	}
 }
 
-TH_ENTRY_POINT void* update_grav_async(void* unused)
-{
-	int done = 0;
-	int thread_done = 0;
-	memset(th_ogravmap, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
-	memset(th_gravmap, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
-	memset(th_gravy, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
-	memset(th_gravx, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
-	memset(th_gravp, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
-	//memset(th_gravy, 0, XRES*YRES*sizeof(float));
-	//memset(th_gravx, 0, XRES*YRES*sizeof(float));
-	//memset(th_gravp, 0, XRES*YRES*sizeof(float));
-#ifdef GRAVFFT
-	if (!grav_fft_status)
-		grav_fft_init();
-#endif
-	while(!thread_done){
-		if(!done){
-			update_grav();
-			done = 1;
-			pthread_mutex_lock(&gravmutex);
-			
-			grav_ready = done;
-			thread_done = gravthread_done;
-			
-			pthread_mutex_unlock(&gravmutex);
-		} else {
-			pthread_mutex_lock(&gravmutex);
-			pthread_cond_wait(&gravcv, &gravmutex);
-		    
-			done = grav_ready;
-			thread_done = gravthread_done;
-			
-			pthread_mutex_unlock(&gravmutex);
-		}
-	}
-	pthread_exit(NULL);
-	return 0;
-}
-
 void start_grav_async()
 {
 	if (ngrav_completedisable)
 		return;
 	if(!ngrav_enable){
-		gravthread_done = 0;
-		grav_ready = 0;
-		pthread_mutex_init (&gravmutex, NULL);
-		pthread_cond_init(&gravcv, NULL);
-		pthread_create(&gravthread, NULL, update_grav_async, NULL); //Start asynchronous gravity simulation
+		memset(th_ogravmap, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
+		memset(th_gravmap, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
+		memset(th_gravy, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
+		memset(th_gravx, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
+		memset(th_gravp, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
+		JobSystem::Ref().Submit(new GravityJob(), &gravityJob); //Start asynchronous gravity simulation
 		ngrav_enable = true;
 	}
 	memset(gravy, 0, (XRES/CELL)*(YRES/CELL)*sizeof(float));
@@ -233,12 +200,7 @@ void stop_grav_async()
 	if (ngrav_completedisable)
 		return;
 	if(ngrav_enable){
-		pthread_mutex_lock(&gravmutex);
-		gravthread_done = 1;
-		pthread_cond_signal(&gravcv);
-		pthread_mutex_unlock(&gravmutex);
-		pthread_join(gravthread, NULL);
-		pthread_mutex_destroy(&gravmutex); //Destroy the mutex
+		gravityJob.Wait();
 		ngrav_enable = false;
 	}
 	//Clear the grav velocities
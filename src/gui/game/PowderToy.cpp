@@ -110,7 +110,8 @@ PowderToy::PowderToy():
 	hasBorder = false;
 
 	sim = new Simulation();
-	globalSim = sim;
+	sim->MakeCurrent();
+	Simulation_Compat_CopyData(sim);
 
 	InitMenusections();
 	FillMenus();
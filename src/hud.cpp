@@ -10,6 +10,7 @@
 #include "powder.h"
 
 #include "common/tpt-minmax.h"
+#include "game/FrameRecorder.h"
 #include "game/Menus.h"
 #include "simulation/Simulation.h"
 #include "simulation/Tool.h"
@@ -313,7 +314,7 @@ void SetLeftHudText(Simulation * sim, float FPSB2)
 	}
 	if (currentHud[4])
 	{
-		sprintf(tempstring,"Parts:%d ",NUM_PARTS);
+		sprintf(tempstring,"Parts:%d ",globalSim->numParts);
 		strappend(uitext,tempstring);
 	}
 	if (currentHud[5])
@@ -365,10 +366,8 @@ void SetLeftHudText(Simulation * sim, float FPSB2)
 		strappend(uitext, tempstring);
 		frameNum = 0;
 	}
-#ifdef INTERNAL
-	if (vs)
-		strappend(uitext, "[FRAME CAPTURE]");
-#endif
+	if (FrameRecorder::Ref().IsRecording())
+		strappend(uitext, "[RECORDING] ");
 	if (strlen(uitext) > 0 && uitext[strlen(uitext)-1] == ' ')
 		uitext[strlen(uitext)-1] = 0;
 }
@@ -468,31 +467,20 @@ void DrawPhotonWavelengths(pixel *vid, int x, int y, int h, int wl)
 
 void DrawRecordsInfo(Simulation * sim)
 {
-	int ytop = 244, num_parts = 0, totalselected = 0;
-	float totaltemp = 0, totalpressure = 0;
-	for (int i = 0; i < NPART; i++)
-	{
-		//average temperature of all particles
-		if (parts[i].type)
-		{
-			totaltemp += parts[i].temp;
-			num_parts++;
-		}
+	int ytop = 244, num_parts = sim->stats.particleCount, totalselected = 0;
+	float totaltemp = (float)sim->stats.temperatureSum, totalpressure = sim->PressureSum();
 
-		//count total number of left selected element particles
-		if (parts[i].type == PT_LIFE)
-		{
-			if (parts[i].ctype == ((GolTool*)activeTools[0])->GetID())
-				totalselected++;
-		}
-		else if (parts[i].type == ((ElementTool*)activeTools[0])->GetID())
-			totalselected++;
+	//count total number of left selected element particles
+	int selectedID = activeTools[0]->GetID();
+	if (activeTools[0]->GetType() == GOL_TOOL)
+	{
+		if (selectedID >= 0 && selectedID < NGOL)
+			totalselected = sim->stats.lifeCount[selectedID];
 	}
-	for (int y = 0; y < YRES/CELL; y++)
-		for (int x = 0; x < XRES/CELL; x++)
-		{
-			totalpressure += sim->air->pv[y][x];
-		}
+	else if (selectedID == 0)
+		totalselected = NPART-num_parts;
+	else if (selectedID > 0 && selectedID < PT_NUM && selectedID != PT_LIFE)
+		totalselected = sim->elementCount[selectedID];
 
 	GetTimeString(currentTime-totalafktime-afktime, timeinfotext, 0);
 	sprintf(infotext,"Time Played: %s", timeinfotext);
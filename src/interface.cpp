@@ -70,7 +70,11 @@
 #include "game/Download.h"
 #include "game/Favorite.h"
 #include "game/Menus.h"
+#include "game/SaveWriter.h"
 #include "game/Sign.h"
+#include "game/StampPack.h"
+#include "game/TabState.h"
+#include "game/ThumbnailCache.h"
 #include "game/ToolTip.h"
 #include "simulation/Snapshot.h"
 #include "simulation/Tool.h"
@@ -2130,6 +2134,7 @@ int stamp_ui(pixel *vid_buf, int *reorder)
 					x = (XRES*i)/GRID_X + XRES/(GRID_X*2);
 					y = (YRES*j)/GRID_Y + YRES/(GRID_Y*2);
 					gy -= 20;
+					bool loading = !stamps[k].thumb && stamp_gen_thumb(k);
 					w = stamps[k].thumb_w;
 					h = stamps[k].thumb_h;
 					x -= w/2;
@@ -2139,6 +2144,10 @@ int stamp_ui(pixel *vid_buf, int *reorder)
 						draw_image(vid_buf, stamps[k].thumb, gx+(((XRES/GRID_S)/2)-(w/2)), gy+(((YRES/GRID_S)/2)-(h/2)), w, h, 255);
 						xor_rect(vid_buf, gx+(((XRES/GRID_S)/2)-(w/2)), gy+(((YRES/GRID_S)/2)-(h/2)), w, h);
 					}
+					else if (loading)
+					{
+						drawtext(vid_buf, gx+(XRES/GRID_S-textwidth("Loading..."))/2, gy+((YRES/GRID_S)/2)-4, "Loading...", 128, 128, 128, 255);
+					}
 					else
 					{
 						drawtext(vid_buf, gx+8, gy+((YRES/GRID_S)/2)-4, "Error loading stamp", 255, 255, 255, 255);
@@ -2186,9 +2195,22 @@ int stamp_ui(pixel *vid_buf, int *reorder)
 		}
 		else
 		{
-			sprintf(page_info, "Page %d of %d", stamp_page+1, page_count);
+			StampPack::Info info;
+			// the stamp under the mouse, if its thumbnail has been rendered
+			if (r != -1 && StampPack::Ref().GetInfo(stamps[r].name, &info))
+			{
+				std::stringstream infoText;
+				infoText << info.width << "x" << info.height << ", " << info.particleCount << " particles";
+				for (int t = 0; t < STAMP_TOP_ELEMENTS && info.topTypes[t]; t++)
+					infoText << (t ? " " : ": ") << globalSim->elements[info.topTypes[t]].Name;
+				drawtext(vid_buf, (XRES/2)-(textwidth(infoText.str().c_str())/2), YRES+MENUSIZE-14, infoText.str().c_str(), 255, 255, 255, 255);
+			}
+			else
+			{
+				sprintf(page_info, "Page %d of %d", stamp_page+1, page_count);
 
-			drawtext(vid_buf, (XRES/2)-(textwidth(page_info)/2), YRES+MENUSIZE-14, page_info, 255, 255, 255, 255);
+				drawtext(vid_buf, (XRES/2)-(textwidth(page_info)/2), YRES+MENUSIZE-14, page_info, 255, 255, 255, 255);
+			}
 		}
 
 		if (stamp_page)
@@ -2251,38 +2273,22 @@ int stamp_ui(pixel *vid_buf, int *reorder)
 			}
 			sdl_wheel = 0;
 		}
-		if (b && !bq && mx >= XRES-65 && mx <= XRES-25 && my >= YRES+MENUSIZE-18 && my < YRES+MENUSIZE-2 && confirm_ui(vid_buf, "Rescan stamps?", "Rescanning stamps will find all stamps in your stamps/ directory and overwrite stamps.def", "OK"))
+		if (b && !bq && mx >= XRES-65 && mx <= XRES-25 && my >= YRES+MENUSIZE-18 && my < YRES+MENUSIZE-2 && confirm_ui(vid_buf, "Rescan stamps?", "Rescanning stamps will add all .stm files in your stamps/ directory that aren't in the stamp list yet", "OK"))
 		{
 			DIR *directory;
 			struct dirent * entry;
 			directory = opendir("stamps");
 			if (directory != NULL)
 			{
-				std::string stampList = "";
 				while ((entry = readdir(directory)))
 				{
 					if (strstr(entry->d_name, ".stm") && strlen(entry->d_name) == 14)
-						stampList.insert(0, entry->d_name, 10);
+						StampPack::Ref().Import(std::string(entry->d_name, 10));
 				}
 				closedir(directory);
 
-				FILE *f = fopen("stamps" PATH_SEP "stamps.def", "wb");
-				if (!f)
-				{
-					error_ui(vid_buf, 0, "Could not open stamps.def");
-				}
-				else
-				{
-					fwrite(stampList.c_str(), stampList.length(), 1, f);
-					fclose(f);
-
-					for (int i = 0; i < STAMP_MAX; i++)
-						if (stamps[i].thumb)
-							free(stamps[i].thumb);
-					stamp_count = 0;
-					stamp_init();
-					page_count = (stamp_count-1)/per_page+1;
-				}
+				stamp_init();
+				page_count = (stamp_count-1)/per_page+1;
 			}
 		}
 
@@ -3246,6 +3252,7 @@ void menu_select_element(int b, Tool* over)
 
 char tabNames[10][255];
 pixel* tabThumbnails[10];
+TabState* tabStates[10];
 int quickoptionsThumbnailFade = 0;
 int clickedQuickoption = -1, hoverQuickoption = -1;
 void QuickoptionsMenu(pixel *vid_buf, int b, int bq, int x, int y)
@@ -3429,11 +3436,15 @@ void QuickoptionsMenu(pixel *vid_buf, int b, int bq, int x, int y)
 				if (num_tabs > 1)
 				{
 					char name[30], newname[30];
+					//tab files are renamed below, so finish writing them first
+					SaveWriter::Ref().Flush();
 					//delete the tab that was closed, free thumbnail
 					sprintf(name, "tabs%s%d.stm", PATH_SEP, clickedQuickoption);
 					remove(name);
 					free(tabThumbnails[clickedQuickoption-1]);
 					tabThumbnails[clickedQuickoption-1] = NULL;
+					delete tabStates[clickedQuickoption-1];
+					tabStates[clickedQuickoption-1] = NULL;
 
 					//rename all the tabs and move other variables around
 					for (i = clickedQuickoption; i < num_tabs; i++)
@@ -3443,10 +3454,12 @@ void QuickoptionsMenu(pixel *vid_buf, int b, int bq, int x, int y)
 						rename(name, newname);
 						strncpy(tabNames[i-1], tabNames[i], 254);
 						tabThumbnails[i-1] = tabThumbnails[i];
+						tabStates[i-1] = tabStates[i];
 					}
 
 					num_tabs--;
 					tabThumbnails[num_tabs] = NULL;
+					tabStates[num_tabs] = NULL;
 					if (clickedQuickoption == tab_num)
 					{
 						if (tab_num > 1)
@@ -3548,6 +3561,10 @@ int EventProcess(SDL_Event event)
 		// if we don't do this, the touchscreen calibration variables won't ever be set properly
 		SetSDLVideoMode((XRES + BARSIZE) * sdl_scale, (YRES + MENUSIZE) * sdl_scale);
 		break;
+	case SDL_VIDEOEXPOSE:
+		// the window was uncovered, the next frame has to be sent in full
+		sdl_invalidate();
+		break;
 	case SDL_QUIT:
 		if (fastquit)
 			has_quit = 1;
@@ -3785,6 +3802,15 @@ corrupt:
 	return NULL;
 }
 
+// id used for the decoded thumbnail cache, matches the id used when downloading the thumbnail
+std::string search_thumb_id(int pos)
+{
+	std::string id = std::string("save_") + search_ids[pos];
+	if (search_dates[pos])
+		id += std::string("_") + search_dates[pos];
+	return id;
+}
+
 int search_ui(pixel *vid_buf)
 {
 	int uih=0,nyu,nyd,b=1,bq,mx=0,my=0,mxq=0,myq=0,mmt=0,gi,gj,gx,gy,pos,i,mp,dp,dap,own,last_own=search_own,last_fav=search_fav,page_count=0,last_page=0,last_date=0,j,w,h,st=0,lv;
@@ -3795,13 +3821,11 @@ int search_ui(pixel *vid_buf)
 	bool dragging = false;
 #else
 	const int xOffset = 0;
-	int nmp = -1;
 #endif
 	int touchOffset = 0;
 	bool touchDragged = false; // when true, ignore clicks on saves
 	int thumb_drawn[GRID_X*GRID_Y];
 	pixel *v_buf = (pixel *)malloc(((YRES+MENUSIZE)*(XRES+BARSIZE))*PIXELSIZE);
-	pixel *bthumb_rsdata = NULL;
 	float ry;
 	ui_edit ed;
 	ui_richtext motd;
@@ -4081,19 +4105,23 @@ int search_ui(pixel *vid_buf)
 				}
 				else
 					drawtext(vid_buf, gx+XRES/(GRID_S*2)-j/2, gy+YRES/GRID_S+20, search_owners[pos], 128, 128, 128, 255);
-				if (search_thumbs[pos]&&thumb_drawn[pos]==0)
+				if (thumb_drawn[pos]==0)
 				{
-					//render_thumb(search_thumbs[pos], search_thsizes[pos], 1, v_buf, gx, gy, GRID_S);
-					int finh, finw;
-					pixel *thumb_rsdata = NULL;
-					pixel *thumb_imgdata = ptif_unpack(search_thumbs[pos], search_thsizes[pos], &finw, &finh);
-					if(thumb_imgdata!=NULL){
-						thumb_rsdata = resample_img(thumb_imgdata, finw, finh, XRES/GRID_S, YRES/GRID_S);
+					// decoded thumbnails are cached (also on disk), so they can be drawn before the download finishes
+					std::string thumbID = search_thumb_id(pos);
+					pixel *thumb_rsdata = ThumbnailCache::Ref().Get(thumbID, XRES/GRID_S, YRES/GRID_S);
+					if (thumb_rsdata)
+					{
 						draw_image(v_buf, thumb_rsdata, gx-touchOffset, gy, XRES/GRID_S, YRES/GRID_S, 255);
-						free(thumb_imgdata);
-						free(thumb_rsdata);
+						thumb_drawn[pos] = 1;
+					}
+					else if (search_thumbs[pos])
+					{
+						ThumbnailCache::Ref().RequestPTI(thumbID, search_thumbs[pos], search_thsizes[pos], XRES/GRID_S, YRES/GRID_S);
+						// stop trying if it couldn't be decoded
+						if (!ThumbnailCache::Ref().IsLoading(thumbID, XRES/GRID_S, YRES/GRID_S))
+							thumb_drawn[pos] = 1;
 					}
-					thumb_drawn[pos] = 1;
 				}
 				own = (svf_login && (!strcmp(svf_user, search_owners[pos]) || svf_admin || svf_mod));
 				if (mx>=gx-2 && mx<=gx+XRES/GRID_S+3 && my>=gy && my<=gy+YRES/GRID_S+29)
@@ -4210,22 +4238,12 @@ int search_ui(pixel *vid_buf)
 			if (gy+h>=YRES+(MENUSIZE-2)) gy=YRES+(MENUSIZE-3)-h;
 			clearrect(vid_buf, gx-1, gy-2, w+3, h-1);
 			drawrect(vid_buf, gx-2, gy-3, w+4, h, 160, 160, 192, 255);
-			if (search_thumbs[mp]){
-				if(mp != nmp && bthumb_rsdata){
-					free(bthumb_rsdata);
-					bthumb_rsdata = NULL;
-				}
-				if(!bthumb_rsdata){
-					int finh, finw;
-					pixel *thumb_imgdata = ptif_unpack(search_thumbs[mp], search_thsizes[mp], &finw, &finh);
-					if(thumb_imgdata!=NULL){
-						bthumb_rsdata = resample_img(thumb_imgdata, finw, finh, XRES/GRID_Z, YRES/GRID_Z);				
-						free(thumb_imgdata);
-					}
-				}
+			std::string thumbID = search_thumb_id(mp);
+			pixel *bthumb_rsdata = ThumbnailCache::Ref().Get(thumbID, XRES/GRID_Z, YRES/GRID_Z);
+			if (bthumb_rsdata)
 				draw_image(vid_buf, bthumb_rsdata, gx+(w-(XRES/GRID_Z))/2, gy, XRES/GRID_Z, YRES/GRID_Z, 255);
-				nmp = mp;
-			}
+			else if (search_thumbs[mp])
+				ThumbnailCache::Ref().RequestPTI(thumbID, search_thumbs[mp], search_thsizes[mp], XRES/GRID_Z, YRES/GRID_Z);
 			drawtext(vid_buf, gx+(w-i)/2, gy+YRES/GRID_Z+4, search_names[mp], 192, 192, 192, 255);
 			drawtext(vid_buf, gx+(w-textwidth(search_owners[mp]))/2, gy+YRES/GRID_Z+16, search_owners[mp], 128, 128, 128, 255);
 		}
@@ -4452,9 +4470,6 @@ int search_ui(pixel *vid_buf)
 				page_count = search_results(results, last_own||svf_admin||svf_mod||(unlockedstuff&0x08));
 				memset(thumb_drawn, 0, sizeof(thumb_drawn));
 				memset(v_buf, 0, ((YRES+MENUSIZE)*(XRES+BARSIZE))*PIXELSIZE);
-#ifndef TOUCHUI
-				nmp = -1;
-#endif
 				
 				if (is_p1)
 				{
@@ -4610,11 +4625,7 @@ finish:
 			img_id[i] = NULL;
 		}
 	}
-			
-	if(bthumb_rsdata){
-		free(bthumb_rsdata);
-		bthumb_rsdata = NULL;
-	}
+
 
 	search_results((char*)"", 0);
 
@@ -6369,6 +6380,7 @@ int execute_save(pixel *vid_buf)
 	}
 
 	thumb_cache_inval(svf_id);
+	ThumbnailCache::Ref().Invalidate(std::string("save_") + svf_id);
 
 	svf_own = 1;
 	if (result)
@@ -7458,8 +7470,9 @@ void decoration_editor(pixel *vid_buf, int b, int bq, int mx, int my)
 				if (framenum > parts[i].ctype)
 					parts[i].ctype = framenum;
 
-				if (sdl_mod & (KMOD_CTRL|KMOD_META) && canCopy)
-					parts[i].animations[framenum] = parts[i].animations[framenum-1];
+				ARGBColour *frames = globalSim->animations.Get(i);
+				if (sdl_mod & (KMOD_CTRL|KMOD_META) && canCopy && frames)
+					frames[framenum] = frames[framenum-1];
 			}
 	}
 	else if (sdl_key==SDLK_LEFT)
@@ -7490,8 +7503,10 @@ void decoration_editor(pixel *vid_buf, int b, int bq, int mx, int my)
 					if (framenum < 0)
 						framenum = 0;
 				}
-				for (int j = framenum; j < globalSim->maxFrames-1; j++)
-					parts[i].animations[j] = parts[i].animations[j+1];
+				ARGBColour *frames = globalSim->animations.Get(i);
+				if (frames)
+					for (int j = framenum; j < globalSim->maxFrames-1; j++)
+						frames[j] = frames[j+1];
 				if (parts[i].ctype >= framenum && parts[i].ctype)
 					parts[i].ctype--;
 				if (parts[i].tmp2 > parts[i].ctype)
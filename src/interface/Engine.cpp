@@ -114,6 +114,10 @@ bool Engine::EventProcess(SDL_Event event)
 		// if we don't do this, the touchscreen calibration variables won't ever be set properly
 		SetSDLVideoMode((XRES + BARSIZE) * sdl_scale, (YRES + MENUSIZE) * sdl_scale);
 		break;
+	case SDL_VIDEOEXPOSE:
+		// the window was uncovered, the next frame has to be sent in full
+		sdl_invalidate();
+		break;
 	case SDL_QUIT:
 		if (fastquit)
 			has_quit = 1;
@@ -19,6 +19,7 @@
 #include <cmath>
 #include <cstring>
 #include <sstream>
+#include <vector>
 
 #include "SDLCompat.h"
 #if defined(LIN) || defined(MACOSX)
@@ -47,6 +48,7 @@ extern "C"
 
 #include "common/SDL_keysym.h"
 #include "game/Brush.h"
+#include "game/FrameRecorder.h"
 #include "game/Menus.h"
 #include "graphics/Renderer.h"
 #include "gui/game/PowderToy.h"
@@ -57,6 +59,8 @@ extern "C"
 Simulation * luaSim;
 pixel *lua_vid_buf;
 int *lua_el_func, *lua_el_mode, *lua_gr_func;
+int *lua_el_batch_func, *lua_el_batch_mode;
+int lua_el_batch_count = 0;
 char* log_history[20];
 int log_history_times[20];
 int getPartIndex_curIdx;
@@ -137,6 +141,7 @@ void luacon_open()
 		{"setwindowsize",&luatpt_setwindowsize},
 		{"watertest",&luatpt_togglewater},
 		{"screenshot",&luatpt_screenshot},
+		{"record",&luatpt_record},
 		{"get_clipboard",&platform_clipboardCopy},
 		{"set_clipboard",&platform_clipboardPaste},
 		{"element",&luatpt_getelement},
@@ -314,6 +319,8 @@ tpt.partsdata = nil");
 	lua_el_func = (int*)calloc(PT_NUM, sizeof(int));
 	lua_el_mode = (int*)calloc(PT_NUM, sizeof(int));
 	lua_gr_func = (int*)calloc(PT_NUM, sizeof(int));
+	lua_el_batch_func = (int*)calloc(PT_NUM, sizeof(int));
+	lua_el_batch_mode = (int*)calloc(PT_NUM, sizeof(int));
 	for(i = 0; i < PT_NUM; i++)
 	{
 		lua_el_mode[i] = 0;
@@ -577,6 +584,8 @@ int luacon_element_getproperty(const char * key, int * format, unsigned int * mo
 	{
 		offset = offsetof(Element, Falldown);
 		*format = 0;
+		if (modified_stuff)
+			*modified_stuff |= LUACON_EL_MODIFIED_CANMOVE;
 	}
 	else if (!strcmp(key, "flammable"))
 	{
@@ -936,7 +945,7 @@ int luacon_step(int mx, int my)
 	lua_getglobal(l, "simulation");
 	if (lua_istable(l, -1))
 	{
-		lua_pushinteger(l, NUM_PARTS);
+		lua_pushinteger(l, globalSim->numParts);
 		lua_setfield(l, -2, "NUM_PARTS");
 	}
 	lua_pop(l, 1);
@@ -1157,6 +1166,73 @@ int luacon_part_update(unsigned int t, int i, int x, int y, int surround_space,
 	return retval;
 }
 
+void luacon_set_batch_update(int t, int function, int mode)
+{
+	if (lua_el_batch_func[t])
+	{
+		luaL_unref(l, LUA_REGISTRYINDEX, lua_el_batch_func[t]);
+		lua_el_batch_count--;
+	}
+	lua_el_batch_func[t] = function;
+	lua_el_batch_mode[t] = function ? mode : 0;
+	if (function)
+		lua_el_batch_count++;
+}
+
+// Calls every UpdateBatch function that runs at this point in the frame with a table of the ids of all particles of
+// its element, so scripts pay for one Lua call per element instead of one per particle
+void luacon_batch_update(Simulation *sim, bool before)
+{
+	static std::vector<int> ids[PT_NUM];
+	static std::vector<int> types;
+	if (!lua_el_batch_count || sim != luaSim)
+		return;
+
+	// replace functions run with the after ones, in place of the C update that was skipped for these particles
+	types.clear();
+	for (int t = 1; t < PT_NUM; t++)
+		if (lua_el_batch_func[t] && (lua_el_batch_mode[t] == 3) == before)
+		{
+			types.push_back(t);
+			ids[t].clear();
+		}
+	if (!types.size())
+		return;
+
+	// one pass over the particles for every element
+	for (int i = 0; i <= sim->parts_lastActiveIndex; i++)
+	{
+		int t = sim->parts[i].type;
+		if (t && lua_el_batch_func[t] && (lua_el_batch_mode[t] == 3) == before)
+			ids[t].push_back(i);
+	}
+
+	for (size_t n = 0; n < types.size(); n++)
+	{
+		int t = types[n];
+		// a previous function might have removed this one
+		if (!lua_el_batch_func[t] || !ids[t].size())
+			continue;
+		int count = ids[t].size();
+		lua_rawgeti(l, LUA_REGISTRYINDEX, lua_el_batch_func[t]);
+		lua_createtable(l, count, 0);
+		for (int i = 0; i < count; i++)
+		{
+			lua_pushinteger(l, ids[t][i]);
+			lua_rawseti(l, -2, i+1);
+		}
+		lua_pushinteger(l, count);
+		if (lua_pcall(l, 2, 0, 0))
+		{
+			char *error = (char*)luacon_geterror();
+			char *tolog = (char*)malloc(strlen(error) + 29);
+			sprintf(tolog, "In batched particle update: %s", error);
+			luacon_log(tolog);
+			lua_pop(l, 1);
+		}
+	}
+}
+
 int luacon_graphics_update(int t, int i, int *pixel_mode, int *cola, int *colr, int *colg, int *colb, int *firea, int *firer, int *fireg, int *fireb)
 {
 	int cache = 0, callret;
@@ -1203,6 +1279,7 @@ void luacon_close()
 {
 	int i;
 	lua_close(l);
+	simulation_diff_free();
 	if (lastCode)
 		free(lastCode);
 	if (logs)
@@ -2231,7 +2308,7 @@ int luatpt_confirm(lua_State* l)
 
 int luatpt_get_numOfParts(lua_State* l)
 {
-	lua_pushinteger(l, NUM_PARTS);
+	lua_pushinteger(l, globalSim->numParts);
 	return 1;
 }
 
@@ -2540,6 +2617,44 @@ int luatpt_screenshot(lua_State* l)
 	return 0;
 }
 
+// tpt.record(true, [every n frames], ["png" or "delta"], [x, y, w, h]) starts recording and returns the recording name.
+// tpt.record(false) stops, tpt.record() returns whether it is recording and the number of recorded and dropped frames
+int luatpt_record(lua_State* l)
+{
+	FrameRecorder &recorder = FrameRecorder::Ref();
+	if (lua_gettop(l) == 0)
+	{
+		lua_pushboolean(l, recorder.IsRecording());
+		lua_pushinteger(l, recorder.GetRecordedFrames());
+		lua_pushinteger(l, recorder.GetDroppedFrames());
+		return 3;
+	}
+	if (!lua_toboolean(l, 1))
+	{
+		recorder.Stop();
+		return 0;
+	}
+
+	int every = luaL_optint(l, 2, 1);
+	std::string formatName = luaL_optstring(l, 3, "png");
+	int x = luaL_optint(l, 4, 0), y = luaL_optint(l, 5, 0), w = luaL_optint(l, 6, XRES), h = luaL_optint(l, 7, YRES);
+	FrameRecorder::Format format;
+	if (formatName == "png")
+		format = FrameRecorder::FORMAT_PNG;
+	else if (formatName == "delta")
+		format = FrameRecorder::FORMAT_DELTA;
+	else
+		return luaL_error(l, "Invalid recording format \"%s\"", formatName.c_str());
+	if (every < 1)
+		return luaL_error(l, "Invalid frame interval (%d)", every);
+
+	std::string name = recorder.Start(format, every, x, y, w, h);
+	if (!name.length())
+		return luaL_error(l, "Could not start recording: %s", recorder.GetError().c_str());
+	lua_pushstring(l, name.c_str());
+	return 1;
+}
+
 int luatpt_bubble(lua_State* l)
 {
 	int x = luaL_optint(l, 1, 0);
@@ -2580,14 +2695,10 @@ int luatpt_maxframes(lua_State* l)
 		luaSim->maxFrames = maxFrames;
 	else
 		return luaL_error(l, "must be between 1 and 256");
+	luaSim->animations.Reset(maxFrames);
 	for (i = 0; i <= luaSim->parts_lastActiveIndex; i++)
 		if (parts[i].type == PT_ANIM)
 		{
-			if (parts[i].animations)
-			{
-				free(parts[i].animations);
-				parts[i].animations = NULL;
-			}
 			parts[i].tmp2 = parts[i].ctype = 0;
 			parts[i].tmp = 1;
 		}
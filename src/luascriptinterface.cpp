@@ -32,6 +32,7 @@
 #include "simulation/Simulation.h"
 #include "simulation/WallNumbers.h"
 #include "simulation/Snapshot.h"
+#include "simulation/StateDelta.h"
 #include "simulation/ToolNumbers.h"
 #include "simulation/Tool.h"
 #include "simulation/elements/FIGH.h"
@@ -246,6 +247,10 @@ void initSimulationAPI(lua_State * l)
 		{"saveStamp", simulation_saveStamp},
 		{"loadStamp", simulation_loadStamp},
 		{"deleteStamp", simulation_deleteStamp},
+		{"serialize", simulation_serialize},
+		{"deserialize", simulation_deserialize},
+		{"diff", simulation_diff},
+		{"applyDiff", simulation_applyDiff},
 		{"loadSave", simulation_loadSave},
 		{"reloadSave", simulation_reloadSave},
 		{"getSaveID", simulation_getSaveID},
@@ -259,6 +264,12 @@ void initSimulationAPI(lua_State * l)
 		{"waterEqualisation", simulation_waterEqualization},
 		{"ambientAirTemp", simulation_ambientAirTemp},
 		{"elementCount", simulation_elementCount},
+		{"stats", simulation_stats},
+		{"temperatureHistogram", simulation_temperatureHistogram},
+		{"updateByType", simulation_updateByType},
+		{"compactParticles", simulation_compactParticles},
+		{"compactInterval", simulation_compactInterval},
+		{"elementUpdateTime", simulation_elementUpdateTime},
 		{"can_move", simulation_canMove},
 		{"parts", simulation_parts},
 		{"brush", simulation_brush},
@@ -336,8 +347,178 @@ void initSimulationAPI(lua_State * l)
 	lua_pushcfunction(l, simulation_deletesign);
 	lua_setfield(l, -2, "delete");
 	lua_setfield(l, -2, "signs");
+
+#ifdef LUAJIT
+	initFFIViews(l);
+#endif
 }
 
+#ifdef LUAJIT
+// Views hold a pointer to one of these pointers instead of the array itself, so they follow gravx and gravy
+// when the gravity thread swaps them, and parts/pmap/photons if the main thread switches simulations
+static float *ffiPv, *ffiVx, *ffiVy, *ffiHv;
+
+static const char *ffiViewsScript =
+"local arrays, simulation = ...\n"
+"local ffi = require(\"ffi\")\n"
+"ffi.cdef[[\n"
+"typedef struct { int type; int life, ctype; float x, y, vx, vy; float temp; float pavg[2]; int flags; int tmp; int tmp2; unsigned int dcolour; } tpt_particle;\n"
+"typedef struct { tpt_particle **ref; int size, width, height, alive, writable; } tpt_parts_view;\n"
+"typedef struct { tpt_particle **ref; int index; } tpt_particle_ref;\n"
+"typedef struct { const tpt_particle **ref; int size, width, height, alive, writable; } tpt_parts_const_view;\n"
+"typedef struct { unsigned int **ref; int size, width, height, alive, writable; } tpt_uint_view;\n"
+"typedef struct { float **ref; int size, width, height, alive, writable; } tpt_float_view;\n"
+"]]\n"
+"if ffi.sizeof(\"tpt_particle\") ~= arrays.particleSize then\n"
+"	error(\"particle struct doesn't match\")\n"
+"end\n"
+"local methods = {}\n"
+"function methods.release(v) v.alive = 0 end\n"
+"function methods.valid(v) return v.alive ~= 0 end\n"
+"local function checkXY(v, x, y)\n"
+"	if v.alive == 0 then error(\"view has been released\", 3) end\n"
+"	if x < 0 or x >= v.width or y < 0 or y >= v.height then error(\"coordinates out of range\", 3) end\n"
+"	return x + y*v.width\n"
+"end\n"
+"function methods.get(v, x, y) return v.ref[0][checkXY(v, x, y)] end\n"
+"function methods.set(v, x, y, value)\n"
+"	local i = checkXY(v, x, y)\n"
+"	if v.writable == 0 then error(\"view is read only\", 2) end\n"
+"	v.ref[0][i] = value\n"
+"end\n"
+"local meta = {\n"
+"	__index = function(v, i)\n"
+"		if type(i) ~= \"number\" then return methods[i] end\n"
+"		if v.alive == 0 then error(\"view has been released\", 2) end\n"
+"		if i < 0 or i >= v.size then error(\"index out of range\", 2) end\n"
+"		return v.ref[0][i]\n"
+"	end,\n"
+"	__newindex = function(v, i, value)\n"
+"		if type(i) ~= \"number\" then error(\"invalid view index\", 2) end\n"
+"		if v.alive == 0 then error(\"view has been released\", 2) end\n"
+"		if v.writable == 0 then error(\"view is read only\", 2) end\n"
+"		if i < 0 or i >= v.size then error(\"index out of range\", 2) end\n"
+"		v.ref[0][i] = value\n"
+"	end,\n"
+"	__len = function(v) return v.size end,\n"
+"}\n"
+"-- particles in writable parts views are returned as references that don't allow changing the type, that has to go\n"
+"-- through sim.partChangeType so pmap and the element counts stay right\n"
+"local particleRef = ffi.metatype(\"tpt_particle_ref\", {\n"
+"	__index = function(p, k) return p.ref[0][p.index][k] end,\n"
+"	__newindex = function(p, k, value)\n"
+"		if k == \"type\" then error(\"particle type is read only, use sim.partChangeType\", 2) end\n"
+"		p.ref[0][p.index][k] = value\n"
+"	end,\n"
+"})\n"
+"local partsMethods = {\n"
+"	release = methods.release,\n"
+"	valid = methods.valid,\n"
+"	get = function(v, x, y) return particleRef(v.ref, checkXY(v, x, y)) end,\n"
+"}\n"
+"local partsMeta = {\n"
+"	__index = function(v, i)\n"
+"		if type(i) ~= \"number\" then return partsMethods[i] end\n"
+"		if v.alive == 0 then error(\"view has been released\", 2) end\n"
+"		if i < 0 or i >= v.size then error(\"index out of range\", 2) end\n"
+"		return particleRef(v.ref, i)\n"
+"	end,\n"
+"	__newindex = function(v, i, value) error(\"set particle fields instead\", 2) end,\n"
+"	__len = meta.__len,\n"
+"}\n"
+"local partsView = ffi.metatype(\"tpt_parts_view\", partsMeta)\n"
+"local partsConstView = ffi.metatype(\"tpt_parts_const_view\", meta)\n"
+"local uintView = ffi.metatype(\"tpt_uint_view\", meta)\n"
+"local floatView = ffi.metatype(\"tpt_float_view\", meta)\n"
+"local cellsW, cellsH = arrays.cellsWidth, arrays.cellsHeight\n"
+"local specs = {\n"
+"	parts = {arrays.parts, arrays.npart, arrays.npart, 1},\n"
+"	pmap = {arrays.pmap, arrays.xres*arrays.yres, arrays.xres, arrays.yres},\n"
+"	photons = {arrays.photons, arrays.xres*arrays.yres, arrays.xres, arrays.yres},\n"
+"	pv = {arrays.pv, cellsW*cellsH, cellsW, cellsH},\n"
+"	vx = {arrays.vx, cellsW*cellsH, cellsW, cellsH},\n"
+"	vy = {arrays.vy, cellsW*cellsH, cellsW, cellsH},\n"
+"	hv = {arrays.hv, cellsW*cellsH, cellsW, cellsH},\n"
+"	gravx = {arrays.gravx, cellsW*cellsH, cellsW, cellsH},\n"
+"	gravy = {arrays.gravy, cellsW*cellsH, cellsW, cellsH},\n"
+"}\n"
+"function simulation.view(name, writable)\n"
+"	local spec = specs[name]\n"
+"	if not spec then error(\"invalid view name\", 2) end\n"
+"	writable = writable ~= nil and writable ~= false and writable ~= 0\n"
+"	-- writing to these directly would skip the occupancy bitmaps, which ClearPmap relies on\n"
+"	if writable and (name == \"pmap\" or name == \"photons\") then error(\"pmap and photons views are read only\", 2) end\n"
+"	local ctype, reftype\n"
+"	if name == \"parts\" then\n"
+"		ctype = writable and partsView or partsConstView\n"
+"		reftype = writable and \"tpt_particle **\" or \"const tpt_particle **\"\n"
+"	elseif name == \"pmap\" or name == \"photons\" then\n"
+"		ctype, reftype = uintView, \"unsigned int **\"\n"
+"	else\n"
+"		ctype, reftype = floatView, \"float **\"\n"
+"	end\n"
+"	return ctype(ffi.cast(reftype, spec[1]), spec[2], spec[3], spec[4], 1, writable and 1 or 0)\n"
+"end\n";
+
+// sim.view(name, [writable]) returns a bounds checked LuaJIT FFI view of parts, pmap, photons, pv, vx, vy, hv, gravx
+// or gravy, indexed from 0 like the arrays in C (pmap and air arrays can also be indexed with view:get(x, y) and
+// view:set(x, y, value)). Views are read only unless writable is set, parts views are const so particle fields can't be
+// written either. pmap and photons views are always read only, and particle types can only be changed with
+// sim.partChangeType. A view is valid until view:release() is called or Lua is reset
+void initFFIViews(lua_State * l)
+{
+	int simulation = lua_gettop(l);
+	ffiPv = &luaSim->air->pv[0][0];
+	ffiVx = &luaSim->air->vx[0][0];
+	ffiVy = &luaSim->air->vy[0][0];
+	ffiHv = &luaSim->air->hv[0][0];
+
+	if (luaL_loadstring(l, ffiViewsScript))
+	{
+		printf("Error loading FFI views: %s\n", lua_tostring(l, -1));
+		lua_pop(l, 1);
+		return;
+	}
+	lua_newtable(l);
+	lua_pushlightuserdata(l, &parts);
+	lua_setfield(l, -2, "parts");
+	lua_pushlightuserdata(l, &pmap);
+	lua_setfield(l, -2, "pmap");
+	lua_pushlightuserdata(l, &photons);
+	lua_setfield(l, -2, "photons");
+	lua_pushlightuserdata(l, &ffiPv);
+	lua_setfield(l, -2, "pv");
+	lua_pushlightuserdata(l, &ffiVx);
+	lua_setfield(l, -2, "vx");
+	lua_pushlightuserdata(l, &ffiVy);
+	lua_setfield(l, -2, "vy");
+	lua_pushlightuserdata(l, &ffiHv);
+	lua_setfield(l, -2, "hv");
+	lua_pushlightuserdata(l, &gravx);
+	lua_setfield(l, -2, "gravx");
+	lua_pushlightuserdata(l, &gravy);
+	lua_setfield(l, -2, "gravy");
+	lua_pushinteger(l, sizeof(particle));
+	lua_setfield(l, -2, "particleSize");
+	lua_pushinteger(l, NPART);
+	lua_setfield(l, -2, "npart");
+	lua_pushinteger(l, XRES);
+	lua_setfield(l, -2, "xres");
+	lua_pushinteger(l, YRES);
+	lua_setfield(l, -2, "yres");
+	lua_pushinteger(l, XRES/CELL);
+	lua_setfield(l, -2, "cellsWidth");
+	lua_pushinteger(l, YRES/CELL);
+	lua_setfield(l, -2, "cellsHeight");
+	lua_pushvalue(l, simulation);
+	if (lua_pcall(l, 2, 0, 0))
+	{
+		printf("Error loading FFI views: %s\n", lua_tostring(l, -1));
+		lua_pop(l, 1);
+	}
+}
+#endif
+
 int simulation_partNeighbours(lua_State * l)
 {
 	int id = 0;
@@ -1188,6 +1369,127 @@ int simulation_deleteStamp(lua_State* l)
 	}
 }
 
+// Same as saveStamp, but returns the save data as a string instead of writing a file
+int simulation_serialize(lua_State* l)
+{
+	int x = luaL_optint(l,1,0);
+	int y = luaL_optint(l,2,0);
+	int w = luaL_optint(l,3,XRES);
+	int h = luaL_optint(l,4,YRES);
+	int includePressure = luaL_optint(l,5,1);
+	int size;
+
+	Json::Value stampInfo;
+	stampInfo["type"] = "stamp";
+	stampInfo["username"] = svf_user;
+	stampInfo["date"] = (Json::Value::UInt64)time(NULL);
+	if (authors.size())
+		stampInfo["links"].append(authors);
+
+	char *data = (char*)build_save(&size, x, y, w, h, bmap, luaSim->air->vx, luaSim->air->vy, luaSim->air->pv, luaSim->air->fvx, luaSim->air->fvy, signs, parts, &stampInfo, false, includePressure != 0);
+	if (!data)
+	{
+		lua_pushnil(l);
+		return 1;
+	}
+	lua_pushlstring(l, data, size);
+	free(data);
+	return 1;
+}
+
+// Same as loadStamp, but loads save data from a string (made by sim.serialize) instead of a file
+int simulation_deserialize(lua_State* l)
+{
+	size_t size;
+	const char *data = luaL_checklstring(l, 1, &size);
+	int x = luaL_optint(l,2,0);
+	int y = luaL_optint(l,3,0);
+	int includePressure = luaL_optint(l,4,1);
+
+	// parse_save doesn't take const data
+	std::vector<char> saveData(data, data+size);
+	int oldPause = sys_pause;
+	Json::Value luaStampAuthors;
+	if (size && !parse_save(&saveData[0], size, 0, x, y, bmap, luaSim->air->vx, luaSim->air->vy, luaSim->air->pv, luaSim->air->fvx, luaSim->air->fvy, signs, parts, pmap, &luaStampAuthors, includePressure != 0))
+	{
+		lua_pushinteger(l, 1);
+
+		if (luaStampAuthors.size())
+		{
+			luaStampAuthors["type"] = "luastamp";
+			MergeStampAuthorInfo(luaStampAuthors);
+		}
+	}
+	else
+		lua_pushnil(l);
+	sys_pause = oldPause;
+	return 1;
+}
+
+// The state the last sim.diff call returned, which is what the next call is usually given. The state returned to Lua
+// is only a handle to this, so it isn't encoded or decoded again on every call
+static StateDelta::SimulationState *diffState = NULL;
+static unsigned int diffStateID = 0;
+
+static std::string DiffStateHandle(unsigned int id)
+{
+	char handle[8] = { 'T', 'P', 'T', 'S' };
+	for (int i = 0; i < 4; i++)
+		handle[4+i] = (char)((id>>(i*8))&0xFF);
+	return std::string(handle, 8);
+}
+
+void simulation_diff_free()
+{
+	delete diffState;
+	diffState = NULL;
+}
+
+// delta, state = sim.diff([state])
+// Returns the changes since state (a state returned by the last call, or a delta from an empty simulation), or the
+// whole simulation if there is no state, and the current state to pass to the next call. Apply the delta in another
+// simulation with sim.applyDiff
+int simulation_diff(lua_State* l)
+{
+	if (!diffState)
+		diffState = new StateDelta::SimulationState();
+	StateDelta::View stateView = diffState->GetView();
+	if (lua_isnoneornil(l, 1))
+		diffState->Clear();
+	else
+	{
+		size_t size;
+		const char *data = luaL_checklstring(l, 1, &size);
+		if (std::string(data, size) != DiffStateHandle(diffStateID))
+		{
+			diffState->Clear();
+			if (!StateDelta::Apply(data, size, stateView))
+			{
+				diffStateID++; // diffState is no longer what the last handle refers to
+				return luaL_error(l, "Invalid simulation state");
+			}
+		}
+	}
+
+	std::string delta = StateDelta::Create(stateView, StateDelta::GetView(luaSim));
+	// only what the delta has, so the state matches a simulation the delta was applied to
+	StateDelta::Apply(delta.data(), delta.size(), stateView);
+	lua_pushlstring(l, delta.data(), delta.size());
+	diffStateID++;
+	std::string handle = DiffStateHandle(diffStateID);
+	lua_pushlstring(l, handle.data(), handle.size());
+	return 2;
+}
+
+int simulation_applyDiff(lua_State* l)
+{
+	size_t size;
+	const char *data = luaL_checklstring(l, 1, &size);
+	if (!StateDelta::Apply(data, size, luaSim))
+		return luaL_error(l, "Invalid simulation delta");
+	return 0;
+}
+
 int simulation_loadSave(lua_State * l)
 {
 	int saveID = luaL_optint(l,1,1);
@@ -1355,6 +1657,91 @@ int simulation_elementCount(lua_State* l)
 	return 1;
 }
 
+// totals from the start of the current frame, see SimulationStats
+int simulation_stats(lua_State * l)
+{
+	const SimulationStats &stats = luaSim->stats;
+	lua_newtable(l);
+	lua_pushinteger(l, stats.particleCount);
+	lua_setfield(l, -2, "particles");
+	lua_pushnumber(l, stats.temperatureSum);
+	lua_setfield(l, -2, "temperatureSum");
+	if (stats.particleCount)
+	{
+		lua_pushnumber(l, stats.minTemperature);
+		lua_setfield(l, -2, "minTemperature");
+		lua_pushnumber(l, stats.maxTemperature);
+		lua_setfield(l, -2, "maxTemperature");
+	}
+	lua_pushnumber(l, luaSim->PressureSum());
+	lua_setfield(l, -2, "pressureSum");
+	return 1;
+}
+
+int simulation_temperatureHistogram(lua_State * l)
+{
+	int bins = luaL_checkint(l, 1);
+	float min = (float)luaL_optnumber(l, 2, MIN_TEMP);
+	float max = (float)luaL_optnumber(l, 3, MAX_TEMP);
+	if (bins <= 0 || bins > 100000)
+		return luaL_error(l, "Invalid number of bins (%d)", bins);
+	if (max <= min)
+		return luaL_error(l, "Invalid temperature range");
+
+	std::vector<int> histogram;
+	luaSim->TemperatureHistogram(histogram, bins, min, max);
+	lua_createtable(l, bins, 0);
+	for (int i = 0; i < bins; i++)
+	{
+		lua_pushinteger(l, histogram[i]);
+		lua_rawseti(l, -2, i+1);
+	}
+	return 1;
+}
+
+int simulation_updateByType(lua_State * l)
+{
+	int acount = lua_gettop(l);
+	if (acount == 0)
+	{
+		lua_pushboolean(l, luaSim->updateByType);
+		return 1;
+	}
+	luaL_checktype(l, 1, LUA_TBOOLEAN);
+	luaSim->updateByType = lua_toboolean(l, 1);
+	return 0;
+}
+
+int simulation_compactParticles(lua_State * l)
+{
+	luaSim->CompactParticles();
+	lua_pushinteger(l, luaSim->parts_lastActiveIndex);
+	return 1;
+}
+
+int simulation_compactInterval(lua_State * l)
+{
+	int acount = lua_gettop(l);
+	if (acount == 0)
+	{
+		lua_pushinteger(l, luaSim->compactInterval);
+		return 1;
+	}
+	int interval = luaL_checkint(l, 1);
+	luaSim->compactInterval = interval > 0 ? interval : 0;
+	return 0;
+}
+
+int simulation_elementUpdateTime(lua_State * l)
+{
+	int element = luaL_checkint(l, 1);
+	if (element < 0 || element >= PT_NUM)
+		return luaL_error(l, "Invalid element ID (%d)", element);
+
+	lua_pushnumber(l, luaSim->typeUpdateTime[element]);
+	return 1;
+}
+
 int simulation_canMove(lua_State * l)
 {
 	int movingElement = luaL_checkint(l, 1);
@@ -2529,6 +2916,7 @@ int elements_getProperty(const char * key, int * format, unsigned int * modified
 	{
 		offset = offsetof(Element, Falldown);
 		*format = 0;
+		*modifiedStuff |= LUACON_EL_MODIFIED_CANMOVE;
 	}
 	else if (!strcmp(key, "Flammable"))
 	{
@@ -2871,6 +3259,17 @@ int elements_element(lua_State * l)
 		else
 			lua_pop(l, 1);
 
+		lua_getfield(l, -1, "UpdateBatch");
+		if(lua_type(l, -1) == LUA_TFUNCTION)
+			luacon_set_batch_update(id, luaL_ref(l, LUA_REGISTRYINDEX), 1);
+		else if(lua_type(l, -1) == LUA_TBOOLEAN && !lua_toboolean(l, -1))
+		{
+			luacon_set_batch_update(id, 0, 0);
+			lua_pop(l, 1);
+		}
+		else
+			lua_pop(l, 1);
+
 		lua_getfield(l, -1, "Graphics");
 		if(lua_type(l, -1) == LUA_TFUNCTION)
 		{
@@ -2954,6 +3353,7 @@ int elements_property(lua_State * l)
 					int replace = lua_tointeger(l, 4);
 					if (replace == 2)
 						lua_el_mode[id] = 3; // update befre
+					// 2 has always ended up as update after, and scripts depend on that
 					if (replace == 1)
 						lua_el_mode[id] = 2; // replace
 					else
@@ -2970,6 +3370,27 @@ int elements_property(lua_State * l)
 				lua_el_mode[id] = 0;
 			}
 		}
+		else if(!strcmp(propertyName,"UpdateBatch"))
+		{
+			if(lua_type(l, 3) == LUA_TFUNCTION)
+			{
+				int mode = 1; // update after
+				if (args > 3)
+				{
+					luaL_checktype(l, 4, LUA_TNUMBER);
+					int replace = lua_tointeger(l, 4);
+					// 2 is update after like it is for Update, so before has its own value
+					if (replace == 3)
+						mode = 3; // update before
+					else if (replace == 1)
+						mode = 2; // replace
+				}
+				lua_pushvalue(l, 3);
+				luacon_set_batch_update(id, luaL_ref(l, LUA_REGISTRYINDEX), mode);
+			}
+			else if(lua_type(l, 3) == LUA_TBOOLEAN && !lua_toboolean(l, 3))
+				luacon_set_batch_update(id, 0, 0);
+		}
 		else if(!strcmp(propertyName,"Graphics"))
 		{
 			if(lua_type(l, 3) == LUA_TFUNCTION)
@@ -891,28 +891,6 @@ local function playerMouseMove(id)
 		user.pmx,user.pmy = user.mousex,user.mousey
 	end
 end
-local function loadStamp(size,x,y,reset)
-	con.socket:settimeout(10)
-	local s = con.socket:receive(size)
-	con.socket:settimeout(0)
-	if s then
-		local f = io.open(".tmp.stm","wb")
-		f:write(s)
-		f:close()
-		if reset then sim.clearSim() end
-		if not sim.loadStamp(".tmp.stm",x,y) then
-			infoText:reset("Error loading stamp")
-		end
-		os.remove".tmp.stm"
-	else
-		infoText:reset("Error loading empty stamp")
-	end
-end
-local function saveStamp(x, y, w, h)
-	local stampName = sim.saveStamp(x, y, w, h) or "errorsavingstamp"
-	local fullName = "stamps/"..stampName..".stm"
-	return stampName, fullName
-end
 local function deleteStamp(name)
 	if sim.deleteStamp then
 		sim.deleteStamp(name)
@@ -920,6 +898,57 @@ local function deleteStamp(name)
 		os.remove("stamps/"..name..".stm")
 	end
 end
+--save an area to a string, in memory if this version can
+local function serializeArea(x, y, w, h)
+	if sim.serialize then
+		return sim.serialize(x, y, w, h)
+	end
+	local stampName = sim.saveStamp(x, y, w, h) or "errorsavingstamp"
+	local f = assert(io.open("stamps/"..stampName..".stm","rb"))
+	local s = f:read"*a"
+	f:close()
+	deleteStamp(stampName)
+	return s
+end
+local function deserializeArea(s, x, y)
+	if sim.deserialize then
+		return sim.deserialize(s, x, y)
+	end
+	local f = io.open(".tmp.stm","wb")
+	f:write(s)
+	f:close()
+	local ret = sim.loadStamp(".tmp.stm",x,y)
+	os.remove".tmp.stm"
+	return ret
+end
+--stamp that is still arriving, received a bit each frame so large stamps don't freeze the game
+local pendingStamp = nil
+--returns true once the whole stamp has arrived and was loaded
+local function receiveStamp()
+	local p = pendingStamp
+	local s,r,partial = con.socket:receive(p.size-p.got)
+	local part = s or partial
+	if part and #part>0 then
+		table.insert(p.data,part)
+		p.got = p.got+#part
+	end
+	if not s and r~="timeout" then pendingStamp=nil disconnected() return false end
+	if p.got<p.size then return false end
+	pendingStamp = nil
+	if p.reset then sim.clearSim() end
+	if not deserializeArea(table.concat(p.data),p.x,p.y) then
+		infoText:reset("Error loading stamp")
+	end
+	return true
+end
+local function loadStamp(size,x,y,reset)
+	if size==0 then
+		infoText:reset("Error loading empty stamp")
+		return
+	end
+	pendingStamp = {size=size,x=x,y=y,reset=reset,data={},got=0}
+	receiveStamp()
+end
 
 local dataCmds = {
 	[16] = function()
@@ -1179,7 +1208,7 @@ local dataCmds = {
 	[70] = function()
 		local id = cByte()
 		sim.clearSim()
-		if not sim.loadStamp("stamps/tmp.stm",0,0) then
+		if not L.reloadData or not deserializeArea(L.reloadData,0,0) then
 			infoText:reset("Error reloading save from "..con.members[id].name)
 		end
 	end,
@@ -1187,11 +1216,7 @@ local dataCmds = {
 	[128] = function()
 		local id = cByte()
 		conSend(130,string.char(id,49,tpt.set_pause()))
-		local stampName,fullName = saveStamp(0,0,sim.XRES-1,sim.YRES-1)
-		local f = assert(io.open(fullName,"rb"))
-		local s = f:read"*a"
-		f:close()
-		deleteStamp(stampName)
+		local s = serializeArea(0,0,sim.XRES-1,sim.YRES-1)
 		local d = #s
 		conSend(128,string.char(id,math.floor(d/65536),math.floor(d/256)%256,d%256)..s)
 		conSend(130,string.char(id,53,tpt.ambient_heat()))
@@ -1214,8 +1239,8 @@ local dataCmds = {
 local function connectThink()
 	if not con.connected then return end
 	if not con.socket then disconnected() return end
-	--read all messages
-	while 1 do
+	--read all messages, after the rest of any stamp that is still arriving
+	while not pendingStamp or receiveStamp() do
 		local s,r = con.socket:receive(1)
 		if s then
 			local cmd = string.byte(s)
@@ -1226,6 +1251,7 @@ local function connectThink()
 			break
 		end
 	end
+	if not con.connected then return end
 
 	--ping every minute
 	if os.time()>con.pingTime then conSend(2) con.pingTime=os.time()+60 end
@@ -1330,10 +1356,8 @@ local function sendStuff()
 		if L.lastSave~=id then
 			L.lastSave=id
 			--save a backup for the reload button
-			local stampName,fullName = saveStamp(0,0,sim.XRES-1,sim.YRES-1)
-			os.remove("stamps/tmp.stm") os.rename(fullName,"stamps/tmp.stm")
+			L.reloadData = serializeArea(0,0,sim.XRES-1,sim.YRES-1)
 			conSend(69,string.char(math.floor(id/65536),math.floor(id/256)%256,id%256))
-			deleteStamp(stampName)
 		end
 		L.browseMode=nil
 	elseif L.browseMode==2 then
@@ -1342,10 +1366,8 @@ local function sendStuff()
 		L.browseMode=nil
 	elseif L.browseMode==3 and L.lastSave==sim.getSaveID() then
 		L.browseMode=nil
-		--save this as a stamp for reloading (unless an api function exists to do this)
-		local stampName,fullName = saveStamp(0,0,sim.XRES-1,sim.YRES-1)
-		os.remove("stamps/tmp.stm") os.rename(fullName,"stamps/tmp.stm")
-		deleteStamp(stampName)
+		--save this for reloading
+		L.reloadData = serializeArea(0,0,sim.XRES-1,sim.YRES-1)
 	end
 
 	--Send screen (or an area for known size) for stamps
@@ -1362,11 +1384,7 @@ local function sendStuff()
 			L.copying=false
 		end
 		L.sendScreen=false
-		local stampName,fullName = saveStamp(x,y,w,h)
-		local f = assert(io.open(fullName,"rb"))
-		local s = f:read"*a"
-		f:close()
-		deleteStamp(stampName)
+		local s = serializeArea(x,y,w,h)
 		local d = #s
 		local b1,b2,b3 = math.floor(x/16),((x%16)*16)+math.floor(y/256),(y%256)
 		conSend(67,string.char(math.floor(x/16),((x%16)*16)+math.floor(y/256),(y%256),math.floor((x+w)/16),(((x+w)%16)*16)+math.floor((y+h)/256),((y+h)%256)))
@@ -1474,13 +1492,10 @@ local function mouseclicky(mousex,mousey,button,event,wheel)
 					conSend(67,string.char(math.floor(L.stampx/16),((L.stampx%16)*16)+math.floor(L.stampy/256),(L.stampy%256),math.floor(sx/16),((sx%16)*16)+math.floor(sy/256),(sy%256)))
 				end
 				local w,h = sx-L.stampx,sy-L.stampy
-				local stampName,fullName = saveStamp(L.stampx,L.stampy,w,h)
+				local data = serializeArea(L.stampx,L.stampy,w,h)
 				sx,sy,L.stampx,L.stampy = math.ceil((sx+1)/4)*4,math.ceil((sy+1)/4)*4,math.floor(L.stampx/4)*4,math.floor(L.stampy/4)*4
 				w,h = sx-L.stampx, sy-L.stampy
-				local f = assert(io.open(fullName,"rb"))
-				if L.copying then L.lastCopy = {data=f:read"*a",w=w,h=h} else L.lastStamp = {data=f:read"*a",w=w,h=h} end
-				f:close()
-				deleteStamp(stampName)
+				if L.copying then L.lastCopy = {data=data,w=w,h=h} else L.lastStamp = {data=data,w=w,h=h} end
 			end
 			L.stamp=false
 			L.copying=false
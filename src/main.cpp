@@ -45,6 +45,7 @@
 #endif
 #else
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #endif
 
@@ -76,6 +77,7 @@
 #include "hud.h"
 #include "benchmark.h"
 
+#include "common/JobSystem.h"
 #include "common/Platform.h"
 #include "common/tpt-minmax.h"
 #include "game/Authors.h"
@@ -85,6 +87,11 @@
 #include "game/ToolTip.h"
 #include "game/Download.h"
 #include "game/DownloadManager.h"
+#include "game/FrameRecorder.h"
+#include "game/SaveWriter.h"
+#include "game/TabState.h"
+#include "game/StampPack.h"
+#include "game/ThumbnailCache.h"
 #include "simulation/Simulation.h"
 #include "simulation/Snapshot.h"
 #include "simulation/Tool.h"
@@ -220,9 +227,6 @@ int saveURIOpen = 0;
 char * saveDataOpen = NULL;
 int saveDataOpenSize = 0;
 
-#ifdef INTERNAL
-	int vs = 0;
-#endif
 bool firstRun = false;
 bool doubleScreenDialog = false;
 int screenWidth = 0;
@@ -288,17 +292,7 @@ int core_count()
 {
 	int numCPU = 1;
 #ifdef MT
-#ifdef WIN
-	SYSTEM_INFO sysinfo;
-	GetSystemInfo( &sysinfo );
-	numCPU = sysinfo.dwNumberOfProcessors;
-#else
-#ifdef MACOSX
-	numCPU = 4;
-#else
-	numCPU = sysconf( _SC_NPROCESSORS_ONLN );
-#endif
-#endif
+	numCPU = Platform::GetCPUCount();
 
 	printf("Cpus: %d\n", numCPU);
 	if (numCPU>1)
@@ -338,24 +332,8 @@ void dump_frame(pixel *src, int w, int h, int pitch)
 
 void clear_sim()
 {
-	for (int i = 0; i < NPART; i++)
-	{
-		if (parts[i].animations)
-		{
-			free(parts[i].animations);
-			parts[i].animations = NULL;
-		}
-	}
-	memset(bmap, 0, sizeof(bmap));
 	globalSim->Clear();
-	memset(emap, 0, sizeof(emap));
 	ClearSigns();
-	memset(parts, 0, sizeof(particle)*NPART);
-	for (int i = 0; i < NPART-1; i++)
-		parts[i].life = i+1;
-	parts[NPART-1].life = -1;
-	memset(pmap, 0, sizeof(pmap));
-	memset(photons, 0, sizeof(photons));
 	memset(pers_bg, 0, (XRES+BARSIZE)*YRES*PIXELSIZE);
 	memset(fire_r, 0, sizeof(fire_r));
 	memset(fire_g, 0, sizeof(fire_g));
@@ -427,63 +405,39 @@ void stamp_gen_name(char *fn)
 	sprintf(fn, "%08x%02x", last_time, last_name);
 }
 
+// removes the stamps marked with dodelete
 void stamp_update(void)
 {
-	FILE *f;
-	int i;
-	f=fopen("stamps" PATH_SEP "stamps.def", "wb");
-	if (!f)
-		return;
-	for (i=0; i<STAMP_MAX; i++)
+	for (int i = 0; i < STAMP_MAX; i++)
 	{
 		if (!stamps[i].name[0])
 			break;
-		if (stamps[i].dodelete!=1)
-		{
-			fwrite(stamps[i].name, 1, 10, f);
-		}
-		else
+		if (stamps[i].dodelete == 1)
 		{
 			char name[30] = {0};
+			StampPack::Ref().Remove(stamps[i].name);
+			// so rescanning doesn't bring it back
 			sprintf(name,"stamps%s%s.stm",PATH_SEP,stamps[i].name);
 			remove(name);
 		}
 	}
-	fclose(f);
 }
 
-void stamp_gen_thumb(int i)
+// Thumbnails are stored in the stamp pack once they have been rendered in the background, returns true while it is still loading
+bool stamp_gen_thumb(int i)
 {
-	char fn[64];
-	void *data;
-	int size, factor_x, factor_y;
-	pixel *tmp;
+	int w, h;
+	bool loading;
+	pixel *thumb = StampPack::Ref().GetThumbnail(stamps[i].name, &w, &h, &loading);
+	if (!thumb)
+		return loading;
 
 	if (stamps[i].thumb)
-	{
 		free(stamps[i].thumb);
-		stamps[i].thumb = NULL;
-	}
-
-	sprintf(fn, "stamps" PATH_SEP "%s.stm", stamps[i].name);
-	data = file_load(fn, &size);
-
-	if (data)
-	{
-		stamps[i].thumb = prerender_save(data, size, &(stamps[i].thumb_w), &(stamps[i].thumb_h));
-		if (stamps[i].thumb && (stamps[i].thumb_w>XRES/GRID_S || stamps[i].thumb_h>YRES/GRID_S))
-		{
-			factor_x = (int)ceil((float)stamps[i].thumb_w/(float)(XRES/GRID_S));
-			factor_y = (int)ceil((float)stamps[i].thumb_h/(float)(YRES/GRID_S));
-			if (factor_y > factor_x)
-				factor_x = factor_y;
-			tmp = rescale_img(stamps[i].thumb, stamps[i].thumb_w, stamps[i].thumb_h, &(stamps[i].thumb_w), &(stamps[i].thumb_h), factor_x);
-			free(stamps[i].thumb);
-			stamps[i].thumb = tmp;
-		}
-	}
-
-	free(data);
+	stamps[i].thumb = thumb;
+	stamps[i].thumb_w = w;
+	stamps[i].thumb_h = h;
+	return false;
 }
 
 int clipboard_ready = 0;
@@ -492,7 +446,6 @@ int clipboard_length = 0;
 
 char* stamp_save(int x, int y, int w, int h, bool includePressure)
 {
-	FILE *f;
 	char fn[64], sn[16];
 	int n;
 
@@ -514,20 +467,17 @@ char* stamp_save(int x, int y, int w, int h, bool includePressure)
 	void *s = build_save(&n, x, y, w, h, bmap, globalSim->air->vx, globalSim->air->vy, globalSim->air->pv, globalSim->air->fvx, globalSim->air->fvy, signs, parts, &stampInfo, false, includePressure);
 	if (!s)
 		return NULL;
-
-#ifdef WIN
-	_mkdir("stamps");
-#else
-	mkdir("stamps", 0755);
-#endif
-
-	f = fopen(fn, "wb");
-	if (!f)
-		return NULL;
-	fwrite(s, n, 1, f);
-	fclose(f);
-
+	bool added = StampPack::Ref().Add(sn, s, n);
+	// the .stm file is only read if the stamp pack needs to be rebuilt
+	FILE *f = added ? fopen(fn, "wb") : NULL;
+	if (f)
+	{
+		fwrite(s, n, 1, f);
+		fclose(f);
+	}
 	free(s);
+	if (!added)
+		return NULL;
 
 	if (stamps[STAMP_MAX-1].thumb)
 		free(stamps[STAMP_MAX-1].thumb);
@@ -538,8 +488,6 @@ char* stamp_save(int x, int y, int w, int h, bool includePressure)
 
 	strcpy(stamps[0].name, sn);
 	stamp_gen_thumb(0);
-
-	stamp_update();
 	return mystrdup(sn);
 }
 
@@ -559,8 +507,8 @@ void tab_save(int num, char reloadButton)
 	tabInfo["date"] = (Json::Value::UInt64)time(NULL);
 	SaveAuthorInfo(&tabInfo);
 
-	//build the tab
-	saveData = build_save(&fileSize, 0, 0, XRES, YRES, bmap, globalSim->air->vx, globalSim->air->vy, globalSim->air->pv, globalSim->air->fvx, globalSim->air->fvy, signs, parts, &tabInfo, true);
+	//build the tab, compression is left to SaveWriter or done below
+	saveData = build_save(&fileSize, 0, 0, XRES, YRES, bmap, globalSim->air->vx, globalSim->air->vy, globalSim->air->pv, globalSim->air->fvx, globalSim->air->fvy, signs, parts, &tabInfo, true, true, false);
 	if (!saveData)
 		return;
 
@@ -570,21 +518,38 @@ void tab_save(int num, char reloadButton)
 	mkdir("tabs", 0755);
 #endif
 
-	//save the tab
-	f = fopen(fileName, "wb");
-	if (!f)
-		return;
-	fwrite(saveData, fileSize, 1, f);
-	fclose(f);
-
 	if (!reloadButton)
-		free(saveData);
+	{
+		//the file is only needed after a restart or crash, so write it in the background
+		SaveWriter::Ref().Write(fileName, saveData, fileSize);
+		//switching back to this tab restores it from memory. Autosave writes tab 1 even when it isn't the one open
+		if (num == tab_num)
+		{
+			delete tabStates[num-1];
+			tabStates[num-1] = TabState::Capture(globalSim);
+		}
+	}
 	else
 	{
+		int compressedSize;
+		void *compressedData = compress_save(saveData, fileSize, &compressedSize);
+		free(saveData);
+		if (!compressedData)
+			return;
+
+		//save the tab
+		SaveWriter::Ref().Cancel(fileName);
+		f = fopen(fileName, "wb");
+		if (f)
+		{
+			fwrite(compressedData, compressedSize, 1, f);
+			fclose(f);
+		}
+
 		if (svf_last)
 			free(svf_last);
-		svf_last = saveData;
-		svf_lsize = fileSize;
+		svf_last = compressedData;
+		svf_lsize = compressedSize;
 	}
 
 	//set the tab's name
@@ -606,14 +571,12 @@ void tab_save(int num, char reloadButton)
 void *stamp_load(int i, int *size, int reorder)
 {
 	void *data;
-	char fn[64];
 	struct stamp tmp;
 
-	if (!stamps[i].thumb || !stamps[i].name[0])
+	if (!stamps[i].name[0])
 		return NULL;
 
-	sprintf(fn, "stamps" PATH_SEP "%s.stm", stamps[i].name);
-	data = file_load(fn, size);
+	data = StampPack::Ref().GetData(stamps[i].name, size);
 	if (!data)
 		return NULL;
 
@@ -623,7 +586,7 @@ void *stamp_load(int i, int *size, int reorder)
 		memmove(stamps+1, stamps, sizeof(struct stamp)*i);
 		memcpy(stamps, &tmp, sizeof(struct stamp));
 
-		stamp_update();
+		StampPack::Ref().MoveToFront(stamps[0].name);
 	}
 
 	return data;
@@ -635,7 +598,18 @@ int tab_load(int tabNum, bool del)
 	int saveSize;
 	char fileName[64];
 
+	if (tabStates[tabNum-1])
+	{
+		Snapshot::TakeSnapshot(globalSim);
+		tabStates[tabNum-1]->Restore(globalSim);
+		delete tabStates[tabNum-1];
+		tabStates[tabNum-1] = NULL;
+		return 1;
+	}
+
 	sprintf(fileName, "tabs" PATH_SEP "%d.stm", tabNum);
+	// the tab might still be queued or half written
+	SaveWriter::Ref().Flush();
 	saveData = file_load(fileName, &saveSize);
 	if (saveData)
 	{
@@ -653,27 +627,6 @@ int tab_load(int tabNum, bool del)
 	return 0;
 }
 
-void stamp_init()
-{
-	int i;
-	FILE *f;
-
-	memset(stamps, 0, sizeof(stamps));
-
-	f=fopen("stamps" PATH_SEP "stamps.def", "rb");
-	if (!f)
-		return;
-	for (i=0; i<STAMP_MAX; i++)
-	{
-		int readsize = fread(stamps[i].name, 1, 10, f);
-		if (readsize != 10 || !stamps[i].name[0])
-			break;
-		stamp_count++;
-		stamp_gen_thumb(i);
-	}
-	fclose(f);
-}
-
 void stamps_free()
 {
 	for (int i = 0; i < STAMP_MAX; i++)
@@ -684,11 +637,29 @@ void stamps_free()
 		}
 }
 
+// the stamp list is the first STAMP_MAX stamps in the stamp pack
+void stamp_init()
+{
+	stamps_free();
+	memset(stamps, 0, sizeof(stamps));
+	stamp_count = 0;
+
+	int count = StampPack::Ref().GetCount();
+	for (int i = 0; i < count && stamp_count < STAMP_MAX; i++)
+	{
+		std::string name = StampPack::Ref().GetName(i);
+		if (name.length() > 10)
+			continue;
+		strcpy(stamps[stamp_count].name, name.c_str());
+		// thumbnails are only loaded once the stamp browser needs them
+		stamp_count++;
+	}
+}
+
 void del_stamp(int d)
 {
 	stamps[d].dodelete = 1;
 	stamp_update();
-	stamp_count = 0;
 	stamp_init();
 }
 
@@ -775,7 +746,7 @@ void ParticleDebug(int mode, int x, int y)
 	// update one particle at a time
 	if (mode == 0)
 	{
-		if (!NUM_PARTS)
+		if (!globalSim->numParts)
 			return;
 		i = debug_currentParticle;
 		while (i < NPART && !globalSim->parts[i].type)
@@ -822,67 +793,281 @@ void ParticleDebug(int mode, int x, int y)
 }
 
 #ifdef RENDERER
+struct RenderSize
+{
+	int w, h;
+};
+
+// Loads a save into the simulation, optionally runs it for a number of frames, and renders it into vid_buf.
+// Returns -1 if the file couldn't be read, otherwise the parse_save result
+int RenderSave(Simulation *sim, pixel *vid_buf, const char *filename, int frames)
+{
+	int load_size = 0;
+	void *load_data = file_load(filename, &load_size);
+	if (!load_data || !load_size)
+	{
+		free(load_data);
+		return -1;
+	}
+
+	clear_sim();
+	int parsestate = parse_save(load_data, load_size, 1, 0, 0, bmap, sim->air->vx, sim->air->vy, sim->air->pv, sim->air->fvx, sim->air->fvy, signs, parts, pmap, &authors);
+	free(load_data);
+
+	if (!parsestate && frames > 0)
+	{
+		sys_pause = 0;
+		for (int i = 0; i < frames; i++)
+		{
+			sim->Tick();
+			sim->air->UpdateAir();
+			sim->air->UpdateAirHeat();
+		}
+	}
+	sys_pause = 1;
+
+	render_before(vid_buf, sim);
+	render_after(vid_buf, vid_buf, sim, Point(0,0));
+	// let fire build up
+	for (int i = 0; i < 30; i++)
+	{
+		memset(vid_buf, 0, (XRES+BARSIZE)*YRES*PIXELSIZE);
+		render_parts(vid_buf, sim, Point(0,0));
+		render_fire(vid_buf);
+	}
+	render_before(vid_buf, sim);
+	render_after(vid_buf, vid_buf, sim, Point(0,0));
+
+	if (parsestate > 0)
+		info_box(vid_buf, "Save file invalid or from newer version");
+	return parsestate;
+}
+
+bool WriteFile(const char *filename, void *data, int size)
+{
+	FILE *f = fopen(filename, "wb");
+	if (!f)
+		return false;
+	bool ret = fwrite(data, size, 1, f) == 1;
+	fclose(f);
+	return ret;
+}
+
+// Writes <prefix>-<w>x<h>.png for every size
+bool WriteThumbnails(pixel *vid_buf, std::string prefix, const std::vector<RenderSize> &sizes)
+{
+	bool ret = true;
+	for (size_t i = 0; i < sizes.size(); i++)
+	{
+		int w = sizes[i].w, h = sizes[i].h, size;
+		pixel *scaled = vid_buf;
+		if (w != XRES || h != YRES)
+			scaled = resample_img(vid_buf, XRES, YRES, w, h);
+		void *png = scaled ? png_pack(scaled, w, h, &size) : NULL;
+		if (scaled != vid_buf)
+			free(scaled);
+
+		std::stringstream filename;
+		filename << prefix << "-" << w << "x" << h << ".png";
+		if (!png || !WriteFile(filename.str().c_str(), png, size))
+		{
+			fprintf(stderr, "Could not write %s\n", filename.str().c_str());
+			ret = false;
+		}
+		free(png);
+	}
+	return ret;
+}
+
+// A batch line is a save file name, optionally followed by a tab and the output prefix.
+// Without one, the save name minus its extension is used
+bool RenderBatchLine(Simulation *sim, pixel *vid_buf, std::string line, int frames, const std::vector<RenderSize> &sizes)
+{
+	if (line.length() && line[line.length()-1] == '\r')
+		line.erase(line.length()-1);
+	if (!line.length())
+		return true;
+
+	std::string filename = line, prefix;
+	size_t tab = line.find('\t');
+	if (tab != line.npos)
+	{
+		filename = line.substr(0, tab);
+		prefix = line.substr(tab+1);
+	}
+	else
+	{
+		size_t dot = filename.find_last_of('.');
+		size_t slash = filename.find_last_of("/\\");
+		prefix = (dot != filename.npos && (slash == filename.npos || dot > slash)) ? filename.substr(0, dot) : filename;
+	}
+
+	int parsestate = RenderSave(sim, vid_buf, filename.c_str(), frames);
+	if (parsestate < 0)
+	{
+		fprintf(stderr, "Could not read %s\n", filename.c_str());
+		return false;
+	}
+	if (parsestate > 0)
+		fprintf(stderr, "%s: save file invalid or from newer version\n", filename.c_str());
+	return WriteThumbnails(vid_buf, prefix, sizes) && !parsestate;
+}
+
+// Renders every save listed in list (see RenderBatchLine), reusing one simulation and video buffer.
+// With more than one job, the list is read first and split between forked worker processes,
+// which all share the already initialized element tables and graphics caches
+int RenderBatch(Simulation *sim, pixel *vid_buf, FILE *list, int frames, const std::vector<RenderSize> &sizes, int jobs)
+{
+	char buf[4096];
+	int failures = 0;
+#ifndef WIN
+	if (jobs > 1)
+	{
+		std::vector<std::string> lines;
+		while (fgets(buf, sizeof(buf), list))
+		{
+			std::string line = buf;
+			if (line.length() && line[line.length()-1] == '\n')
+				line.erase(line.length()-1);
+			lines.push_back(line);
+		}
+
+		std::vector<pid_t> workers;
+		for (int job = 0; job < jobs; job++)
+		{
+			pid_t pid = fork();
+			if (pid == 0)
+			{
+				for (size_t i = job; i < lines.size(); i += jobs)
+					if (!RenderBatchLine(sim, vid_buf, lines[i], frames, sizes))
+						failures++;
+				fflush(stderr);
+				_exit(failures ? 1 : 0);
+			}
+			else if (pid < 0)
+			{
+				fprintf(stderr, "Could not start worker %i\n", job);
+				// render this worker's share in this process instead
+				for (size_t i = job; i < lines.size(); i += jobs)
+					if (!RenderBatchLine(sim, vid_buf, lines[i], frames, sizes))
+						failures++;
+			}
+			else
+				workers.push_back(pid);
+		}
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			int status;
+			if (waitpid(workers[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+				failures++;
+		}
+		return failures ? 1 : 0;
+	}
+#endif
+
+	// single process, saves are rendered as they are read so a stream can be piped in
+	while (fgets(buf, sizeof(buf), list))
+	{
+		std::string line = buf;
+		if (line.length() && line[line.length()-1] == '\n')
+			line.erase(line.length()-1);
+		if (!RenderBatchLine(sim, vid_buf, line, frames, sizes))
+			failures++;
+	}
+	return failures ? 1 : 0;
+}
+
 int main(int argc, char *argv[])
 {
 	pixel *vid_buf = (pixel*)calloc((XRES+BARSIZE)*(YRES+MENUSIZE), PIXELSIZE);
-	int load_size, i=0, j=0;
-	void *load_data = file_load(argv[1], &load_size);
+	int i=0, j=0;
 	unsigned char c[3];
 	char ppmfilename[256], ptifilename[256], ptismallfilename[256];
 	FILE *f;
 
+	const char *batchList = NULL;
+	int frames = 0, jobs = 1;
+	std::vector<RenderSize> sizes;
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--batch") && i+1 < argc)
+			batchList = argv[++i];
+		else if (!strcmp(argv[i], "--frames") && i+1 < argc)
+			frames = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--jobs") && i+1 < argc)
+			jobs = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--sizes") && i+1 < argc)
+		{
+			std::stringstream sizeList(argv[++i]);
+			std::string size;
+			while (std::getline(sizeList, size, ','))
+			{
+				RenderSize s;
+				if (sscanf(size.c_str(), "%ix%i", &s.w, &s.h) == 2 && s.w > 0 && s.h > 0 && s.w <= XRES && s.h <= YRES)
+					sizes.push_back(s);
+				else
+					fprintf(stderr, "Invalid size %s\n", size.c_str());
+			}
+		}
+		else
+			break;
+	}
+	if (!batchList && argc-i < 2)
+	{
+		fprintf(stderr, "Usage: %s <save> <output name>\n"
+		                "       %s --batch <list file, or - for stdin> [--frames n] [--sizes WxH,WxH...] [--jobs n]\n", argv[0], argv[0]);
+		return 0;
+	}
+
 	//init some new c++ stuff
 	Simulation *mainSim = new Simulation();
-	mainSim->InitElements();
-	globalSim = mainSim;
+	mainSim->MakeCurrent();
+	Simulation_Compat_CopyData(mainSim);
 
 	render_mode = Renderer::Ref().GetRenderModesRaw();
 	display_mode = Renderer::Ref().GetDisplayModesRaw();
 	Renderer::Ref().SetColorMode(COLOR_DEFAULT);
-	init_display_modes();
 	TRON_init_graphics();
+	gravity_init();
 
 	sys_pause = 1;
-	parts = (particle*)calloc(sizeof(particle), NPART);
 	pers_bg = (pixel*)calloc((XRES+BARSIZE)*YRES, PIXELSIZE);
 	clear_sim();
 
-	prepare_alpha(CELL, 1.0f);
+	prepare_alpha(1.0f);
 	prepare_graphicscache();
 	flm_data = generate_gradient(flm_data_colours, flm_data_pos, flm_data_points, 200);
 	plasma_data = generate_gradient(plasma_data_colours, plasma_data_pos, plasma_data_points, 200);
 
-	sprintf(ppmfilename, "%s.ppm", argv[2]);
-	sprintf(ptifilename, "%s.pti", argv[2]);
-	sprintf(ptismallfilename, "%s-small.pti", argv[2]);
-
-	if (load_data && load_size)
+	if (batchList)
 	{
-		int parsestate = 0;
-		//parsestate = parse_save(load_data, load_size, 1, 0, 0);
-		parsestate = parse_save(load_data, load_size, 1, 0, 0, bmap, vx, vy, pv, fvx, fvy, signs, parts, pmap);
-
-		//decorations_enable = 0;
-		render_before(vid_buf);
-		render_after(vid_buf, vid_buf, Point(0,0));
-		for (i=0; i<30; i++)
+		if (!sizes.size())
 		{
-			memset(vid_buf, 0, (XRES+BARSIZE)*YRES*PIXELSIZE);
-			render_parts(vid_buf, Point(0,0));
-			render_fire(vid_buf);
+			RenderSize full = {XRES, YRES}, small = {XRES/GRID_Z, YRES/GRID_Z};
+			sizes.push_back(full);
+			sizes.push_back(small);
 		}
-		render_before(vid_buf);
-		render_after(vid_buf, vid_buf, Point(0,0));
-
-		if (parsestate>0)
+		FILE *list = strcmp(batchList, "-") ? fopen(batchList, "r") : stdin;
+		if (!list)
 		{
-			//return 0;
-			info_box(vid_buf, "Save file invalid or from newer version");
+			fprintf(stderr, "Could not open %s\n", batchList);
+			return 1;
 		}
+		int ret = RenderBatch(mainSim, vid_buf, list, frames, sizes, jobs);
+		if (list != stdin)
+			fclose(list);
+		return ret;
+	}
+
+	sprintf(ppmfilename, "%s.ppm", argv[i+1]);
+	sprintf(ptifilename, "%s.pti", argv[i+1]);
+	sprintf(ptismallfilename, "%s-small.pti", argv[i+1]);
 
+	if (RenderSave(mainSim, vid_buf, argv[i], frames) >= 0)
+	{
 		//Save PTi images
 		char * datares = NULL, *scaled_buf;
-		int res = 0, sw, sh;
+		int res = 0;
 		datares = (char*)ptif_pack(vid_buf, XRES, YRES, &res);
 		if (datares!=NULL)
 		{
@@ -1112,6 +1297,7 @@ PowderToy *the_game;
 int main(int argc, char *argv[])
 {
 	bool benchmark_enable = false;
+	int jobThreads = 0;
 
 #ifdef PTW32_STATIC_LIB
 	pthread_win32_process_attach_np();
@@ -1198,6 +1384,10 @@ int main(int argc, char *argv[])
 			memset(http_proxy_string, 0, sizeof(http_proxy_string));
 			strncpy(http_proxy_string, argv[i]+6, 255);
 		}
+		else if (!strncmp(argv[i], "threads:", 8))
+		{
+			jobThreads = atoi(argv[i]+8);
+		}
 		else if (!strncmp(argv[i], "nohud", 5))
 		{
 			hud_enable = false;
@@ -1294,8 +1484,15 @@ int main(int argc, char *argv[])
 				i++;
 			}
 		}
+		else if (!strcmp(argv[i], "benchmark2") && i+1<argc)
+		{
+			benchmark_file2 = argv[i+1];
+			i++;
+		}
 	}
 
+	// threads:n overrides the number of threads jobs run on, 0 uses the number of CPUs
+	JobSystem::Ref().Init(jobThreads);
 	stamp_init();
 
 	if (!sdl_open())
@@ -1945,32 +2142,12 @@ int main_loop_temp(int b, int bq, int sdl_key, int sdl_rkey, unsigned short sdl_
 			}
 		}
 #ifdef INTERNAL
-		int counterthing;
 		if (sdl_key=='v'&&!(sdl_mod & (KMOD_CTRL|KMOD_META)))//frame capture
 		{
-			if (sdl_mod & (KMOD_SHIFT)) {
-				if (vs>=1)
-					vs = 0;
-				else
-					vs = 3;//every other frame
-			}
-			else
-			{
-				if (vs>=1)
-					vs = 0;
-				else
-					vs = 1;
-			}
-			counterthing = 0;
-		}
-		if (vs)
-		{
-			if (counterthing+1>=vs)
-			{
-				dump_frame(vid_buf, XRES, YRES, XRES+BARSIZE);
-				counterthing = 0;
-			}
-			counterthing = (counterthing+1)%3;
+			if (FrameRecorder::Ref().IsRecording())
+				FrameRecorder::Ref().Stop();
+			else if (!FrameRecorder::Ref().Start(FrameRecorder::FORMAT_PNG, (sdl_mod & KMOD_SHIFT) ? 3 : 1, 0, 0, XRES, YRES).length()) //every third frame with shift
+				error_ui(vid_buf, 0, FrameRecorder::Ref().GetError().c_str());
 		}
 #endif
 
@@ -2325,6 +2502,8 @@ int main_loop_temp(int b, int bq, int sdl_key, int sdl_rkey, unsigned short sdl_
 			DrawLuaLogs();
 		}
 
+		FrameRecorder::Ref().Capture(vid_buf, XRES+BARSIZE);
+
 		if (console_mode)
 		{
 			openConsole = true;
@@ -2351,8 +2530,13 @@ void main_end_hack()
 	SaveWindowPosition();
 	save_presets();
 	DownloadManager::Ref().Shutdown();
+	ThumbnailCache::Ref().Shutdown();
+	StampPack::Ref().Shutdown();
+	SaveWriter::Ref().Shutdown();
+	FrameRecorder::Ref().Shutdown();
 	http_done();
 	gravity_cleanup();
+	JobSystem::Ref().Shutdown();
 #ifdef LUACONSOLE
 	luacon_close();
 #endif
@@ -2376,6 +2560,8 @@ void main_end_hack()
 		sprintf(name,"tabs%s%d.stm",PATH_SEP,i);
 		remove(name);
 	}
+	for (int i = 0; i < 10; i++)
+		delete tabStates[i];
 #ifdef WIN
 	_rmdir("tabs");
 #else
@@ -34,18 +34,17 @@
 
 part_type ptypes[PT_NUM];
 
-particle *parts;
+TPT_THREAD_LOCAL particle *parts = NULL;
 
 int airMode = 0;
 bool water_equal_test = 0;
 
-unsigned char bmap[YRES/CELL][XRES/CELL];
-unsigned char emap[YRES/CELL][XRES/CELL];
+TPT_THREAD_LOCAL unsigned char (*bmap)[XRES/CELL] = NULL;
+TPT_THREAD_LOCAL unsigned char (*emap)[XRES/CELL] = NULL;
 
-unsigned pmap[YRES][XRES];
-int pmap_count[YRES][XRES];
-unsigned photons[YRES][XRES];
-int NUM_PARTS = 0;
+TPT_THREAD_LOCAL unsigned (*pmap)[XRES] = NULL;
+TPT_THREAD_LOCAL int (*pmap_count)[XRES] = NULL;
+TPT_THREAD_LOCAL unsigned (*photons)[XRES] = NULL;
 
 void get_gravity_field(int x, int y, float particleGrav, float newtonGrav, float *pGravX, float *pGravY)
 {
@@ -59,7 +58,7 @@ void get_gravity_field(int x, int y, float particleGrav, float newtonGrav, float
 			*pGravY += particleGrav;
 			break;
 		case 1: //no gravity
-			angle = rand()%360;
+			angle = tpt_rand()%360;
 			*pGravX -= cosf((float)angle);
 			*pGravY -= sinf((float)angle);
 			break;
@@ -140,7 +139,7 @@ int get_wavelength_bin(int *wm)
 	if (wM - w0 < 5)
 		return wM + w0;
 
-	r = rand();
+	r = tpt_rand();
 	i = (r >> 1) % (wM-w0-4);
 	i += w0;
 
@@ -348,6 +347,8 @@ int flood_water(int x, int y, int i, int originaly, int check)
 			int oldy = (int)(parts[i].y + 0.5f);
 			pmap[y-1][x] = pmap[oldy][oldx];
 			pmap[oldy][oldx] = 0;
+			globalSim->occupancy_update(x, y-1);
+			globalSim->occupancy_update(oldx, oldy);
 			parts[i].x = (float)x;
 			parts[i].y = y-1.0f;
 			return 0;
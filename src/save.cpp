@@ -47,7 +47,7 @@
 #include "simulation/elements/STKM.h"
 
 //Pop
-pixel *prerender_save(void *save, int size, int *width, int *height)
+pixel *prerender_save(void *save, int size, int *width, int *height, int *elementCounts)
 {
 	unsigned char * saveData = (unsigned char*)save;
 	if (size < 16 || !save)
@@ -58,7 +58,7 @@ pixel *prerender_save(void *save, int size, int *width, int *height)
 	{
 		if(saveData[0] == 'O' && saveData[1] == 'P' && (saveData[2] == 'S' || saveData[2] == 'J'))
 		{
-			return prerender_save_OPS(save, size, width, height);
+			return prerender_save_OPS(save, size, width, height, elementCounts);
 		}
 		else if((saveData[0]==0x66 && saveData[1]==0x75 && saveData[2]==0x43) || (saveData[0]==0x50 && saveData[1]==0x53 && saveData[2]==0x76))
 		{
@@ -326,7 +326,7 @@ int change_wallpp(int wt)
 	return wt;
 }
 
-pixel *prerender_save_OPS(void *save, int size, int *width, int *height)
+pixel *prerender_save_OPS(void *save, int size, int *width, int *height, int *elementCounts)
 {
 	unsigned char * inputData = (unsigned char*)save, *bsonData = NULL, *partsData = NULL, *partsPosData = NULL, *wallData = NULL;
 	int inputDataLen = size, bsonDataLen = 0, partsDataLen, partsPosDataLen, wallDataLen;
@@ -603,6 +603,8 @@ pixel *prerender_save_OPS(void *save, int size, int *width, int *height)
 					type = fix_type(partsData[i],saved_version, modsave, hasPalette ? elementPalette : NULL);
 					if (type < 0 || type >= PT_NUM || !globalSim->elements[type].Enabled)
 						type = PT_NONE; //invalid element
+					if (elementCounts && type)
+						elementCounts[type]++;
 					
 					//Draw type
 					if (type==PT_STKM || type==PT_STKM2 || type==PT_FIGH)
@@ -766,7 +768,7 @@ fin:
 	minimumMinorVersion = minor;\
 }
 
-void *build_save(int *size, int orig_x0, int orig_y0, int orig_w, int orig_h, unsigned char bmap[YRES/CELL][XRES/CELL], float vx[YRES/CELL][XRES/CELL], float vy[YRES/CELL][XRES/CELL], float pv[YRES/CELL][XRES/CELL], float fvx[YRES/CELL][XRES/CELL], float fvy[YRES/CELL][XRES/CELL], std::vector<Sign*>& signs, void* o_partsptr, Json::Value *j, bool tab, bool includePressure)
+void *build_save(int *size, int orig_x0, int orig_y0, int orig_w, int orig_h, unsigned char bmap[YRES/CELL][XRES/CELL], float vx[YRES/CELL][XRES/CELL], float vy[YRES/CELL][XRES/CELL], float pv[YRES/CELL][XRES/CELL], float fvx[YRES/CELL][XRES/CELL], float fvy[YRES/CELL][XRES/CELL], std::vector<Sign*>& signs, void* o_partsptr, Json::Value *j, bool tab, bool includePressure, bool compress)
 {
 	particle *partsptr = (particle*)o_partsptr;
 	unsigned char *partsData = NULL, *partsPosData = NULL, *fanData = NULL, *wallData = NULL, *finalData = NULL, *outputData = NULL, *soapLinkData = NULL;
@@ -774,7 +776,7 @@ void *build_save(int *size, int orig_x0, int orig_y0, int orig_w, int orig_h, un
 	unsigned *partsPosLink = NULL, *partsPosFirstMap = NULL, *partsPosCount = NULL, *partsPosLastMap = NULL;
 	unsigned partsCount = 0, *partsSaveIndex = NULL;
 	unsigned *elementCount = (unsigned*)calloc(PT_NUM, sizeof(unsigned));
-	int partsDataLen, partsPosDataLen, fanDataLen = 0, wallDataLen, finalDataLen, outputDataLen, soapLinkDataLen;
+	int partsDataLen, partsPosDataLen, fanDataLen = 0, wallDataLen, finalDataLen, soapLinkDataLen;
 	int pressDataLen = 0, vxDataLen = 0, vyDataLen = 0, ambientDataLen = 0;
 #ifndef NOMOD
 	unsigned char *movsData = NULL, *animData = NULL;
@@ -1207,16 +1209,17 @@ void *build_save(int *size, int orig_x0, int orig_y0, int orig_w, int orig_h, un
 					//Turn pmap entry into a partsptr index
 					i = i>>8;
 
-					if (partsptr[i].type == PT_ANIM && partsptr[i].animations)
+					ARGBColour *frames = partsptr[i].type == PT_ANIM ? globalSim->animations.Get(i) : NULL;
+					if (frames)
 					{
 						int animLength = std::min(partsptr[i].ctype, globalSim->maxFrames-1); //make sure we don't try to read past what is allocated
 						animData[animDataLen++] = animLength; //first byte stores data length, rest is length*4 bytes
 						for (int j = 0; j <= animLength; j++)
 						{
-							animData[animDataLen++] = COLA(partsptr[i].animations[j]);
-							animData[animDataLen++] = COLR(partsptr[i].animations[j]);
-							animData[animDataLen++] = COLG(partsptr[i].animations[j]);
-							animData[animDataLen++] = COLB(partsptr[i].animations[j]);
+							animData[animDataLen++] = COLA(frames[j]);
+							animData[animDataLen++] = COLR(frames[j]);
+							animData[animDataLen++] = COLG(frames[j]);
+							animData[animDataLen++] = COLB(frames[j]);
 						}
 					}
 
@@ -1418,8 +1421,7 @@ void *build_save(int *size, int orig_x0, int orig_y0, int orig_w, int orig_h, un
 	
 	finalData = (unsigned char*)bson_data(&b);
 	finalDataLen = bson_size(&b);
-	outputDataLen = finalDataLen*2+12;
-	outputData = (unsigned char*)malloc(outputDataLen);
+	outputData = (unsigned char*)malloc(finalDataLen+12);
 	if (!outputData)
 	{
 		puts("Save Error, out of memory\n");
@@ -1439,19 +1441,16 @@ void *build_save(int *size, int orig_x0, int orig_y0, int orig_w, int orig_h, un
 	outputData[9] = finalDataLen >> 8;
 	outputData[10] = finalDataLen >> 16;
 	outputData[11] = finalDataLen >> 24;
-	
-	if (BZ2_bzBuffToBuffCompress((char*)outputData+12, (unsigned*)(&outputDataLen), (char*)finalData, bson_size(&b), 9, 0, 0) != BZ_OK)
+	memcpy(outputData+12, finalData, finalDataLen);
+	*size = finalDataLen + 12;
+
+	if (compress)
 	{
-		puts("Save Error\n");
+		unsigned char *compressedData = (unsigned char*)compress_save(outputData, *size, size);
 		free(outputData);
-		*size = 0;
-		outputData = NULL;
-		goto fin;
+		outputData = compressedData;
 	}
 	
-	//printf("compressed data: %d\n", outputDataLen);
-	*size = outputDataLen + 12;
-	
 fin:
 	bson_destroy(&b);
 	free(partsData);
@@ -1473,6 +1472,32 @@ fin:
 	return outputData;
 }
 
+void *compress_save(void *save, int size, int *compressedSize)
+{
+	unsigned char *data = (unsigned char*)save;
+	unsigned outputDataLen = (size-12)*2+12;
+	unsigned char *outputData = (unsigned char*)malloc(outputDataLen+12);
+	*compressedSize = 0;
+	if (!outputData)
+	{
+		puts("Save Error, out of memory\n");
+		return NULL;
+	}
+
+	//the header stays the same, it already has the uncompressed size
+	memcpy(outputData, data, 12);
+	if (BZ2_bzBuffToBuffCompress((char*)outputData+12, &outputDataLen, (char*)data+12, size-12, 9, 0, 0) != BZ_OK)
+	{
+		puts("Save Error\n");
+		free(outputData);
+		return NULL;
+	}
+
+	//printf("compressed data: %d\n", outputDataLen);
+	*compressedSize = outputDataLen + 12;
+	return outputData;
+}
+
 void checkBsonFieldUser(bson_iterator iter, const char *field, unsigned char **data, unsigned int *fieldLen)
 {
 	if (!strcmp(bson_iterator_key(&iter), field))
@@ -2147,6 +2172,7 @@ int parse_save_OPS(void *save, int size, int replace, int x0, int y0, unsigned c
 						if (replace >= 0)
 							globalSim->elementCount[parts[newIndex].type]--;
 						pmap[y][x] = 0;
+						globalSim->occupancy_update(x, y);
 					}
 					/*else if(photons[y][x] && posCount==0)
 					{
@@ -2497,8 +2523,8 @@ int parse_save_OPS(void *save, int size, int replace, int x0, int y0, unsigned c
 					int origanimLen = animData[animDataPos++];
 					int animLen = std::min(origanimLen, globalSim->maxFrames-1); //read animation length, make sure it doesn't go past the current frame limit
 					partsptr[newIndex].ctype = animLen;
-					partsptr[newIndex].animations = (ARGBColour*)calloc(globalSim->maxFrames, sizeof(ARGBColour));
-					if (animDataPos+4*animLen > animDataLen || partsptr[newIndex].animations == NULL)
+					ARGBColour *frames = globalSim->animations.Alloc(newIndex);
+					if (animDataPos+4*animLen > animDataLen || frames == NULL)
 						goto fail;
 
 					for (int j = 0; j < globalSim->maxFrames; j++)
@@ -2509,10 +2535,10 @@ int parse_save_OPS(void *save, int size, int replace, int x0, int y0, unsigned c
 							unsigned char red = animData[animDataPos++];
 							unsigned char green = animData[animDataPos++];
 							unsigned char blue = animData[animDataPos++];
-							partsptr[newIndex].animations[j] = COLARGB(alpha, red, green, blue);
+							frames[j] = COLARGB(alpha, red, green, blue);
 						}
 						else //set the rest to 0
-							partsptr[newIndex].animations[j] = 0;
+							frames[j] = 0;
 					}
 					//ignore any extra data in case user set maxFrames to something small
 					if (origanimLen+1 > globalSim->maxFrames)
@@ -2995,6 +3021,7 @@ int parse_save_PSv(void *save, int size, int replace, int x0, int y0, unsigned c
 			x = (int)(parts[i].x+0.5f);
 			y = (int)(parts[i].y+0.5f);
 			pmap[y][x] = (i<<8)|1;
+			globalSim->occupancy_update(x, y);
 		}
 		else
 			fp[nf++] = i;
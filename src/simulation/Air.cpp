@@ -401,7 +401,7 @@ void Air::RecalculateBlockAirMaps(Simulation * sim)
 			bmap_blockairh[y][x] = 0x8;
 		}
 		// mostly accurate insulator blocking, besides checking GEL
-		else if ((type == PT_HSWC && sim->parts[i].life != 10) || sim->elements[type].HeatConduct <= (rand()%250))
+		else if ((type == PT_HSWC && sim->parts[i].life != 10) || sim->elements[type].HeatConduct <= (tpt_rand()%250))
 		{
 			int x = ((int)(sim->parts[i].x+0.5f))/CELL, y = ((int)(sim->parts[i].y+0.5f))/CELL;
 			if (!(bmap_blockairh[y][x]&0x8))
@@ -0,0 +1,96 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "AnimationArena.h"
+#include "defines.h"
+
+AnimationArena::AnimationArena(int frameCount):
+	frameCount(frameCount),
+	handles(NPART, -1)
+{
+}
+
+void AnimationArena::Reset(int newFrameCount)
+{
+	frameCount = newFrameCount;
+	handles.assign(NPART, -1);
+	frames.clear();
+	freeBlocks.clear();
+}
+
+ARGBColour *AnimationArena::Alloc(int i)
+{
+	if (i < 0 || i >= (int)handles.size())
+		return NULL;
+	if (handles[i] < 0)
+	{
+		if (freeBlocks.size())
+		{
+			handles[i] = freeBlocks.back();
+			freeBlocks.pop_back();
+		}
+		else
+		{
+			handles[i] = frames.size()/frameCount;
+			frames.resize(frames.size()+frameCount);
+		}
+	}
+	ARGBColour *block = &frames[handles[i]*frameCount];
+	std::fill(block, block+frameCount, 0);
+	return block;
+}
+
+void AnimationArena::Free(int i)
+{
+	if (i < 0 || i >= (int)handles.size() || handles[i] < 0)
+		return;
+	freeBlocks.push_back(handles[i]);
+	handles[i] = -1;
+}
+
+void AnimationArena::Remap(const int *newIndex)
+{
+	std::vector<int> newHandles(handles.size(), -1);
+	for (size_t i = 0; i < handles.size(); i++)
+	{
+		if (handles[i] < 0)
+			continue;
+		if (newIndex[i] >= 0 && newIndex[i] < (int)newHandles.size())
+			newHandles[newIndex[i]] = handles[i];
+		else
+			freeBlocks.push_back(handles[i]);
+	}
+	handles.swap(newHandles);
+}
+
+AnimationArena AnimationArena::Copy(int count) const
+{
+	AnimationArena snap;
+	snap.frameCount = frameCount;
+	snap.handles.assign(handles.begin(), handles.begin()+std::min(count, (int)handles.size()));
+	snap.frames = frames;
+	snap.freeBlocks = freeBlocks;
+	return snap;
+}
+
+void AnimationArena::Restore(const AnimationArena &snap)
+{
+	frameCount = snap.frameCount;
+	handles = snap.handles;
+	handles.resize(NPART, -1);
+	frames = snap.frames;
+	freeBlocks = snap.freeBlocks;
+}
@@ -0,0 +1,62 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANIMATIONARENA_H
+#define ANIMATIONARENA_H
+
+#include <cstddef>
+#include <vector>
+#include "graphics/ARGBColour.h"
+
+// Frame colors for ANIM particles. Every particle with frames owns one block of frameCount colors,
+// all blocks are stored together and freed blocks are reused, so allocating and freeing don't touch the heap.
+// Particles are looked up by their index, blocks by a handle (the block number), never by pointer.
+// Pointers returned by Get / Alloc are only valid until the next Alloc.
+class AnimationArena
+{
+	int frameCount;
+	std::vector<int> handles; // block for each particle index, -1 if it doesn't have one
+	std::vector<ARGBColour> frames;
+	std::vector<int> freeBlocks;
+
+public:
+	// empty, with room for no particles until Reset or Restore
+	AnimationArena(): frameCount(0) {}
+	AnimationArena(int frameCount);
+
+	// free everything, and change how many frames each block holds
+	void Reset(int newFrameCount);
+	int GetFrameCount() const { return frameCount; }
+
+	// gives particle i a block of frames set to 0, reusing its current block if it has one
+	ARGBColour *Alloc(int i);
+	void Free(int i);
+	ARGBColour *Get(int i)
+	{
+		if (i < 0 || i >= (int)handles.size() || handles[i] < 0)
+			return NULL;
+		return &frames[handles[i]*frameCount];
+	}
+
+	// moves the block of each particle i to newIndex[i], or frees it if that is -1
+	void Remap(const int *newIndex);
+
+	// copy of all frames for particles 0 to count-1, for snapshots
+	AnimationArena Copy(int count) const;
+	// replace everything with a copy made by Copy
+	void Restore(const AnimationArena &snap);
+};
+
+#endif
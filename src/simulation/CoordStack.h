@@ -17,6 +17,7 @@
 #define Simulation_CoordStack_h
 
 #include "defines.h" // for XRES and YRES
+#include <algorithm>
 #include <exception>
 
 class CoordStackOverflowException: public std::exception
@@ -30,18 +31,36 @@ public:
 	~CoordStackOverflowException() throw() {}
 };
 
+// Coordinates still to be visited by a flood fill. Most floods only ever hold a handful of
+// entries, so the buffer starts small and grows as needed instead of reserving room for
+// every pixel of the screen up front.
 class CoordStack
 {
 private:
 	unsigned short (*stack)[2];
 	int stack_size;
+	int stack_capacity;
 	const static int stack_limit = XRES*YRES;
+	const static int initial_capacity = 256;
+
+	void grow()
+	{
+		int newCapacity = stack_capacity ? std::min(stack_capacity*2, (int)stack_limit) : (int)initial_capacity;
+		unsigned short (*newStack)[2] = (unsigned short(*)[2])(new unsigned short[2*newCapacity]);
+		if (stack)
+		{
+			std::copy(stack[0], stack[0]+2*stack_size, newStack[0]);
+			delete[] stack;
+		}
+		stack = newStack;
+		stack_capacity = newCapacity;
+	}
 public:
 	CoordStack() :
 		stack(NULL),
-		stack_size(0)
+		stack_size(0),
+		stack_capacity(0)
 	{
-		stack = (unsigned short(*)[2])(new unsigned short[2*stack_limit]);
 	}
 	~CoordStack()
 	{
@@ -49,8 +68,12 @@ public:
 	}
 	void push(int x, int y)
 	{
-		if (stack_size>=stack_limit)
-			throw CoordStackOverflowException();
+		if (stack_size>=stack_capacity)
+		{
+			if (stack_size>=stack_limit)
+				throw CoordStackOverflowException();
+			grow();
+		}
 		stack[stack_size][0] = (unsigned short)x;
 		stack[stack_size][1] = (unsigned short)y;
 		stack_size++;
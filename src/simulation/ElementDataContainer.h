@@ -25,6 +25,9 @@ public:
 	virtual void Simulation_Cleared(Simulation *sim) {}
 	virtual void Simulation_BeforeUpdate(Simulation *sim) {}
 	virtual void Simulation_AfterUpdate(Simulation *sim) {}
+	// particles were moved to new indices by Simulation::CompactParticles. newIndex[i] is the new index of the
+	// particle that was at i, or -1 if there wasn't one
+	virtual void Simulation_ParticlesMoved(Simulation *sim, const int *newIndex) {}
 };
 
 #endif
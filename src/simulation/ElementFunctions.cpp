@@ -14,15 +14,15 @@ int update_legacy_all(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r)
 						continue;
-					if (((r&0xFF)==PT_WATR||(r&0xFF)==PT_DSTW||(r&0xFF)==PT_SLTW) && !(rand()%1000))
+					if (((r&0xFF)==PT_WATR||(r&0xFF)==PT_DSTW||(r&0xFF)==PT_SLTW) && !(tpt_rand()%1000))
 					{
 						part_change_type(i,x,y,PT_WATR);
 						part_change_type(r>>8,x+rx,y+ry,PT_WATR);
 					}
-					if (((r&0xFF)==PT_ICEI || (r&0xFF)==PT_SNOW) && !(rand()%1000))
+					if (((r&0xFF)==PT_ICEI || (r&0xFF)==PT_SNOW) && !(tpt_rand()%1000))
 					{
 						part_change_type(i,x,y,PT_WATR);
-						if (!(rand()%1000))
+						if (!(tpt_rand()%1000))
 							part_change_type(r>>8,x+rx,y+ry,PT_WATR);
 					}
 				}
@@ -38,7 +38,7 @@ int update_legacy_all(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r)
 						continue;
-					if (((r&0xFF)==PT_FIRE || (r&0xFF)==PT_LAVA) && !(rand()%10))
+					if (((r&0xFF)==PT_FIRE || (r&0xFF)==PT_LAVA) && !(tpt_rand()%10))
 					{
 						part_change_type(i,x,y,PT_WTRV);
 					}
@@ -52,9 +52,9 @@ int update_legacy_all(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r)
 						continue;
-					if (((r&0xFF)==PT_FIRE || (r&0xFF)==PT_LAVA) && !(rand()%10))
+					if (((r&0xFF)==PT_FIRE || (r&0xFF)==PT_LAVA) && !(tpt_rand()%10))
 					{
-						if (rand()%4==0) part_change_type(i,x,y,PT_SALT);
+						if (tpt_rand()%4==0) part_change_type(i,x,y,PT_SALT);
 						else part_change_type(i,x,y,PT_WTRV);
 					}
 				}
@@ -67,7 +67,7 @@ int update_legacy_all(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r)
 						continue;
-					if (((r&0xFF)==PT_WATR || (r&0xFF)==PT_DSTW) && !(rand()%1000))
+					if (((r&0xFF)==PT_WATR || (r&0xFF)==PT_DSTW) && !(tpt_rand()%1000))
 					{
 						part_change_type(i,x,y,PT_ICEI);
 						part_change_type(r>>8,x+rx,y+ry,PT_ICEI);
@@ -82,12 +82,12 @@ int update_legacy_all(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r)
 						continue;
-					if (((r&0xFF)==PT_WATR || (r&0xFF)==PT_DSTW) && !(rand()%1000))
+					if (((r&0xFF)==PT_WATR || (r&0xFF)==PT_DSTW) && !(tpt_rand()%1000))
 					{
 						part_change_type(i,x,y,PT_ICEI);
 						part_change_type(r>>8,x+rx,y+ry,PT_ICEI);
 					}
-					if (((r&0xFF)==PT_WATR || (r&0xFF)==PT_DSTW) && 3>(rand()%200))
+					if (((r&0xFF)==PT_WATR || (r&0xFF)==PT_DSTW) && 3>(tpt_rand()%200))
 						part_change_type(i,x,y,PT_WATR);
 				}
 		break;
@@ -103,7 +103,7 @@ int update_legacy_all(UPDATE_FUNC_ARGS)
 		if (sim->air->pv[y/CELL][x/CELL] > 12.0f)
 		{
 			part_change_type(i,x,y,PT_FIRE);
-			parts[i].life = rand()%50+120;
+			parts[i].life = tpt_rand()%50+120;
 		}
 	default:
 		break;
@@ -0,0 +1,172 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include "INSTNetlist.h"
+#include "Simulation.h"
+
+// all nets are dropped once they hold this many pixels together
+#define INSTNETLIST_MAX_PIXELS (XRES*YRES*2)
+
+INSTNetlist::INSTNetlist():
+	pixelCount(0),
+	recording(NULL),
+	recordingStart(0),
+	recorded(NULL),
+	generation(0),
+	enabled(true)
+{
+}
+
+INSTNetlist::~INSTNetlist()
+{
+	Clear();
+	delete recording;
+	free(recorded);
+}
+
+int INSTNetlist::PixelKind(Simulation *sim, int x, int y)
+{
+	int r = sim->pmap[y][x];
+	if ((r&0xFF) == PT_INST)
+		return sim->parts[r>>8].life <= 0 ? PIXEL_SPARKABLE : PIXEL_COOLING;
+	if ((r&0xFF) == PT_SPRK && sim->parts[r>>8].ctype == PT_INST)
+		return PIXEL_SPRK;
+	return PIXEL_OTHER;
+}
+
+// Replaying is only the same as flooding if sparking INST always turns it into SPRK(INST) and does nothing else.
+// Lua can change the element properties this depends on
+bool INSTNetlist::CanReplay(Simulation *sim)
+{
+	Element *sprk = &sim->elements[PT_SPRK], *inst = &sim->elements[PT_INST];
+	return sprk->Enabled && !(sprk->Properties&TYPE_ENERGY) && !sprk->Func_Create_Allowed && !sprk->Func_ChangeType
+		&& !inst->Func_ChangeType && !(inst->Properties&PROP_INDESTRUCTIBLE);
+}
+
+void INSTNetlist::Record(Simulation *sim, int x, int y)
+{
+	Pixel pixel;
+	pixel.x = (unsigned short)x;
+	pixel.y = (unsigned short)y;
+	pixel.kind = (unsigned char)PixelKind(sim, x, y);
+	recording->pixels.push_back(pixel);
+	recorded[y][x] = generation;
+	if (x < recording->minX)
+		recording->minX = x;
+	if (x > recording->maxX)
+		recording->maxX = x;
+	if (y < recording->minY)
+		recording->minY = y;
+	if (y > recording->maxY)
+		recording->maxY = y;
+}
+
+void INSTNetlist::Drop(std::map<int, Net*>::iterator it)
+{
+	pixelCount -= it->second->pixels.size();
+	delete it->second;
+	nets.erase(it);
+}
+
+bool INSTNetlist::Replay(Simulation *sim, int x, int y, int *result)
+{
+	if (!enabled || recording)
+		return false;
+	std::map<int, Net*>::iterator it = nets.find(x+y*XRES);
+	if (it == nets.end() || !CanReplay(sim))
+		return false;
+
+	Net *net = it->second;
+	for (size_t i = 0; i < net->pixels.size(); i++)
+	{
+		const Pixel &pixel = net->pixels[i];
+		if (PixelKind(sim, pixel.x, pixel.y) != pixel.kind)
+			return false;
+	}
+	for (size_t i = 0; i < net->sparked.size(); i++)
+	{
+		int px = net->sparked[i]%XRES, py = net->sparked[i]/XRES;
+		sim->spark_conductive(sim->pmap[py][px]>>8, px, py);
+	}
+	*result = net->sparked.size() ? 1 : 0;
+	return true;
+}
+
+void INSTNetlist::BeginFlood(Simulation *sim, int x, int y)
+{
+	if (!enabled || recording || !CanReplay(sim))
+		return;
+	if (!recorded)
+	{
+		recorded = (unsigned int (*)[XRES])calloc(XRES*YRES, sizeof(unsigned int));
+		if (!recorded)
+			return;
+	}
+	if (++generation == 0)
+	{
+		memset(recorded, 0, XRES*YRES*sizeof(unsigned int));
+		generation = 1;
+	}
+
+	recording = new Net();
+	recording->minX = recording->maxX = x;
+	recording->minY = recording->maxY = y;
+	recordingStart = x+y*XRES;
+	Record(sim, x, y);
+}
+
+void INSTNetlist::EndFlood(bool finished)
+{
+	if (!recording)
+		return;
+	Net *net = recording;
+	recording = NULL;
+	if (!finished)
+	{
+		delete net;
+		return;
+	}
+
+	std::map<int, Net*>::iterator it = nets.find(recordingStart);
+	if (it != nets.end())
+		Drop(it);
+	if (pixelCount+net->pixels.size() > INSTNETLIST_MAX_PIXELS)
+		Clear();
+	pixelCount += net->pixels.size();
+	nets[recordingStart] = net;
+}
+
+void INSTNetlist::InvalidateNets(int x, int y)
+{
+	std::map<int, Net*>::iterator it = nets.begin();
+	while (it != nets.end())
+	{
+		Net *net = it->second;
+		if (x >= net->minX && x <= net->maxX && y >= net->minY && y <= net->maxY)
+			Drop(it++);
+		else
+			++it;
+	}
+}
+
+void INSTNetlist::Clear()
+{
+	for (std::map<int, Net*>::iterator it = nets.begin(); it != nets.end(); ++it)
+		delete it->second;
+	nets.clear();
+	pixelCount = 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INSTNETLIST_H
+#define INSTNETLIST_H
+
+#include <cstddef>
+#include <map>
+#include <vector>
+#include "defines.h"
+
+class Simulation;
+
+// INST nets found by earlier floods, see INST_flood_spark.
+// A flood from a pixel only depends on the pixels it looks at, and only on whether each of those is sparkable INST,
+// INST that is still cooling down, SPRK(INST) or something else. The first flood from a pixel records those pixels and
+// the order it sparked them in. Later floods from the same pixel check that every recorded pixel is still the same and
+// then just spark the recorded pixels, skipping the span fill and the wire crossing checks.
+// Nets are dropped when INST is created, killed or changed inside them. Anything else that changes a net (moving
+// particles, Lua, loading a save) is caught when the recorded pixels are checked, so a replay is always identical to
+// a flood.
+// Other conductors (SPRK through METL, PSCN, NSCN and so on) aren't covered. Each spark only checks its own
+// neighbours once per frame, so there is no repeated scan to skip.
+class INSTNetlist
+{
+	enum { PIXEL_OTHER, PIXEL_SPARKABLE, PIXEL_COOLING, PIXEL_SPRK };
+
+	struct Pixel
+	{
+		unsigned short x, y;
+		unsigned char kind;
+	};
+	struct Net
+	{
+		std::vector<Pixel> pixels; // every pixel the flood looked at, with what it was before the flood
+		std::vector<int> sparked; // x+y*XRES, in the order the flood sparked them
+		int minX, minY, maxX, maxY;
+	};
+
+	std::map<int, Net*> nets; // by the pixel the flood started from
+	size_t pixelCount; // in all nets, they are all dropped when this gets too large
+
+	Net *recording;
+	int recordingStart;
+	unsigned int (*recorded)[XRES]; // generation each pixel was last recorded in, so pixels are only added once
+	unsigned int generation;
+
+	static int PixelKind(Simulation *sim, int x, int y);
+	static bool CanReplay(Simulation *sim);
+	void Record(Simulation *sim, int x, int y);
+	void Drop(std::map<int, Net*>::iterator it);
+
+public:
+	bool enabled;
+
+	INSTNetlist();
+	~INSTNetlist();
+
+	// sparks the recorded net starting at (x, y) if nothing in it changed. Returns false if there is no net or it has
+	// changed, then the flood has to be done with BeginFlood / EndFlood around it
+	bool Replay(Simulation *sim, int x, int y, int *result);
+	void BeginFlood(Simulation *sim, int x, int y);
+	// keeps the recorded net if the flood finished
+	void EndFlood(bool finished);
+	// called by the flood for every pixel it looks at, before reading it
+	void Read(Simulation *sim, int x, int y)
+	{
+		if (recording && recorded[y][x] != generation)
+			Record(sim, x, y);
+	}
+	// called by the flood after sparking a pixel
+	void Sparked(int x, int y)
+	{
+		if (recording)
+			recording->sparked.push_back(x+y*XRES);
+	}
+
+	// INST was created, killed or changed type at (x, y)
+	void Invalidate(int x, int y)
+	{
+		if (nets.size())
+			InvalidateNets(x, y);
+	}
+	void InvalidateNets(int x, int y);
+	void Clear();
+};
+
+#endif
@@ -14,29 +14,13 @@ bool Simulation::OutOfBounds(int x, int y)
 
 bool Simulation::IsWallBlocking(int x, int y, int type)
 {
-	if (bmap[y/CELL][x/CELL])
-	{
-		int wall = bmap[y/CELL][x/CELL];
-		if (wall == WL_ALLOWGAS && !(elements[type].Properties&TYPE_GAS))
-			return true;
-		else if (wall == WL_ALLOWENERGY && !(elements[type].Properties&TYPE_ENERGY))
-			return true;
-		else if (wall == WL_ALLOWLIQUID && !(elements[type].Properties&TYPE_LIQUID))
-			return true;
-		else if (wall == WL_ALLOWPOWDER && !(elements[type].Properties&TYPE_PART))
-			return true;
-		else if (wall == WL_ALLOWAIR || wall == WL_WALL || wall == WL_WALLELEC)
-			return true;
-		else if (wall == WL_EWALL && !emap[y/CELL][x/CELL])
-			return true;
-	}
-	return false;
+	return GetWallFlags(type, x, y) & WALLFLAG_BLOCK;
 }
 
 // create photons when PHOT moves through GLOW
 void Simulation::CreateGainPhoton(int pp)
 {
-	int lr = rand() % 2;
+	int lr = tpt_rand() % 2;
 
 	float xx, yy;
 	if (lr)
@@ -97,7 +81,7 @@ void Simulation::CreateCherenkovPhoton(int pp)
 	parts[i].temp = parts[pmap[ny][nx] >> 8].temp;
 	parts[i].pavg[0] = parts[i].pavg[1] = 0.0f;
 
-	int lr = rand() % 2;
+	int lr = tpt_rand() % 2;
 	if (lr)
 	{
 		parts[i].vx = parts[pp].vx - 2.5f*parts[pp].vy;
@@ -446,6 +430,66 @@ void Simulation::InitCanMove()
 	can_move[PT_RAZR][PT_GEL] = 1;
 	can_move[PT_MOVS][PT_MOVS] = 2;
 #endif
+
+	InitWallFlags();
+}
+
+// Precalculates wallFlags, which replace checking each wall type against the element properties on every use
+void Simulation::InitWallFlags()
+{
+	for (int t = 0; t < PT_NUM; t++)
+	{
+		int props = elements[t].Properties;
+		int falldown = elements[t].Falldown;
+#ifdef NOMOD
+		bool wallProof = (t == PT_STKM || t == PT_STKM2 || t == PT_FIGH);
+#else
+		bool wallProof = (t == PT_STKM || t == PT_STKM2 || t == PT_FIGH || t == PT_MOVS);
+#endif
+		for (int wall = 0; wall < WALLCOUNT; wall++)
+		{
+			for (int powered = 0; powered <= 1; powered++)
+			{
+				bool block = false, noMove = false, kill = false, ehole = false;
+				switch (wall)
+				{
+				case WL_WALL:
+				case WL_WALLELEC:
+				case WL_ALLOWAIR:
+					block = noMove = kill = true;
+					break;
+				case WL_DESTROYALL:
+					kill = true;
+					break;
+				case WL_ALLOWLIQUID:
+					block = kill = !(props&TYPE_LIQUID);
+					noMove = (falldown != 2);
+					break;
+				case WL_ALLOWPOWDER:
+					block = kill = !(props&TYPE_PART);
+					noMove = (falldown != 1);
+					break;
+				case WL_ALLOWGAS:
+					block = noMove = kill = !(props&TYPE_GAS);
+					break;
+				case WL_ALLOWENERGY:
+					block = noMove = kill = !(props&TYPE_ENERGY);
+					break;
+				case WL_DETECT:
+					kill = (t == PT_METL || t == PT_SPRK);
+					break;
+				case WL_EWALL:
+					block = noMove = kill = !powered;
+					break;
+				case WL_EHOLE:
+					ehole = !powered && !(props&TYPE_SOLID);
+					break;
+				}
+				wallFlags[t][wall][powered] = (kill && !wallProof ? WALLFLAG_KILL : 0) | (block ? WALLFLAG_BLOCK : 0) |
+				        (noMove ? WALLFLAG_NOMOVE : 0) | (ehole ? WALLFLAG_EHOLE : 0);
+			}
+		}
+	}
 }
 
 /*
@@ -553,21 +597,12 @@ unsigned char Simulation::EvalMove(int pt, int nx, int ny, unsigned *rr)
 			break;
 		}
 	}
-	if (bmap[ny/CELL][nx/CELL])
+	unsigned char wall = GetWallFlags(pt, nx, ny);
+	if (wall)
 	{
-		if (bmap[ny/CELL][nx/CELL]==WL_ALLOWGAS && !(elements[pt].Properties&TYPE_GAS))// && elements[pt].Falldown!=0 && pt!=PT_FIRE && pt!=PT_SMKE)
+		if (wall & WALLFLAG_NOMOVE)
 			return 0;
-		if (bmap[ny/CELL][nx/CELL]==WL_ALLOWENERGY && !(elements[pt].Properties&TYPE_ENERGY))// && elements[pt].Falldown!=0 && pt!=PT_FIRE && pt!=PT_SMKE)
-			return 0;
-		if (bmap[ny/CELL][nx/CELL]==WL_ALLOWLIQUID && elements[pt].Falldown!=2)
-			return 0;
-		if (bmap[ny/CELL][nx/CELL]==WL_ALLOWPOWDER && elements[pt].Falldown!=1)
-			return 0;
-		if (bmap[ny/CELL][nx/CELL]==WL_ALLOWAIR || bmap[ny/CELL][nx/CELL]==WL_WALL || bmap[ny/CELL][nx/CELL]==WL_WALLELEC)
-			return 0;
-		if (bmap[ny/CELL][nx/CELL]==WL_EWALL && !emap[ny/CELL][nx/CELL])
-			return 0;
-		if (bmap[ny/CELL][nx/CELL]==WL_EHOLE && !emap[ny/CELL][nx/CELL] && !(elements[pt].Properties&TYPE_SOLID) && !(elements[r&0xFF].Properties&TYPE_SOLID))
+		if ((wall & WALLFLAG_EHOLE) && !(elements[r&0xFF].Properties&TYPE_SOLID))
 			return 2;
 	}
 	return result;
@@ -586,7 +621,7 @@ int Simulation::TryMove(int i, int x, int y, int nx, int ny)
 
 	/* half-silvered mirror */
 	if (!e && parts[i].type==PT_PHOT &&
-			(((r&0xFF)==PT_BMTL && rand()<RAND_MAX/2) ||
+			(((r&0xFF)==PT_BMTL && tpt_rand()<RAND_MAX/2) ||
 			 (pmap[y][x]&0xFF)==PT_BMTL))
 		e = 2;
 
@@ -654,7 +689,7 @@ int Simulation::TryMove(int i, int x, int y, int nx, int ny)
 			switch (r&0xFF)
 			{
 			case PT_GLOW:
-				if (!parts[r>>8].life && rand() < RAND_MAX/30)
+				if (!parts[r>>8].life && tpt_rand() < RAND_MAX/30)
 				{
 					parts[r>>8].life = 120;
 					CreateGainPhoton(i);
@@ -745,7 +780,7 @@ int Simulation::TryMove(int i, int x, int y, int nx, int ny)
 		case PT_NEUT:
 			if ((r&0xFF) == PT_GLAS || (r&0xFF) == PT_BGLA)
 			{
-				if (rand() < RAND_MAX/10)
+				if (tpt_rand() < RAND_MAX/10)
 					CreateCherenkovPhoton(i);
 			}
 			break;
@@ -866,15 +901,23 @@ int Simulation::TryMove(int i, int x, int y, int nx, int ny)
 			parts[e].x = (float)x;
 			parts[e].y = (float)y;
 			pmap[y][x] = (e<<8)|parts[e].type;
+			occupancy_update(nx, ny);
+			occupancy_update(x, y);
 			return 1;
 		}
 
 		if (!OutOfBounds((int)(parts[e].x+0.5f)+x-nx, (int)(parts[e].y+0.5f)+y-ny))
 		{
-			if (!OutOfBounds(nx, ny) && (pmap[ny][nx]>>8)==e) pmap[ny][nx] = 0;
+			if (!OutOfBounds(nx, ny) && (pmap[ny][nx]>>8)==e)
+			{
+				pmap[ny][nx] = 0;
+				occupancy_update(nx, ny);
+			}
 			parts[e].x += x-nx;
 			parts[e].y += y-ny;
-			pmap[(int)(parts[e].y+0.5f)][(int)(parts[e].x+0.5f)] = (e<<8)|parts[e].type;
+			int ex = (int)(parts[e].x+0.5f), ey = (int)(parts[e].y+0.5f);
+			pmap[ey][ex] = (e<<8)|parts[e].type;
+			occupancy_update(ex, ey);
 		}
 	}
 	return 1;
@@ -925,6 +968,7 @@ int Simulation::Move(int i, int x, int y, float nxf, float nyf)
 #endif
 		else if ((int)(photons[y][x]>>8)==i)
 			photons[y][x] = 0;
+		occupancy_update(x, y);
 
 		//kill particle if particle is out of bounds
 		if (OutOfBounds(nx, ny))
@@ -944,6 +988,7 @@ int Simulation::Move(int i, int x, int y, float nxf, float nyf)
 		else
 			pmap[ny][nx] = t|(i<<8);
 #endif
+		occupancy_update(nx, ny);
 	}
 	return 0;
 }
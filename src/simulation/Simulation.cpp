@@ -13,6 +13,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cmath>
 
 //Simulation stuff
@@ -27,6 +28,8 @@
 #include "ElementDataContainer.h"
 #include "Tool.h"
 
+#include "common/Platform.h"
+#include "common/tpt-bitops.h"
 #include "common/tpt-math.h"
 #include "common/tpt-minmax.h"
 #include "game/Brush.h"
@@ -43,27 +46,35 @@
 #include "ToolNumbers.h"
 
 
-Simulation *globalSim = NULL; // TODO: remove this global variable
+TPT_THREAD_LOCAL Simulation *globalSim = NULL; // TODO: remove this global variable
 
 Simulation::Simulation():
 	currentTick(0),
 	pfree(-1),
 	parts_lastActiveIndex(NPART-1),
+	numParts(0),
 	debug_currentParticle(0),
 	forceStackingCheck(false),
+	fullPmapClear(false),
 	edgeMode(0),
 	saveEdgeMode(0),
 	msRotation(true),
 	maxFrames(25),
+	animations(maxFrames),
 #ifdef NOMOD
 	instantActivation(false),
 #else
 	instantActivation(true),
 #endif
-	lightningRecreate(0)
+	updateByType(false),
+	compactInterval(0),
+	lightningRecreate(0),
+	ownRandom(false),
+	randomState(1)
 {
 	std::fill(&elementData[0], &elementData[PT_NUM], static_cast<ElementDataContainer*>(NULL));
-
+	std::fill(&typeUpdateTime[0], &typeUpdateTime[PT_NUM], 0.0);
+	memset(&stats, 0, sizeof(stats));
 	air = new Air();
 
 	Clear();
@@ -84,13 +95,32 @@ Simulation::~Simulation()
 	delete air;
 }
 
+void Simulation::MakeCurrent()
+{
+	globalSim = this;
+	::parts = parts;
+	::pmap = pmap;
+	::pmap_count = pmap_count;
+	::photons = photons;
+	::bmap = bmap;
+	::emap = emap;
+	currentRandState = ownRandom ? &randomState : NULL;
+}
+
+void Simulation::SeedRandom(unsigned int seed)
+{
+	ownRandom = true;
+	// xorshift gets stuck on 0
+	randomState = seed ? seed : 1;
+	if (globalSim == this)
+		currentRandState = &randomState;
+}
+
 void Simulation::InitElements()
 {
 	#define DEFINE_ELEMENT(name, id) if (id>=0 && id<PT_NUM) { name ## _init_element(this, &elements[id], id); };
 	#define ElementNumbers_Include_Call
 	#include "simulation/ElementNumbers.h"
-
-	Simulation_Compat_CopyData(this);
 }
 
 void Simulation::Clear()
@@ -104,8 +134,27 @@ void Simulation::Clear()
 		}
 	}
 	std::fill(&elementCount[0], &elementCount[PT_NUM], 0);
+
+	animations.Reset(maxFrames);
+	instNetlist.Clear();
+	memset(parts, 0, sizeof(parts));
+	for (int i = 0; i < NPART-1; i++)
+		parts[i].life = i+1;
+	parts[NPART-1].life = -1;
 	pfree = 0;
 	parts_lastActiveIndex = NPART-1;
+	numParts = 0;
+
+	std::fill_n(&pmap[0][0], XRES*YRES, 0);
+	std::fill_n(&pmap_count[0][0], XRES*YRES, 0);
+	std::fill_n(&photons[0][0], XRES*YRES, 0);
+	std::fill_n(&occupiedRows[0][0], YRES*OCCUPIED_ROW_WORDS, 0);
+	std::fill_n(&occupiedCols[0][0], XRES*OCCUPIED_COL_WORDS, 0);
+	std::fill_n(&countedRows[0][0], YRES*OCCUPIED_ROW_WORDS, 0);
+	stackedPixels.clear();
+	memset(&stats, 0, sizeof(stats));
+	std::fill_n(&bmap[0][0], (XRES/CELL)*(YRES/CELL), 0);
+	std::fill_n(&emap[0][0], (XRES/CELL)*(YRES/CELL), 0);
 
 #ifdef NOMOD
 	instantActivation = false;
@@ -114,7 +163,18 @@ void Simulation::Clear()
 #endif
 	saveEdgeMode = -1;
 	if (edgeMode == 1)
-		draw_bframe();
+	{
+		for (int i = 0; i < XRES/CELL; i++)
+		{
+			bmap[0][i] = WL_WALL;
+			bmap[YRES/CELL-1][i] = WL_WALL;
+		}
+		for (int i = 1; i < YRES/CELL-1; i++)
+		{
+			bmap[i][0] = WL_WALL;
+			bmap[i][XRES/CELL-1] = WL_WALL;
+		}
+	}
 }
 
 void Simulation::RecountElements()
@@ -289,13 +349,13 @@ int Simulation::part_create(int p, int x, int y, int t, int v)
 	if ((elements[t].Properties & TYPE_PART) && pretty_powder)
 	{
 		int sandcolor = (int)(20.0f*sin((float)(currentTick%360)*(M_PI/180.0f)));
-		int colr = (int)(COLR(elements[t].Colour)+sandcolor*1.3f+(rand()%40)-20+(rand()%30)-15);
-		int colg = (int)(COLG(elements[t].Colour)+sandcolor*1.3f+(rand()%40)-20+(rand()%30)-15);
-		int colb = (int)(COLB(elements[t].Colour)+sandcolor*1.3f+(rand()%40)-20+(rand()%30)-15);
+		int colr = (int)(COLR(elements[t].Colour)+sandcolor*1.3f+(tpt_rand()%40)-20+(tpt_rand()%30)-15);
+		int colg = (int)(COLG(elements[t].Colour)+sandcolor*1.3f+(tpt_rand()%40)-20+(tpt_rand()%30)-15);
+		int colb = (int)(COLB(elements[t].Colour)+sandcolor*1.3f+(tpt_rand()%40)-20+(tpt_rand()%30)-15);
 		colr = std::max(0, std::min(255, colr));
 		colg = std::max(0, std::min(255, colg));
 		colb = std::max(0, std::min(255, colb));
-		parts[i].dcolour = COLARGB(rand()%150, colr, colg, colb);
+		parts[i].dcolour = COLARGB(tpt_rand()%150, colr, colg, colb);
 	}
 
 	// Set non-static properties (such as randomly generated ones)
@@ -305,6 +365,8 @@ int Simulation::part_create(int p, int x, int y, int t, int v)
 	}
 
 	pmap_add(i, x, y, t);
+	if (t == PT_INST || oldType == PT_INST)
+		instNetlist.Invalidate(x, y);
 
 	if (elements[t].Func_ChangeType)
 	{
@@ -340,6 +402,9 @@ bool Simulation::part_change_type(int i, int x, int y, int t)
 	int oldType = parts[i].type;
 	if (oldType)
 		elementCount[oldType]--;
+	// sparking INST and SPRK(INST) turning back into INST are checked when a net is replayed
+	if ((oldType == PT_INST && t != PT_SPRK) || (t == PT_INST && oldType != PT_SPRK) || (oldType == PT_SPRK && parts[i].ctype == PT_INST && t != PT_INST))
+		instNetlist.Invalidate(x, y);
 
 	parts[i].type = t;
 	pmap_remove(i, x, y);
@@ -369,6 +434,8 @@ void Simulation::part_change_type_force(int i, int t)
 	int oldType = parts[i].type;
 	if (oldType)
 		elementCount[oldType]--;
+	if (oldType == PT_INST || t == PT_INST || (oldType == PT_SPRK && parts[i].ctype == PT_INST))
+		instNetlist.Invalidate(x, y);
 	parts[i].type = t;
 	pmap_remove(i, x, y);
 	if (t)
@@ -400,7 +467,11 @@ void Simulation::part_kill(int i)
 	}
 
 	if (x>=0 && y>=0 && x<XRES && y<YRES)
+	{
 		pmap_remove(i, x, y);
+		if (t == PT_INST || (t == PT_SPRK && parts[i].ctype == PT_INST))
+			instNetlist.Invalidate(x, y);
+	}
 	if (t == PT_NONE) // TODO: remove this? (//This shouldn't happen anymore, but it's here just in case)
 		return;
 	elementCount[t]--;
@@ -419,21 +490,120 @@ void Simulation::part_delete(int x, int y)
 		part_kill(pmap[y][x]>>8);
 }
 
+// distance from pos to the next set bit in the direction of dir (1 or -1), or to the first position outside [0, size)
+static int NextSetBit(const uint64_t *bits, int size, int pos, int dir)
+{
+	int next = pos+dir;
+	if (next < 0 || next >= size)
+		return 1;
+	int w = next>>6;
+	if (dir > 0)
+	{
+		uint64_t word = bits[w] & (~(uint64_t)0 << (next&63));
+		while (!word)
+		{
+			if (++w > (size-1)>>6)
+				return size-pos;
+			word = bits[w];
+		}
+		return w*64 + tpt_ctz64(word) - pos;
+	}
+	else
+	{
+		uint64_t word = bits[w] & (~(uint64_t)0 >> (63-(next&63)));
+		while (!word)
+		{
+			if (--w < 0)
+				return pos+1;
+			word = bits[w];
+		}
+		return pos - (w*64 + tpt_msb64(word));
+	}
+}
+
+int Simulation::NextOccupied(int x, int y, int dx, int dy)
+{
+	if (!dy)
+		return NextSetBit(occupiedRows[y], XRES, x, dx);
+	if (!dx)
+		return NextSetBit(occupiedCols[x], YRES, y, dy);
+	int steps = 1;
+	for (x += dx, y += dy; InBounds(x, y) && !IsOccupied(x, y); x += dx, y += dy)
+		steps++;
+	return steps;
+}
+
 /* Recalculates the pfree/parts[].life linked list for particles with ID <= parts_lastActiveIndex.
  * This ensures that future particle allocations are done near the start of the parts array, to keep parts_lastActiveIndex low.
  * parts_lastActiveIndex is also decreased if appropriate.
  * Does not modify or even read any particles beyond parts_lastActiveIndex */
-void Simulation::RecalcFreeParticles()
+// Empties pmap, pmap_count, photons and the occupancy bitmaps. Only the pixels that have their bit set in
+// occupiedRows or countedRows can be non zero, so the rest of the maps are skipped
+void Simulation::ClearPmap()
+{
+	if (fullPmapClear)
+	{
+		std::fill_n(&pmap[0][0], XRES*YRES, 0);
+		std::fill_n(&pmap_count[0][0], XRES*YRES, 0);
+		std::fill_n(&photons[0][0], XRES*YRES, 0);
+		std::fill_n(&occupiedRows[0][0], YRES*OCCUPIED_ROW_WORDS, 0);
+		std::fill_n(&countedRows[0][0], YRES*OCCUPIED_ROW_WORDS, 0);
+	}
+	else
+	{
+		for (int y = 0; y < YRES; y++)
+		{
+			for (int w = 0; w < OCCUPIED_ROW_WORDS; w++)
+			{
+				uint64_t bits = occupiedRows[y][w];
+				if (!bits)
+					continue;
+				occupiedRows[y][w] = 0;
+				if (bits == ~(uint64_t)0)
+				{
+					std::fill_n(&pmap[y][w*64], 64, 0);
+					std::fill_n(&photons[y][w*64], 64, 0);
+					continue;
+				}
+				while (bits)
+				{
+					int x = w*64 + tpt_ctz64(bits);
+					bits &= bits-1;
+					pmap[y][x] = 0;
+					photons[y][x] = 0;
+				}
+			}
+			for (int w = 0; w < OCCUPIED_ROW_WORDS; w++)
+			{
+				uint64_t bits = countedRows[y][w];
+				if (!bits)
+					continue;
+				countedRows[y][w] = 0;
+				while (bits)
+				{
+					pmap_count[y][w*64 + tpt_ctz64(bits)] = 0;
+					bits &= bits-1;
+				}
+			}
+		}
+	}
+	std::fill_n(&occupiedCols[0][0], XRES*OCCUPIED_COL_WORDS, 0);
+	stackedPixels.clear();
+}
+
+void Simulation::RecalcFreeParticles(bool decreaseLife)
 {
 	int x, y, t;
 	int lastPartUsed = 0;
 	int lastPartUnused = -1;
 
-	std::fill_n(&pmap[0][0], XRES*YRES, 0);
-	std::fill_n(&pmap_count[0][0], XRES*YRES, 0);
-	std::fill_n(&photons[0][0], XRES*YRES, 0);
+	ClearPmap();
 
-	NUM_PARTS = 0;
+	numParts = 0;
+	SimulationStats newStats;
+	memset(&newStats, 0, sizeof(newStats));
+	newStats.minTemperature = MAX_TEMP;
+	newStats.maxTemperature = MIN_TEMP;
 	//the particle loop that resets the pmap/photon maps every frame, to update them.
 	for (int i = 0; i <= parts_lastActiveIndex; i++)
 	{
@@ -459,7 +629,11 @@ void Simulation::RecalcFreeParticles()
 						pmap[y][x] = t|(i<<8);
 
 					if (t!=PT_THDR && t!=PT_EMBR && t!=PT_FIGH && t!=PT_PLSM)
-						pmap_count[y][x]++;
+					{
+						if (++pmap_count[y][x] == STACKING_THRESHOLD+1)
+							stackedPixels.push_back(x+y*XRES);
+						countedRows[y][x>>6] |= (uint64_t)1 << (x&63);
+					}
 #else
 					// Particles are sometimes allowed to go inside INVS and FILT
 					// To make particles collide correctly when inside these elements, these elements must not overwrite an existing pmap entry from particles inside them
@@ -471,15 +645,36 @@ void Simulation::RecalcFreeParticles()
 					// Count number of particles at each location, for excess stacking check
 					// (does not include energy particles or THDR - currently no limit on stacking those)
 					if (t!=PT_THDR && t!=PT_EMBR && t!=PT_FIGH && t!=PT_PLSM && t!=PT_MOVS)
-						pmap_count[y][x]++;
+					{
+						if (++pmap_count[y][x] == STACKING_THRESHOLD+1)
+							stackedPixels.push_back(x+y*XRES);
+						countedRows[y][x>>6] |= (uint64_t)1 << (x&63);
+					}
 #endif
 				}
+				// something was always written to pmap or photons here
+				occupiedRows[y][x>>6] |= (uint64_t)1 << (x&63);
+				occupiedCols[x][y>>6] |= (uint64_t)1 << (y&63);
 			}
 			lastPartUsed = i;
-			NUM_PARTS++;
+			numParts++;
 			//decrease the life of certain elements by 1 every frame
-			if (!sys_pause || framerender)
+			if (decreaseLife && (!sys_pause || framerender))
 				decrease_life(i);
+
+			// decrease_life may have killed it
+			if (parts[i].type)
+			{
+				float temp = parts[i].temp;
+				newStats.particleCount++;
+				newStats.temperatureSum += temp;
+				if (temp < newStats.minTemperature)
+					newStats.minTemperature = temp;
+				if (temp > newStats.maxTemperature)
+					newStats.maxTemperature = temp;
+				if (parts[i].type == PT_LIFE && parts[i].ctype >= 0 && parts[i].ctype < NGOL)
+					newStats.lifeCount[parts[i].ctype]++;
+			}
 		}
 		else
 		{
@@ -506,6 +701,126 @@ void Simulation::RecalcFreeParticles()
 			parts[lastPartUnused].life = parts_lastActiveIndex+1;
 	}
 	parts_lastActiveIndex = lastPartUsed;
+	stats = newStats;
+}
+
+float Simulation::PressureSum()
+{
+	float pressureSum = 0.0f;
+	for (int y = 0; y < YRES/CELL; y++)
+		for (int x = 0; x < XRES/CELL; x++)
+			pressureSum += air->pv[y][x];
+	return pressureSum;
+}
+
+// Interleaves the bits of x and y, sorting by the result keeps particles that are close together on screen close
+// together in parts
+static unsigned int MortonCode(unsigned int x, unsigned int y)
+{
+	x &= 0xFFFF;
+	x = (x | (x << 8)) & 0x00FF00FF;
+	x = (x | (x << 4)) & 0x0F0F0F0F;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+	y &= 0xFFFF;
+	y = (y | (y << 8)) & 0x00FF00FF;
+	y = (y | (y << 4)) & 0x0F0F0F0F;
+	y = (y | (y << 2)) & 0x33333333;
+	y = (y | (y << 1)) & 0x55555555;
+	return x | (y << 1);
+}
+
+void Simulation::CompactParticles()
+{
+	// in the middle of stepping through a frame one particle at a time
+	if (debug_currentParticle)
+		return;
+
+	// sort by position, then by the old index so the order is the same every time
+	std::vector<uint64_t> order;
+	order.reserve(numParts);
+	for (int i = 0; i <= parts_lastActiveIndex; i++)
+	{
+		if (!parts[i].type)
+			continue;
+		int x = std::max(0, std::min(XRES-1, (int)(parts[i].x+0.5f)));
+		int y = std::max(0, std::min(YRES-1, (int)(parts[i].y+0.5f)));
+		order.push_back(((uint64_t)MortonCode(x, y) << 32) | i);
+	}
+	std::sort(order.begin(), order.end());
+
+	int count = order.size();
+	std::vector<int> newIndex(NPART, -1);
+	std::vector<particle> sorted(count);
+	for (int n = 0; n < count; n++)
+	{
+		int i = (int)(order[n] & 0xFFFFFFFF);
+		newIndex[i] = n;
+		sorted[n] = parts[i];
+	}
+	if (count)
+		std::copy(sorted.begin(), sorted.end(), parts);
+	// RecalcFreeParticles puts these back in the free list
+	if (parts_lastActiveIndex >= count)
+		memset(parts+count, 0, sizeof(particle)*(parts_lastActiveIndex+1-count));
+
+	for (int n = 0; n < count; n++)
+	{
+		particle &part = parts[n];
+		if (part.type == PT_SOAP)
+		{
+			// links to particles that are gone are dropped
+			if (part.ctype&2)
+			{
+				int linked = part.tmp >= 0 && part.tmp < NPART ? newIndex[part.tmp] : -1;
+				if (linked < 0)
+					part.ctype &= ~2;
+				part.tmp = std::max(linked, 0);
+			}
+			if (part.ctype&4)
+			{
+				int linked = part.tmp2 >= 0 && part.tmp2 < NPART ? newIndex[part.tmp2] : -1;
+				if (linked < 0)
+					part.ctype &= ~4;
+				part.tmp2 = std::max(linked, 0);
+			}
+		}
+#ifndef NOMOD
+		// pmap value of the particle inside it
+		else if (part.type == PT_PINV && part.tmp2)
+		{
+			int inside = (part.tmp2>>8) < NPART ? newIndex[part.tmp2>>8] : -1;
+			part.tmp2 = inside < 0 ? 0 : (part.tmp2&0xFF)|(inside<<8);
+		}
+#endif
+	}
+	for (int t = 0; t < PT_NUM; t++)
+		if (elementData[t])
+			elementData[t]->Simulation_ParticlesMoved(this, &newIndex[0]);
+	animations.Remap(&newIndex[0]);
+
+	// rebuild pmap, photons and the free list, which also lowers parts_lastActiveIndex
+	RecalcFreeParticles(false);
+}
+
+void Simulation::TemperatureHistogram(std::vector<int> &histogram, int bins, float min, float max)
+{
+	histogram.assign(bins, 0);
+	if (bins <= 0)
+		return;
+	float scale = max > min ? bins/(max-min) : 0.0f;
+	for (int i = 0; i <= parts_lastActiveIndex; i++)
+	{
+		if (!parts[i].type)
+			continue;
+		float bin = (parts[i].temp-min)*scale;
+		if (bin < 0)
+			histogram[0]++;
+		else if (bin >= bins)
+			histogram[bins-1]++;
+		else
+			histogram[(int)bin]++;
+	}
 }
 
 void Simulation::UpdateBefore()
@@ -523,35 +838,30 @@ void Simulation::UpdateBefore()
 	}
 
 	//check for excessive stacked particles, create BHOL if found
-	if (forceStackingCheck || !(rand()%10))
+	if (forceStackingCheck || !(tpt_rand()%10))
 	{
 		bool excessiveStackingFound = false;
 		forceStackingCheck = 0;
-		for (int y = 0; y < YRES; y++)
+		// only pixels that went over the threshold when pmap_count was rebuilt need to be checked
+		for (size_t p = 0; p < stackedPixels.size(); p++)
 		{
-			for (int x = 0; x < XRES; x++)
+			int x = stackedPixels[p]%XRES, y = stackedPixels[p]/XRES;
+			//Setting pmap_count[y][x] > NPART means BHOL will form in that spot
+			if (bmap[y/CELL][x/CELL] == WL_EHOLE)
 			{
-				//Use a threshold, since some particle stacking can be normal (e.g. BIZR + FILT)
-				//Setting pmap_count[y][x] > NPART means BHOL will form in that spot
-				if (pmap_count[y][x] > 5)
+				//Allow more stacking in E-hole
+				if (pmap_count[y][x] > 1500)
 				{
-					if (bmap[y/CELL][x/CELL] == WL_EHOLE)
-					{
-						//Allow more stacking in E-hole
-						if (pmap_count[y][x] > 1500)
-						{
-							pmap_count[y][x] = pmap_count[y][x] + NPART;
-							excessiveStackingFound = true;
-						}
-					}
-					//Random chance to turn into BHOL that increases with the amount of stacking, up to a threshold where it is certain to turn into BHOL
-					else if (pmap_count[y][x] > 1500 || (rand()%1600) <= pmap_count[y][x]+100)
-					{
-						pmap_count[y][x] = pmap_count[y][x] + NPART;
-						excessiveStackingFound = true;
-					}
+					pmap_count[y][x] = pmap_count[y][x] + NPART;
+					excessiveStackingFound = true;
 				}
 			}
+			//Random chance to turn into BHOL that increases with the amount of stacking, up to a threshold where it is certain to turn into BHOL
+			else if (pmap_count[y][x] > 1500 || (tpt_rand()%1600) <= pmap_count[y][x]+100)
+			{
+				pmap_count[y][x] = pmap_count[y][x] + NPART;
+				excessiveStackingFound = true;
+			}
 		}
 		if (excessiveStackingFound)
 		{
@@ -611,6 +921,47 @@ void Simulation::UpdateParticles(int start, int end)
 		}
 }
 
+/* Updates every particle, grouped by type so that each element's update code runs many times in a row.
+ * Types are updated in ascending order of their id, and particles of the same type in ascending index order.
+ * Particles are grouped by their type when this starts: a particle that changes type is still updated with its old group,
+ * and particles created while this runs aren't updated until the next frame.
+ * Subframe debugging (UpdateParticles with a range) always goes in index order. */
+void Simulation::UpdateParticlesByType()
+{
+	// counting sort of all particle ids by type
+	std::fill(&typeStart[0], &typeStart[PT_NUM+1], 0);
+	for (int i = 0; i <= parts_lastActiveIndex; i++)
+		if (parts[i].type > 0 && parts[i].type < PT_NUM)
+			typeStart[parts[i].type+1]++;
+	for (int t = 1; t <= PT_NUM; t++)
+		typeStart[t] += typeStart[t-1];
+	int typeEnd[PT_NUM];
+	std::copy(&typeStart[0], &typeStart[PT_NUM], typeEnd);
+	for (int i = 0; i <= parts_lastActiveIndex; i++)
+		if (parts[i].type > 0 && parts[i].type < PT_NUM)
+			typeOrder[typeEnd[parts[i].type]++] = i;
+	std::fill_n(allocatedInPass, NPART, 0);
+
+	for (int t = 1; t < PT_NUM; t++)
+	{
+		if (typeStart[t] == typeStart[t+1])
+		{
+			typeUpdateTime[t] = 0.0;
+			continue;
+		}
+		double start = Platform::GetTime();
+		for (int j = typeStart[t]; j < typeStart[t+1]; j++)
+		{
+			int i = typeOrder[j];
+			// particles that changed type earlier in the frame are still updated here, once. Skip the ones that died,
+			// and new particles that took over a dead one's slot
+			if (parts[i].type && !allocatedInPass[i])
+				UpdateParticle(i);
+		}
+		typeUpdateTime[t] = Platform::GetTime()-start;
+	}
+}
+
 void Simulation::UpdateAfter()
 {
 	// For elements with extra data, run special update functions
@@ -629,25 +980,33 @@ void Simulation::Tick()
 	RecalcFreeParticles();
 	if (!sys_pause || framerender)
 	{
+		if (compactInterval > 0 && !(currentTick % compactInterval))
+			CompactParticles();
 		UpdateBefore();
-		UpdateParticles(0, NPART);
+#ifdef LUACONSOLE
+		luacon_batch_update(this, true);
+#endif
+		if (updateByType)
+			UpdateParticlesByType();
+		else
+			UpdateParticles(0, NPART);
 		UpdateAfter();
+#ifdef LUACONSOLE
+		luacon_batch_update(this, false);
+#endif
 		currentTick++;
 	}
-	// In automatic heat mode, calculate highest and lowest temperature points (maybe could be moved)
+	// In automatic heat mode, use the highest and lowest temperatures from RecalcFreeParticles
 	if (heatmode == 1)
 	{
 		highesttemp = MIN_TEMP;
 		lowesttemp = MAX_TEMP;
-		for (int i = 0; i <= parts_lastActiveIndex; i++)
+		if (stats.particleCount)
 		{
-			if (parts[i].type)
-			{
-				if (parts[i].temp > highesttemp)
-					highesttemp = (int)parts[i].temp;
-				if (parts[i].temp < lowesttemp)
-					lowesttemp = (int)parts[i].temp;
-			}
+			if (stats.maxTemperature > highesttemp)
+				highesttemp = (int)stats.maxTemperature;
+			if (stats.minTemperature < lowesttemp)
+				lowesttemp = (int)stats.minTemperature;
 		}
 	}
 }
@@ -667,23 +1026,7 @@ bool Simulation::UpdateParticle(int i)
 	bool transitionOccurred = false;
 
 	//this kills any particle out of the screen, or in a wall where it isn't supposed to go
-	if (OutOfBounds(x, y) ||
-		( bmap[y/CELL][x/CELL] &&
-		  ( bmap[y/CELL][x/CELL] == WL_WALL ||
-		   (bmap[y/CELL][x/CELL] == WL_WALLELEC) ||
-		   (bmap[y/CELL][x/CELL] == WL_ALLOWAIR) ||
-		   (bmap[y/CELL][x/CELL] == WL_DESTROYALL) ||
-		   (bmap[y/CELL][x/CELL] == WL_ALLOWLIQUID && !(elements[t].Properties&TYPE_LIQUID)) ||
-		   (bmap[y/CELL][x/CELL] == WL_ALLOWPOWDER && !(elements[t].Properties&TYPE_PART)) ||
-		   (bmap[y/CELL][x/CELL] == WL_ALLOWGAS && !(elements[t].Properties&TYPE_GAS)) || //&&  elements[t].Falldown!=0 && t!=PT_FIRE && t!=PT_SMKE && t!=PT_HFLM) ||
-		   (bmap[y/CELL][x/CELL] == WL_ALLOWENERGY && !(elements[t].Properties&TYPE_ENERGY)) ||
-		   (bmap[y/CELL][x/CELL] == WL_DETECT && (t==PT_METL || t==PT_SPRK)) ||
-		   (bmap[y/CELL][x/CELL] == WL_EWALL && !emap[y/CELL][x/CELL])
-#ifdef NOMOD
-		  ) && t!=PT_STKM && t!=PT_STKM2 && t!=PT_FIGH))
-#else
-		  ) && t!=PT_STKM && t!=PT_STKM2 && t!=PT_FIGH && t != PT_MOVS))
-#endif
+	if (OutOfBounds(x, y) || (GetWallFlags(t, x, y) & WALLFLAG_KILL))
 	{
 		part_kill(i);
 		return true;
@@ -777,13 +1120,13 @@ bool Simulation::UpdateParticle(int i)
 		if (realistic)
 		{
 			//The magic number controls diffusion speed
-			parts[i].vx += 0.05f*sqrtf(parts[i].temp)*elements[t].Diffusion*(rand()/(0.5f*RAND_MAX)-1.0f);
-			parts[i].vy += 0.05f*sqrtf(parts[i].temp)*elements[t].Diffusion*(rand()/(0.5f*RAND_MAX)-1.0f);
+			parts[i].vx += 0.05f*sqrtf(parts[i].temp)*elements[t].Diffusion*(tpt_rand()/(0.5f*RAND_MAX)-1.0f);
+			parts[i].vy += 0.05f*sqrtf(parts[i].temp)*elements[t].Diffusion*(tpt_rand()/(0.5f*RAND_MAX)-1.0f);
 		}
 		else
 		{
-			parts[i].vx += elements[t].Diffusion*(rand()/(0.5f*RAND_MAX)-1.0f);
-			parts[i].vy += elements[t].Diffusion*(rand()/(0.5f*RAND_MAX)-1.0f);
+			parts[i].vx += elements[t].Diffusion*(tpt_rand()/(0.5f*RAND_MAX)-1.0f);
+			parts[i].vy += elements[t].Diffusion*(tpt_rand()/(0.5f*RAND_MAX)-1.0f);
 		}
 	}
 
@@ -869,7 +1212,7 @@ bool Simulation::UpdateParticle(int i)
 	//the basic explosion, from the .explosive variable
 	if (!(elements[t].Properties&PROP_INDESTRUCTIBLE) && (elements[t].Explosive&2) && air->pv[y/CELL][x/CELL] > 2.5f)
 	{
-		parts[i].life = rand()%80 + 180;
+		parts[i].life = tpt_rand()%80 + 180;
 		parts[i].temp = restrict_flt(elements[PT_FIRE].DefaultProperties.temp + (elements[t].Flammable/2), MIN_TEMP, MAX_TEMP);
 		t = PT_FIRE;
 		part_change_type(i, x, y, t);
@@ -898,7 +1241,7 @@ bool Simulation::UpdateParticle(int i)
 		y = (int)(parts[i].y+0.5f);
 	}
 
-	if (lua_el_mode[t] != 2)
+	if (lua_el_mode[t] != 2 && lua_el_batch_mode[t] != 2)
 	{
 #endif
 		if (elements[t].Properties&PROP_POWERED)
@@ -958,13 +1301,13 @@ bool Simulation::UpdateParticle(int i)
 
 	if (parts[i].flags&FLAG_EXPLODE)
 	{
-		if (!(rand()%10))
+		if (!(tpt_rand()%10))
 		{
 			parts[i].flags &= ~FLAG_EXPLODE;
 			air->pv[y/CELL][x/CELL] += 5.0f;
-			if(!(rand()%3))
+			if(!(tpt_rand()%3))
 			{
-				if(!(rand()%2))
+				if(!(tpt_rand()%2))
 				{
 					part_create(i, x, y, PT_BOMB);
 					parts[i].temp = MAX_TEMP;
@@ -979,8 +1322,8 @@ bool Simulation::UpdateParticle(int i)
 			{
 				part_create(i, x, y, PT_EMBR);
 				parts[i].temp = MAX_TEMP;
-				parts[i].vx = rand()%20-10.0f;
-				parts[i].vy = rand()%20-10.0f;
+				parts[i].vx = tpt_rand()%20-10.0f;
+				parts[i].vy = tpt_rand()%20-10.0f;
 			}
 			return true;
 		}
@@ -1022,6 +1365,10 @@ bool Simulation::UpdateParticle(int i)
 		fin_x = (int)(fin_xf+0.5f);
 		fin_y = (int)(fin_yf+0.5f);
 		bool closedEholeStart = this->InBounds(fin_x, fin_y) && (bmap[fin_y/CELL][fin_x/CELL] == WL_EHOLE && !emap[fin_y/CELL][fin_x/CELL]);
+		// When moving along a row or column, find how far the path is empty, those steps only need a wall check
+		int startX = fin_x, startY = fin_y, clearRun = 0;
+		if ((dx == 0 || dy == 0) && GetEdgeMode() != 2 && !closedEholeStart && this->InBounds(fin_x, fin_y) && can_move[t][0] && can_move[t][0] != 3)
+			clearRun = NextOccupied(fin_x, fin_y, (dx > 0) - (dx < 0), (dy > 0) - (dy < 0)) - 1;
 		while (1)
 		{
 			mv -= ISTP;
@@ -1062,6 +1409,8 @@ bool Simulation::UpdateParticle(int i)
 				clear_y = (int)(clear_yf+0.5f);
 				break;
 			}
+			if (abs(fin_x-startX)+abs(fin_y-startY) <= clearRun && !bmap[fin_y/CELL][fin_x/CELL])
+				continue;
 			//block if particle can't move (0), or some special cases where it returns 1 (can_move = 3 but returns 1 meaning particle will be eaten)
 			//also photons are still blocked (slowed down) by any particle (even ones it can move through), and absorb wall also blocks particles
 			int eval = EvalMove(t, fin_x, fin_y);
@@ -1208,7 +1557,7 @@ bool Simulation::UpdateParticle(int i)
 				return true;
 			//reflection
 			parts[i].flags |= FLAG_STAGNANT;
-			if (t == PT_NEUT && !(rand()%10))
+			if (t == PT_NEUT && !(tpt_rand()%10))
 			{
 				part_kill(i);
 				return true;
@@ -1233,7 +1582,7 @@ bool Simulation::UpdateParticle(int i)
 			{
 				if ((r & 0xFF) == PT_CRMC)
 				{
-					float r = (rand() % 101 - 50) * 0.01f, rx, ry, anrx, anry;
+					float r = (tpt_rand() % 101 - 50) * 0.01f, rx, ry, anrx, anry;
 					r = r * r * r;
 					rx = cosf(r); ry = sinf(r);
 					anrx = rx * nrx + ry * nry;
@@ -1298,7 +1647,7 @@ bool Simulation::UpdateParticle(int i)
 	else
 	{
 		//checking stagnant is cool, but then it doesn't update when you change it later.
-		if (water_equal_test && elements[t].Falldown == 2 && !(rand()%400))
+		if (water_equal_test && elements[t].Falldown == 2 && !(tpt_rand()%400))
 		{
 			if (!flood_water(x, y, i, y, parts[i].flags&FLAG_WATEREQUAL))
 				return false;
@@ -1320,7 +1669,7 @@ bool Simulation::UpdateParticle(int i)
 			else
 			{
 				int nx, ny, s = 1;
-				int r = (rand()%2)*2-1; // position search direction (left/right first)
+				int r = (tpt_rand()%2)*2-1; // position search direction (left/right first)
 				if ((clear_x!=x || clear_y!=y || nt || surround_space) &&
 					(fabsf(parts[i].vx)>0.01f || fabsf(parts[i].vy)>0.01f))
 				{
@@ -2165,7 +2514,7 @@ int Simulation::CreateTool(int x, int y, int tool, float strength)
 		if (!thisPart)
 			return 0;
 
-		if (rand() % 100 != 0)
+		if (tpt_rand() % 100 != 0)
 			return 0;
 
 		int distance = (int)(std::pow(strength, .5f) * 10);
@@ -2173,8 +2522,8 @@ int Simulation::CreateTool(int x, int y, int tool, float strength)
 		if (!(elements[thisPart&0xFF].Properties & (TYPE_PART | TYPE_LIQUID | TYPE_GAS)))
 			return 0;
 
-		int newX = x + (rand() % distance) - (distance/2);
-		int newY = y + (rand() % distance) - (distance/2);
+		int newX = x + (tpt_rand() % distance) - (distance/2);
+		int newY = y + (tpt_rand() % distance) - (distance/2);
 
 		if(newX < 0 || newY < 0 || newX >= XRES || newY >= YRES)
 			return 0;
@@ -2193,6 +2542,8 @@ int Simulation::CreateTool(int x, int y, int tool, float strength)
 		pmap[newY][newX] = thisPart;
 		parts[thisPart>>8].x = newX;
 		parts[thisPart>>8].y = newY;
+		occupancy_update(x, y);
+		occupancy_update(newX, newY);
 		return -1;
 	}
 	return -1;
@@ -2655,8 +3006,9 @@ void Simulation::CreateDeco(int x, int y, int tool, ARGBColour color)
 #ifndef NOMOD
 	if (parts[rp>>8].type == PT_ANIM)
 	{
-		if (parts[rp>>8].tmp2 >= 0 && parts[rp>>8].tmp2 < maxFrames)
-			parts[rp>>8].animations[parts[rp>>8].tmp2] = parts[rp>>8].dcolour;
+		ARGBColour *frames = animations.Get(rp>>8);
+		if (frames && parts[rp>>8].tmp2 >= 0 && parts[rp>>8].tmp2 < maxFrames)
+			frames[parts[rp>>8].tmp2] = parts[rp>>8].dcolour;
 	}
 #endif
 }
@@ -2851,9 +3203,6 @@ void Simulation::FloodDeco(pixel *vid, int x, int y, ARGBColour color, ARGBColou
 void Simulation_Compat_CopyData(Simulation* sim)
 {
 	// TODO: this can be removed once all the code uses Simulation instead of global variables
-	parts = sim->parts;
-
-
 	for (int t=0; t<PT_NUM; t++)
 	{
 		ptypes[t].name = mystrdup(sim->elements[t].Name.c_str());
@@ -17,11 +17,18 @@
 #define Simulation_h
 
 #include <cstddef> // offsetof, for FloodProp
+#include <vector>
 #include "graphics/ARGBColour.h"
 #include "graphics/Pixel.h"
 #include "simulation/Air.h"
+#include "simulation/AnimationArena.h"
 #include "simulation/Element.h"
+#include "simulation/INSTNetlist.h"
+#include "simulation/WallNumbers.h"
 #include "powder.h"
+#include "common/Probability.h"
+#include "common/tpt-rand.h"
+#include "common/tpt-stdint.h"
 
 // Defines for element transitions
 #define IPL -257.0f
@@ -33,22 +40,64 @@
 // special transition - lava ctypes etc need extra code, which is only found and run if ST is given
 #define ST PT_NUM
 
+// flags in Simulation::wallFlags
+#define WALLFLAG_KILL 0x1 // UpdateParticle kills particles of this type inside the wall
+#define WALLFLAG_BLOCK 0x2 // IsWallBlocking
+#define WALLFLAG_NOMOVE 0x4 // EvalMove never lets this type move into the wall
+#define WALLFLAG_EHOLE 0x8 // closed E-hole: EvalMove lets this type overlap anything that isn't a solid
+
+#define OCCUPIED_ROW_WORDS ((XRES+63)/64)
+#define OCCUPIED_COL_WORDS ((YRES+63)/64)
+
+// some particle stacking can be normal (e.g. BIZR + FILT), more than this many particles in one pixel may turn into BHOL
+#define STACKING_THRESHOLD 5
+
 class ElementDataContainer;
 class Brush;
 
+// Totals collected while RecalcFreeParticles walks the particles at the start of each frame, so the HUD
+// and Lua can read them without scanning parts. Per type counts are in Simulation::elementCount
+struct SimulationStats
+{
+	int particleCount;
+	double temperatureSum;
+	float minTemperature, maxTemperature; // only valid when particleCount isn't 0
+	int lifeCount[NGOL]; // LIFE particles of each rule (by ctype)
+};
+
 class Simulation
 {
 public:
 	unsigned int currentTick;
 
 	particle parts[NPART];
+	unsigned pmap[YRES][XRES];
+	int pmap_count[YRES][XRES];
+	unsigned photons[YRES][XRES];
+	// One bit per pixel, set where pmap or photons isn't empty, by row and by column. Must be updated
+	// (occupancy_update) whenever pmap or photons are written, so rays can skip over empty space
+	uint64_t occupiedRows[YRES][OCCUPIED_ROW_WORDS];
+	uint64_t occupiedCols[XRES][OCCUPIED_COL_WORDS];
+	// set where pmap_count may be non zero, so RecalcFreeParticles only has to clear those pixels
+	uint64_t countedRows[YRES][OCCUPIED_ROW_WORDS];
+	// pixels (x+y*XRES) where pmap_count went over STACKING_THRESHOLD in the last RecalcFreeParticles, each listed once.
+	// The excess stacking check in UpdateBefore only looks at these
+	std::vector<int> stackedPixels;
+	unsigned char bmap[YRES/CELL][XRES/CELL];
+	unsigned char emap[YRES/CELL][XRES/CELL];
 	int elementCount[PT_NUM];
+	SimulationStats stats;
 	Element elements[PT_NUM];
 	ElementDataContainer *elementData[PT_NUM];
 	int pfree;
 	int parts_lastActiveIndex;
+	// number of particles, counted in RecalcFreeParticles
+	int numParts;
 	int debug_currentParticle;
 	bool forceStackingCheck;
+	// clear all of pmap, pmap_count and photons in RecalcFreeParticles instead of only the pixels marked in the
+	// occupancy bitmaps. For debugging, if something writes to pmap without calling occupancy_update it will show up
+	bool fullPmapClear;
 	
 	Air * air;
 
@@ -57,13 +106,29 @@ public:
 	signed char saveEdgeMode;
 	bool msRotation; //for moving solids
 	int maxFrames;   //for animated LCRY
+	AnimationArena animations; // ANIM frames, always reset when maxFrames changes
+	INSTNetlist instNetlist; // INST floods done before, so they can be repeated without searching the wire again
 	bool instantActivation; //electronics are instantly activated
+	// Update particles grouped by type instead of in index order, see UpdateParticlesByType.
+	// Off by default, since the different order changes how some builds behave
+	bool updateByType;
+	// seconds spent updating each type in the last frame, only measured when updateByType is on
+	double typeUpdateTime[PT_NUM];
+	// run CompactParticles every this many frames, 0 to never do it automatically
+	int compactInterval;
 
 	// misc Simulation variables
 	unsigned int lightningRecreate; //timer for when LIGH can be created again
 	
 	Simulation();
 	~Simulation();
+	// Points globalSim and the parts/pmap/photons/bmap/emap globals at this simulation, for the calling thread only.
+	// Must be called on a thread before it ticks or edits this simulation.
+	// Each thread may have a different current simulation, so separate simulations can run on separate threads
+	void MakeCurrent();
+	// gives this simulation its own random number generator, starting from seed, instead of sharing rand() with the
+	// rest of the process. Its ticks can then be repeated exactly, whichever thread runs them
+	void SeedRandom(unsigned int seed);
 	void InitElements();
 	void InitElement(char* name, int id);
 	void Clear();
@@ -74,9 +139,22 @@ public:
 	bool part_change_type(int i, int x, int y, int t);
 	void part_change_type_force(int i, int t);
 
-	void RecalcFreeParticles();
+	// rebuilds pmap, photons, pmap_count and the free particle list from parts. Also decreases life
+	// (decrease_life) as part of the frame when decreaseLife is set and the simulation isn't paused
+	void RecalcFreeParticles(bool decreaseLife = true);
+	// sum of air->pv over all cells. Not part of stats, because it doesn't come from the particles and is rarely needed
+	float PressureSum();
+	// Renumbers the particles in Z-order of their positions, so particles that are near each other on screen are
+	// near each other in parts, and lowers parts_lastActiveIndex to the particle count. Fixes every stored particle
+	// index in parts, pmap, photons and the element data. Particle ids held by Lua scripts are not updated
+	void CompactParticles();
+	void ClearPmap();
+	// fills histogram with the number of particles in each of bins equal temperature ranges between min and max,
+	// particles outside the range are counted in the first or last bin. Walks all particles, only use it on demand
+	void TemperatureHistogram(std::vector<int> &histogram, int bins, float min, float max);
 	void UpdateBefore();
 	void UpdateParticles(int start, int end);
+	void UpdateParticlesByType();
 	void UpdateAfter();
 	bool UpdateParticle(int i); // called by UpdateParticles
 	void Tick();
@@ -119,10 +197,19 @@ public:
 
 	// movement, functions implemented in Movement.cpp
 	unsigned char can_move[PT_NUM][PT_NUM];
+	// How each type interacts with each wall, built by InitCanMove from the element properties.
+	// The last index is 1 if the wall's cell is powered (emap not 0)
+	unsigned char wallFlags[PT_NUM][WALLCOUNT][2];
+	unsigned char GetWallFlags(int t, int x, int y)
+	{
+		unsigned char wall = bmap[y/CELL][x/CELL];
+		return wall ? wallFlags[t][wall][emap[y/CELL][x/CELL] != 0] : 0;
+	}
 	bool OutOfBounds(int x, int y);
 	bool IsWallBlocking(int x, int y, int type);
 	bool GetNormalInterp(int pt, float x0, float y0, float dx, float dy, float *nx, float *ny);
 	void InitCanMove();
+	void InitWallFlags();
 	unsigned char EvalMove(int pt, int nx, int ny, unsigned *rr = NULL);
 	int DoMove(int i, int x, int y, float nxf, float nyf);
 	int Move(int i, int x, int y, float nxf, float nyf);
@@ -152,6 +239,7 @@ public:
 		pfree = parts[i].life;
 		if (i>parts_lastActiveIndex)
 			parts_lastActiveIndex = i;
+		allocatedInPass[i] = 1;
 		return i;
 	}
 	void part_free(int i)
@@ -167,6 +255,7 @@ public:
 			photons[y][x] = t|(i<<8);
 		else if ((!pmap[y][x] || (t!=PT_INVIS && t!= PT_FILT)))// && (pmap[y][x]&0xFF) != PT_PINV)
 			pmap[y][x] = t|(i<<8);
+		occupancy_update(x, y);
 	}
 	void pmap_remove(unsigned int i, int x, int y)
 	{
@@ -179,7 +268,30 @@ public:
 #endif
 		else if ((photons[y][x]>>8)==i)
 			photons[y][x] = 0;
+		occupancy_update(x, y);
+	}
+	// recalculate the occupied bits for a pixel after pmap or photons was changed there
+	void occupancy_update(int x, int y)
+	{
+		uint64_t rowBit = (uint64_t)1 << (x&63), colBit = (uint64_t)1 << (y&63);
+		if (pmap[y][x] || photons[y][x])
+		{
+			occupiedRows[y][x>>6] |= rowBit;
+			occupiedCols[x][y>>6] |= colBit;
+		}
+		else
+		{
+			occupiedRows[y][x>>6] &= ~rowBit;
+			occupiedCols[x][y>>6] &= ~colBit;
+		}
 	}
+	bool IsOccupied(int x, int y)
+	{
+		return (occupiedRows[y][x>>6] >> (x&63)) & 1;
+	}
+	// Number of steps of (dx, dy) from (x, y) until the next pixel with anything in pmap or photons,
+	// or until the first pixel outside the simulation. dx and dy must be -1, 0 or 1, and not both 0
+	int NextOccupied(int x, int y, int dx, int dy);
 
 	char GetEdgeMode()
 	{
@@ -199,6 +311,17 @@ private:
 
 	int TryMove(int i, int x, int y, int nx, int ny);
 	
+	// particle ids grouped by type for UpdateParticlesByType, type t is typeOrder[typeStart[t]] to typeOrder[typeStart[t+1]-1]
+	int typeOrder[NPART];
+	int typeStart[PT_NUM+1];
+	// set by part_alloc, cleared when UpdateParticlesByType starts. A slot in typeOrder whose particle died and was
+	// replaced by a new one mustn't be updated as the old particle
+	unsigned char allocatedInPass[NPART];
+
+	// state for tpt_rand, only used once SeedRandom is called
+	bool ownRandom;
+	unsigned int randomState;
+
 	// Functions in Transitions.cpp
 	bool TransferHeat(int i, int t, int surround[8]);
 	bool CheckPressureTransitions(int i, int t);
@@ -206,6 +329,6 @@ private:
 
 void Simulation_Compat_CopyData(Simulation *sim);
 
-extern Simulation *globalSim; // TODO: remove this
+extern TPT_THREAD_LOCAL Simulation *globalSim; // TODO: remove this
 
 #endif
@@ -91,13 +91,14 @@ Snapshot * Snapshot::CreateSnapshot(Simulation * sim)
 	snap->AirVelocityX.insert(snap->AirVelocityX.begin(), &sim->air->vx[0][0], &sim->air->vx[0][0]+((XRES/CELL)*(YRES/CELL)));
 	snap->AirVelocityY.insert(snap->AirVelocityY.begin(), &sim->air->vy[0][0], &sim->air->vy[0][0]+((XRES/CELL)*(YRES/CELL)));
 	snap->AmbientHeat.insert(snap->AmbientHeat.begin(), &sim->air->hv[0][0], &sim->air->hv[0][0]+((XRES/CELL)*(YRES/CELL)));
-	snap->Particles.insert(snap->Particles.begin(), parts, parts+sim->parts_lastActiveIndex+1);
+	snap->Particles.insert(snap->Particles.begin(), sim->parts, sim->parts+sim->parts_lastActiveIndex+1);
+	snap->Animations = sim->animations.Copy(sim->parts_lastActiveIndex+1);
 	snap->GravVelocityX.insert(snap->GravVelocityX.begin(), gravx, gravx+((XRES/CELL)*(YRES/CELL)));
 	snap->GravVelocityY.insert(snap->GravVelocityY.begin(), gravy, gravy+((XRES/CELL)*(YRES/CELL)));
 	snap->GravValue.insert(snap->GravValue.begin(), gravp, gravp+((XRES/CELL)*(YRES/CELL)));
 	snap->GravMap.insert(snap->GravMap.begin(), gravmap, gravmap+((XRES/CELL)*(YRES/CELL)));
-	snap->BlockMap.insert(snap->BlockMap.begin(), &bmap[0][0], &bmap[0][0]+((XRES/CELL)*(YRES/CELL)));
-	snap->ElecMap.insert(snap->ElecMap.begin(), &emap[0][0], &emap[0][0]+((XRES/CELL)*(YRES/CELL)));
+	snap->BlockMap.insert(snap->BlockMap.begin(), &sim->bmap[0][0], &sim->bmap[0][0]+((XRES/CELL)*(YRES/CELL)));
+	snap->ElecMap.insert(snap->ElecMap.begin(), &sim->emap[0][0], &sim->emap[0][0]+((XRES/CELL)*(YRES/CELL)));
 	snap->FanVelocityX.insert(snap->FanVelocityX.begin(), &sim->air->fvx[0][0], &sim->air->fvx[0][0]+((XRES/CELL)*(YRES/CELL)));
 	snap->FanVelocityY.insert(snap->FanVelocityY.begin(), &sim->air->fvy[0][0], &sim->air->fvy[0][0]+((XRES/CELL)*(YRES/CELL)));
 	for (std::vector<Sign*>::iterator iter = signs.begin(), end = signs.end(); iter != end; ++iter)
@@ -122,8 +123,9 @@ void Snapshot::Restore(Simulation * sim, const Snapshot &snap)
 	std::copy(snap.AirVelocityY.begin(), snap.AirVelocityY.end(), &sim->air->vy[0][0]);
 	std::copy(snap.AmbientHeat.begin(), snap.AmbientHeat.end(), &sim->air->hv[0][0]);
 	for (int i = 0; i < NPART; i++)
-		parts[i].type = 0;
-	std::copy(snap.Particles.begin(), snap.Particles.end(), parts);
+		sim->parts[i].type = 0;
+	std::copy(snap.Particles.begin(), snap.Particles.end(), sim->parts);
+	sim->animations.Restore(snap.Animations);
 	sim->parts_lastActiveIndex = NPART-1;
 	sim->RecalcFreeParticles();
 	if (ngrav_enable)
@@ -133,8 +135,8 @@ void Snapshot::Restore(Simulation * sim, const Snapshot &snap)
 		std::copy(snap.GravValue.begin(), snap.GravValue.end(), gravp);
 		std::copy(snap.GravMap.begin(), snap.GravMap.end(), gravmap);
 	}
-	std::copy(snap.BlockMap.begin(), snap.BlockMap.end(), &bmap[0][0]);
-	std::copy(snap.ElecMap.begin(), snap.ElecMap.end(), &emap[0][0]);
+	std::copy(snap.BlockMap.begin(), snap.BlockMap.end(), &sim->bmap[0][0]);
+	std::copy(snap.ElecMap.begin(), snap.ElecMap.end(), &sim->emap[0][0]);
 	std::copy(snap.FanVelocityX.begin(), snap.FanVelocityX.end(), &sim->air->fvx[0][0]);
 	std::copy(snap.FanVelocityY.begin(), snap.FanVelocityY.end(), &sim->air->fvy[0][0]);
 	ClearSigns();
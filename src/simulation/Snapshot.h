@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "ElementNumbers.h"
+#include "AnimationArena.h"
 #include "Particle.h"
 #include "common/tpt-minmax.h"
 #include "game/Sign.h"
@@ -21,6 +22,7 @@ public:
 	std::vector<float> AmbientHeat;
 
 	std::vector<particle> Particles;
+	AnimationArena Animations;
 
 	ElementDataContainer *elementData[PT_NUM];
 
@@ -45,6 +47,7 @@ public:
 		AirVelocityY(),
 		AmbientHeat(),
 		Particles(),
+		Animations(),
 		GravVelocityX(),
 		GravVelocityY(),
 		GravValue(),
@@ -69,15 +72,15 @@ public:
 	static void SetUndoHistoryLimit(unsigned int newLimit) { undoHistoryLimit = std::min(newLimit, (unsigned int)200); }
 	static unsigned int GetUndoHistoryLimit() { return undoHistoryLimit; }
 
+	// actual creation / restoration of snapshots, also used to keep tabs in memory
+	static Snapshot * CreateSnapshot(Simulation * sim);
+	static void Restore(Simulation * sim, const Snapshot &snap);
+
 private:
 	static unsigned int undoHistoryLimit;
 	static unsigned int historyPosition;
 	static std::deque<Snapshot*> snapshots;
 	static Snapshot* redoHistory;
-
-	// actual creation / restoration of snapshots
-	static Snapshot * CreateSnapshot(Simulation * sim);
-	static void Restore(Simulation * sim, const Snapshot &snap);
 };
 
 #endif // SNAPSHOT
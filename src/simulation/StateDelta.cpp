@@ -0,0 +1,348 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include "StateDelta.h"
+#include "Simulation.h"
+#include "common/tpt-stdint.h"
+
+// Format, all numbers little endian:
+// "TPTD", version byte
+// particle count (u32), then for each: index (u32), changed fields (u16 bitmask of particleFields), the changed fields (4 bytes each).
+//   A particle that was removed only has the type field, set to 0
+// wall count (u32), then for each: cell index (u32), wall type (u8)
+// air count (u32), then for each: cell index (u32), changed values (u8 bitmask of pv, vx, vy, hv), the changed values (4 bytes each)
+
+static const int deltaVersion = 1;
+static const int cellCount = (XRES/CELL)*(YRES/CELL);
+
+// every particle field is 4 bytes, and they are compared and copied as raw bytes
+static const size_t particleFields[] = {
+	offsetof(particle, type), offsetof(particle, life), offsetof(particle, ctype),
+	offsetof(particle, x), offsetof(particle, y), offsetof(particle, vx), offsetof(particle, vy),
+	offsetof(particle, temp), offsetof(particle, pavg[0]), offsetof(particle, pavg[1]),
+	offsetof(particle, flags), offsetof(particle, tmp), offsetof(particle, tmp2), offsetof(particle, dcolour)
+};
+static const int particleFieldCount = sizeof(particleFields)/sizeof(particleFields[0]);
+static const int airFieldCount = 4;
+
+// Particles of these types keep data outside of parts (player and fighter slots, spawn points, moving solids,
+// animation frames), which a delta doesn't carry. They are left out of deltas, and deltas that have them are invalid
+static bool HasOutsideData(int type)
+{
+	switch (type)
+	{
+	case PT_STKM:
+	case PT_STKM2:
+	case PT_FIGH:
+	case PT_SPAWN:
+	case PT_SPAWN2:
+#ifndef NOMOD
+	case PT_MOVS:
+	case PT_ANIM:
+#endif
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void WriteU32(std::string &out, uint32_t value)
+{
+	out += (char)(value&0xFF);
+	out += (char)((value>>8)&0xFF);
+	out += (char)((value>>16)&0xFF);
+	out += (char)((value>>24)&0xFF);
+}
+
+static void WriteU16(std::string &out, uint16_t value)
+{
+	out += (char)(value&0xFF);
+	out += (char)((value>>8)&0xFF);
+}
+
+static void WriteField(std::string &out, const void *field)
+{
+	uint32_t value;
+	memcpy(&value, field, 4);
+	WriteU32(out, value);
+}
+
+static void SetU32(std::string &out, size_t pos, uint32_t value)
+{
+	out[pos] = (char)(value&0xFF);
+	out[pos+1] = (char)((value>>8)&0xFF);
+	out[pos+2] = (char)((value>>16)&0xFF);
+	out[pos+3] = (char)((value>>24)&0xFF);
+}
+
+class DeltaReader
+{
+	const unsigned char *data;
+	size_t size, pos;
+public:
+	bool error;
+
+	DeltaReader(const char *data_, size_t size_):
+		data((const unsigned char*)data_),
+		size(size_),
+		pos(0),
+		error(false)
+	{
+	}
+
+	uint32_t ReadU32()
+	{
+		if (pos+4 > size)
+		{
+			error = true;
+			return 0;
+		}
+		uint32_t value = data[pos] | (data[pos+1]<<8) | (data[pos+2]<<16) | ((uint32_t)data[pos+3]<<24);
+		pos += 4;
+		return value;
+	}
+
+	unsigned int ReadU16()
+	{
+		if (pos+2 > size)
+		{
+			error = true;
+			return 0;
+		}
+		unsigned int value = data[pos] | (data[pos+1]<<8);
+		pos += 2;
+		return value;
+	}
+
+	unsigned int ReadU8()
+	{
+		if (pos+1 > size)
+		{
+			error = true;
+			return 0;
+		}
+		return data[pos++];
+	}
+
+	void ReadField(void *field)
+	{
+		uint32_t value = ReadU32();
+		if (!error)
+			memcpy(field, &value, 4);
+	}
+
+	bool AtEnd()
+	{
+		return pos == size;
+	}
+};
+
+StateDelta::SimulationState::SimulationState():
+	parts(NPART),
+	bmap(cellCount, 0),
+	pv(cellCount, 0.0f),
+	vx(cellCount, 0.0f),
+	vy(cellCount, 0.0f),
+	hv(cellCount, 0.0f)
+{
+	memset(&parts[0], 0, sizeof(particle)*NPART);
+}
+
+void StateDelta::SimulationState::Clear()
+{
+	memset(&parts[0], 0, sizeof(particle)*NPART);
+	std::fill(bmap.begin(), bmap.end(), 0);
+	std::fill(pv.begin(), pv.end(), 0.0f);
+	std::fill(vx.begin(), vx.end(), 0.0f);
+	std::fill(vy.begin(), vy.end(), 0.0f);
+	std::fill(hv.begin(), hv.end(), 0.0f);
+}
+
+StateDelta::View StateDelta::SimulationState::GetView()
+{
+	View view;
+	view.parts = &parts[0];
+	view.bmap = &bmap[0];
+	view.pv = &pv[0];
+	view.vx = &vx[0];
+	view.vy = &vy[0];
+	view.hv = &hv[0];
+	return view;
+}
+
+StateDelta::View StateDelta::GetView(Simulation *sim)
+{
+	View view;
+	view.parts = sim->parts;
+	view.bmap = &sim->bmap[0][0];
+	view.pv = &sim->air->pv[0][0];
+	view.vx = &sim->air->vx[0][0];
+	view.vy = &sim->air->vy[0][0];
+	view.hv = &sim->air->hv[0][0];
+	return view;
+}
+
+std::string StateDelta::Create(const View &base, const View &current)
+{
+	std::string out("TPTD");
+	out += (char)deltaVersion;
+
+	size_t countPos = out.size();
+	uint32_t count = 0;
+	WriteU32(out, 0);
+	for (int i = 0; i < NPART; i++)
+	{
+		const particle &from = base.parts[i], &to = current.parts[i];
+		bool hasFrom = from.type && !HasOutsideData(from.type), hasTo = to.type && !HasOutsideData(to.type);
+		if (!hasFrom && !hasTo)
+			continue;
+		unsigned int mask = 0;
+		if (!hasTo)
+			mask = 1; // removed, only the type is sent
+		else
+		{
+			for (int f = 0; f < particleFieldCount; f++)
+				if (!hasFrom || memcmp((const char*)&from+particleFields[f], (const char*)&to+particleFields[f], 4))
+					mask |= 1<<f;
+		}
+		if (!mask)
+			continue;
+		WriteU32(out, i);
+		WriteU16(out, mask);
+		if (!hasTo)
+			WriteU32(out, 0);
+		else
+		{
+			for (int f = 0; f < particleFieldCount; f++)
+				if (mask & (1<<f))
+					WriteField(out, (const char*)&to+particleFields[f]);
+		}
+		count++;
+	}
+	SetU32(out, countPos, count);
+
+	countPos = out.size();
+	count = 0;
+	WriteU32(out, 0);
+	for (int c = 0; c < cellCount; c++)
+		if (base.bmap[c] != current.bmap[c])
+		{
+			WriteU32(out, c);
+			out += (char)current.bmap[c];
+			count++;
+		}
+	SetU32(out, countPos, count);
+
+	countPos = out.size();
+	count = 0;
+	WriteU32(out, 0);
+	const float *baseAir[airFieldCount] = { base.pv, base.vx, base.vy, base.hv };
+	const float *currentAir[airFieldCount] = { current.pv, current.vx, current.vy, current.hv };
+	for (int c = 0; c < cellCount; c++)
+	{
+		unsigned int mask = 0;
+		for (int f = 0; f < airFieldCount; f++)
+			if (memcmp(&baseAir[f][c], &currentAir[f][c], 4))
+				mask |= 1<<f;
+		if (!mask)
+			continue;
+		WriteU32(out, c);
+		out += (char)mask;
+		for (int f = 0; f < airFieldCount; f++)
+			if (mask & (1<<f))
+				WriteField(out, &currentAir[f][c]);
+		count++;
+	}
+	SetU32(out, countPos, count);
+	return out;
+}
+
+bool StateDelta::Apply(const char *data, size_t size, View &state, Simulation *sim)
+{
+	if (size < 5 || memcmp(data, "TPTD", 4) || data[4] != deltaVersion)
+		return false;
+	DeltaReader reader(data+5, size-5);
+
+	uint32_t count = reader.ReadU32();
+	for (uint32_t n = 0; n < count && !reader.error; n++)
+	{
+		uint32_t i = reader.ReadU32();
+		unsigned int mask = reader.ReadU16();
+		if (i >= NPART || mask >= (1u<<particleFieldCount))
+			return false;
+		particle &part = state.parts[i];
+		particle updated = part;
+		for (int f = 0; f < particleFieldCount; f++)
+			if (mask & (1<<f))
+				reader.ReadField((char*)&updated+particleFields[f]);
+		if (reader.error)
+			break;
+		if (!updated.type)
+			memset(&updated, 0, sizeof(particle));
+		else if (updated.type < 0 || updated.type >= PT_NUM || HasOutsideData(updated.type) || (sim && !sim->elements[updated.type].Enabled))
+			return false;
+
+		int oldType = part.type;
+		if (!sim || oldType == updated.type)
+		{
+			part = updated;
+			continue;
+		}
+		// let the elements update their own data, like part_change_type does
+		if (oldType && sim->elements[oldType].Func_ChangeType)
+			(*(sim->elements[oldType].Func_ChangeType))(sim, i, (int)(part.x+0.5f), (int)(part.y+0.5f), oldType, updated.type);
+		part = updated;
+		if (part.type && sim->elements[part.type].Func_ChangeType)
+			(*(sim->elements[part.type].Func_ChangeType))(sim, i, (int)(part.x+0.5f), (int)(part.y+0.5f), oldType, part.type);
+	}
+
+	count = reader.ReadU32();
+	for (uint32_t n = 0; n < count && !reader.error; n++)
+	{
+		uint32_t c = reader.ReadU32();
+		unsigned int wall = reader.ReadU8();
+		if (c >= (uint32_t)cellCount || wall >= WALLCOUNT)
+			return false;
+		state.bmap[c] = wall;
+	}
+
+	count = reader.ReadU32();
+	float *air[airFieldCount] = { state.pv, state.vx, state.vy, state.hv };
+	for (uint32_t n = 0; n < count && !reader.error; n++)
+	{
+		uint32_t c = reader.ReadU32();
+		unsigned int mask = reader.ReadU8();
+		if (c >= (uint32_t)cellCount)
+			return false;
+		for (int f = 0; f < airFieldCount; f++)
+			if (mask & (1<<f))
+				reader.ReadField(&air[f][c]);
+	}
+	return !reader.error && reader.AtEnd();
+}
+
+bool StateDelta::Apply(const char *data, size_t size, Simulation *sim)
+{
+	View view = GetView(sim);
+	bool ok = Apply(data, size, view, sim);
+	// rebuild everything that depends on the particles, without decreasing life like a normal frame does
+	sim->parts_lastActiveIndex = NPART-1;
+	sim->RecalcFreeParticles(false);
+	sim->RecountElements();
+	return ok;
+}
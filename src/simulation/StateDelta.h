@@ -0,0 +1,66 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATEDELTA_H
+#define STATEDELTA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Particle.h"
+
+class Simulation;
+
+// Compact binary deltas between two simulation states, for keeping simulations in sync over a network
+// (sim.diff / sim.applyDiff in Lua). Covers particles (by index, only the fields that changed), walls
+// and air (pressure, velocity and ambient heat). A delta against an empty simulation is a full copy
+// of the state, and is also used as the baseline for the next delta.
+// Element specific data (portals, etc.) and gravity are not included, and neither are particles of elements that
+// keep data outside of parts (stickmen, fighters, spawn points, moving solids and ANIM)
+class StateDelta
+{
+public:
+	// Pointers to the arrays a delta covers, either in a Simulation or in a SimulationState
+	struct View
+	{
+		particle *parts;
+		unsigned char *bmap;
+		float *pv, *vx, *vy, *hv;
+	};
+
+	// Owned copy of the state, empty to start with
+	class SimulationState
+	{
+		std::vector<particle> parts;
+		std::vector<unsigned char> bmap;
+		std::vector<float> pv, vx, vy, hv;
+	public:
+		SimulationState();
+		void Clear();
+		View GetView();
+	};
+
+	static View GetView(Simulation *sim);
+
+	// Delta that turns base into current
+	static std::string Create(const View &base, const View &current);
+	// Returns false if the data isn't a valid delta, in which case state may have been partially changed.
+	// If sim is given, particle types must be enabled in it, and elements are told about particles that change type
+	static bool Apply(const char *data, size_t size, View &state, Simulation *sim = NULL);
+	// Applies a delta to a simulation, then rebuilds pmap, the free particle list and element counts
+	static bool Apply(const char *data, size_t size, Simulation *sim);
+};
+
+#endif
@@ -15,7 +15,7 @@ bool Simulation::TransferHeat(int i, int t, int surround[8])
 		gel_scale = parts[i].tmp*2.55f;
 
 	//some heat convection for liquids
-	if ((elements[t].Properties&TYPE_LIQUID) && (t!=PT_GEL || gel_scale > (1+rand()%255)) && y-2 >= 0 && y-2 < YRES)
+	if ((elements[t].Properties&TYPE_LIQUID) && (t!=PT_GEL || gel_scale > (1+tpt_rand()%255)) && y-2 >= 0 && y-2 < YRES)
 	{
 		r = pmap[y-2][x];
 		if (!(!r || parts[i].type != (r&0xFF)))
@@ -30,7 +30,7 @@ bool Simulation::TransferHeat(int i, int t, int surround[8])
 	}
 
 	//heat transfer code
-	if ((t!=PT_HSWC || parts[i].life==10) && (elements[t].HeatConduct*gel_scale) && (realistic || (elements[t].HeatConduct*gel_scale) > (rand()%250)))
+	if ((t!=PT_HSWC || parts[i].life==10) && (elements[t].HeatConduct*gel_scale) && (realistic || (elements[t].HeatConduct*gel_scale) > (tpt_rand()%250)))
 	{
 		float c_Cm = 0.0f;
 		if (aheat_enable && !(elements[t].Properties&PROP_NOAMBHEAT))
@@ -217,7 +217,7 @@ bool Simulation::TransferHeat(int i, int t, int surround[8])
 						{
 							pt = (c_heat - elements[t].Latent)/c_Cm;
 
-							if (1>rand()%6)
+							if (1>tpt_rand()%6)
 								t = PT_SALT;
 							else
 								t = PT_WTRV;
@@ -230,7 +230,7 @@ bool Simulation::TransferHeat(int i, int t, int surround[8])
 					}
 					else
 					{
-						if (1>rand()%6)
+						if (1>tpt_rand()%6)
 							t = PT_SALT;
 						else
 							t = PT_WTRV;
@@ -383,14 +383,14 @@ bool Simulation::TransferHeat(int i, int t, int surround[8])
 				else
 					part_change_type(i,x,y,t);
 				if (t==PT_FIRE || t==PT_PLSM || t==PT_HFLM)
-					parts[i].life = rand()%50+120;
+					parts[i].life = tpt_rand()%50+120;
 				if (t==PT_LAVA)
 				{
 					if (parts[i].ctype==PT_BRMT)		parts[i].ctype = PT_BMTL;
 					else if (parts[i].ctype==PT_SAND)	parts[i].ctype = PT_GLAS;
 					else if (parts[i].ctype==PT_BGLA)	parts[i].ctype = PT_GLAS;
 					else if (parts[i].ctype==PT_PQRT)	parts[i].ctype = PT_QRTZ;
-					parts[i].life = rand()%120+240;
+					parts[i].life = tpt_rand()%120+240;
 				}
 			}
 		}
@@ -480,6 +480,6 @@ bool Simulation::CheckPressureTransitions(int i, int t)
 		part_change_type(i,x,y,t);
 
 	if (t == PT_FIRE)
-		parts[i].life = rand()%50 + 120;
+		parts[i].life = tpt_rand()%50 + 120;
 	return true;
 }
@@ -36,14 +36,14 @@ int ACID_update(UPDATE_FUNC_ARGS)
 					}
 					else if ((r&0xFF)==PT_WTRV)
 					{
-						if(!(rand()%250))
+						if(!(tpt_rand()%250))
 						{
 							part_change_type(i, x, y, PT_CAUS);
-							parts[i].life = (rand()%50)+25;
+							parts[i].life = (tpt_rand()%50)+25;
 							kill_part(r>>8);
 						}
 					}
-					else if ((!(sim->elements[r&0xFF].Properties&PROP_CLONE) && !(sim->elements[r&0xFF].Properties&PROP_INDESTRUCTIBLE) && sim->elements[r&0xFF].Hardness>(rand()%1000))&&parts[i].life>=50)
+					else if ((!(sim->elements[r&0xFF].Properties&PROP_CLONE) && !(sim->elements[r&0xFF].Properties&PROP_INDESTRUCTIBLE) && sim->elements[r&0xFF].Hardness>(tpt_rand()%1000))&&parts[i].life>=50)
 					{
 						if (parts_avg(i, r>>8,PT_GLAS)!= PT_GLAS)//GLAS protects stuff from acid
 						{
@@ -65,8 +65,8 @@ int ACID_update(UPDATE_FUNC_ARGS)
 			}
 	for (trade = 0; trade < 2; trade++)
 	{
-		rx = rand()%5-2;
-		ry = rand()%5-2;
+		rx = tpt_rand()%5-2;
+		ry = tpt_rand()%5-2;
 		if (BOUNDS_CHECK && (rx || ry))
 		{
 			r = pmap[y+ry][x+rx];
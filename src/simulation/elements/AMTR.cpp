@@ -41,7 +41,7 @@ int AMTR_update(UPDATE_FUNC_ARGS)
 							kill_part(i);
 							return 1;
 						}
-						if (!(rand()%10))
+						if (!(tpt_rand()%10))
 							sim->part_create(r>>8, x+rx, y+ry, PT_PHOT);
 						else
 							kill_part(r>>8);
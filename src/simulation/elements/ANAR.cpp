@@ -25,10 +25,10 @@ int ANAR_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 					continue;
-				if ((r&0xFF) == PT_HFLM && !(rand()%4))
+				if ((r&0xFF) == PT_HFLM && !(tpt_rand()%4))
 				{
 					part_change_type(i, x, y, PT_HFLM);
-					parts[i].life = rand()%150+50;
+					parts[i].life = tpt_rand()%150+50;
 					parts[r>>8].temp = parts[i].temp = 0;
 					sim->air->pv[y/CELL][x/CELL] -= 0.5;
 				}
@@ -15,12 +15,14 @@
 
 #ifndef NOMOD
 #include <cstring>
+#include <functional>
 #include "simulation/ElementsCommon.h"
 #include "interface.h"
 
 int ANIM_update(UPDATE_FUNC_ARGS)
 {
-	if (!parts[i].animations)
+	ARGBColour *frames = sim->animations.Get(i);
+	if (!frames)
 	{
 		kill_part(i);
 		return 1;
@@ -38,23 +40,28 @@ int ANIM_update(UPDATE_FUNC_ARGS)
 	{
 		parts[i].tmp2 = 0;
 	}
-	parts[i].dcolour = parts[i].animations[parts[i].tmp2];
+	parts[i].dcolour = frames[parts[i].tmp2];
 	return 0;
 }
 
 int ANIM_graphics(GRAPHICS_FUNC_ARGS)
 {
+	//cpart can be a copy that isn't in parts, PIPE draws the particle it holds that way. Copies have no frames
+	std::less<const particle*> before;
+	if (before(cpart, sim->parts) || !before(cpart, sim->parts+NPART))
+		return 0;
 	//invalid ANIM
-	if (!cpart->animations || cpart->tmp2 < 0 || cpart->tmp2 >= sim->maxFrames)
+	ARGBColour *frames = sim->animations.Get(cpart-sim->parts);
+	if (!frames || cpart->tmp2 < 0 || cpart->tmp2 >= sim->maxFrames)
 		return 0;
 
 	//if decorations are even set (black deco has alpha set)
-	if (cpart->animations[cpart->tmp2])
+	if (frames[cpart->tmp2])
 	{
-		*cola = COLA(cpart->animations[cpart->tmp2]);
-		*colr = COLR(cpart->animations[cpart->tmp2]);
-		*colg = COLG(cpart->animations[cpart->tmp2]);
-		*colb = COLB(cpart->animations[cpart->tmp2]);
+		*cola = COLA(frames[cpart->tmp2]);
+		*colr = COLR(frames[cpart->tmp2]);
+		*colg = COLG(frames[cpart->tmp2]);
+		*colb = COLB(frames[cpart->tmp2]);
 	}
 
 	if (cpart->life < 10)
@@ -70,19 +77,13 @@ int ANIM_graphics(GRAPHICS_FUNC_ARGS)
 
 void ANIM_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	sim->parts[i].animations = (ARGBColour*)calloc(sim->maxFrames, sizeof(ARGBColour));
-	if (!sim->parts[i].animations)
-		return;
-	memset(sim->parts[i].animations, 0, sizeof(*sim->parts[i].animations));
+	sim->animations.Alloc(i);
 }
 
 void ANIM_ChangeType(ELEMENT_CHANGETYPE_FUNC_ARGS)
 {
-	if (to != PT_ANIM && parts[i].animations)
-    {
-            free(parts[i].animations);
-            parts[i].animations = NULL;
-    }
+	if (to != PT_ANIM)
+		sim->animations.Free(i);
 }
 
 void ANIM_init_element(ELEMENT_INIT_FUNC_ARGS)
@@ -57,27 +57,27 @@ int BANG_update(UPDATE_FUNC_ARGS)
 		//Explode!!
 		sim->air->pv[y/CELL][x/CELL] += 0.5f;
 		parts[i].tmp = 0;
-		if(!(rand()%3))
+		if(!(tpt_rand()%3))
 		{
-			if(!(rand()%2))
+			if(!(tpt_rand()%2))
 			{
 				sim->part_create(i, x, y, PT_FIRE);
 			}
 			else
 			{
 				sim->part_create(i, x, y, PT_SMKE);
-				parts[i].life = rand()%50+500;
+				parts[i].life = tpt_rand()%50+500;
 			}
 			parts[i].temp = restrict_flt((MAX_TEMP/4)+otemp, MIN_TEMP, MAX_TEMP);
 		}
 		else
 		{
-			if(!(rand()%15))
+			if(!(tpt_rand()%15))
 			{
 				sim->part_create(i, x, y, PT_EMBR);
 				parts[i].temp = restrict_flt((MAX_TEMP/3)+otemp, MIN_TEMP, MAX_TEMP);
-				parts[i].vx = rand()%20-10.0f;
-				parts[i].vy = rand()%20-10.0f;
+				parts[i].vx = tpt_rand()%20-10.0f;
+				parts[i].vy = tpt_rand()%20-10.0f;
 			}
 			else
 			{
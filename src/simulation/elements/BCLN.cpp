@@ -20,7 +20,7 @@
 int BCLN_update(UPDATE_FUNC_ARGS)
 {
 	if (!parts[i].life && sim->air->pv[y/CELL][x/CELL]>4.0f)
-		parts[i].life = rand()%40+80;
+		parts[i].life = tpt_rand()%40+80;
 	if (parts[i].life)
 	{
 		parts[i].vx += ADVECTION * sim->air->vx[y/CELL][x/CELL];
@@ -51,10 +51,10 @@ int BCLN_update(UPDATE_FUNC_ARGS)
 	else
 	{
 		if (parts[i].ctype == PT_LIFE)
-			sim->part_create(-1, x+rand()%3-1, y+rand()%3-1, PT_LIFE, parts[i].tmp);
-		else if (parts[i].ctype != PT_LIGH || (rand()%30) == 0)
+			sim->part_create(-1, x+tpt_rand()%3-1, y+tpt_rand()%3-1, PT_LIFE, parts[i].tmp);
+		else if (parts[i].ctype != PT_LIGH || (tpt_rand()%30) == 0)
 		{
-			int np = sim->part_create(-1, x+rand()%3-1, y+rand()%3-1, parts[i].ctype&0xFF);
+			int np = sim->part_create(-1, x+tpt_rand()%3-1, y+tpt_rand()%3-1, parts[i].ctype&0xFF);
 			if (np >= 0)
 			{
 				if (parts[i].ctype == PT_LAVA && parts[i].tmp > 0 && parts[i].tmp < PT_NUM && sim->elements[parts[i].tmp].HighTemperatureTransitionElement == PT_LAVA)
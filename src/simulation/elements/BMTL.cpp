@@ -28,14 +28,14 @@ int BMTL_update(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r)
 						continue;
-					if (((r&0xFF)==PT_METL || (r&0xFF)==PT_IRON) && !(rand()%100))
+					if (((r&0xFF)==PT_METL || (r&0xFF)==PT_IRON) && !(tpt_rand()%100))
 					{
 						part_change_type(r>>8,x+rx,y+ry,PT_BMTL);
-						parts[r>>8].tmp=(parts[i].tmp<=7)?parts[i].tmp=1:parts[i].tmp-(rand()%5);//rand()/(RAND_MAX/300)+100;
+						parts[r>>8].tmp=(parts[i].tmp<=7)?parts[i].tmp=1:parts[i].tmp-(tpt_rand()%5);//tpt_rand()/(RAND_MAX/300)+100;
 					}
 				}
 	}
-	else if (parts[i].tmp==1 && !(rand()%1000))
+	else if (parts[i].tmp==1 && !(tpt_rand()%1000))
 	{
 		parts[i].tmp = 0;
 		part_change_type(i,x,y,PT_BRMT);
@@ -32,6 +32,7 @@ int BOMB_update(UPDATE_FUNC_ARGS)
 					int nxi, nxj;
 					//TODO: this looks like a bad idea
 					pmap[y][x] = 0;
+					sim->occupancy_update(x, y);
 					for (nxj=-rad; nxj<=rad; nxj++)
 						for (nxi=-rad; nxi<=rad; nxi++)
 							if ((std::pow((float)nxi,2.0f))/(std::pow((float)rad,2.0f))+(std::pow((float)nxj,2.0f))/(std::pow((float)rad,2.0f))<=1)
@@ -66,8 +67,8 @@ int BOMB_update(UPDATE_FUNC_ARGS)
 									parts[nb].tmp = 0;
 									parts[nb].life = 50;
 									parts[nb].temp = MAX_TEMP;
-									parts[nb].vx = rand()%40-20.0f;
-									parts[nb].vy = rand()%40-20.0f;
+									parts[nb].vx = tpt_rand()%40-20.0f;
+									parts[nb].vy = tpt_rand()%40-20.0f;
 								}
 							}
 					sim->part_kill(i);
@@ -40,12 +40,12 @@ int BOYL_update(UPDATE_FUNC_ARGS)
 					continue;
 				if ((r&0xFF)==PT_WATR)
 				{
-					if (!(rand()%30))
+					if (!(tpt_rand()%30))
 						part_change_type(r>>8,x+rx,y+ry,PT_FOG);
 				}
 				else if ((r&0xFF)==PT_O2)
 				{
-					if (!(rand()%9))
+					if (!(tpt_rand()%9))
 					{
 						kill_part(r>>8);
 						part_change_type(i, x, y, PT_WATR);
@@ -30,16 +30,16 @@ int BRMT_update(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r)
 						continue;
-					if ((r&0xFF) == PT_BREL && !(rand()%tempFactor))
+					if ((r&0xFF) == PT_BREL && !(tpt_rand()%tempFactor))
 					{
-						if(rand()%2)
+						if(tpt_rand()%2)
 						{
 							sim->part_create(r>>8, x+rx, y+ry, PT_THRM);
 						}
 						else
 							sim->part_create(i, x, y, PT_THRM);
 						//part_change_type(r>>8,x+rx,y+ry,PT_BMTL);
-						//parts[r>>8].tmp=(parts[i].tmp<=7)?parts[i].tmp=1:parts[i].tmp-(rand()%5);//rand()/(RAND_MAX/300)+100;
+						//parts[r>>8].tmp=(parts[i].tmp<=7)?parts[i].tmp=1:parts[i].tmp-(tpt_rand()%5);//tpt_rand()/(RAND_MAX/300)+100;
 					}
 				}
 	}
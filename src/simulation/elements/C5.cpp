@@ -27,11 +27,11 @@ int C5_update(UPDATE_FUNC_ARGS)
 					continue;
 				if (((r&0xFF)!=PT_C5 && parts[r>>8].temp<100 && sim->elements[r&0xFF].HeatConduct && ((r&0xFF)!=PT_HSWC||parts[r>>8].life==10)) || (r&0xFF)==PT_HFLM)
 				{
-					if (!(rand()%6))
+					if (!(tpt_rand()%6))
 					{
 						sim->part_change_type(i,x,y,PT_HFLM);
 						parts[r>>8].temp = parts[i].temp = 0;
-						parts[i].life = rand()%150+50;
+						parts[i].life = tpt_rand()%150+50;
 						sim->air->pv[y/CELL][x/CELL] += 1.5;
 					}
 				}
@@ -35,7 +35,7 @@ int CAUS_update(UPDATE_FUNC_ARGS)
 				}
 				else if ((r&0xFF)!=PT_ACID && (r&0xFF)!=PT_CAUS && (r&0xFF)!=PT_RFRG && (r&0xFF)!=PT_RFGL)
 				{
-					if ((!(sim->elements[r&0xFF].Properties&PROP_CLONE) && sim->elements[r&0xFF].Hardness>(rand()%1000))&&parts[i].life>=50)
+					if ((!(sim->elements[r&0xFF].Properties&PROP_CLONE) && sim->elements[r&0xFF].Hardness>(tpt_rand()%1000))&&parts[i].life>=50)
 					{
 						if (parts_avg(i, r>>8,PT_GLAS)!= PT_GLAS)//GLAS protects stuff from acid
 						{
@@ -20,7 +20,7 @@ int CBNW_update(UPDATE_FUNC_ARGS)
 	int r, rx, ry;
 	if (sim->air->pv[y/CELL][x/CELL]<=3)
 	{
-		if (sim->air->pv[y/CELL][x/CELL] <= -0.5 || !(rand()%4000))
+		if (sim->air->pv[y/CELL][x/CELL] <= -0.5 || !(tpt_rand()%4000))
 		{
 			part_change_type(i, x, y, PT_CO2);
 			parts[i].ctype = 5;
@@ -31,15 +31,15 @@ int CBNW_update(UPDATE_FUNC_ARGS)
 	{
 		parts[i].tmp2 -= (parts[i].tmp2>20)?1:-1;
 	}
-	else if (!(rand()%200))
+	else if (!(tpt_rand()%200))
 	{
-		parts[i].tmp2 = rand()%40;
+		parts[i].tmp2 = tpt_rand()%40;
 	}
 
 	if (parts[i].tmp > 0)
 	{
 		//Explode
-		if (parts[i].tmp==1 && rand()%4)
+		if (parts[i].tmp==1 && tpt_rand()%4)
 		{
 			part_change_type(i, x, y, PT_CO2);
 			parts[i].ctype = 5;
@@ -54,14 +54,14 @@ int CBNW_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 					continue;
-				if (ptypes[r&0xFF].properties&TYPE_PART && parts[i].tmp == 0 && !(rand()%83))
+				if (ptypes[r&0xFF].properties&TYPE_PART && parts[i].tmp == 0 && !(tpt_rand()%83))
 				{
 					//Start explode
-					parts[i].tmp = rand()%25;//(rand()%100)+50;
+					parts[i].tmp = tpt_rand()%25;//(tpt_rand()%100)+50;
 				}
-				else if (ptypes[r&0xFF].properties&TYPE_SOLID && !(ptypes[r&0xFF].properties&PROP_INDESTRUCTIBLE) && (r&0xFF)!=PT_GLAS && parts[i].tmp == 0 && (2-sim->air->pv[y/CELL][x/CELL])>(rand()%6667))
+				else if (ptypes[r&0xFF].properties&TYPE_SOLID && !(ptypes[r&0xFF].properties&PROP_INDESTRUCTIBLE) && (r&0xFF)!=PT_GLAS && parts[i].tmp == 0 && (2-sim->air->pv[y/CELL][x/CELL])>(tpt_rand()%6667))
 				{
-					if (rand()%2)
+					if (tpt_rand()%2)
 					{
 						part_change_type(i, x, y, PT_CO2);
 						parts[i].ctype = 5;
@@ -88,7 +88,7 @@ int CBNW_update(UPDATE_FUNC_ARGS)
 				}
 				else if ((r&0xFF)==PT_RBDM || (r&0xFF)==PT_LRBD)
 				{
-					if ((legacy_enable||parts[i].temp>(273.15f+12.0f)) && !(rand()%166))
+					if ((legacy_enable||parts[i].temp>(273.15f+12.0f)) && !(tpt_rand()%166))
 					{
 						part_change_type(i, x, y, PT_FIRE);
 						parts[i].life = 4;
@@ -98,7 +98,7 @@ int CBNW_update(UPDATE_FUNC_ARGS)
 				else if ((r&0xFF)==PT_FIRE && parts[r>>8].ctype!=PT_WATR)
 				{
 					kill_part(r>>8);
-					if (!(rand()%50)){
+					if (!(tpt_rand()%50)){
 						kill_part(i);
 						return 1;
 					}
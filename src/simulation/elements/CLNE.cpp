@@ -43,10 +43,10 @@ int CLNE_update(UPDATE_FUNC_ARGS)
 	else
 	{
 		if (parts[i].ctype == PT_LIFE)
-			sim->part_create(-1, x+rand()%3-1, y+rand()%3-1, PT_LIFE, parts[i].tmp);
-		else if (parts[i].ctype != PT_LIGH || (rand()%30) == 0)
+			sim->part_create(-1, x+tpt_rand()%3-1, y+tpt_rand()%3-1, PT_LIFE, parts[i].tmp);
+		else if (parts[i].ctype != PT_LIGH || (tpt_rand()%30) == 0)
 		{
-			int np = sim->part_create(-1, x+rand()%3-1, y+rand()%3-1, parts[i].ctype&0xFF);
+			int np = sim->part_create(-1, x+tpt_rand()%3-1, y+tpt_rand()%3-1, parts[i].ctype&0xFF);
 			if (np>=0)
 			{
 				if (parts[i].ctype==PT_LAVA && parts[i].tmp>0 && parts[i].tmp<PT_NUM && sim->elements[parts[i].tmp].HighTemperatureTransitionElement==PT_LAVA)
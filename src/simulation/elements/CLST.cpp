@@ -28,7 +28,7 @@ int CLST_update(UPDATE_FUNC_ARGS)
 					continue;
 				if ((r&0xFF) == PT_WATR)
 				{
-					if (!(rand()%1500))
+					if (!(tpt_rand()%1500))
 					{
 						sim->part_create(i, x, y, PT_PSTS);
 						kill_part(r>>8);
@@ -68,7 +68,7 @@ int CLST_graphics(GRAPHICS_FUNC_ARGS)
 
 void CLST_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	sim->parts[i].tmp = (rand()%7);
+	sim->parts[i].tmp = (tpt_rand()%7);
 }
 
 void CLST_init_element(ELEMENT_INIT_FUNC_ARGS)
@@ -17,8 +17,8 @@
 
 int DEST_update(UPDATE_FUNC_ARGS)
 {
-	int rx=rand()%5-2;
-	int ry=rand()%5-2;
+	int rx=tpt_rand()%5-2;
+	int ry=tpt_rand()%5-2;
 
 	int r = pmap[y+ry][x+rx];
 	if (!r || (r&0xFF)==PT_DEST || (sim->elements[r&0xFF].Properties&PROP_INDESTRUCTIBLE) || (sim->elements[r&0xFF].Properties&PROP_CLONE) || (sim->elements[r&0xFF].Properties&PROP_BREAKABLECLONE))
@@ -26,13 +26,13 @@ int DEST_update(UPDATE_FUNC_ARGS)
 
 	if (parts[i].life<=0 || parts[i].life>37)
 	{
-		parts[i].life=30+rand()%20;
+		parts[i].life=30+tpt_rand()%20;
 		sim->air->pv[y/CELL][x/CELL]+=60.0f;
 	}
 	if ((r&0xFF)==PT_PLUT || (r&0xFF)==PT_DEUT)
 	{
 		sim->air->pv[y/CELL][x/CELL]+=20.0f;
-		if (rand()%2)
+		if (tpt_rand()%2)
 		{
 			sim->part_create(r>>8, x+rx, y+ry, PT_NEUT);
 			parts[r>>8].temp = MAX_TEMP;
@@ -44,7 +44,7 @@ int DEST_update(UPDATE_FUNC_ARGS)
 	{
 		sim->part_create(r>>8, x+rx, y+ry, PT_PLSM);
 	}
-	else if (!(rand()%3))
+	else if (!(tpt_rand()%3))
 	{
 		kill_part(r>>8);
 		parts[i].life -= 4*((sim->elements[r&0xFF].Properties&TYPE_SOLID)?3:1);
@@ -21,7 +21,7 @@ int DEUT_update(UPDATE_FUNC_ARGS)
 	float gravtot = fabs(gravy[(y/CELL)*(XRES/CELL)+(x/CELL)])+fabs(gravx[(y/CELL)*(XRES/CELL)+(x/CELL)]);
 	int maxlife = (int)((10000/(parts[i].temp + 1))-1);
 	// no idea what this line was intended to do, but kept for compatibility
-	if ((10000%((int)parts[i].temp + 1))>rand()%((int)parts[i].temp + 1))
+	if ((10000%((int)parts[i].temp + 1))>tpt_rand()%((int)parts[i].temp + 1))
 		maxlife++;
 	// Compress when Newtonian gravity is applied
 	// multiplier=1 when gravtot=0, multiplier -> 5 as gravtot -> inf
@@ -35,7 +35,7 @@ int DEUT_update(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r || (parts[i].life >=maxlife))
 						continue;
-					if ((r&0xFF)==PT_DEUT && !(rand()%3))
+					if ((r&0xFF)==PT_DEUT && !(tpt_rand()%3))
 					{
 						// If neighbour life+1 fits in the free capacity for this particle, absorb neighbour
 						// Condition is written in this way so that large neighbour life values don't cause integer overflow
@@ -70,8 +70,8 @@ int DEUT_update(UPDATE_FUNC_ARGS)
 trade:
 	for ( trade = 0; trade<4; trade ++)
 	{
-		rx = rand()%5-2;
-		ry = rand()%5-2;
+		rx = tpt_rand()%5-2;
+		ry = tpt_rand()%5-2;
 		if (BOUNDS_CHECK && (rx || ry))
 		{
 			r = pmap[y+ry][x+rx];
@@ -45,6 +45,16 @@ int DRAY_update(UPDATE_FUNC_ARGS)
 						for (int xStep = rx*-1, yStep = ry*-1, xCurrent = x+xStep, yCurrent = y+yStep; ; xCurrent+=xStep, yCurrent+=yStep)
 						{
 							int rr;
+							// nothing but the length limit can stop it on empty pixels, so skip over those all at once
+							if (!foundParticle && (ctype || copyLength) && sim->InBounds(xCurrent, yCurrent) && !sim->IsOccupied(xCurrent, yCurrent))
+							{
+								int skip = sim->NextOccupied(xCurrent, yCurrent, xStep, yStep)-1;
+								if (partsRemaining > 0 && skip > partsRemaining-1)
+									skip = partsRemaining-1;
+								partsRemaining -= skip;
+								xCurrent += xStep*skip;
+								yCurrent += yStep*skip;
+							}
 							// haven't found a particle yet, keep looking for one
 							// the first particle it sees decides whether it will copy energy particles or not
 							if (!foundParticle)
@@ -116,14 +126,15 @@ int DRAY_update(UPDATE_FUNC_ARGS)
 							{
 								if (type == PT_SPRK) // spark hack
 									sim->part_change_type(p, xCopyTo, yCopyTo, PT_SPRK);
-								if (isEnergy)
-									parts[p] = parts[photons[yCurrent][xCurrent]>>8];
-								else
-									parts[p] = parts[pmap[yCurrent][xCurrent]>>8];
+								int src = isEnergy ? photons[yCurrent][xCurrent]>>8 : pmap[yCurrent][xCurrent]>>8;
+								parts[p] = parts[src];
 
 								parts[p].x = (float)xCopyTo;
 								parts[p].y = (float)yCopyTo;
-								parts[p].animations = NULL;
+								// ANIM frames aren't part of the particle, copy them separately
+								ARGBColour *srcFrames = sim->animations.Get(src), *newFrames = sim->animations.Get(p);
+								if (srcFrames && newFrames)
+									std::copy(srcFrames, srcFrames+sim->maxFrames, newFrames);
 							}
 						}
 					}
@@ -26,29 +26,29 @@ int DSTW_update(UPDATE_FUNC_ARGS)
 				switch (r&0xFF)
 				{
 				case PT_SALT:
-					if (!(rand()%50))
+					if (!(tpt_rand()%50))
 					{
 						part_change_type(i, x, y, PT_SLTW);
 						// on average, convert 3 DSTW to SLTW before SALT turns into SLTW
-						if (rand()%3==0)
+						if (tpt_rand()%3==0)
 							part_change_type(r>>8, x+rx, y+ry, PT_SLTW);
 					}
 					break;
 				case PT_SLTW:
-					if (!(rand()%2000))
+					if (!(tpt_rand()%2000))
 					{
 						part_change_type(i, x, y, PT_SLTW);
 					}
 					// no break here intentionally
 				case PT_WATR:
-					if (!(rand()%100))
+					if (!(tpt_rand()%100))
 					{
 						part_change_type(i, x, y, PT_WATR);
 					}
 					break;
 				case PT_RBDM:
 				case PT_LRBD:
-					if ((legacy_enable||parts[i].temp>12.0f) && !(rand()%100))
+					if ((legacy_enable||parts[i].temp>12.0f) && !(tpt_rand()%100))
 					{
 						part_change_type(i, x, y, PT_FIRE);
 						parts[i].life = 4;
@@ -56,7 +56,7 @@ int DSTW_update(UPDATE_FUNC_ARGS)
 					break;
 				case PT_FIRE:
 					kill_part(r>>8);
-					if (!(rand()%30))
+					if (!(tpt_rand()%30))
 					{
 						kill_part(i);
 						return 1;
@@ -59,6 +59,10 @@ public:
 	{
 		invalidate();
 	}
+	virtual void Simulation_ParticlesMoved(Simulation *sim, const int *newIndex)
+	{
+		invalidate();
+	}
 
 private:
 	static bool compareFunc(const ETRD_deltaWithLength &a, const ETRD_deltaWithLength &b)
@@ -28,7 +28,7 @@ int EXOT_update(UPDATE_FUNC_ARGS)
 				rt = r&0xFF;
 				if (rt == PT_WARP)
 				{
-					if (parts[r>>8].tmp2>2000 && !(rand()%100))
+					if (parts[r>>8].tmp2>2000 && !(tpt_rand()%100))
 					{
 						parts[i].tmp2 += 100;
 					}
@@ -37,7 +37,7 @@ int EXOT_update(UPDATE_FUNC_ARGS)
 				{
 					if (parts[r>>8].ctype == PT_PROT)
 						parts[i].ctype = PT_PROT;
-					if (parts[r>>8].life == 1500 && !(rand()%1000))
+					if (parts[r>>8].life == 1500 && !(tpt_rand()%1000))
 						parts[i].life = 1500;
 				}
 				else if (rt == PT_LAVA)
@@ -45,7 +45,7 @@ int EXOT_update(UPDATE_FUNC_ARGS)
 					//turn molten TTAN or molten GOLD to molten VIBR 
 					if (parts[r>>8].ctype == PT_TTAN || parts[r>>8].ctype == PT_GOLD)
 					{
-						if (!(rand()%10))
+						if (!(tpt_rand()%10))
 						{
 							parts[r>>8].ctype = PT_VIBR;
 							kill_part(i);
@@ -55,7 +55,7 @@ int EXOT_update(UPDATE_FUNC_ARGS)
 					//molten VIBR will kill the leftover EXOT though, so the VIBR isn't killed later
 					else if (parts[r>>8].ctype == PT_VIBR)
 					{
-						if (!(rand()%1000))
+						if (!(tpt_rand()%1000))
 						{
 							kill_part(i);
 							return 1;
@@ -98,8 +98,8 @@ int EXOT_update(UPDATE_FUNC_ARGS)
 	{
 		for (trade = 0; trade<9; trade++)
 		{
-			rx = rand()%5-2;
-			ry = rand()%5-2;
+			rx = tpt_rand()%5-2;
+			ry = tpt_rand()%5-2;
 			if (BOUNDS_CHECK && (rx || ry))
 			{
 				r = pmap[y+ry][x+rx];
@@ -152,7 +152,7 @@ int EXOT_graphics(GRAPHICS_FUNC_ARGS)
 	int c = cpart->tmp2;	
 	if (cpart->life < 1001)
 	{
-		if ((cpart->tmp2 - 1)>rand()%1000)
+		if ((cpart->tmp2 - 1)>tpt_rand()%1000)
 		{	
 			float frequency = 0.04045f;
 			*colr = (int)(sinf(frequency*c + 4) * 127 + 150);
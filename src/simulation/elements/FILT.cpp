@@ -66,9 +66,9 @@ int interactWavelengths(particle* cpart, int origWl)
 		return (~origWl) & mask; // Invert colours 
 	case 9:
 	{
-		int t1 = (origWl & 0x0000FF)+(rand()%5)-2;
-		int t2 = ((origWl & 0x00FF00)>>8)+(rand()%5)-2;
-		int t3 = ((origWl & 0xFF0000)>>16)+(rand()%5)-2;
+		int t1 = (origWl & 0x0000FF)+(tpt_rand()%5)-2;
+		int t2 = ((origWl & 0x00FF00)>>8)+(tpt_rand()%5)-2;
+		int t3 = ((origWl & 0xFF0000)>>16)+(tpt_rand()%5)-2;
 		return (origWl & 0xFF000000) | (t3<<16) | (t2<<8) | t1;
 	}
 	case 10:
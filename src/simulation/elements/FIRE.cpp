@@ -31,7 +31,7 @@ int FIRE_update_legacy(UPDATE_FUNC_ARGS)
 				int rt = r&0xFF;
 				int lpv = (int)sim->air->pv[(y+ry)/CELL][(x+rx)/CELL];
 				if (lpv < 1) lpv = 1;
-				if (sim->elements[rt].Meltable && ((rt!=PT_RBDM && rt!=PT_LRBD) || t!=PT_SPRK) && ((t!=PT_FIRE&&t!=PT_PLSM) || (rt!=PT_METL && rt!=PT_IRON && rt!=PT_ETRD && rt!=PT_PSCN && rt!=PT_NSCN && rt!=PT_NTCT && rt!=PT_PTCT && rt!=PT_BMTL && rt!=PT_BRMT && rt!=PT_SALT && rt!=PT_INWR)) && sim->elements[rt].Meltable*lpv>(rand()%1000))
+				if (sim->elements[rt].Meltable && ((rt!=PT_RBDM && rt!=PT_LRBD) || t!=PT_SPRK) && ((t!=PT_FIRE&&t!=PT_PLSM) || (rt!=PT_METL && rt!=PT_IRON && rt!=PT_ETRD && rt!=PT_PSCN && rt!=PT_NSCN && rt!=PT_NTCT && rt!=PT_PTCT && rt!=PT_BMTL && rt!=PT_BRMT && rt!=PT_SALT && rt!=PT_INWR)) && sim->elements[rt].Meltable*lpv>(tpt_rand()%1000))
 				{
 					if (t!=PT_LAVA || parts[i].life>0)
 					{
@@ -42,7 +42,7 @@ int FIRE_update_legacy(UPDATE_FUNC_ARGS)
 						else
 							parts[r>>8].ctype = rt;
 						sim->part_change_type(r>>8,x+rx,y+ry,PT_LAVA);
-						parts[r>>8].life = rand()%120+240;
+						parts[r>>8].life = tpt_rand()%120+240;
 					}
 					else
 					{
@@ -119,7 +119,7 @@ int FIRE_update(UPDATE_FUNC_ARGS)
 			else if (parts[i].temp<625)
 			{
 				sim->part_change_type(i, x, y, PT_SMKE);
-				parts[i].life = rand()%20+250;
+				parts[i].life = tpt_rand()%20+250;
 			}
 		}
 		break;
@@ -137,7 +137,7 @@ int FIRE_update(UPDATE_FUNC_ARGS)
 				//THRM burning
 				if (rt==PT_THRM && (t==PT_FIRE || t==PT_PLSM || t==PT_LAVA))
 				{
-					if (!(rand()%500))
+					if (!(tpt_rand()%500))
 					{
 						sim->part_change_type(r>>8,x+rx,y+ry,PT_LAVA);
 						parts[r>>8].ctype = PT_BMTL;
@@ -159,14 +159,14 @@ int FIRE_update(UPDATE_FUNC_ARGS)
 				{
 					if ((t==PT_FIRE || t==PT_PLSM))
 					{
-						if (parts[r>>8].life>100 && !(rand()%500))
+						if (parts[r>>8].life>100 && !(tpt_rand()%500))
 						{
 							parts[r>>8].life = 99;
 						}
 					}
 					else if (t==PT_LAVA)
 					{
-						if (parts[i].ctype == PT_IRON && !(rand()%500))
+						if (parts[i].ctype == PT_IRON && !(tpt_rand()%500))
 						{
 							parts[i].ctype = PT_METL;
 							kill_part(r>>8);
@@ -189,7 +189,7 @@ int FIRE_update(UPDATE_FUNC_ARGS)
 					}
 					else if (rt == PT_HEAC && parts[i].ctype == PT_HEAC)
 					{
-						if (parts[r>>8].temp > sim->elements[PT_HEAC].HighTemperatureTransitionThreshold && rand()%200)
+						if (parts[r>>8].temp > sim->elements[PT_HEAC].HighTemperatureTransitionThreshold && tpt_rand()%200)
 						{
 							sim->part_change_type(r>>8, x+rx, y+ry, PT_LAVA);
 							parts[r>>8].ctype = PT_HEAC;
@@ -198,7 +198,7 @@ int FIRE_update(UPDATE_FUNC_ARGS)
 				}
 
 				if ((surround_space || sim->elements[rt].Explosive) &&
-					sim->elements[rt].Flammable && (sim->elements[rt].Flammable + (int)(sim->air->pv[(y+ry)/CELL][(x+rx)/CELL]*10.0f)) > (rand()%1000) &&
+					sim->elements[rt].Flammable && (sim->elements[rt].Flammable + (int)(sim->air->pv[(y+ry)/CELL][(x+rx)/CELL]*10.0f)) > (tpt_rand()%1000) &&
 					//exceptions, t is the thing causing the flame and rt is what's burning
 					(t != PT_SPRK || (rt != PT_RBDM && rt != PT_LRBD && rt != PT_INSL)) &&
 					(t != PT_PHOT || rt != PT_INSL) &&
@@ -206,7 +206,7 @@ int FIRE_update(UPDATE_FUNC_ARGS)
 				{
 					sim->part_change_type(r>>8, x+rx, y+ry, PT_FIRE);
 					parts[r>>8].temp = restrict_flt(ptypes[PT_FIRE].heat + (sim->elements[rt].Flammable/2), MIN_TEMP, MAX_TEMP);
-					parts[r>>8].life = rand()%80+180;
+					parts[r>>8].life = tpt_rand()%80+180;
 					parts[r>>8].tmp = parts[r>>8].ctype = 0;
 					if (sim->elements[rt].Explosive)
 						sim->air->pv[y/CELL][x/CELL] += 0.25f * CFDS;
@@ -237,7 +237,7 @@ int FIRE_graphics(GRAPHICS_FUNC_ARGS)
 
 void FIRE_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	sim->parts[i].life = rand()%50+120;
+	sim->parts[i].life = tpt_rand()%50+120;
 }
 
 void FIRE_init_element(ELEMENT_INIT_FUNC_ARGS)
@@ -35,12 +35,12 @@ int FIRW_update(UPDATE_FUNC_ARGS)
 						get_gravity_field(x, y, sim->elements[PT_FIRW].Gravity, 1.0f, &gx, &gy);
 						if (gx*gx+gy*gy < 0.001f)
 						{
-							float angle = (rand()%6284)*0.001f;//(in radians, between 0 and 2*pi)
+							float angle = (tpt_rand()%6284)*0.001f;//(in radians, between 0 and 2*pi)
 							gx += sinf(angle) * sim->elements[PT_FIRW].Gravity * 0.5f;
 							gy += cosf(angle) * sim->elements[PT_FIRW].Gravity * 0.5f;
 						}
 						parts[i].tmp = 1;
-						parts[i].life = rand()%10+20;
+						parts[i].life = tpt_rand()%10+20;
 						multiplier = (parts[i].life+20)*0.2f/sqrtf(gx*gx+gy*gy);
 						parts[i].vx -= gx*multiplier;
 						parts[i].vy -= gy*multiplier;
@@ -62,7 +62,7 @@ int FIRW_update(UPDATE_FUNC_ARGS)
 	else //if (parts[i].tmp >= 2)
 	{
 		float angle, magnitude;
-		int caddress = (rand()%200)*3;
+		int caddress = (tpt_rand()%200)*3;
 		int n;
 		unsigned col = (((unsigned char)(firw_data[caddress]))<<16) | (((unsigned char)(firw_data[caddress+1]))<<8) | ((unsigned char)(firw_data[caddress+2]));
 		for (n=0; n<40; n++)
@@ -70,14 +70,14 @@ int FIRW_update(UPDATE_FUNC_ARGS)
 			np = sim->part_create(-3, x, y, PT_EMBR);
 			if (np>-1)
 			{
-				magnitude = ((rand()%60)+40)*0.05f;
-				angle = (rand()%6284)*0.001f;//(in radians, between 0 and 2*pi)
+				magnitude = ((tpt_rand()%60)+40)*0.05f;
+				angle = (tpt_rand()%6284)*0.001f;//(in radians, between 0 and 2*pi)
 				parts[np].vx = parts[i].vx*0.5f + cosf(angle)*magnitude;
 				parts[np].vy = parts[i].vy*0.5f + sinf(angle)*magnitude;
 				parts[np].ctype = col;
 				parts[np].tmp = 1;
-				parts[np].life = rand()%40+70;
-				parts[np].temp = (rand()%500)+5750.0f;
+				parts[np].life = tpt_rand()%40+70;
+				parts[np].temp = (tpt_rand()%500)+5750.0f;
 				parts[np].dcolour = parts[i].dcolour;
 			}
 		}
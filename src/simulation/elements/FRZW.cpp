@@ -25,12 +25,12 @@ int FRZW_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 					continue;
-				if ((r&0xFF)==PT_WATR && !(rand()%14))
+				if ((r&0xFF)==PT_WATR && !(tpt_rand()%14))
 				{
 					part_change_type(r>>8,x+rx,y+ry,PT_FRZW);
 				}
 			}
-	if ((!parts[i].life && !(rand()%192)) || (100-parts[i].life) > rand()%50000)
+	if ((!parts[i].life && !(tpt_rand()%192)) || (100-parts[i].life) > tpt_rand()%50000)
 	{
 		part_change_type(i,x,y,PT_ICEI);
 		parts[i].ctype=PT_FRZW;
@@ -25,7 +25,7 @@ int FRZZ_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 					continue;
-				if ((r&0xFF)==PT_WATR&& !(rand()%20))
+				if ((r&0xFF)==PT_WATR&& !(tpt_rand()%20))
 				{
 					part_change_type(r>>8,x+rx,y+ry,PT_FRZW);
 					parts[r>>8].life = 100;
@@ -28,9 +28,9 @@ int FSEP_update(UPDATE_FUNC_ARGS)
 	else if (parts[i].life < 40)
 	{
 		parts[i].life--;
-		if (!(rand()%10))
+		if (!(tpt_rand()%10))
 		{
-			r = sim->part_create(-1, x+rand()%3-1, y+rand()%3-1, PT_PLSM);
+			r = sim->part_create(-1, x+tpt_rand()%3-1, y+tpt_rand()%3-1, PT_PLSM);
 			if (r > -1)
 				parts[r].life = 50;
 		}
@@ -44,7 +44,7 @@ int FSEP_update(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r)
 						continue;
-					if (((r&0xFF)==PT_SPRK || (parts[i].temp>=(273.15+400.0f))) && !(rand()%15))
+					if (((r&0xFF)==PT_SPRK || (parts[i].temp>=(273.15+400.0f))) && !(tpt_rand()%15))
 					{
 						parts[i].life = 39;
 						return 0;
@@ -28,9 +28,9 @@ int FUSE_update(UPDATE_FUNC_ARGS)
 	else if (parts[i].life < 40)
 	{
 		parts[i].life--;
-		if (!(rand()%100))
+		if (!(tpt_rand()%100))
 		{
-			r = sim->part_create(-1, x+rand()%3-1, y+rand()%3-1, PT_PLSM);
+			r = sim->part_create(-1, x+tpt_rand()%3-1, y+tpt_rand()%3-1, PT_PLSM);
 			if (r > -1)
 				parts[r].life = 50;
 		}
@@ -53,7 +53,7 @@ int FUSE_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 					continue;
-				if ((r&0xFF)==PT_SPRK || (parts[i].temp>=(273.15+700.0f) && !(rand()%20)))
+				if ((r&0xFF)==PT_SPRK || (parts[i].temp>=(273.15+700.0f) && !(tpt_rand()%20)))
 				{
 					if (parts[i].life > 40)
 						parts[i].life = 39;
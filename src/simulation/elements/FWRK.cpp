@@ -17,14 +17,14 @@
 
 int FWRK_update(UPDATE_FUNC_ARGS)
 {
-	if (parts[i].life == 0 && ((surround_space && parts[i].temp > 400 && (9+parts[i].temp/40) > rand()%100000) || parts[i].ctype == PT_DUST))
+	if (parts[i].life == 0 && ((surround_space && parts[i].temp > 400 && (9+parts[i].temp/40) > tpt_rand()%100000) || parts[i].ctype == PT_DUST))
 	{
 		float gx, gy, multiplier, gmax;
 		int randTmp;
 		get_gravity_field(x, y, sim->elements[PT_FWRK].Gravity, 1.0f, &gx, &gy);
 		if (gx*gx+gy*gy < 0.001f)
 		{
-			float angle = (rand()%6284)*0.001f;//(in radians, between 0 and 2*pi)
+			float angle = (tpt_rand()%6284)*0.001f;//(in radians, between 0 and 2*pi)
 			gx += sinf(angle) * sim->elements[PT_FWRK].Gravity * 0.5f;
 			gy += cosf(angle) * sim->elements[PT_FWRK].Gravity * 0.5f;
 		}
@@ -34,15 +34,15 @@ int FWRK_update(UPDATE_FUNC_ARGS)
 			multiplier = 15.0f/sqrtf(gx*gx+gy*gy);
 
 			//Some variation in speed parallel to gravity direction
-			randTmp = (rand()%200)-100;
+			randTmp = (tpt_rand()%200)-100;
 			gx += gx*randTmp*0.002f;
 			gy += gy*randTmp*0.002f;
 			//and a bit more variation in speed perpendicular to gravity direction
-			randTmp = (rand()%200)-100;
+			randTmp = (tpt_rand()%200)-100;
 			gx += -gy*randTmp*0.005f;
 			gy += gx*randTmp*0.005f;
 
-			parts[i].life=rand()%10+18;
+			parts[i].life=tpt_rand()%10+18;
 			parts[i].ctype=0;
 			parts[i].vx -= gx*multiplier;
 			parts[i].vy -= gy*multiplier;
@@ -51,9 +51,9 @@ int FWRK_update(UPDATE_FUNC_ARGS)
 	}
 	if (parts[i].life<3 && parts[i].life>0)
 	{
-		int r = (rand()%245+11);
-		int g = (rand()%245+11);
-		int b = (rand()%245+11);
+		int r = (tpt_rand()%245+11);
+		int g = (tpt_rand()%245+11);
+		int b = (tpt_rand()%245+11);
 		int n;
 		float angle, magnitude;
 		unsigned col = (r<<16) | (g<<8) | b;
@@ -62,14 +62,14 @@ int FWRK_update(UPDATE_FUNC_ARGS)
 			int np = sim->part_create(-3, x, y, PT_EMBR);
 			if (np>-1)
 			{
-				magnitude = ((rand()%60)+40)*0.05f;
-				angle = (rand()%6284)*0.001f;//(in radians, between 0 and 2*pi)
+				magnitude = ((tpt_rand()%60)+40)*0.05f;
+				angle = (tpt_rand()%6284)*0.001f;//(in radians, between 0 and 2*pi)
 				parts[np].vx = parts[i].vx*0.5f + cosf(angle)*magnitude;
 				parts[np].vy = parts[i].vy*0.5f + sinf(angle)*magnitude;
 				parts[np].ctype = col;
 				parts[np].tmp = 1;
-				parts[np].life = rand()%40+70;
-				parts[np].temp = (rand()%500)+5750.0f;
+				parts[np].life = tpt_rand()%40+70;
+				parts[np].temp = (tpt_rand()%500)+5750.0f;
 				parts[np].dcolour = parts[i].dcolour;
 			}
 		}
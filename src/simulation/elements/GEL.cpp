@@ -38,31 +38,31 @@ int GEL_update(UPDATE_FUNC_ARGS)
 				case PT_WATR:
 				case PT_DSTW:
 				case PT_FRZW:
-					if (parts[i].tmp<100 && 500>rand()%absorbChanceDenom)
+					if (parts[i].tmp<100 && 500>tpt_rand()%absorbChanceDenom)
 					{
 						parts[i].tmp++;
 						kill_part(r>>8);
 					}
 					break;
 				case PT_PSTE:
-					if (parts[i].tmp<100 && 20>rand()%absorbChanceDenom)
+					if (parts[i].tmp<100 && 20>tpt_rand()%absorbChanceDenom)
 					{
 						parts[i].tmp++;
 						sim->part_create(r>>8, x+rx, y+ry, PT_CLST);
 					}
 					break;
 				case PT_SLTW:
-					if (parts[i].tmp<100 && 50>rand()%absorbChanceDenom)
+					if (parts[i].tmp<100 && 50>tpt_rand()%absorbChanceDenom)
 					{
 						parts[i].tmp++;
-						if (rand()%4)
+						if (tpt_rand()%4)
 							kill_part(r>>8);
 						else
 							part_change_type(r>>8, x+rx, y+ry, PT_SALT);
 					}
 					break;
 				case PT_CBNW:
-					if (parts[i].tmp<100 && 100>rand()%absorbChanceDenom)
+					if (parts[i].tmp<100 && 100>tpt_rand()%absorbChanceDenom)
 					{
 						parts[i].tmp++;
 						part_change_type(r>>8, x+rx, y+ry, PT_CO2);
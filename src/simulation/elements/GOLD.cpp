@@ -23,7 +23,7 @@ int GOLD_update(UPDATE_FUNC_ARGS)
 	//Find nearby rusted iron (BMTL with tmp 1+)
 	for (j = 0; j < 8; j++)
 	{
-		rndstore = rand();
+		rndstore = tpt_rand();
 		rx = (rndstore % 9)-4;
 		rndstore >>= 4;
 		ry = (rndstore % 9)-4;
@@ -61,7 +61,7 @@ int GOLD_update(UPDATE_FUNC_ARGS)
 	}
 	if ((photons[y][x]&0xFF) == PT_NEUT)
 	{
-		if (!(rand()%7))
+		if (!(tpt_rand()%7))
 		{
 			kill_part(photons[y][x]>>8);
 		}
@@ -71,7 +71,7 @@ int GOLD_update(UPDATE_FUNC_ARGS)
 
 int GOLD_graphics(GRAPHICS_FUNC_ARGS)
 {
-	int rndstore = rand();
+	int rndstore = tpt_rand();
 	*colr += (rndstore % 10) - 5;
 	rndstore >>= 4;
 	*colg += (rndstore % 10)- 5;
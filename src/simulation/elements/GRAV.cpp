@@ -17,7 +17,7 @@
 
 int GRAV_update(UPDATE_FUNC_ARGS)
 {
-	if (parts[i].vx*parts[i].vx + parts[i].vy*parts[i].vy >= 0.1f && (rand() % 512) == 0)
+	if (parts[i].vx*parts[i].vx + parts[i].vy*parts[i].vy >= 0.1f && (tpt_rand() % 512) == 0)
 	{
 		if (!parts[i].life)
 			parts[i].life = 48;
@@ -48,14 +48,14 @@ int H2_update(UPDATE_FUNC_ARGS)
 						parts[r>>8].tmp |= 1;
 
 						sim->part_create(i,x,y,PT_FIRE);
-						parts[i].temp += (rand()%100);
+						parts[i].temp += (tpt_rand()%100);
 						parts[i].tmp |= 1;
 						return 1;
 					}
 					else if ((rt==PT_PLSM && !(parts[r>>8].tmp&4)) || (rt==PT_LAVA && parts[r>>8].ctype != PT_BMTL))
 					{
 						sim->part_create(i,x,y,PT_FIRE);
-						parts[i].temp += (rand()%100);
+						parts[i].temp += (tpt_rand()%100);
 						parts[i].tmp |= 1;
 						sim->air->pv[y/CELL][x/CELL] += 0.1f;
 						return 1;
@@ -64,7 +64,7 @@ int H2_update(UPDATE_FUNC_ARGS)
 			}
 	if (parts[i].temp > 2273.15f && sim->air->pv[y/CELL][x/CELL] > 50.0f)
 	{
-		if (!(rand()%5))
+		if (!(tpt_rand()%5))
 		{
 			int j;
 			float temp = parts[i].temp;
@@ -74,7 +74,7 @@ int H2_update(UPDATE_FUNC_ARGS)
 			j = sim->part_create(-3,x,y,PT_NEUT);
 			if (j > -1)
 				parts[j].temp = temp;
-			if (!(rand()%10))
+			if (!(tpt_rand()%10))
 			{
 				j = sim->part_create(-3,x,y,PT_ELEC);
 				if (j > -1)
@@ -87,7 +87,7 @@ int H2_update(UPDATE_FUNC_ARGS)
 				parts[j].temp = temp;
 				parts[j].tmp = 0x1;
 			}
-			rx = x+rand()%3-1, ry = y+rand()%3-1, rt = pmap[ry][rx]&0xFF;
+			rx = x+tpt_rand()%3-1, ry = y+tpt_rand()%3-1, rt = pmap[ry][rx]&0xFF;
 			if (sim->can_move[PT_PLSM][rt] || rt == PT_H2)
 			{
 				j = sim->part_create(-3,rx,ry,PT_PLSM);
@@ -98,7 +98,7 @@ int H2_update(UPDATE_FUNC_ARGS)
 				}
 			}
 
-			parts[i].temp = temp+750+rand()%500;
+			parts[i].temp = temp+750+tpt_rand()%500;
 			sim->air->pv[y/CELL][x/CELL] += 30;
 			return 1;
 		}
@@ -31,14 +31,14 @@ int ICE_update(UPDATE_FUNC_ARGS)
 					continue;
 				if ((r&0xFF)==PT_SALT || (r&0xFF)==PT_SLTW)
 				{
-					if (parts[i].temp > sim->elements[PT_SLTW].LowTemperatureTransitionThreshold && !(rand()%200))
+					if (parts[i].temp > sim->elements[PT_SLTW].LowTemperatureTransitionThreshold && !(tpt_rand()%200))
 					{
 						sim->part_change_type(i, x, y, PT_SLTW);
 						sim->part_change_type(r>>8, x+rx, y+ry, PT_SLTW);
 						return 0;
 					}
 				}
-				else if (((r&0xFF)==PT_FRZZ) && !(rand()%200))
+				else if (((r&0xFF)==PT_FRZZ) && !(tpt_rand()%200))
 				{
 					sim->part_change_type(r>>8,x+rx,y+ry,PT_ICEI);
 					parts[r>>8].ctype = PT_FRZW;
@@ -19,7 +19,7 @@
 //INST that can be sparked
 bool contains_sparkable_INST(Simulation *sim, int x, int y)
 {
-	return (pmap[y][x]&0xFF) == PT_INST && parts[pmap[y][x]>>8].life <= 0;
+	return (sim->pmap[y][x]&0xFF) == PT_INST && sim->parts[sim->pmap[y][x]>>8].life <= 0;
 }
 
 //Any INST or SPRK(INST) regardless of life
@@ -28,15 +28,24 @@ bool part_cmp_conductive(unsigned int p, int t)
 	return ((p&0xFF)==(unsigned int)t || ((p&0xFF)==PT_SPRK && parts[p>>8].ctype==t));
 }
 
-int INST_flood_spark(Simulation *sim, int x, int y)
+// Pixels looked at by the flood go through these, so the netlist can record them
+static bool INST_sparkable(Simulation *sim, int x, int y)
+{
+	sim->instNetlist.Read(sim, x, y);
+	return contains_sparkable_INST(sim, x, y);
+}
+
+static bool INST_conductive(Simulation *sim, int x, int y)
+{
+	sim->instNetlist.Read(sim, x, y);
+	return part_cmp_conductive(sim->pmap[y][x], PT_INST);
+}
+
+static int INST_flood(Simulation *sim, int x, int y)
 {
 	int x1, x2;
-	const int cm = PT_INST;
 	int created_something = 0;
 
-	if (!contains_sparkable_INST(sim, x, y))
-		return 0;
-
 	try
 	{
 		CoordStack cs;
@@ -49,21 +58,22 @@ int INST_flood_spark(Simulation *sim, int x, int y)
 			// go left as far as possible
 			while (x1>=CELL)
 			{
-				if (!contains_sparkable_INST(sim, x1-1, y)) break;
+				if (!INST_sparkable(sim, x1-1, y)) break;
 				x1--;
 			}
 			// go right as far as possible
 			while (x2<XRES-CELL)
 			{
-				if (!contains_sparkable_INST(sim, x2+1, y)) break;
+				if (!INST_sparkable(sim, x2+1, y)) break;
 				x2++;
 			}
 			// fill span
 			for (x=x1; x<=x2; x++)
 			{
-				if (contains_sparkable_INST(sim, x, y))
+				if (INST_sparkable(sim, x, y))
 				{
-					sim->spark_conductive(pmap[y][x]>>8, x, y);
+					sim->spark_conductive(sim->pmap[y][x]>>8, x, y);
+					sim->instNetlist.Sparked(x, y);
 					created_something = 1;
 				}
 			}
@@ -71,15 +81,15 @@ int INST_flood_spark(Simulation *sim, int x, int y)
 			// add vertically adjacent pixels to stack
 			// (wire crossing for INST)
 			if (y>=CELL+1 && x1==x2 &&
-					part_cmp_conductive(pmap[y-1][x1-1], cm) &&
-					part_cmp_conductive(pmap[y-1][x1], cm) &&
-					part_cmp_conductive(pmap[y-1][x1+1], cm) &&
-					!part_cmp_conductive(pmap[y-2][x1-1], cm) &&
-					part_cmp_conductive(pmap[y-2][x1], cm) &&
-					!part_cmp_conductive(pmap[y-2][x1+1], cm))
+					INST_conductive(sim, x1-1, y-1) &&
+					INST_conductive(sim, x1, y-1) &&
+					INST_conductive(sim, x1+1, y-1) &&
+					!INST_conductive(sim, x1-1, y-2) &&
+					INST_conductive(sim, x1, y-2) &&
+					!INST_conductive(sim, x1+1, y-2))
 			{
 				// travelling vertically up, skipping a horizontal line
-				if (contains_sparkable_INST(sim, x1, y-2))
+				if (INST_sparkable(sim, x1, y-2))
 					cs.push(x1, y-2);
 			}
 			else if (y>=CELL+1)
@@ -87,33 +97,33 @@ int INST_flood_spark(Simulation *sim, int x, int y)
 				for (x=x1; x<=x2; x++)
 				{
 					// if at the end of a horizontal section, or if it's a T junction
-					if (x==x1 || x==x2 || y>=YRES-CELL-1 || !part_cmp_conductive(pmap[y+1][x],cm) || part_cmp_conductive(pmap[y+1][x-1],cm) || part_cmp_conductive(pmap[y+1][x+1],cm))
+					if (x==x1 || x==x2 || y>=YRES-CELL-1 || !INST_conductive(sim, x, y+1) || INST_conductive(sim, x-1, y+1) || INST_conductive(sim, x+1, y+1))
 					{
-						if (contains_sparkable_INST(sim, x, y-1))
+						if (INST_sparkable(sim, x, y-1))
 							cs.push(x, y-1);
 					}
 				}
 			}
 
 			if (y<YRES-CELL-1 && x1==x2 &&
-					part_cmp_conductive(pmap[y+1][x1-1], cm) &&
-					part_cmp_conductive(pmap[y+1][x1], cm) &&
-					part_cmp_conductive(pmap[y+1][x1+1], cm) &&
-					!part_cmp_conductive(pmap[y+2][x1-1], cm) &&
-					part_cmp_conductive(pmap[y+2][x1], cm) &&
-					!part_cmp_conductive(pmap[y+2][x1+1], cm))
+					INST_conductive(sim, x1-1, y+1) &&
+					INST_conductive(sim, x1, y+1) &&
+					INST_conductive(sim, x1+1, y+1) &&
+					!INST_conductive(sim, x1-1, y+2) &&
+					INST_conductive(sim, x1, y+2) &&
+					!INST_conductive(sim, x1+1, y+2))
 			{
 				// travelling vertically down, skipping a horizontal line
-				if (contains_sparkable_INST(sim, x1, y+2))
+				if (INST_sparkable(sim, x1, y+2))
 					cs.push(x1, y+2);
 			}
 			else if (y<YRES-CELL-1)
 			{
 				for (x=x1; x<=x2; x++)
 				{
-					if (x==x1 || x==x2 || y<0 || !part_cmp_conductive(pmap[y-1][x],cm) || part_cmp_conductive(pmap[y-1][x-1],cm) || part_cmp_conductive(pmap[y-1][x+1],cm))
+					if (x==x1 || x==x2 || y<0 || !INST_conductive(sim, x, y-1) || INST_conductive(sim, x-1, y-1) || INST_conductive(sim, x+1, y-1))
 					{
-						if (contains_sparkable_INST(sim, x, y+1))
+						if (INST_sparkable(sim, x, y+1))
 							cs.push(x, y+1);
 					}
 				}
@@ -129,6 +139,21 @@ int INST_flood_spark(Simulation *sim, int x, int y)
 	return created_something;
 }
 
+// Sparks all the INST connected to (x, y). Floods that were done before are replayed from sim->instNetlist
+int INST_flood_spark(Simulation *sim, int x, int y)
+{
+	if (!contains_sparkable_INST(sim, x, y))
+		return 0;
+
+	int created_something;
+	if (sim->instNetlist.Replay(sim, x, y, &created_something))
+		return created_something;
+	sim->instNetlist.BeginFlood(sim, x, y);
+	created_something = INST_flood(sim, x, y);
+	sim->instNetlist.EndFlood(created_something >= 0);
+	return created_something;
+}
+
 void INST_init_element(ELEMENT_INIT_FUNC_ARGS)
 {
 	elem->Identifier = "DEFAULT_PT_INST";
@@ -28,19 +28,19 @@ int IRON_update(UPDATE_FUNC_ARGS)
 				switch (r&0xFF)
 				{
 				case PT_SALT:
-					if (!(rand()%47))
+					if (!(tpt_rand()%47))
 						goto succ;
 					break;
 				case PT_SLTW:
-					if (!(rand()%67))
+					if (!(tpt_rand()%67))
 						goto succ;
 					break;
 				case PT_WATR:
-					if (!(rand()%1200))
+					if (!(tpt_rand()%1200))
 						goto succ;
 					break;
 				case PT_O2:
-					if (!(rand()%250))
+					if (!(tpt_rand()%250))
 						goto succ;
 					break;
 				case PT_LO2:
@@ -52,7 +52,7 @@ int IRON_update(UPDATE_FUNC_ARGS)
 	return 0;
 succ:
 	sim->part_change_type(i,x,y,PT_BMTL);
-	parts[i].tmp = (rand()%10)+20;
+	parts[i].tmp = (tpt_rand()%10)+20;
 	return 0;
 }
 
@@ -16,6 +16,243 @@
 #include "simulation/ElementsCommon.h"
 #include "simulation/GolNumbers.h"
 #include "LIFE.h"
+#include "common/tpt-bitops.h"
+
+// cx and cy are relative to the top left corner inside the border, bit 0 of each row is padding
+static inline void gol_set(std::vector<uint64_t> &board, int cx, int cy)
+{
+	board[cy*GOL_WORDS + ((cx+1)>>6)] |= (uint64_t)1 << ((cx+1)&63);
+}
+
+static inline bool gol_get(const std::vector<uint64_t> &board, int cx, int cy)
+{
+	return (board[cy*GOL_WORDS + ((cx+1)>>6)] >> ((cx+1)&63)) & 1;
+}
+
+// copy the cells at each end of every row into the padding bits on the other side
+static void gol_wrap(std::vector<uint64_t> &board)
+{
+	for (int cy = 0; cy < GOL_H; cy++)
+	{
+		if (gol_get(board, GOL_W-1, cy))
+			board[cy*GOL_WORDS] |= 1;
+		if (gol_get(board, 0, cy))
+			gol_set(board, GOL_W, cy);
+	}
+}
+
+// count the neighbours of 64 cells at once, adding the 8 shifted bitboards into a 4 bit counter
+static inline void gol_count(const std::vector<uint64_t> &board, int cy, int w, uint64_t planes[4])
+{
+	const uint64_t *rows[3] = {
+		&board[((cy+GOL_H-1)%GOL_H)*GOL_WORDS],
+		&board[cy*GOL_WORDS],
+		&board[((cy+1)%GOL_H)*GOL_WORDS]
+	};
+	uint64_t b0 = 0, b1 = 0, b2 = 0, b3 = 0;
+	for (int k = 0; k < 3; k++)
+	{
+		const uint64_t *row = rows[k];
+		uint64_t in[3];
+		in[0] = (row[w] << 1) | (w > 0 ? row[w-1] >> 63 : 0);
+		in[1] = row[w];
+		in[2] = (row[w] >> 1) | (w < GOL_WORDS-1 ? row[w+1] << 63 : 0);
+		for (int j = 0; j < 3; j++)
+		{
+			if (k == 1 && j == 1)
+				continue;
+			uint64_t c0 = b0 & in[j];
+			b0 ^= in[j];
+			uint64_t c1 = b1 & c0;
+			b1 ^= c0;
+			uint64_t c2 = b2 & c1;
+			b2 ^= c1;
+			b3 |= c2;
+		}
+	}
+	planes[0] = b0;
+	planes[1] = b1;
+	planes[2] = b2;
+	planes[3] = b3;
+}
+
+// cells where a 4 bit counter equals n
+static inline uint64_t gol_equals(const uint64_t planes[4], int n)
+{
+	return ((n&1) ? planes[0] : ~planes[0]) & ((n&2) ? planes[1] : ~planes[1]) & ((n&4) ? planes[2] : ~planes[2]) & ((n&8) ? planes[3] : ~planes[3]);
+}
+
+void LIFE_ElementDataContainer::Simulation_BeforeUpdate(Simulation *sim)
+{
+	//golSpeed is frames per generation
+	if (sim->elementCount[PT_LIFE] <= 0 || ++golSpeedCounter < golSpeed)
+		return;
+
+	particle *parts = sim->parts;
+	bool createdSomething = false;
+	bool present[NGOL+1];
+	int presentList[NGOL], presentCount = 0;
+	golSpeedCounter = 0;
+
+	const int size = GOL_H*GOL_WORDS;
+	if (lifeCells.empty())
+	{
+		allAlive.resize(size);
+		lifeCells.resize(size);
+		emptyCells.resize(size);
+		candidates.resize(size);
+		for (int b = 0; b < 4; b++)
+			count[b].resize(size);
+	}
+	std::fill(present, present+NGOL+1, false);
+	std::fill(lifeCells.begin(), lifeCells.end(), 0);
+
+	//go through every particle, find the fully alive ones and count down the dying ones
+	for (int cy = 0; cy < GOL_H; cy++)
+	{
+		//indexed by bit number, so pmapRow[1] is the first cell inside the border
+		const unsigned *pmapRow = &sim->pmap[cy+CELL][CELL-1];
+		for (int w = 0; w < GOL_WORDS; w++)
+		{
+			int i = cy*GOL_WORDS+w;
+			int first = std::max(w*64, 1), last = std::min(w*64+64, GOL_W+1);
+			uint64_t occupied = 0, empty = 0;
+			for (int b = first; b < last; b++)
+			{
+				occupied |= (uint64_t)(pmapRow[b] != 0) << (b&63);
+				empty |= (uint64_t)(pmapRow[b] == 0) << (b&63);
+			}
+			while (occupied)
+			{
+				int b = tpt_ctz64(occupied);
+				uint64_t bit = occupied & (~occupied+1);
+				occupied ^= bit;
+				int r = pmapRow[w*64+b];
+				if ((r&0xFF) != PT_LIFE)
+					continue;
+				unsigned char golnum = (unsigned char)(parts[r>>8].ctype+1);
+				if (golnum <= 0 || golnum > NGOL)
+				{
+					sim->part_kill(r>>8);
+					empty |= bit;
+					continue;
+				}
+				lifeCells[i] |= bit;
+				if (parts[r>>8].tmp == grule[golnum][9]-1)
+				{
+					if (!present[golnum])
+					{
+						present[golnum] = true;
+						alive[golnum].assign(size, 0);
+					}
+					alive[golnum][i] |= bit;
+				}
+				else
+					parts[r>>8].tmp--;
+			}
+			emptyCells[i] = empty;
+		}
+	}
+	for (int golnum = 1; golnum <= NGOL; golnum++)
+		if (present[golnum])
+			presentList[presentCount++] = golnum;
+
+	//number of fully alive neighbours of every cell, of any rule
+	std::fill(allAlive.begin(), allAlive.end(), 0);
+	for (int p = 0; p < presentCount; p++)
+	{
+		std::vector<uint64_t> &board = alive[presentList[p]];
+		gol_wrap(board);
+		for (int i = 0; i < size; i++)
+			allAlive[i] |= board[i];
+	}
+	for (int cy = 0; cy < GOL_H; cy++)
+	{
+		for (int w = 0; w < GOL_WORDS; w++)
+		{
+			uint64_t planes[4];
+			gol_count(allAlive, cy, w, planes);
+			for (int b = 0; b < 4; b++)
+				count[b][cy*GOL_WORDS+w] = planes[b];
+		}
+	}
+
+	//Empty cells become LIFE if the rule creates LIFE with that many neighbours, and at least half of them are that rule.
+	//If more than one rule can, the lowest rule number wins
+	std::copy(lifeCells.begin(), lifeCells.end(), candidates.begin());
+	for (int p = 0; p < presentCount; p++)
+	{
+		int golnum = presentList[p];
+		create[golnum].resize(size);
+		for (int cy = 0; cy < GOL_H; cy++)
+		{
+			for (int w = 0; w < GOL_WORDS; w++)
+			{
+				int i = cy*GOL_WORDS+w;
+				uint64_t total[4] = { count[0][i], count[1][i], count[2][i], count[3][i] };
+				uint64_t own[4], atLeast[5];
+				gol_count(alive[golnum], cy, w, own);
+				atLeast[1] = own[0] | own[1] | own[2] | own[3];
+				atLeast[2] = own[1] | own[2] | own[3];
+				atLeast[3] = (own[0] & own[1]) | own[2] | own[3];
+				atLeast[4] = own[2] | own[3];
+				uint64_t spawn = 0;
+				for (int n = 1; n <= 8; n++)
+					if (grule[golnum][n] >= 2)
+						spawn |= gol_equals(total, n) & atLeast[(n+1)/2];
+				spawn &= emptyCells[i] & ~candidates[i];
+				create[golnum][i] = spawn;
+				candidates[i] |= spawn;
+			}
+		}
+	}
+
+	//go through those cells and all LIFE in the same order as the first pass, then update particles
+	for (int cy = 0; cy < GOL_H; cy++)
+	{
+		for (int w = 0; w < GOL_WORDS; w++)
+		{
+			int i = cy*GOL_WORDS+w;
+			uint64_t bits = candidates[i];
+			while (bits)
+			{
+				int b = tpt_ctz64(bits);
+				uint64_t bit = bits & (~bits+1);
+				bits ^= bit;
+				int cx = w*64+b-1;
+				int r = sim->pmap[cy+CELL][cx+CELL];
+				if (!r)
+				{
+					int creategol = 0;
+					for (int p = 0; p < presentCount && !creategol; p++)
+						if (create[presentList[p]][i] & bit)
+							creategol = presentList[p];
+					if (creategol && sim->part_create(-1, cx+CELL, cy+CELL, PT_LIFE, creategol-1) > -1)
+						createdSomething = true;
+				}
+				else if ((r&0xFF) == PT_LIFE)
+				{
+					int golnum = (unsigned char)(parts[r>>8].ctype+1);
+					int neighbors = (int)((count[0][i]>>b)&1) | (int)((count[1][i]>>b)&1)<<1 | (int)((count[2][i]>>b)&1)<<2 | (int)((count[3][i]>>b)&1)<<3;
+					//fully alive cells also count themselves
+					if (allAlive[i] & bit)
+						neighbors++;
+					//subtract 1 because it counted itself
+					if (neighbors && (grule[golnum][neighbors-1] == 0 || grule[golnum][neighbors-1] == 2))
+					{
+						if (parts[r>>8].tmp == grule[golnum][9]-1)
+							parts[r>>8].tmp--;
+					}
+					//we still need to kill things with 0 neighbors (higher state life)
+					if (parts[r>>8].tmp <= 0)
+						sim->part_kill(r>>8);
+				}
+			}
+		}
+	}
+	if (createdSomething)
+		golGeneration++;
+}
 
 int LIFE_update(UPDATE_FUNC_ARGS)
 {
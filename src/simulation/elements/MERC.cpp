@@ -20,7 +20,7 @@ int MERC_update(UPDATE_FUNC_ARGS)
 	int r;
 	const int absorbScale = 10000; // max number of particles that can be condensed into one
 	int maxtmp = ((absorbScale/(parts[i].temp + 1))-1);
-	if ((absorbScale%((int)parts[i].temp+1))>rand()%((int)parts[i].temp+1))
+	if ((absorbScale%((int)parts[i].temp+1))>tpt_rand()%((int)parts[i].temp+1))
 		maxtmp++;
 	if (parts[i].tmp < 0)
 		parts[i].tmp = 0;
@@ -36,7 +36,7 @@ int MERC_update(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r || (parts[i].tmp >= maxtmp))
 						continue;
-					if ((r&0xFF)==PT_MERC && !(rand()%3))
+					if ((r&0xFF)==PT_MERC && !(tpt_rand()%3))
 					{
 						if ((parts[i].tmp + parts[r>>8].tmp + 1) <= maxtmp)
 						{
@@ -67,8 +67,8 @@ int MERC_update(UPDATE_FUNC_ARGS)
 				}
 	for (int trade = 0; trade < 4; trade ++)
 	{
-		int rx = rand()%5-2;
-		int ry = rand()%5-2;
+		int rx = tpt_rand()%5-2;
+		int ry = tpt_rand()%5-2;
 		if (BOUNDS_CHECK && (rx || ry))
 		{
 			r = pmap[y+ry][x+rx];
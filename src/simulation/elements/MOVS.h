@@ -125,6 +125,14 @@ public:
 		return creatingSolid != 0;
 	}
 
+	virtual void Simulation_ParticlesMoved(Simulation *sim, const int *newIndex)
+	{
+		// index is the center particle's index + 1
+		for (int bn = 0; bn < numBalls; bn++)
+			if (movingSolids[bn].index > 0 && movingSolids[bn].index <= NPART)
+				movingSolids[bn].index = newIndex[movingSolids[bn].index-1]+1;
+	}
+
 	virtual void Simulation_BeforeUpdate(Simulation *sim)
 	{
 		creatingSolid = 0;
@@ -136,18 +144,18 @@ public:
 			return;
 		for (int i = 0; i <= sim->parts_lastActiveIndex; i++)
 		{
-			if (parts[i].flags&FLAG_DISAPPEAR)
+			if (sim->parts[i].flags&FLAG_DISAPPEAR)
 			{
 				sim->part_kill(i);
 			}
-			else if (parts[i].type == PT_MOVS)
+			else if (sim->parts[i].type == PT_MOVS)
 			{
-				MovingSolid *movingSolid = GetMovingSolid(parts[i].tmp2);
+				MovingSolid *movingSolid = GetMovingSolid(sim->parts[i].tmp2);
 				if (!movingSolid || !movingSolid->index)
 					continue;
 
-				movingSolid->vx = movingSolid->vx + parts[i].vx;
-				movingSolid->vy = movingSolid->vy + parts[i].vy;
+				movingSolid->vx = movingSolid->vx + sim->parts[i].vx;
+				movingSolid->vy = movingSolid->vy + sim->parts[i].vy;
 			}
 		}
 		for (int bn = 0; bn < numBalls; bn++)
@@ -166,9 +174,9 @@ public:
 			case 1:
 				break;
 			case 2:
-				float pGravD = 0.01f - hypotf((parts[movingSolid->index-1].x - XCNTR), (parts[movingSolid->index-1].y - YCNTR));
-				movingSolid->vx = movingSolid->vx + .2f * ((parts[movingSolid->index-1].x - XCNTR) / pGravD);
-				movingSolid->vy = movingSolid->vy + .2f * ((parts[movingSolid->index-1].y - YCNTR) / pGravD);
+				float pGravD = 0.01f - hypotf((sim->parts[movingSolid->index-1].x - XCNTR), (sim->parts[movingSolid->index-1].y - YCNTR));
+				movingSolid->vx = movingSolid->vx + .2f * ((sim->parts[movingSolid->index-1].x - XCNTR) / pGravD);
+				movingSolid->vy = movingSolid->vy + .2f * ((sim->parts[movingSolid->index-1].y - YCNTR) / pGravD);
 				break;
 			}
 			movingSolid->rotationOld = movingSolid->rotation;
@@ -187,41 +195,41 @@ public:
 		}
 		for (int i = 0; i <= sim->parts_lastActiveIndex; i++)
 		{
-			if (parts[i].type == PT_MOVS)
+			if (sim->parts[i].type == PT_MOVS)
 			{
-				MovingSolid *movingSolid = GetMovingSolid(parts[i].tmp2);
-				if (!movingSolid || (parts[i].flags&FLAG_DISAPPEAR))
+				MovingSolid *movingSolid = GetMovingSolid(sim->parts[i].tmp2);
+				if (!movingSolid || (sim->parts[i].flags&FLAG_DISAPPEAR))
 					continue;
 				if (movingSolid->index)
 				{
-					float tmp = parts[i].pavg[0];
-					float tmp2 = parts[i].pavg[1];
+					float tmp = sim->parts[i].pavg[0];
+					float tmp2 = sim->parts[i].pavg[1];
 					if (sim->msRotation)
 						rotate(&tmp, &tmp2, movingSolid->rotationOld);
-					float nx = parts[movingSolid->index-1].x + tmp;
-					float ny = parts[movingSolid->index-1].y + tmp2;
-					sim->Move(i,(int)(parts[i].x+.5f),(int)(parts[i].y+.5f),nx,ny);
+					float nx = sim->parts[movingSolid->index-1].x + tmp;
+					float ny = sim->parts[movingSolid->index-1].y + tmp2;
+					sim->Move(i,(int)(sim->parts[i].x+.5f),(int)(sim->parts[i].y+.5f),nx,ny);
 
 					if (sim->msRotation)
 					{
 						rotate(&tmp, &tmp2, .02f);
-						if (parts[movingSolid->index-1].x + tmp != nx || parts[movingSolid->index-1].y + tmp2 != ny)
+						if (sim->parts[movingSolid->index-1].x + tmp != nx || sim->parts[movingSolid->index-1].y + tmp2 != ny)
 						{
-							int j = sim->part_create(-1, (int)(parts[movingSolid->index-1].x + tmp), (int)(parts[movingSolid->index-1].y + tmp2), parts[i].type);
+							int j = sim->part_create(-1, (int)(sim->parts[movingSolid->index-1].x + tmp), (int)(sim->parts[movingSolid->index-1].y + tmp2), sim->parts[i].type);
 							if (j >= 0)
 							{
-								parts[j].flags |= FLAG_DISAPPEAR;
-								parts[j].tmp2 = parts[i].tmp2;
-								parts[j].dcolour = parts[i].dcolour;
+								sim->parts[j].flags |= FLAG_DISAPPEAR;
+								sim->parts[j].tmp2 = sim->parts[i].tmp2;
+								sim->parts[j].dcolour = sim->parts[i].dcolour;
 							}
 						}
 					}
 
-					parts[i].vx = movingSolid->vx;
-					parts[i].vy = movingSolid->vy;
+					sim->parts[i].vx = movingSolid->vx;
+					sim->parts[i].vy = movingSolid->vy;
 				}
-				if (sim->OutOfBounds((int)(parts[i].x+.5f), (int)(parts[i].y+.5f)))//kill_part if particle is out of bounds
-					kill_part(i);
+				if (sim->OutOfBounds((int)(sim->parts[i].x+.5f), (int)(sim->parts[i].y+.5f)))//kill_part if particle is out of bounds
+					sim->part_kill(i);
 			}
 		}
 		for (int bn = 0; bn < numBalls; bn++)
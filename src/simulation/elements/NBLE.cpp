@@ -20,7 +20,7 @@ int NBLE_update(UPDATE_FUNC_ARGS)
 	if (parts[i].temp > 5273.15 && sim->air->pv[y/CELL][x/CELL] > 100.0f)
 	{
 		parts[i].tmp |= 0x1;
-		if (!(rand()%5))
+		if (!(tpt_rand()%5))
 		{
 			int j;
 			float temp = parts[i].temp;
@@ -29,7 +29,7 @@ int NBLE_update(UPDATE_FUNC_ARGS)
 			j = sim->part_create(-3,x,y,PT_NEUT);
 			if (j != -1)
 				parts[j].temp = temp;
-			if (!(rand()%25))
+			if (!(tpt_rand()%25))
 			{
 				j = sim->part_create(-3,x,y,PT_ELEC);
 				if (j != -1)
@@ -43,7 +43,7 @@ int NBLE_update(UPDATE_FUNC_ARGS)
 				parts[j].tmp = 0x1;
 			}
 
-			int rx = x+rand()%3-1, ry = y+rand()%3-1, rt = pmap[ry][rx]&0xFF;
+			int rx = x+tpt_rand()%3-1, ry = y+tpt_rand()%3-1, rt = pmap[ry][rx]&0xFF;
 			if (sim->can_move[PT_PLSM][rt] || rt == PT_NBLE)
 			{
 				j = sim->part_create(-3,rx,ry,PT_PLSM);
@@ -54,7 +54,7 @@ int NBLE_update(UPDATE_FUNC_ARGS)
 				}
 			}
 
-			parts[i].temp = temp+1750+rand()%500;
+			parts[i].temp = temp+1750+tpt_rand()%500;
 			sim->air->pv[y/CELL][x/CELL] += 50;
 		}
 	}
@@ -50,7 +50,7 @@ int NEUT_update(UPDATE_FUNC_ARGS)
 				switch (r&0xFF)
 				{
 				case PT_WATR:
-					if (3>(rand()%20))
+					if (3>(tpt_rand()%20))
 						part_change_type(r>>8, x+rx, y+ry, PT_DSTW);
 					//no break
 				case PT_ICEI:
@@ -59,11 +59,11 @@ int NEUT_update(UPDATE_FUNC_ARGS)
 					parts[i].vy *= 0.995f;
 					break;
 				case PT_PLUT:
-					if (pressureFactor>(rand()%1000))
+					if (pressureFactor>(tpt_rand()%1000))
 					{
-						if (!(rand()%3))
+						if (!(tpt_rand()%3))
 						{
-							sim->part_create(r>>8, x+rx, y+ry, rand()%3 ? PT_LAVA : PT_URAN);
+							sim->part_create(r>>8, x+rx, y+ry, tpt_rand()%3 ? PT_LAVA : PT_URAN);
 							parts[r>>8].temp = MAX_TEMP;
 							if (parts[r>>8].type == PT_LAVA)
 							{
@@ -83,7 +83,7 @@ int NEUT_update(UPDATE_FUNC_ARGS)
 					break;
 #ifdef SDEUT
 				case PT_DEUT:
-					if (pressureFactor+1+(parts[r>>8].life/100) > rand()%1000)
+					if (pressureFactor+1+(parts[r>>8].life/100) > tpt_rand()%1000)
 					{
 						DeutExplosion(sim, parts[r>>8].life, x+rx, y+ry, restrict_flt(parts[r>>8].temp + parts[r>>8].life*500.0f, MIN_TEMP, MAX_TEMP), PT_NEUT);
 						sim->part_kill(r>>8);
@@ -91,7 +91,7 @@ int NEUT_update(UPDATE_FUNC_ARGS)
 					break;
 #else
 				case PT_DEUT:
-					if (pressureFactor+1 > rand()%1000)
+					if (pressureFactor+1 > tpt_rand()%1000)
 					{
 						sim->part_create(r>>8, x+rx, y+ry, PT_NEUT);
 						parts[r>>8].vx = 0.25f*parts[r>>8].vx + parts[i].vx;
@@ -108,70 +108,70 @@ int NEUT_update(UPDATE_FUNC_ARGS)
 					break;
 #endif
 				case PT_GUNP:
-					if (3>(rand()%200))
+					if (3>(tpt_rand()%200))
 						sim->part_change_type(r>>8, x+rx, y+ry, PT_DUST);
 					break;
 				case PT_DYST:
-					if (3>(rand()%200))
+					if (3>(tpt_rand()%200))
 						sim->part_change_type(r>>8, x+rx, y+ry, PT_YEST);
 					break;
 				case PT_YEST:
 					sim->part_change_type(r>>8, x+rx, y+ry, PT_DYST);
 					break;
 				case PT_PLEX:
-					if (3>(rand()%200))
+					if (3>(tpt_rand()%200))
 						sim->part_change_type(r>>8, x+rx, y+ry, PT_GOO);
 					break;
 				case PT_NITR:
-					if (3>(rand()%200))
+					if (3>(tpt_rand()%200))
 						sim->part_change_type(r>>8, x+rx, y+ry, PT_DESL);
 					break;
 				case PT_PLNT:
-					if (!(rand()%20))
+					if (!(tpt_rand()%20))
 						sim->part_create(r>>8, x+rx, y+ry, PT_WOOD);
 					break;
 				case PT_DESL:
 				case PT_OIL:
-					if (3>(rand()%200))
+					if (3>(tpt_rand()%200))
 						sim->part_change_type(r>>8, x+rx, y+ry, PT_GAS);
 					break;
 				case PT_COAL:
-					if (!(rand()%20))
+					if (!(tpt_rand()%20))
 						sim->part_create(r>>8, x+rx, y+ry, PT_WOOD);
 					break;
 				case PT_BCOL:
-					if (!(rand()%20))
+					if (!(tpt_rand()%20))
 						sim->part_create(r>>8, x+rx, y+ry, PT_SAWD);
 					break;
 				case PT_DUST:
-					if (!(rand()%20))
+					if (!(tpt_rand()%20))
 						sim->part_change_type(r>>8, x+rx, y+ry, PT_FWRK);
 					break;
 				case PT_EMBR:
-					if (parts[i].tmp == 1 && !(rand()%20))
+					if (parts[i].tmp == 1 && !(tpt_rand()%20))
 						sim->part_change_type(r>>8, x+rx, y+ry, PT_FWRK);
 					break;
 				case PT_FWRK:
-					if (!(rand()%20))
+					if (!(tpt_rand()%20))
 						parts[r>>8].ctype = PT_DUST;
 					break;
 				case PT_ACID:
-					if (!(rand()%20))
+					if (!(tpt_rand()%20))
 						sim->part_create(r>>8, x+rx, y+ry, PT_ISOZ);
 					break;
 				case PT_TTAN:
-					if (!(rand()%20))
+					if (!(tpt_rand()%20))
 					{
 						kill_part(i);
 						return 1;
 					}
 					break;
 				case PT_EXOT:
-					if (5>(rand()%100))
+					if (5>(tpt_rand()%100))
 						parts[r>>8].life = 1500;
 					break;
 				case PT_RFRG:
-					if (rand()%2)
+					if (tpt_rand()%2)
 						sim->part_create(r>>8, x+rx, y+ry, PT_GAS);
 					else
 						sim->part_create(r>>8, x+rx, y+ry, PT_CAUS);
@@ -197,9 +197,9 @@ int NEUT_graphics(GRAPHICS_FUNC_ARGS)
 
 void NEUT_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	float r = (rand()%128+128)/127.0f;
-	float a = (rand()%360)*3.14159f/180.0f;
-	sim->parts[i].life = rand()%480+480;
+	float r = (tpt_rand()%128+128)/127.0f;
+	float a = (tpt_rand()%360)*3.14159f/180.0f;
+	sim->parts[i].life = tpt_rand()%480+480;
 	sim->parts[i].vx = r*cosf(a);
 	sim->parts[i].vy = r*sinf(a);
 }
@@ -30,26 +30,26 @@ int O2_update(UPDATE_FUNC_ARGS)
 
 				if ((r&0xFF)==PT_FIRE)
 				{
-					parts[r>>8].temp += (rand()%100);
+					parts[r>>8].temp += (tpt_rand()%100);
 					if (parts[r>>8].tmp & 0x01)
 						parts[r>>8].temp=3473;
 					parts[r>>8].tmp |= 2;
 
 					sim->part_create(i,x,y,PT_FIRE);
-					parts[i].temp+=(rand()/(RAND_MAX/100));
+					parts[i].temp+=(tpt_rand()/(RAND_MAX/100));
 					parts[i].tmp |= 2;
 				}
 				else if ((r&0xFF)==PT_PLSM && !(parts[r>>8].tmp&4))
 				{
 					sim->part_create(i,x,y,PT_FIRE);
-					parts[i].temp+=(rand()/(RAND_MAX/100));
+					parts[i].temp+=(tpt_rand()/(RAND_MAX/100));
 					parts[i].tmp |= 2;
 				}
 			}
 
 	if (parts[i].temp > 9973.15 && sim->air->pv[y/CELL][x/CELL] > 250.0f && fabsf(gravx[((y/CELL)*(XRES/CELL))+(x/CELL)]) + fabsf(gravy[((y/CELL)*(XRES/CELL))+(x/CELL)]) > 20)
 	{
-		if (!(rand()%5))
+		if (!(tpt_rand()%5))
 		{
 			int j;
 			sim->part_create(i,x,y,PT_BRMT);
@@ -63,7 +63,7 @@ int O2_update(UPDATE_FUNC_ARGS)
 				parts[j].temp = MAX_TEMP;
 				parts[j].tmp = 0x1;
 			}
-			int rx = x+rand()%3-1, ry = y+rand()%3-1, rt = pmap[ry][rx]&0xFF;
+			int rx = x+tpt_rand()%3-1, ry = y+tpt_rand()%3-1, rt = pmap[ry][rx]&0xFF;
 			if (sim->can_move[PT_PLSM][rt] || rt == PT_O2)
 			{
 				j = sim->part_create(-3,rx,ry,PT_PLSM);
@@ -20,7 +20,7 @@
 int PBCN_update(UPDATE_FUNC_ARGS)
 {
 	if (!parts[i].tmp2 && sim->air->pv[y/CELL][x/CELL] > 4.0f)
-		parts[i].tmp2 = rand()%40+80;
+		parts[i].tmp2 = tpt_rand()%40+80;
 	if (parts[i].tmp2)
 	{
 		parts[i].vx += ADVECTION * sim->air->vx[y/CELL][x/CELL];
@@ -85,9 +85,9 @@ int PBCN_update(UPDATE_FUNC_ARGS)
 					sim->part_create(-1, x+rx, y+ry, PT_LIFE, parts[i].tmp);
 				}
 		}
-		else if (parts[i].ctype != PT_LIGH || !(rand()%30))
+		else if (parts[i].ctype != PT_LIGH || !(tpt_rand()%30))
 		{
-			int np = sim->part_create(-1, x+rand()%3-1, y+rand()%3-1, parts[i].ctype&0xFF);
+			int np = sim->part_create(-1, x+tpt_rand()%3-1, y+tpt_rand()%3-1, parts[i].ctype&0xFF);
 			if (np >= 0)
 			{
 				if (parts[i].ctype==PT_LAVA && parts[i].tmp>0 && parts[i].tmp<PT_NUM && sim->elements[parts[i].tmp].HighTemperatureTransitionElement==PT_LAVA)
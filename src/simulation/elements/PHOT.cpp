@@ -27,7 +27,7 @@ int PHOT_update(UPDATE_FUNC_ARGS)
 		return 1;
 	}
 	if (parts[i].temp > 506.0f)
-		if (!(rand()%10)) FIRE_update(UPDATE_FUNC_SUBCALL_ARGS);
+		if (!(tpt_rand()%10)) FIRE_update(UPDATE_FUNC_SUBCALL_ARGS);
 
 	for (rx=-1; rx<2; rx++)
 		for (ry=-1; ry<2; ry++)
@@ -38,16 +38,16 @@ int PHOT_update(UPDATE_FUNC_ARGS)
 					continue;
 				if ((r&0xFF)==PT_ISOZ || (r&0xFF)==PT_ISZS)
 				{
-					if (!(rand()%400))
+					if (!(tpt_rand()%400))
 					{
 						parts[i].vx *= 0.90f;
 						parts[i].vy *= 0.90f;
 						sim->part_create(r>>8, x+rx, y+ry, PT_PHOT);
-						rrr = (rand()%360)*M_PI/180.0f;
+						rrr = (tpt_rand()%360)*M_PI/180.0f;
 						if ((r&0xFF) == PT_ISOZ)
-							rr = (rand()%128+128)/127.0f;
+							rr = (tpt_rand()%128+128)/127.0f;
 						else
-							rr = (rand()%228+128)/127.0f;
+							rr = (tpt_rand()%228+128)/127.0f;
 						parts[r>>8].vx = rr*cosf(rrr);
 						parts[r>>8].vy = rr*sinf(rrr);
 						sim->air->pv[y/CELL][x/CELL] -= 15.0f * CFDS;
@@ -57,11 +57,11 @@ int PHOT_update(UPDATE_FUNC_ARGS)
 				{
 					if (!ry && !rx)
 					{
-						float a = (rand()%360)*M_PI/180.0f;
+						float a = (tpt_rand()%360)*M_PI/180.0f;
 						parts[i].vx = 3.0f*cosf(a);
 						parts[i].vy = 3.0f*sinf(a);
 						if (parts[i].ctype == 0x3FFFFFFF)
-							parts[i].ctype = 0x1F<<(rand()%26);
+							parts[i].ctype = 0x1F<<(tpt_rand()%26);
 						if (parts[i].life)
 							parts[i].life++; //Delay death
 					}
@@ -70,7 +70,7 @@ int PHOT_update(UPDATE_FUNC_ARGS)
 				{
 					if (!ry && !rx)
 					{
-						float a = (rand()%101 - 50) * 0.001f;
+						float a = (tpt_rand()%101 - 50) * 0.001f;
 						float rx = cosf(a), ry = sinf(a), vx, vy;
 						vx = rx * parts[i].vx + ry * parts[i].vy;
 						vy = rx * parts[i].vy - ry * parts[i].vx;
@@ -82,8 +82,8 @@ int PHOT_update(UPDATE_FUNC_ARGS)
 				{
 					if (parts[r>>8].tmp == 9)
 					{
-						parts[i].vx += ((float)(rand()%1000-500))/1000.0f;
-						parts[i].vy += ((float)(rand()%1000-500))/1000.0f;
+						parts[i].vx += ((float)(tpt_rand()%1000-500))/1000.0f;
+						parts[i].vy += ((float)(tpt_rand()%1000-500))/1000.0f;
 					}
 				}
 			}
@@ -122,7 +122,7 @@ int PHOT_graphics(GRAPHICS_FUNC_ARGS)
 
 void PHOT_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	float a = (rand()%8) * 0.78540f;
+	float a = (tpt_rand()%8) * 0.78540f;
 	sim->parts[i].vx = 3.0f*cosf(a);
 	sim->parts[i].vy = 3.0f*sinf(a);
 	if ((pmap[y][x]&0xFF) == PT_FILT)
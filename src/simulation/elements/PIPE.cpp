@@ -14,6 +14,7 @@
  */
 
 #include "simulation/ElementsCommon.h"
+#include "simulation/CoordStack.h"
 #include "simulation/elements/PPIP.h"
 #include "simulation/elements/PRTI.h"
 #include "graphics.h"
@@ -42,9 +43,6 @@ signed char pos_1_ry[] = {-1, 0, 1,-1, 1,-1, 0, 1};
 
 void PPIP_flood_trigger(Simulation* sim, int x, int y, int sparkedBy)
 {
-	int coord_stack_limit = XRES*YRES;
-	unsigned short (*coord_stack)[2];
-	int coord_stack_size = 0;
 	int x1, x2;
 
 	// Separate flags for on and off in case PPIP is sparked by PSCN and NSCN on the same frame
@@ -54,77 +52,61 @@ void PPIP_flood_trigger(Simulation* sim, int x, int y, int sparkedBy)
 	else if (sparkedBy==PT_NSCN) prop = PPIP_TMPFLAG_TRIGGER_OFF << 3;
 	else if (sparkedBy==PT_INST) prop = PPIP_TMPFLAG_TRIGGER_REVERSE << 3;
 
-	if (prop==0 || (pmap[y][x]&0xFF)!=PT_PPIP || (parts[pmap[y][x]>>8].tmp & prop))
+	if (prop==0 || (sim->pmap[y][x]&0xFF)!=PT_PPIP || (sim->parts[sim->pmap[y][x]>>8].tmp & prop))
 		return;
 
-	coord_stack = (unsigned short(*)[2])malloc(sizeof(unsigned short)*2*coord_stack_limit);
-	coord_stack[coord_stack_size][0] = x;
-	coord_stack[coord_stack_size][1] = y;
-	coord_stack_size++;
-
-	do
+	try
 	{
-		coord_stack_size--;
-		x = coord_stack[coord_stack_size][0];
-		y = coord_stack[coord_stack_size][1];
-		x1 = x2 = x;
-		// go left as far as possible
-		while (x1>=CELL)
-		{
-			if ((pmap[y][x1-1]&0xFF)!=PT_PPIP)
-			{
-				break;
-			}
-			x1--;
-		}
-		// go right as far as possible
-		while (x2<XRES-CELL)
+		CoordStack cs;
+		cs.push(x, y);
+
+		do
 		{
-			if ((pmap[y][x2+1]&0xFF)!=PT_PPIP)
+			cs.pop(x, y);
+			x1 = x2 = x;
+			// go left as far as possible
+			while (x1>=CELL)
 			{
-				break;
-			}
-			x2++;
-		}
-		// fill span
-		for (x=x1; x<=x2; x++)
-		{
-			if (!(parts[pmap[y][x]>>8].tmp & prop))
-				((PPIP_ElementDataContainer*)sim->elementData[PT_PPIP])->ppip_changed = 1;
-			parts[pmap[y][x]>>8].tmp |= prop;
-		}
-
-		// add adjacent pixels to stack
-		// +-1 to x limits to include diagonally adjacent pixels
-		// Don't need to check x bounds here, because already limited to [CELL, XRES-CELL]
-		if (y>=CELL+1)
-			for (x=x1-1; x<=x2+1; x++)
-				if ((pmap[y-1][x]&0xFF)==PT_PPIP && !(parts[pmap[y-1][x]>>8].tmp & prop))
+				if ((sim->pmap[y][x1-1]&0xFF)!=PT_PPIP)
 				{
-					coord_stack[coord_stack_size][0] = x;
-					coord_stack[coord_stack_size][1] = y-1;
-					coord_stack_size++;
-					if (coord_stack_size>=coord_stack_limit)
-					{
-						free(coord_stack);
-						return;
-					}
+					break;
 				}
-		if (y<YRES-CELL-1)
-			for (x=x1-1; x<=x2+1; x++)
-				if ((pmap[y+1][x]&0xFF)==PT_PPIP && !(parts[pmap[y+1][x]>>8].tmp & prop))
+				x1--;
+			}
+			// go right as far as possible
+			while (x2<XRES-CELL)
+			{
+				if ((sim->pmap[y][x2+1]&0xFF)!=PT_PPIP)
 				{
-					coord_stack[coord_stack_size][0] = x;
-					coord_stack[coord_stack_size][1] = y+1;
-					coord_stack_size++;
-					if (coord_stack_size>=coord_stack_limit)
-					{
-						free(coord_stack);
-						return;
-					}
+					break;
 				}
-	} while (coord_stack_size>0);
-	free(coord_stack);
+				x2++;
+			}
+			// fill span
+			for (x=x1; x<=x2; x++)
+			{
+				if (!(sim->parts[sim->pmap[y][x]>>8].tmp & prop))
+					((PPIP_ElementDataContainer*)sim->elementData[PT_PPIP])->ppip_changed = 1;
+				sim->parts[sim->pmap[y][x]>>8].tmp |= prop;
+			}
+
+			// add adjacent pixels to stack
+			// +-1 to x limits to include diagonally adjacent pixels
+			// Don't need to check x bounds here, because already limited to [CELL, XRES-CELL]
+			if (y>=CELL+1)
+				for (x=x1-1; x<=x2+1; x++)
+					if ((sim->pmap[y-1][x]&0xFF)==PT_PPIP && !(sim->parts[sim->pmap[y-1][x]>>8].tmp & prop))
+						cs.push(x, y-1);
+			if (y<YRES-CELL-1)
+				for (x=x1-1; x<=x2+1; x++)
+					if ((sim->pmap[y+1][x]&0xFF)==PT_PPIP && !(sim->parts[sim->pmap[y+1][x]>>8].tmp & prop))
+						cs.push(x, y+1);
+		} while (cs.getSize()>0);
+	}
+	catch (const CoordStackOverflowException& e)
+	{
+		(void)e; //ignore compiler warning
+	}
 }
 
 void PIPE_transfer_pipe_to_part(particle *pipe, particle *part)
@@ -177,7 +159,7 @@ void pushParticle(Simulation *sim, int i, int count, int original)
 	if( !(parts[i].tmp&0x200) )
 	{ 
 		//normal random push
-		rndstore = rand();
+		rndstore = tpt_rand();
 		// RAND_MAX is at least 32767 on all platforms i.e. pow(8,5)-1
 		// so can go 5 cycles without regenerating rndstore
 		for (q=0; q<3; q++)//try to push 3 times
@@ -203,10 +185,11 @@ void pushParticle(Simulation *sim, int i, int count, int original)
 				{
 					PortalChannel *channel = ((PRTI_ElementDataContainer*)sim->elementData[PT_PRTI])->GetParticleChannel(sim, r>>8);
 					int slot = PRTI_ElementDataContainer::GetSlot(-rx, -ry);
-					particle *storePart = channel->AllocParticle(slot);
-					if (storePart)
+					if (!channel->IsFull(slot))
 					{
-						PIPE_transfer_pipe_to_part(parts+i, storePart);
+						particle storePart = particle();
+						PIPE_transfer_pipe_to_part(parts+i, &storePart);
+						channel->StoreParticle(storePart, slot);
 						count++;
 						break;
 					}
@@ -230,10 +213,11 @@ void pushParticle(Simulation *sim, int i, int count, int original)
 		{
 			PortalChannel *channel = ((PRTI_ElementDataContainer*)sim->elementData[PT_PRTI])->GetParticleChannel(sim, r>>8);
 			int slot = PRTI_ElementDataContainer::GetSlot(-pos_1_rx[coords], -pos_1_ry[coords]);
-			particle *storePart = channel->AllocParticle(slot);
-			if (storePart)
+			if (!channel->IsFull(slot))
 			{
-				PIPE_transfer_pipe_to_part(parts+i, storePart);
+				particle storePart = particle();
+				PIPE_transfer_pipe_to_part(parts+i, &storePart);
+				channel->StoreParticle(storePart, slot);
 				count++;
 			}
 		}
@@ -366,7 +350,7 @@ int PIPE_update(UPDATE_FUNC_ARGS)
 
 			if (nt)//there is something besides PIPE around current particle
 			{
-				rndstore = rand();
+				rndstore = tpt_rand();
 				rnd = rndstore&7;
 				rndstore = rndstore>>3;
 				rx = pos_1_rx[rnd];
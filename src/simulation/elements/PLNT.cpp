@@ -26,7 +26,7 @@ int PLNT_update(UPDATE_FUNC_ARGS)
 				switch (r&0xFF)
 				{
 				case PT_WATR:
-					if (!(rand()%50))
+					if (!(tpt_rand()%50))
 					{
 						np = sim->part_create(r>>8, x+rx, y+ry, PT_PLNT);
 						if (np<0) continue;
@@ -34,7 +34,7 @@ int PLNT_update(UPDATE_FUNC_ARGS)
 					}
 					break;
 				case PT_LAVA:
-					if (!(rand()%50))
+					if (!(tpt_rand()%50))
 					{
 						part_change_type(i, x, y, PT_FIRE);
 						parts[i].life = 4;
@@ -42,14 +42,14 @@ int PLNT_update(UPDATE_FUNC_ARGS)
 					break;
 				case PT_SMKE:
 				case PT_CO2:
-					if (!(rand()%50))
+					if (!(tpt_rand()%50))
 					{
 						kill_part(r>>8);
-						parts[i].life = rand()%60 + 60;
+						parts[i].life = tpt_rand()%60 + 60;
 					}
 					break;
 				case PT_WOOD:
-					rndstore = rand();
+					rndstore = tpt_rand();
 					if (surround_space && abs(rx+ry)<=2 && parts[i].tmp==1 && !(rndstore%4))
 					{
 						rndstore >>= 3;
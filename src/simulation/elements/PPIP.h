@@ -21,10 +21,10 @@ public:
 		{
 			for (int i = 0; i <= sim->parts_lastActiveIndex; i++)
 			{
-				if (parts[i].type == PT_PPIP)
+				if (sim->parts[i].type == PT_PPIP)
 				{
-					parts[i].tmp |= (parts[i].tmp&0xE0000000)>>3;
-					parts[i].tmp &= ~0xE0000000;
+					sim->parts[i].tmp |= (sim->parts[i].tmp&0xE0000000)>>3;
+					sim->parts[i].tmp &= ~0xE0000000;
 				}
 			}
 			ppip_changed = false;
@@ -56,7 +56,7 @@ int PROT_update(UPDATE_FUNC_ARGS)
 		break;
 	}
 	case PT_DEUT:
-		if ((-((int)sim->air->pv[y/CELL][x/CELL]-4)+(parts[under>>8].life/100)) > rand()%200)
+		if ((-((int)sim->air->pv[y/CELL][x/CELL]-4)+(parts[under>>8].life/100)) > tpt_rand()%200)
 		{
 			DeutImplosion(sim, parts[under>>8].life, x, y, restrict_flt(parts[under>>8].temp + parts[under>>8].life*500, MIN_TEMP, MAX_TEMP), PT_PROT);
 			kill_part(under>>8);
@@ -64,7 +64,7 @@ int PROT_update(UPDATE_FUNC_ARGS)
 		break;
 	case PT_LCRY:
 		//Powered LCRY reaction: PROT->PHOT
-		if (parts[under>>8].life > 5 && !(rand() % 10))
+		if (parts[under>>8].life > 5 && !(tpt_rand() % 10))
 		{
 			part_change_type(i, x, y, PT_PHOT);
 			parts[i].life *= 2;
@@ -126,7 +126,7 @@ int PROT_update(UPDATE_FUNC_ARGS)
 			element = PT_CO2;
 		else
 			element = PT_NBLE;
-		newID = sim->part_create(-1, x+rand()%3-1, y+rand()%3-1, element);
+		newID = sim->part_create(-1, x+tpt_rand()%3-1, y+tpt_rand()%3-1, element);
 		if (newID >= 0)
 			parts[newID].temp = restrict_flt(100.0f*parts[i].tmp, MIN_TEMP, MAX_TEMP);
 		kill_part(i);
@@ -165,7 +165,7 @@ int PROT_graphics(GRAPHICS_FUNC_ARGS)
 
 void PROT_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	float a = (rand()%36)* 0.17453f;
+	float a = (tpt_rand()%36)* 0.17453f;
 	sim->parts[i].life = 680;
 	sim->parts[i].vx = 2.0f*cosf(a);
 	sim->parts[i].vy = 2.0f*sinf(a);
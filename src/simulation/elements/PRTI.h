@@ -25,60 +25,138 @@
 extern const int portal_rx[8];
 extern const int portal_ry[8];
 
+// The parts of a particle that survive being stored in a portal. The position is replaced by
+// the PRTO position when it comes out, so it isn't kept
+struct PortalParticle
+{
+	int type;
+	int life, ctype;
+	float vx, vy;
+	float temp;
+	float pavg[2];
+	int flags;
+	int tmp;
+	int tmp2;
+	ARGBColour dcolour;
+
+	void Load(const particle &p)
+	{
+		type = p.type;
+		life = p.life;
+		ctype = p.ctype;
+		vx = p.vx;
+		vy = p.vy;
+		temp = p.temp;
+		pavg[0] = p.pavg[0];
+		pavg[1] = p.pavg[1];
+		flags = p.flags;
+		tmp = p.tmp;
+		tmp2 = p.tmp2;
+		dcolour = p.dcolour;
+	}
+	// Copies everything except the position into p
+	void Unload(particle &p) const
+	{
+		p.type = type;
+		p.life = life;
+		p.ctype = ctype;
+		p.vx = vx;
+		p.vy = vy;
+		p.temp = temp;
+		p.pavg[0] = pavg[0];
+		p.pavg[1] = pavg[1];
+		p.flags = flags;
+		p.tmp = tmp;
+		p.tmp2 = tmp2;
+		p.dcolour = dcolour;
+	}
+};
+
+// Each of the 8 slots is a fixed size ring buffer, particles come out in the order they went in
 class PortalChannel
 {
 public:
 	static const int storageSize = 80;
 	int particleCount[8];
-	particle portalp[8][80];
+private:
+	int head[8];
+	PortalParticle portalp[8][storageSize];
+
+	PortalParticle * Push(int slot)
+	{
+		int pos = head[slot]+particleCount[slot];
+		if (pos >= storageSize)
+			pos -= storageSize;
+		particleCount[slot]++;
+		return &portalp[slot][pos];
+	}
+public:
+	bool IsFull(int slot)
+	{
+		return particleCount[slot] >= storageSize;
+	}
 	// Store a particle in a given slot (one of the 8 neighbour positions) for this portal channel, then kills the original
 	// Does not check whether the particle should be in a portal
 	// Returns true on success, or false if the portal is full
 	bool StoreParticle(Simulation *sim, int store_i, int slot)
 	{
-		if (particleCount[slot]>=storageSize)
+		if (IsFull(slot))
 			return false;
-		for (int nnx=0; nnx<80; nnx++)
-			if (!portalp[slot][nnx].type)
+		if (sim->parts[store_i].type == PT_STOR)
+		{
+			if (sim->IsElement(sim->parts[store_i].tmp) && (sim->elements[sim->parts[store_i].tmp].Properties & (TYPE_PART | TYPE_LIQUID | TYPE_GAS | TYPE_ENERGY)))
 			{
-				if (parts[store_i].type == PT_STOR)
-				{
-					if (sim->IsElement(parts[store_i].tmp) && (sim->elements[parts[store_i].tmp].Properties & (TYPE_PART | TYPE_LIQUID | TYPE_GAS | TYPE_ENERGY)))
-					{
-						PIPE_transfer_pipe_to_part(parts+store_i, &portalp[slot][nnx]);
-						return true;
-					}
-					return false;
-				}
-				else
-				{
-					portalp[slot][nnx] = parts[store_i];
-					particleCount[slot]++;
-					if (parts[store_i].type==PT_SPRK)
-						sim->part_change_type(store_i,(int)(sim->parts[store_i].x+0.5f),(int)(sim->parts[store_i].y+0.5f),sim->parts[store_i].ctype);
-					else
-						sim->part_kill(store_i);
-					return true;
-				}
+				particle storedPart = particle();
+				PIPE_transfer_pipe_to_part(sim->parts+store_i, &storedPart);
+				Push(slot)->Load(storedPart);
+				return true;
 			}
-		return false;
+			return false;
+		}
+		Push(slot)->Load(sim->parts[store_i]);
+		if (sim->parts[store_i].type==PT_SPRK)
+			sim->part_change_type(store_i,(int)(sim->parts[store_i].x+0.5f),(int)(sim->parts[store_i].y+0.5f),sim->parts[store_i].ctype);
+		else
+			sim->part_kill(store_i);
+		return true;
+	}
+	// Store a particle that isn't in the simulation (for example one coming out of a pipe)
+	// Returns false if the slot is full
+	bool StoreParticle(const particle &part, int slot)
+	{
+		if (IsFull(slot))
+			return false;
+		Push(slot)->Load(part);
+		return true;
 	}
-	particle * AllocParticle(int slot)
+	// Whether position pos of a slot's storage currently holds a particle
+	bool IsStored(int slot, int pos)
 	{
-		if (particleCount[slot]>=storageSize)
+		int offset = pos-head[slot];
+		if (offset < 0)
+			offset += storageSize;
+		return offset < particleCount[slot];
+	}
+	// Oldest particle in a slot, or NULL if the slot is empty
+	PortalParticle * PeekParticle(int slot)
+	{
+		if (!particleCount[slot])
 			return NULL;
-		for (int nnx=0; nnx<80; nnx++)
-			if (!portalp[slot][nnx].type)
-			{
-				particleCount[slot]++;
-				return &(portalp[slot][nnx]);
-			}
-		return NULL;
+		return &portalp[slot][head[slot]];
+	}
+	// Remove the oldest particle in a slot
+	void PopParticle(int slot)
+	{
+		if (!particleCount[slot])
+			return;
+		if (++head[slot] >= storageSize)
+			head[slot] = 0;
+		particleCount[slot]--;
 	}
 	void Simulation_Cleared()
 	{
-		memset(portalp, 0, sizeof(portalp));
 		memset(particleCount, 0, sizeof(particleCount));
+		memset(head, 0, sizeof(head));
 	}
 };
 
@@ -105,7 +183,7 @@ public:
 		sim->parts[i].tmp = (int)((sim->parts[i].temp-73.15f)/100+1);
 		if (sim->parts[i].tmp>=CHANNELS) sim->parts[i].tmp = CHANNELS-1;
 		else if (sim->parts[i].tmp<0) sim->parts[i].tmp = 0;
-		return channels+parts[i].tmp;
+		return channels+sim->parts[i].tmp;
 	}
 
 	static int GetSlot(int rx, int ry)
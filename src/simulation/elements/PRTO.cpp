@@ -44,13 +44,18 @@ int PRTO_update(UPDATE_FUNC_ARGS)
 			if (!pmap[y+ry][x+rx])
 			{
 				fe = 1;
+				// nothing stored in any of the slots this position can take particles from
+				if (!channel->particleCount[(count+3)%8] && !channel->particleCount[(count+4)%8] && !channel->particleCount[(count+5)%8])
+					continue;
 				for (int nnx = 0 ; nnx < PortalChannel::storageSize; nnx++)
 				{
 					//add -1,0,or 1 to count
-					int randomness = (count + rand()%3-1 + 4)%8;
-					if (!channel->portalp[randomness][nnx].type)
+					int randomness = (count + tpt_rand()%3-1 + 4)%8;
+					// Only emit when this try lands on a stored position, so a slot comes out as often as
+					// it did when each stored particle was looked up by position. The oldest is emitted
+					if (!channel->IsStored(randomness, nnx))
 						continue;
-					particle *storedPart = &(channel->portalp[randomness][nnx]);
+					PortalParticle *storedPart = channel->PeekParticle(randomness);
 					if (storedPart->type == PT_SPRK)// TODO: make it look better, spark creation
 					{
 						if (pmap[y+1][x+1])
@@ -69,11 +74,10 @@ int PRTO_update(UPDATE_FUNC_ARGS)
 							sim->spark_all_attempt(pmap[y][x-1]>>8, x-1, y);
 						if (pmap[y-1][x-1])
 							sim->spark_all_attempt(pmap[y-1][x-1]>>8, x-1, y-1);
-						storedPart->type = 0;
-						channel->particleCount[randomness]--;
+						channel->PopParticle(randomness);
 						break;
 					}
-					else if (storedPart->type)
+					else
 					{
 						if (storedPart->type == PT_FIGH)
 						{
@@ -107,18 +111,17 @@ int PRTO_update(UPDATE_FUNC_ARGS)
 							// particles that have passed from PIPE into PRTI have lost their velocity, so use the velocity of the newly created particle if the particle in the portal has no velocity
 							float tmp_vx = parts[np].vx;
 							float tmp_vy = parts[np].vy;
-							parts[np] = *storedPart;
+							storedPart->Unload(parts[np]);
 							parts[np].vx = tmp_vx;
 							parts[np].vy = tmp_vy;
 						}
 						else
 						{
-							parts[np] = *storedPart;
+							storedPart->Unload(parts[np]);
 						}
 						parts[np].x = (float)(x+rx);
 						parts[np].y = (float)(y+ry);
-						storedPart->type = 0;
-						channel->particleCount[randomness]--;
+						channel->PopParticle(randomness);
 						break;
 					}
 				}
@@ -130,9 +133,9 @@ int PRTO_update(UPDATE_FUNC_ARGS)
 		int orbd[4] = {0, 0, 0, 0};	//Orbital distances
 		int orbl[4] = {0, 0, 0, 0};	//Orbital locations
 		if (!parts[i].life)
-			parts[i].life = rand()*rand()*rand();
+			parts[i].life = tpt_rand()*tpt_rand()*tpt_rand();
 		if (!parts[i].ctype)
-			parts[i].ctype = rand()*rand()*rand();
+			parts[i].ctype = tpt_rand()*tpt_rand()*tpt_rand();
 		orbitalparts_get(parts[i].life, parts[i].ctype, orbd, orbl);
 		for (int r = 0; r < 4; r++)
 		{
@@ -142,7 +145,7 @@ int PRTO_update(UPDATE_FUNC_ARGS)
 				if (orbd[r] > 254)
 				{
 					orbd[r] = 0;
-					orbl[r] = rand()%255;
+					orbl[r] = tpt_rand()%255;
 				}
 				else
 				{
@@ -153,7 +156,7 @@ int PRTO_update(UPDATE_FUNC_ARGS)
 			else
 			{
 				orbd[r] = 0;
-				orbl[r] = rand()%255;
+				orbl[r] = tpt_rand()%255;
 			}
 		}
 		orbitalparts_set(&parts[i].life, &parts[i].ctype, orbd, orbl);
@@ -27,7 +27,8 @@ struct StackData
 	}
 };
 
-int tempParts[XRES];
+// scratch list of the particles in a stack, shared by CanMoveStack and MoveStack
+static TPT_THREAD_LOCAL int tempParts[XRES];
 
 #define PISTON_INACTIVE	0x00
 #define PISTON_RETRACT	0x01
@@ -170,6 +171,8 @@ int MoveStack(Simulation *sim, int stackX, int stackY, int directionX, int direc
 				parts[jP].x = (float)destX;
 				parts[jP].y = (float)destY;
 				pmap[destY][destX] = parts[jP].type|(jP<<8);
+				sim->occupancy_update(srcX, srcY);
+				sim->occupancy_update(destX, destY);
 			}
 			return amount;
 		}
@@ -198,6 +201,8 @@ int MoveStack(Simulation *sim, int stackX, int stackY, int directionX, int direc
 				parts[jP].x = (float)destX;
 				parts[jP].y = (float)destY;
 				pmap[destY][destX] = parts[jP].type|(jP<<8);
+				sim->occupancy_update(srcX, srcY);
+				sim->occupancy_update(destX, destY);
 			}
 			return possibleMovement;
 		}
@@ -39,7 +39,7 @@ int QRTZ_update(UPDATE_FUNC_ARGS)
 					r = pmap[y+ry][x+rx];
 					if (!r)
 						continue;
-					else if ((r&0xFF)==PT_SLTW && !(rand()%500))
+					else if ((r&0xFF)==PT_SLTW && !(tpt_rand()%500))
 					{
 						kill_part(r>>8);
 						parts[i].tmp++;
@@ -52,7 +52,7 @@ int QRTZ_update(UPDATE_FUNC_ARGS)
 		int rnd, sry, srx;
 		for (trade = 0; trade < 9; trade++)
 		{
-			rnd = rand()%0x3FF;
+			rnd = tpt_rand()%0x3FF;
 			rx = (rnd%5)-2;
 			srx = (rnd%3)-1;
 			rnd >>= 3;
@@ -75,11 +75,11 @@ int QRTZ_update(UPDATE_FUNC_ARGS)
 								// If PQRT is stationary and has started growing particles of QRTZ, the PQRT is basically part of a new QRTZ crystal. So turn it back into QRTZ so that it behaves more like part of the crystal.
 								sim->part_change_type(i,x,y,PT_QRTZ);
 							}
-							if (rand()%2)
+							if (tpt_rand()%2)
 							{
 								parts[np].tmp = -1;//dead qrtz
 							}
-							else if (!parts[i].tmp && !(rand()%15))
+							else if (!parts[i].tmp && !(tpt_rand()%15))
 							{
 								parts[i].tmp=-1;
 							}
@@ -136,7 +136,7 @@ int QRTZ_graphics(GRAPHICS_FUNC_ARGS)
 
 void QRTZ_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	sim->parts[i].tmp2 = (rand()%11);
+	sim->parts[i].tmp2 = (tpt_rand()%11);
 	sim->parts[i].pavg[1] = sim->air->pv[y/CELL][x/CELL];
 }
 
@@ -28,7 +28,7 @@ int RIME_update(UPDATE_FUNC_ARGS)
 				if ((r&0xFF)==PT_SPRK)
 				{
 					part_change_type(i,x,y,PT_FOG);
-					parts[i].life = rand()%50 + 60;
+					parts[i].life = tpt_rand()%50 + 60;
 				}
 				else if ((r&0xFF)==PT_FOG&&parts[r>>8].life>0)
 				{
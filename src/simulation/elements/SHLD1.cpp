@@ -27,7 +27,7 @@ int SHLD1_update(UPDATE_FUNC_ARGS)
 					continue;
 				else if ((r&0xFF)==PT_SPRK&&parts[i].life==0)
 				{
-					if (11>rand()%40 && parts[i].life==0)
+					if (11>tpt_rand()%40 && parts[i].life==0)
 					{
 						part_change_type(i,x,y,PT_SHLD2);
 						parts[i].life = 7;
@@ -42,7 +42,7 @@ int SHLD1_update(UPDATE_FUNC_ARGS)
 							}
 						}
 				}
-				else if ((r&0xFF)==PT_SHLD3 && 2>rand()%5)
+				else if ((r&0xFF)==PT_SHLD3 && 2>tpt_rand()%5)
 				{
 					part_change_type(i,x,y,PT_SHLD2);
 					parts[i].life = 7;
@@ -25,7 +25,7 @@ int SHLD3_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 				{
-					if (!(rand()%2500))
+					if (!(tpt_rand()%2500))
 					{
 						np = sim->part_create(-1,x+rx,y+ry,PT_SHLD1);
 						if (np<0) continue;
@@ -40,7 +40,7 @@ int SHLD3_update(UPDATE_FUNC_ARGS)
 				}
 				else if ((r&0xFF)==PT_SPRK && !parts[i].life)
 				{
-					if (3>rand()%500)
+					if (3>tpt_rand()%500)
 					{
 						part_change_type(i,x,y,PT_SHLD4);
 						parts[i].life = 7;
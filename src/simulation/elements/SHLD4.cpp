@@ -25,7 +25,7 @@ int SHLD4_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 				{
-					if (!(rand()%5500))
+					if (!(tpt_rand()%5500))
 					{
 						np = sim->part_create(-1,x+rx,y+ry,PT_SHLD1);
 						if (np<0) continue;
@@ -50,7 +50,7 @@ int SING_update(UPDATE_FUNC_ARGS)
 		spawncount = (spawncount>255) ? 3019 : (int)(std::pow((double)(spawncount/8), 2)*M_PI);
 		for (int j = 0; j < spawncount; j++)
 		{
-			switch(rand()%3)
+			switch(tpt_rand()%3)
 			{
 				case 0:
 					nb = sim->part_create(-3, x, y, PT_PHOT);
@@ -64,10 +64,10 @@ int SING_update(UPDATE_FUNC_ARGS)
 			}
 			if (nb != -1)
 			{
-				parts[nb].life = (rand()%300);
+				parts[nb].life = (tpt_rand()%300);
 				parts[nb].temp = MAX_TEMP/2;
-				angle = rand()*2.0f*M_PI/RAND_MAX;
-				v = (float)(rand())*5.0f/RAND_MAX;
+				angle = tpt_rand()*2.0f*M_PI/RAND_MAX;
+				v = (float)(tpt_rand())*5.0f/RAND_MAX;
 				parts[nb].vx = v*cosf(angle);
 				parts[nb].vy = v*sinf(angle);
 			}
@@ -84,7 +84,7 @@ int SING_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 					continue;
-				if (!(ptypes[r&0xFF].properties&PROP_INDESTRUCTIBLE) && !(ptypes[r&0xFF].properties&PROP_CLONE) && !(ptypes[r&0xFF].properties&PROP_BREAKABLECLONE) && !(rand()%3))
+				if (!(ptypes[r&0xFF].properties&PROP_INDESTRUCTIBLE) && !(ptypes[r&0xFF].properties&PROP_CLONE) && !(ptypes[r&0xFF].properties&PROP_BREAKABLECLONE) && !(tpt_rand()%3))
 				{
 					if ((r&0xFF)==PT_SING && parts[r>>8].life >10)
 					{
@@ -96,11 +96,11 @@ int SING_update(UPDATE_FUNC_ARGS)
 					{
 						if (parts[i].life+3 > 255)
 						{
-							if (parts[r>>8].type!=PT_SING && !(rand()%100))
+							if (parts[r>>8].type!=PT_SING && !(tpt_rand()%100))
 							{
 								int np;
 								np = sim->part_create(r>>8,x+rx,y+ry,PT_SING);
-								parts[np].life = rand()%50+60;
+								parts[np].life = tpt_rand()%50+60;
 								parts[np].tmp2 = parts[i].tmp2;
 							}
 							continue;
@@ -117,7 +117,7 @@ int SING_update(UPDATE_FUNC_ARGS)
 
 void SING_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	sim->parts[i].life = rand()%50+60;
+	sim->parts[i].life = tpt_rand()%50+60;
 }
 
 void SING_init_element(ELEMENT_INIT_FUNC_ARGS)
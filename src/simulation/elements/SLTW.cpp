@@ -26,16 +26,16 @@ int SLTW_update(UPDATE_FUNC_ARGS)
 				switch (r&0xFF)
 				{
 				case PT_SALT:
-					if (!(rand()%2000))
+					if (!(tpt_rand()%2000))
 						part_change_type(r>>8, x+rx, y+ry, PT_SLTW);
 					break;
 				case PT_PLNT:
-					if (!(rand()%40))
+					if (!(tpt_rand()%40))
 						kill_part(r>>8);
 					break;
 				case PT_RBDM:
 				case PT_LRBD:
-					if ((legacy_enable || parts[i].temp>(273.15f+12.0f)) && !(rand()%100))
+					if ((legacy_enable || parts[i].temp>(273.15f+12.0f)) && !(tpt_rand()%100))
 					{
 						part_change_type(i, x, y, PT_FIRE);
 						parts[i].life = 4;
@@ -46,7 +46,7 @@ int SLTW_update(UPDATE_FUNC_ARGS)
 					if (parts[r>>8].ctype != PT_WATR)
 					{
 						kill_part(r>>8);
-						if (!(rand()%30))
+						if (!(tpt_rand()%30))
 						{
 							kill_part(i);
 							return 1;
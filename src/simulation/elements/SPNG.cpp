@@ -32,31 +32,31 @@ int SPNG_update(UPDATE_FUNC_ARGS)
 					case PT_WATR:
 					case PT_DSTW:
 					case PT_FRZW:
-						if (parts[i].life<limit && 500>rand()%absorbChanceDenom)
+						if (parts[i].life<limit && 500>tpt_rand()%absorbChanceDenom)
 						{
 							parts[i].life++;
 							kill_part(r>>8);
 						}
 						break;
 					case PT_SLTW:
-						if (parts[i].life<limit && 50>rand()%absorbChanceDenom)
+						if (parts[i].life<limit && 50>tpt_rand()%absorbChanceDenom)
 						{
 							parts[i].life++;
-							if (rand()%4)
+							if (tpt_rand()%4)
 								kill_part(r>>8);
 							else
 								part_change_type(r>>8, x+rx, y+ry, PT_SALT);
 						}
 						break;
 					case PT_CBNW:
-						if (parts[i].life<limit && 100>rand()%absorbChanceDenom)
+						if (parts[i].life<limit && 100>tpt_rand()%absorbChanceDenom)
 						{
 							parts[i].life++;
 							part_change_type(r>>8, x+rx, y+ry, PT_CO2);
 						}
 						break;
 					case PT_PSTE:
-						if (parts[i].life<limit && 20>rand()%absorbChanceDenom)
+						if (parts[i].life<limit && 20>tpt_rand()%absorbChanceDenom)
 						{
 							parts[i].life++;
 							sim->part_create(r>>8, x+rx, y+ry, PT_CLST);
@@ -81,8 +81,8 @@ int SPNG_update(UPDATE_FUNC_ARGS)
 				}
 	for ( trade = 0; trade<9; trade ++)
 	{
-		rx = rand()%5-2;
-		ry = rand()%5-2;
+		rx = tpt_rand()%5-2;
+		ry = tpt_rand()%5-2;
 		if (BOUNDS_CHECK && (rx || ry))
 		{
 			r = pmap[y+ry][x+rx];
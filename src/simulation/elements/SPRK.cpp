@@ -75,7 +75,7 @@ int SPRK_update(UPDATE_FUNC_ARGS)
 	case PT_NBLE:
 		if (parts[i].life <= 1 && !(parts[i].tmp&0x1))
 		{
-			parts[i].life = rand()%150+50;
+			parts[i].life = tpt_rand()%150+50;
 			part_change_type(i, x, y, PT_PLSM);
 			parts[i].ctype = PT_NBLE;
 			if (parts[i].temp > 5273.15)
@@ -94,12 +94,12 @@ int SPRK_update(UPDATE_FUNC_ARGS)
 			r = pmap[y+ry][x+rx];
 			if (r)
 				continue;
-			if (parts[i].tmp>4 && rand()%(parts[i].tmp*parts[i].tmp/20+6)==0)
+			if (parts[i].tmp>4 && tpt_rand()%(parts[i].tmp*parts[i].tmp/20+6)==0)
 			{
 				int p=sim->part_create(-1, x+rx*2, y+ry*2, PT_LIGH);
 				if (p!=-1)
 				{
-					parts[p].life=rand()%(2+parts[i].tmp/15)+parts[i].tmp/7;
+					parts[p].life=tpt_rand()%(2+parts[i].tmp/15)+parts[i].tmp/7;
 					if (parts[i].life>60)
 						parts[i].life=60;
 					parts[p].temp=parts[p].life*parts[i].tmp/2.5f;
@@ -127,7 +127,7 @@ int SPRK_update(UPDATE_FUNC_ARGS)
 				continue;
 			if ((r&0xFF) == PT_DSTW || (r&0xFF) == PT_SLTW || ((r&0xFF) == PT_WATR))
 			{
-				int rnd = rand()%100;
+				int rnd = tpt_rand()%100;
 				if (!rnd)
 					part_change_type(r>>8, x+rx, y+ry, PT_O2);
 				else if (3 > rnd)
@@ -137,7 +137,7 @@ int SPRK_update(UPDATE_FUNC_ARGS)
 		break;
 	case PT_TUNG:
 		if (parts[i].temp < 3595.0)
-			parts[i].temp += (rand()%20)-4;
+			parts[i].temp += (tpt_rand()%20)-4;
 		break;
 	default:
 		break;
@@ -396,7 +396,7 @@ int STKM_ElementDataContainer::Run(Stickman *playerp, UPDATE_FUNC_ARGS)
 	// Spawn
 	if (((int)(playerp->comm)&0x08) == 0x08)
 	{
-		ry -= 2*(rand()%2)+1;
+		ry -= 2*(tpt_rand()%2)+1;
 		int r = pmap[ry][rx];
 		if (sim->elements[r&0xFF].Properties&TYPE_SOLID)
 		{
@@ -436,7 +436,7 @@ int STKM_ElementDataContainer::Run(Stickman *playerp, UPDATE_FUNC_ARGS)
 			{
 				if (playerp->elem == PT_PHOT)
 				{
-					int random = abs(rand()%3-1)*3;
+					int random = abs(tpt_rand()%3-1)*3;
 					if (random == 0)
 					{
 						sim->part_kill(np);
@@ -457,7 +457,7 @@ int STKM_ElementDataContainer::Run(Stickman *playerp, UPDATE_FUNC_ARGS)
 					if (gvx != 0 || gvy != 0)
 						angle = atan2(gvx, gvy)*180.0f/M_PI;
 					else
-						angle = (float)(rand()%360);
+						angle = (float)(tpt_rand()%360);
 					if (((int)playerp->pcomm)&0x01)
 						angle += 180;
 					if (angle > 360)
@@ -465,7 +465,7 @@ int STKM_ElementDataContainer::Run(Stickman *playerp, UPDATE_FUNC_ARGS)
 					if (angle < 0)
 						angle += 360;
 					parts[np].tmp = (int)angle;
-					parts[np].life = rand()%(2+power/15) + power/7;
+					parts[np].life = tpt_rand()%(2+power/15) + power/7;
 					parts[np].temp = parts[np].life * power/2.5f;
 					parts[np].tmp2 = 1;
 				}
@@ -585,7 +585,7 @@ void STKM_ElementDataContainer::Interact(Simulation* sim, Stickman *playerp, int
 	{
 		if ((r&0xFF)==PT_SPRK && playerp->elem!=PT_LIGH) //If on charge
 		{
-			parts[i].life -= (int)(rand()*20/RAND_MAX)+32;
+			parts[i].life -= (int)(tpt_rand()*20/RAND_MAX)+32;
 		}
 
 		if (sim->elements[r&0xFF].HeatConduct && ((r&0xFF)!=PT_HSWC||parts[r>>8].life==10) && ((playerp->elem!=PT_LIGH && parts[r>>8].temp>=323) || parts[r>>8].temp<=243) && (!playerp->rocketBoots || (r&0xFF)!=PT_PLSM))
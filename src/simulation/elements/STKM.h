@@ -50,12 +50,19 @@ public:
 	{
 		//create stickmen if the current one has been deleted
 		if (sim->elementCount[PT_STKM] <= 0 && player.spawnID >= 0 && player.spawnID < NPART && sim->parts[player.spawnID].type == PT_SPAWN)
-			sim->part_create(-1, (int)parts[player.spawnID].x, (int)parts[player.spawnID].y, PT_STKM);
+			sim->part_create(-1, (int)sim->parts[player.spawnID].x, (int)sim->parts[player.spawnID].y, PT_STKM);
 		else if (sim->elementCount[PT_STKM2] <= 0 && player2.spawnID >= 0 && player2.spawnID < NPART && sim->parts[player2.spawnID].type == PT_SPAWN2)
-			sim->part_create(-1, (int)parts[player2.spawnID].x, (int)parts[player2.spawnID].y, PT_STKM2);
+			sim->part_create(-1, (int)sim->parts[player2.spawnID].x, (int)sim->parts[player2.spawnID].y, PT_STKM2);
 	}
 
 	virtual void Simulation_AfterUpdate(Simulation *sim);
+	virtual void Simulation_ParticlesMoved(Simulation *sim, const int *newIndex)
+	{
+		if (player.spawnID >= 0 && player.spawnID < NPART)
+			player.spawnID = newIndex[player.spawnID];
+		if (player2.spawnID >= 0 && player2.spawnID < NPART)
+			player2.spawnID = newIndex[player2.spawnID];
+	}
 
 	Stickman * GetStickman1()
 	{
@@ -132,7 +132,7 @@ int TRON_update(UPDATE_FUNC_ARGS)
 		int originaldir = direction;
 
 		//random turn
-		int random = rand()%340;
+		int random = tpt_rand()%340;
 		if ((random==1 || random==3) && !(parts[i].tmp & TRON_NORANDOM))
 		{
 			//randomly turn left(3) or right(1)
@@ -156,7 +156,7 @@ int TRON_update(UPDATE_FUNC_ARGS)
 			}
 			else
 			{
-				seconddir = (direction + ((rand()%2)*2)+1)% 4;
+				seconddir = (direction + ((tpt_rand()%2)*2)+1)% 4;
 				lastdir = (seconddir + 2)%4;
 			}
 			seconddircheck = trymovetron(x,y,seconddir,i,parts[i].tmp2);
@@ -226,8 +226,8 @@ void TRON_init_graphics()
 
 void TRON_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	int randhue = rand()%360;
-	int randomdir = rand()%4;
+	int randhue = tpt_rand()%360;
+	int randomdir = tpt_rand()%4;
 	sim->parts[i].tmp = 1|(randomdir<<5)|(randhue<<7);//set as a head and a direction
 	sim->parts[i].tmp2 = 4;//tail
 	sim->parts[i].life = 5;
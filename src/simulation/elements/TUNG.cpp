@@ -33,16 +33,16 @@ int TUNG_update(UPDATE_FUNC_ARGS)
 					}
 				}
 	}
-	if((parts[i].temp > MELTING_POINT && !(rand()%20)) || splode)
+	if((parts[i].temp > MELTING_POINT && !(tpt_rand()%20)) || splode)
 	{
-		if(!(rand()%50))
+		if(!(tpt_rand()%50))
 		{
 			sim->air->pv[y/CELL][x/CELL] += 50.0f;
 		}
-		else if(!(rand()%100))
+		else if(!(tpt_rand()%100))
 		{
 			part_change_type(i, x, y, PT_FIRE);
-			parts[i].life = rand()%500;
+			parts[i].life = tpt_rand()%500;
 			return 1;
 		}
 		else
@@ -53,10 +53,10 @@ int TUNG_update(UPDATE_FUNC_ARGS)
 		}
 		if(splode)
 		{
-			parts[i].temp = restrict_flt(MELTING_POINT + (rand()%600) + 200, MIN_TEMP, MAX_TEMP);
+			parts[i].temp = restrict_flt(MELTING_POINT + (tpt_rand()%600) + 200, MIN_TEMP, MAX_TEMP);
 		}
-		parts[i].vx += (rand()%100)-50;
-		parts[i].vy += (rand()%100)-50;
+		parts[i].vx += (tpt_rand()%100)-50;
+		parts[i].vy += (tpt_rand()%100)-50;
 		return 1;
 	}
 	parts[i].pavg[0] = parts[i].pavg[1];
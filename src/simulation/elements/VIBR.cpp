@@ -50,7 +50,7 @@ int VIBR_update(UPDATE_FUNC_ARGS)
 	{
 		//Release sparks before explode
 		if (parts[i].life < 500)
-			rndstore = rand();
+			rndstore = tpt_rand();
 		if (parts[i].life < 300)
 		{
 			rx = rndstore%3-1;
@@ -82,7 +82,7 @@ int VIBR_update(UPDATE_FUNC_ARGS)
 		{
 			if (!parts[i].tmp2)
 			{
-				rndstore = rand();
+				rndstore = tpt_rand();
 				int index = sim->part_create(-3,x+((rndstore>>4)&3)-1,y+((rndstore>>6)&3)-1,PT_ELEC);
 				if (index != -1)
 					parts[index].temp = 7000;
@@ -90,7 +90,7 @@ int VIBR_update(UPDATE_FUNC_ARGS)
 				if (index != -1)
 					parts[index].temp = 7000;
 				int rx = ((rndstore>>12)&3)-1;
-				rndstore = rand();
+				rndstore = tpt_rand();
 				index = sim->part_create(-1,x+rx-1,y+rndstore%3-1,PT_BREL);
 				if (index != -1)
 					parts[index].temp = 7000;
@@ -124,7 +124,7 @@ int VIBR_update(UPDATE_FUNC_ARGS)
 					{
 						if (!parts[r>>8].life)
 							parts[r>>8].tmp += 45;
-						else if (parts[i].tmp2 && parts[i].life > 75 && rand()%2)
+						else if (parts[i].tmp2 && parts[i].life > 75 && tpt_rand()%2)
 						{
 							parts[r>>8].tmp2 = 1;
 							parts[i].tmp = 0;
@@ -140,7 +140,7 @@ int VIBR_update(UPDATE_FUNC_ARGS)
 				else
 				{
 					//Melts into EXOT
-					if ((r&0xFF) == PT_EXOT && !(rand()%25))
+					if ((r&0xFF) == PT_EXOT && !(tpt_rand()%25))
 					{
 						sim->part_create(i, x, y, PT_EXOT);
 						return 1;
@@ -156,7 +156,7 @@ int VIBR_update(UPDATE_FUNC_ARGS)
 	for (trade = 0; trade < 9; trade++)
 	{
 		if (!(trade%2))
-			rndstore = rand();
+			rndstore = tpt_rand();
 		rx = rndstore%7-3;
 		rndstore >>= 3;
 		ry = rndstore%7-3;
@@ -21,13 +21,13 @@ int WARP_update(UPDATE_FUNC_ARGS)
 	{
 		parts[i].temp = 10000;
 		sim->air->pv[y/CELL][x/CELL] += (parts[i].tmp2/5000) * CFDS;
-		if (!(rand()%50))
+		if (!(tpt_rand()%50))
 			sim->part_create(-3, x, y, PT_ELEC);
 	}
 	for (int trade = 0; trade < 5; trade ++)
 	{
-		int rx = rand()%3-1;
-		int ry = rand()%3-1;
+		int rx = tpt_rand()%3-1;
+		int ry = tpt_rand()%3-1;
 		if (BOUNDS_CHECK && (rx || ry))
 		{
 			int r = pmap[y+ry][x+rx];
@@ -39,11 +39,13 @@ int WARP_update(UPDATE_FUNC_ARGS)
 				parts[i].y = parts[r>>8].y;
 				parts[r>>8].x = (float)x;
 				parts[r>>8].y = (float)y;
-				parts[r>>8].vx = (rand()%4)-1.5f;
-				parts[r>>8].vy = (rand()%4)-2.0f;
+				parts[r>>8].vx = (tpt_rand()%4)-1.5f;
+				parts[r>>8].vy = (tpt_rand()%4)-2.0f;
 				parts[i].life += 4;
 				pmap[y][x] = r;
 				pmap[y+ry][x+rx] = (i<<8) | parts[i].type;
+				sim->occupancy_update(x, y);
+				sim->occupancy_update(x+rx, y+ry);
 				trade = 5;
 			}
 		}
@@ -61,7 +63,7 @@ int WARP_graphics(GRAPHICS_FUNC_ARGS)
 
 void WARP_create(ELEMENT_CREATE_FUNC_ARGS)
 {
-	sim->parts[i].life = rand()%95+70;
+	sim->parts[i].life = tpt_rand()%95+70;
 }
 
 void WARP_init_element(ELEMENT_INIT_FUNC_ARGS)
@@ -25,14 +25,14 @@ int WATR_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 					continue;
-				if ((r&0xFF)==PT_SALT && !(rand()%50))
+				if ((r&0xFF)==PT_SALT && !(tpt_rand()%50))
 				{
 					part_change_type(i,x,y,PT_SLTW);
 					// on average, convert 3 WATR to SLTW before SALT turns into SLTW
-					if (rand()%3==0)
+					if (tpt_rand()%3==0)
 						part_change_type(r>>8,x+rx,y+ry,PT_SLTW);
 				}
-				else if (((r&0xFF)==PT_RBDM||(r&0xFF)==PT_LRBD) && (legacy_enable||parts[i].temp>(273.15f+12.0f)) && !(rand()%100))
+				else if (((r&0xFF)==PT_RBDM||(r&0xFF)==PT_LRBD) && (legacy_enable||parts[i].temp>(273.15f+12.0f)) && !(tpt_rand()%100))
 				{
 					part_change_type(i,x,y,PT_FIRE);
 					parts[i].life = 4;
@@ -41,17 +41,17 @@ int WATR_update(UPDATE_FUNC_ARGS)
 				else if ((r&0xFF)==PT_FIRE && parts[r>>8].ctype!=PT_WATR)
 				{
 					kill_part(r>>8);
-					if (!(rand()%30))
+					if (!(tpt_rand()%30))
 					{
 						kill_part(i);
 						return 1;
 					}
 				}
-				else if ((r&0xFF)==PT_SLTW && !(rand()%2000))
+				else if ((r&0xFF)==PT_SLTW && !(tpt_rand()%2000))
 				{
 					part_change_type(i,x,y,PT_SLTW);
 				}
-				/*if ((r&0xFF)==PT_CNCT && !(rand()%100))	Concrete+Water to paste, not very popular
+				/*if ((r&0xFF)==PT_CNCT && !(tpt_rand()%100))	Concrete+Water to paste, not very popular
 				{
 					part_change_type(i,x,y,PT_PSTE);
 					kill_part(r>>8);
@@ -25,7 +25,7 @@ int WTRV_update(UPDATE_FUNC_ARGS)
 				r = pmap[y+ry][x+rx];
 				if (!r)
 					continue;
-				if (((r&0xFF)==PT_RBDM||(r&0xFF)==PT_LRBD) && !legacy_enable && parts[i].temp>(273.15f+12.0f) && !(rand()%100))
+				if (((r&0xFF)==PT_RBDM||(r&0xFF)==PT_LRBD) && !legacy_enable && parts[i].temp>(273.15f+12.0f) && !(tpt_rand()%100))
 				{
 					part_change_type(i,x,y,PT_FIRE);
 					parts[i].life = 4;
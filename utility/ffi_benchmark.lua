@@ -0,0 +1,107 @@
+-- Compares looping over particles through tpt.parts (a metamethod call for every field) with the LuaJIT FFI views
+-- from sim.view. Only works in --luajit builds. Run it from the console with dofile("utility/ffi_benchmark.lua")
+
+if not sim.view then
+	print("sim.view is only available in LuaJIT builds")
+	return
+end
+
+local iterations = 10
+local npart = sim.XRES*sim.YRES
+
+local function time(name, f)
+	local start = os.clock()
+	local result = f()
+	local elapsed = os.clock() - start
+	print(string.format("%-28s %8.2f ms  (result %s)", name, elapsed*1000/iterations, tostring(result)))
+	return elapsed
+end
+
+local function readParts()
+	local total = 0
+	for n = 1, iterations do
+		for i = 0, npart - 1 do
+			if tpt.parts[i].type ~= 0 then
+				total = total + tpt.parts[i].temp
+			end
+		end
+	end
+	return total
+end
+
+local function readView()
+	local parts = sim.view("parts")
+	local total = 0
+	for n = 1, iterations do
+		for i = 0, npart - 1 do
+			local part = parts[i]
+			if part.type ~= 0 then
+				total = total + part.temp
+			end
+		end
+	end
+	parts:release()
+	return total
+end
+
+local function writeParts()
+	for n = 1, iterations do
+		for i = 0, npart - 1 do
+			if tpt.parts[i].type ~= 0 then
+				tpt.parts[i].temp = tpt.parts[i].temp
+			end
+		end
+	end
+end
+
+local function writeView()
+	local parts = sim.view("parts", true)
+	for n = 1, iterations do
+		for i = 0, npart - 1 do
+			local part = parts[i]
+			if part.type ~= 0 then
+				part.temp = part.temp
+			end
+		end
+	end
+	parts:release()
+end
+
+local function readPressure()
+	local pv = sim.view("pv")
+	local width, height = pv.width, pv.height
+	pv:release()
+	local total = 0
+	for n = 1, iterations do
+		for y = 0, height - 1 do
+			for x = 0, width - 1 do
+				total = total + sim.pressure(x, y)
+			end
+		end
+	end
+	return total
+end
+
+local function readPressureView()
+	local pv = sim.view("pv")
+	local total = 0
+	for n = 1, iterations do
+		for i = 0, #pv - 1 do
+			total = total + pv[i]
+		end
+	end
+	pv:release()
+	return total
+end
+
+print("Particle loops, per iteration:")
+local a = time("tpt.parts read", readParts)
+local b = time("sim.view read", readView)
+print(string.format("speedup %.1fx", a/b))
+a = time("tpt.parts read+write", writeParts)
+b = time("sim.view read+write", writeView)
+print(string.format("speedup %.1fx", a/b))
+print("Pressure loops, per iteration:")
+a = time("sim.pressure", readPressure)
+b = time("sim.view(\"pv\")", readPressureView)
+print(string.format("speedup %.1fx", a/b))